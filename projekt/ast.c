@@ -18,6 +18,7 @@ void ast_init(ast *tree) {
     *tree = malloc(sizeof(struct ast));
     (*tree)->import = NULL;
     (*tree)->class_list = NULL;
+    (*tree)->strings = NULL;
 }
 
 /// @brief Initializes an import node
@@ -175,9 +176,31 @@ void ast_add_new_node(ast_class *class_node, enum ast_node_type type) {
     }
 }
 
+/// @brief Copies a string into the tree (literal folded at compile time)
+/// @param tree pointer to the AST
+/// @param value string to copy
+/// @return the copy, freed by ast_dispose()
+char *ast_string_copy(ast tree, const char *value) {
+    size_t len = strlen(value);
+    ast_string copy = malloc(sizeof(struct ast_string) + len + 1);
+    if (copy == NULL) return NULL;
+    memcpy(copy->value, value, len + 1);
+    copy->next = tree->strings;
+    tree->strings = copy;
+    return copy->value;
+}
+
 /// @brief Disposes of the AST
+/// Names and literals point into the token list and are freed with it,
+/// codegen names (cg_name) are copies made by the semantic analysis and the
+/// literals folded at compile time (strings) belong to the tree.
 /// @param tree pointer to the AST
 void ast_dispose(ast tree) {
+    while (tree->strings != NULL) {
+        ast_string next = tree->strings->next;
+        free(tree->strings);
+        tree->strings = next;
+    }
     free(tree->import);
     ast_class_dispose(tree->class_list);
     free(tree);
@@ -186,17 +209,18 @@ void ast_dispose(ast tree) {
 /// @brief Disposes of a class node
 /// @param class_node pointer to the class node
 void ast_class_dispose(ast_class class_node) {
-    if(class_node == NULL) {
-        return;
+    while (class_node != NULL) {
+        ast_class next = class_node->next;
+        // A parse error can leave the class inside a nested block
+        ast_block root = class_node->current;
+        while (root != NULL && root->parent != NULL) root = root->parent;
+        ast_block_dispose(root);
+        free(class_node);
+        class_node = next;
     }
-
-    ast_block_dispose(class_node->current);
-
-    ast_class_dispose(class_node->next);
-    free(class_node);
 }
 
-/// @brief Disposes of a block node
+/// @brief Disposes of a block node and all nodes in it
 /// @param block_node pointer to the block node
 void ast_block_dispose(ast_block block_node) {
     if(block_node == NULL) {
@@ -205,13 +229,26 @@ void ast_block_dispose(ast_block block_node) {
 
     ast_node current_node = block_node->first;
     while(current_node != NULL) {
+        ast_node next_node = current_node->next;
         ast_node_dispose(current_node);
-        current_node = current_node->next;
+        current_node = next_node;
     }
 
     free(block_node);
 }
 
+/// @brief Disposes of a list of parameters or call arguments
+/// @param param first parameter of the list
+void ast_parameters_dispose(ast_parameter param) {
+    while(param != NULL) {
+        ast_parameter next = param->next;
+        free(param->cg_name);
+        if (param->value_type == AST_VALUE_EXPRESSION) ast_expression_dispose(param->expression);
+        free(param);
+        param = next;
+    }
+}
+
 /// @brief Disposes of a node
 /// @param node pointer to the AST node
 void ast_node_dispose(ast_node node) {
@@ -222,12 +259,15 @@ void ast_node_dispose(ast_node node) {
     switch (node->type)
     {
     case AST_BLOCK:
+        ast_block_dispose(node->data.block);
         break;
     case AST_CONDITION:
+        ast_expression_dispose(node->data.condition.condition);
         ast_block_dispose(node->data.condition.if_branch);
         ast_block_dispose(node->data.condition.else_branch);
         break;
     case AST_WHILE_LOOP:
+        ast_expression_dispose(node->data.while_loop.condition);
         ast_block_dispose(node->data.while_loop.body);
         break;
     case AST_BREAK:
@@ -238,50 +278,23 @@ void ast_node_dispose(ast_node node) {
         ast_expression_dispose(node->data.expression);
         break;
     case AST_VAR_DECLARATION:
-    if (node->data.declaration.name) {
-        free(node->data.declaration.name);
-    }
-    if (node->data.declaration.cg_name) {
         free(node->data.declaration.cg_name);
-    }
         break;
     case AST_ASSIGNMENT:
-    if (node->data.assignment.name) {
-        free(node->data.assignment.name);
-    }
-    if (node->data.assignment.cg_name) {
         free(node->data.assignment.cg_name);
-    }
         ast_expression_dispose(node->data.assignment.value);
         break;
-    case AST_FUNCTION: {
-        if (node->data.function->name) free(node->data.function->name);
-        ast_parameter param = node->data.function->parameters;
-        ast_parameter temp;
-        while(param != NULL) {
-            temp = param->next;
-            if (param->cg_name) free(param->cg_name);
-            free(param);
-            param = temp;
-        }
+    case AST_FUNCTION:
+        ast_parameters_dispose(node->data.function->parameters);
         ast_block_dispose(node->data.function->code);
         free(node->data.function);
         break;
-    }
-    case AST_CALL_FUNCTION: {
-        if (node->data.function_call->name) free(node->data.function_call->name);
-        ast_parameter param = node->data.function_call->parameters;
-        ast_parameter temp;
-        while(param != NULL) {
-            temp = param->next;
-            free(param->cg_name);
-            free(param);
-            param = temp;
-        }
+    case AST_CALL_FUNCTION:
+        ast_parameters_dispose(node->data.function_call->parameters);
         free(node->data.function_call);
         break;
-    }
     case AST_RETURN:
+        ast_expression_dispose(node->data.return_expr.output);
         break;
     case AST_GETTER:
         ast_block_dispose(node->data.getter.body);
@@ -289,33 +302,201 @@ void ast_node_dispose(ast_node node) {
     case AST_SETTER:
         ast_block_dispose(node->data.setter.body);
         break;
-    case AST_IFJ_FUNCTION: {
-        if (node->data.ifj_function->name) free(node->data.ifj_function->name);
-        ast_parameter param = node->data.ifj_function->parameters;
-        while(param != NULL) {
-            ast_parameter to_free = param;
-            param = param->next;
-            free(to_free);
-        }
+    case AST_IFJ_FUNCTION:
+        ast_parameters_dispose(node->data.ifj_function->parameters);
         free(node->data.ifj_function);
         break;
     }
-    }
+    free(node);
 }
 
-/// @brief Disposes of an expression node
+/// @brief Disposes of an expression node and its operands
+/// The tree may be arbitrarily deep: the nodes already emptied hold the list of subtrees
+/// still to be freed (condition and if_true of a ternary node, if_false links the list),
+/// so no stack grows with the depth and no memory is allocated
 /// @param expr pointer to the expression node
 void ast_expression_dispose(ast_expression expr) {
-    if(expr == NULL) {
-        return;
+    ast_expression pending = NULL;
+    while (expr != NULL || pending != NULL) {
+        if (expr == NULL) {
+            // take the next subtree from the list, the cell keeps its other subtree
+            ast_expression cell = pending;
+            expr = cell->operands.ternary_op.condition;
+            if (cell->operands.ternary_op.if_true != NULL) {
+                cell->operands.ternary_op.condition = cell->operands.ternary_op.if_true;
+                cell->operands.ternary_op.if_true = NULL;
+            } else {
+                pending = cell->operands.ternary_op.if_false;
+                free(cell);
+            }
+            continue;
+        }
+
+        ast_expression first = NULL, second = NULL, third = NULL;
+        switch (expr->type) {
+        case AST_FUNCTION_CALL:
+            ast_parameters_dispose(expr->operands.function_call->parameters);
+            free(expr->operands.function_call);
+            break;
+        case AST_IFJ_FUNCTION_EXPR:
+            ast_parameters_dispose(expr->operands.ifj_function->parameters);
+            free(expr->operands.ifj_function);
+            break;
+        case AST_NOT:
+        case AST_NOT_NULL:
+            first = expr->operands.unary_op.expression;
+            break;
+        case AST_TERNARY:
+            first = expr->operands.ternary_op.condition;
+            second = expr->operands.ternary_op.if_true;
+            third = expr->operands.ternary_op.if_false;
+            break;
+        case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV:
+        case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE: case AST_GT: case AST_GE:
+        case AST_AND: case AST_OR: case AST_IS: case AST_CONCAT:
+            first = expr->operands.binary_op.left;
+            second = expr->operands.binary_op.right;
+            break;
+        default: // AST_VALUE, AST_IDENTIFIER, AST_ID, AST_NONE, AST_NIL own no memory
+            break;
+        }
+
+        // the emptied node becomes a list cell for the operands after the first one
+        if (second == NULL) {
+            second = third;
+            third = NULL;
+        }
+        if (second != NULL) {
+            expr->operands.ternary_op.condition = second;
+            expr->operands.ternary_op.if_true = third;
+            expr->operands.ternary_op.if_false = pending;
+            pending = expr;
+        } else {
+            free(expr);
+        }
+        expr = first;
     }
-    
-    if(expr->type != AST_VALUE) {
-        ast_expression_dispose(expr->operands.binary_op.left);
-        ast_expression_dispose(expr->operands.binary_op.right);
-        return;
-    } 
-    free(expr);
+}
+
+/// @brief Number of operands of an expression walked as values
+/// @param expr expression node
+/// @return 1 for unary operators and `is` (its type name is not a value), 2 for binary, 3 for ternary, else 0
+int ast_expression_operand_count(ast_expression expr) {
+    switch (expr->type) {
+    case AST_NOT:
+    case AST_NOT_NULL:
+    case AST_IS:
+        return 1;
+    case AST_TERNARY:
+        return 3;
+    case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV:
+    case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE: case AST_GT: case AST_GE:
+    case AST_AND: case AST_OR: case AST_CONCAT:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+/// @brief Operand of an expression in evaluation order
+/// @param expr expression node
+/// @param index index of the operand, below ast_expression_operand_count()
+/// @return the operand, may be NULL
+ast_expression ast_expression_operand(ast_expression expr, int index) {
+    switch (expr->type) {
+    case AST_NOT:
+    case AST_NOT_NULL:
+        return expr->operands.unary_op.expression;
+    case AST_TERNARY:
+        return index == 0 ? expr->operands.ternary_op.condition :
+               index == 1 ? expr->operands.ternary_op.if_true : expr->operands.ternary_op.if_false;
+    default:
+        return index == 0 ? expr->operands.binary_op.left : expr->operands.binary_op.right;
+    }
+}
+
+/// @brief Starts a walk of an expression tree
+/// @param walk walk to initialize, freed by ast_walk_free()
+/// @param root root of the tree, may be NULL
+void ast_walk_init(ast_walk *walk, ast_expression root) {
+    walk->frames = NULL;
+    walk->count = 0;
+    walk->capacity = 0;
+    walk->leaving = false;
+    walk->failed = false;
+    walk->root = root;
+}
+
+/// @brief Pushes a node entered by the walk
+/// @return false when out of memory, the walk is then ended
+static bool ast_walk_push(ast_walk *walk, ast_expression node) {
+    if (walk->count == walk->capacity) {
+        size_t capacity = walk->capacity ? 2 * walk->capacity : 64;
+        ast_walk_frame *frames = realloc(walk->frames, capacity * sizeof *frames);
+        if (frames == NULL) {
+            walk->failed = true;
+            walk->count = 0;
+            return false;
+        }
+        walk->frames = frames;
+        walk->capacity = capacity;
+    }
+    walk->frames[walk->count].node = node;
+    walk->frames[walk->count].next = 0;
+    walk->frames[walk->count].end = ast_expression_operand_count(node);
+    walk->count++;
+    walk->leaving = false;
+    return true;
+}
+
+/// @brief Next event of the walk: a node entered before its operands or left after them
+/// @param walk walk started by ast_walk_init()
+/// @return the node, walk->leaving tells the event; NULL at the end (walk->failed when out of memory)
+ast_expression ast_walk_next(ast_walk *walk) {
+    if (walk->root != NULL) {
+        ast_expression root = walk->root;
+        walk->root = NULL;
+        return ast_walk_push(walk, root) ? root : NULL;
+    }
+    if (walk->count == 0) {
+        return NULL;
+    }
+
+    ast_walk_frame *top = &walk->frames[walk->count - 1];
+    while (top->next < top->end) {
+        ast_expression operand = ast_expression_operand(top->node, top->next++);
+        if (operand != NULL) {
+            return ast_walk_push(walk, operand) ? operand : NULL;
+        }
+    }
+    walk->count--;
+    walk->leaving = true;
+    return top->node;
+}
+
+/// @brief Skips the operands of the node just entered, it is left by the next call of ast_walk_next()
+/// @param walk walk whose last event entered a node
+void ast_walk_skip(ast_walk *walk) {
+    ast_walk_limit(walk, 0);
+}
+
+/// @brief Walks only the first operands of the node just entered (the condition of a ternary operator, ...)
+/// @param walk walk whose last event entered a node
+/// @param count number of operands to walk
+void ast_walk_limit(ast_walk *walk, int count) {
+    ast_walk_frame *top = &walk->frames[walk->count - 1];
+    if (count < top->end) {
+        top->end = count;
+    }
+}
+
+/// @brief Frees the stack of a walk, the walk may be left unfinished
+/// @param walk walk started by ast_walk_init()
+void ast_walk_free(ast_walk *walk) {
+    free(walk->frames);
+    walk->frames = NULL;
+    walk->count = 0;
+    walk->capacity = 0;
 }
 
 /// @brief Prints the AST
@@ -456,6 +637,8 @@ void ast_print_node(ast_node node, char *offset) {
                     printf("%f", parameter->value.double_value);
                 else if (parameter->value_type == AST_VALUE_NULL)
                     printf("Null value");
+                else if (parameter->value_type == AST_VALUE_EXPRESSION)
+                    printf("(expression)");
                 else
                     printf("%s", parameter->value.string_value);
                 parameter = parameter->next;
@@ -483,6 +666,8 @@ void ast_print_node(ast_node node, char *offset) {
                     printf("%f", parameter->value.double_value);
                 else if (parameter->value_type == AST_VALUE_NULL)
                     printf("Null value");
+                else if (parameter->value_type == AST_VALUE_EXPRESSION)
+                    printf("(expression)");
                 else
                     printf("%s", parameter->value.string_value);
                 parameter = parameter->next;
@@ -544,6 +729,8 @@ void ast_print_node(ast_node node, char *offset) {
                     printf("%f", parameter->value.double_value);
                 else if (parameter->value_type == AST_VALUE_NULL)
                     printf("Null value");
+                else if (parameter->value_type == AST_VALUE_EXPRESSION)
+                    printf("(expression)");
                 else
                     printf("%s", parameter->value.string_value);
                 parameter = parameter->next;
@@ -586,6 +773,8 @@ char *get_operator_symbol(ast_expression_type type) {
         return ">=";
     case AST_IS:
         return "is";
+    case AST_TERNARY:
+        return "?:";
     case AST_VALUE:
         return "VALUE";
     case AST_IDENTIFIER:
@@ -650,6 +839,8 @@ void ast_print_expression(ast_expression expr, char *offset) {
                         printf("%f", parameter->value.double_value);
                     else if (parameter->value_type == AST_VALUE_NULL)
                         printf("Null value");
+                    else if (parameter->value_type == AST_VALUE_EXPRESSION)
+                        printf("(expression)");
                     else
                         printf("%s", parameter->value.string_value);
                     parameter = parameter->next;
@@ -672,6 +863,8 @@ void ast_print_expression(ast_expression expr, char *offset) {
                         printf("%f", parameter->value.double_value);
                     else if (parameter->value_type == AST_VALUE_NULL)
                         printf("Null value");
+                    else if (parameter->value_type == AST_VALUE_EXPRESSION)
+                        printf("(expression)");
                     else
                         printf("%s", parameter->value.string_value);
                     parameter = parameter->next;
@@ -681,7 +874,11 @@ void ast_print_expression(ast_expression expr, char *offset) {
                 }
             }
         printf(")\n");
-        } 
+        } else if(expr->type == AST_TERNARY) {
+                ast_print_expression(expr->operands.ternary_op.condition, newOffset);
+                ast_print_expression(expr->operands.ternary_op.if_true, newOffset);
+                ast_print_expression(expr->operands.ternary_op.if_false, newOffset);
+        }
         else {
                 ast_print_expression(expr->operands.binary_op.left, newOffset);
                 ast_print_expression(expr->operands.binary_op.right, newOffset);
@@ -9,6 +9,9 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "string.h"
 
 /// @brief Definition of all AST node types
@@ -63,10 +66,12 @@ typedef enum {
     AST_VALUE_FLOAT,
     AST_VALUE_STRING,
     AST_VALUE_NULL,
-    AST_VALUE_IDENTIFIER
+    AST_VALUE_IDENTIFIER,
+    AST_VALUE_EXPRESSION
 } ast_value_type;
 
 /// @brief Definition of AST parameter
+/// Call arguments other than a single literal or identifier are AST_VALUE_EXPRESSION (FUNEXP)
 typedef struct ast_parameter {
     ast_value_type value_type;
     union {
@@ -74,6 +79,7 @@ typedef struct ast_parameter {
         double double_value;
         char *string_value;
     } value;
+    struct ast_expression *expression;
     char *cg_name;
     struct ast_parameter *next;
 } *ast_parameter;
@@ -89,6 +95,11 @@ typedef struct ast_expression {
         struct ast_unary_operation {
             struct ast_expression *expression;
         } unary_op;
+        struct ast_ternary_operation {
+            struct ast_expression *condition;
+            struct ast_expression *if_true;
+            struct ast_expression *if_false;
+        } ternary_op;
         struct ast_value {
             ast_value_type value_type;
             union {
@@ -187,10 +198,17 @@ typedef struct ast_import {
     char *alias;
 } *ast_import;
 
+/// @brief String made after parsing (folded literal), the tokens own all the others
+typedef struct ast_string {
+    struct ast_string *next;
+    char value[];
+} *ast_string;
+
 /// @brief Definition of the AST
 typedef struct ast {
     struct ast_import *import;
     struct ast_class *class_list;
+    struct ast_string *strings;  // freed with the tree
 } *ast;
 
 /// @brief list of classes
@@ -233,6 +251,12 @@ void ast_block_parent(ast_class *class_node);
 /// @param type type of the AST node to be created
 void ast_add_new_node(ast_class *class_node, enum ast_node_type type);
 
+/// @brief Copies a string into the tree, the copy lives until ast_dispose()
+/// @param tree pointer to the AST
+/// @param value string to copy
+/// @return the copy, NULL on allocation failure
+char *ast_string_copy(ast tree, const char *value);
+
 /// @brief Disposes of the AST
 /// @param tree pointer to the AST
 void ast_dispose(ast tree);
@@ -249,10 +273,68 @@ void ast_block_dispose(ast_block block_node);
 /// @param node pointer to the AST node
 void ast_node_dispose(ast_node node);
 
-/// @brief Disposes of an expression node
+/// @brief Disposes of an expression node and its operands, without recursion
 /// @param expr pointer to the expression node
 void ast_expression_dispose(ast_expression expr);
 
+/// @brief Disposes of a list of parameters or call arguments
+/// @param param first parameter of the list
+void ast_parameters_dispose(ast_parameter param);
+
+/// @brief Frame of an expression walk: node, index of its next operand and of the first one not walked
+typedef struct ast_walk_frame {
+    ast_expression node;
+    int next;
+    int end;
+} ast_walk_frame;
+
+/// @brief Walk of an expression tree with an explicit stack on the heap
+/// Every node is returned twice: entered before its operands and left after them.
+/// The operands are walked in evaluation order, the type name right of `is` and the
+/// arguments of calls are not. The depth of the tree is limited by memory only.
+typedef struct ast_walk {
+    ast_walk_frame *frames;
+    size_t count;
+    size_t capacity;
+    ast_expression root;   // root not entered yet
+    bool leaving;          // the last node returned is being left
+    bool failed;           // the walk ended early, out of memory
+} ast_walk;
+
+/// @brief Number of operands of an expression walked as values
+/// @param expr expression node
+/// @return 1 for unary operators and `is`, 2 for binary operators, 3 for ternary, 0 otherwise
+int ast_expression_operand_count(ast_expression expr);
+
+/// @brief Operand of an expression in evaluation order
+/// @param expr expression node
+/// @param index index of the operand, below ast_expression_operand_count()
+/// @return the operand, may be NULL
+ast_expression ast_expression_operand(ast_expression expr, int index);
+
+/// @brief Starts a walk of an expression tree
+/// @param walk walk to initialize, freed by ast_walk_free()
+/// @param root root of the tree, may be NULL
+void ast_walk_init(ast_walk *walk, ast_expression root);
+
+/// @brief Next event of the walk: a node entered before its operands or left after them
+/// @param walk walk started by ast_walk_init()
+/// @return the node, walk->leaving tells the event; NULL at the end (walk->failed when out of memory)
+ast_expression ast_walk_next(ast_walk *walk);
+
+/// @brief Skips the operands of the node just entered, it is left by the next call of ast_walk_next()
+/// @param walk walk whose last event entered a node
+void ast_walk_skip(ast_walk *walk);
+
+/// @brief Walks only the first operands of the node just entered (the condition of a ternary operator, ...)
+/// @param walk walk whose last event entered a node
+/// @param count number of operands to walk
+void ast_walk_limit(ast_walk *walk, int count);
+
+/// @brief Frees the stack of a walk, the walk may be left unfinished
+/// @param walk walk started by ast_walk_init()
+void ast_walk_free(ast_walk *walk);
+
 /// @brief Prints the AST
 /// @param tree pointer to the AST
 void ast_print(ast tree);
@@ -0,0 +1,303 @@
+/**
+ * @file budget.c
+ * @brief Optimisation budget of one compilation (--opt-budget=MS).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "options.h"
+
+#define BUDGET_LABEL      64
+#define BUDGET_VALUE_MAX  (1ULL << 30)  // estimates are capped, products of two fit in 64 bits
+#define BUDGET_NEST_MAX   4             // deeper loops weigh as much as this nesting
+
+// Estimated steps of the passes (per node, local or call)
+#define COST_CONSTEVAL_CALL  500   // evaluation of one call, most stop far below CONSTEVAL_MAX_STEPS
+#define COST_CSE_NODE        4     // value numbering: hashing and lookups per node
+#define COST_SLOTS_NODE      2     // liveness walk per node, plus locals² for the interference
+#define COST_VERSION_NODE    8     // loop analysis and the second copy of the loop
+
+// Name of the pass 1 << i, its cost and benefit are at index i
+static const char *pass_names[BUDGET_PASSES] = { "consteval", "cse", "slots", "versioning", "unroll" };
+
+/**
+ * @brief Size of one function, counted before any pass rewrites it.
+ */
+typedef struct fn_profile {
+    unsigned long long nodes;        // statements and expression nodes
+    unsigned long long operations;   // operators
+    unsigned long long op_weight;    // operators weighted by the loop nesting
+    unsigned long long locals;       // declared locals
+    unsigned long long loops;        // while loops
+    unsigned long long loop_nodes;   // nodes inside loops (copied by versioning and unrolling)
+    unsigned long long loop_weight;  // nodes inside loops weighted by the nesting
+    unsigned long long calls;        // user calls with literal arguments
+    unsigned long long call_weight;  // of them, weighted by the nesting
+    unsigned depth;                  // loop nesting of the node being counted
+} fn_profile;
+
+/**
+ * @brief Schedule of one function.
+ */
+typedef struct budget_entry {
+    ast_node function;               // node of the whole-program plan, NULL when planned on arrival
+    char label[BUDGET_LABEL];        // name$arity, name$get or name$set
+    unsigned applicable;             // passes with something to do in the function
+    unsigned granted;                // passes that fit in the budget
+    unsigned long long cost[BUDGET_PASSES];
+    unsigned long long benefit[BUDGET_PASSES];
+} budget_entry;
+
+typedef struct {
+    size_t entry;
+    unsigned pass;
+} budget_item;
+
+static budget_entry *table = NULL;
+static size_t table_count = 0;
+static size_t table_capacity = 0;
+static bool planned = false;               // budget_plan() saw the whole program
+static unsigned long long remaining = 0;   // steps left, set by the first plan
+
+// ------------------------------------------------------------------ profile
+
+static unsigned long long nest_weight(unsigned depth) {
+    return 1ULL << (2 * (depth < BUDGET_NEST_MAX ? depth : BUDGET_NEST_MAX));
+}
+
+static unsigned long long capped(unsigned long long v) {
+    return v < BUDGET_VALUE_MAX ? v : BUDGET_VALUE_MAX;
+}
+
+static void count_node(fn_profile *p) {
+    p->nodes++;
+    if (p->depth == 0) return;
+    p->loop_nodes++;
+    p->loop_weight += nest_weight(p->depth);
+}
+
+static bool literal_args(ast_parameter p) {
+    for (; p; p = p->next)
+        if (p->value_type == AST_VALUE_IDENTIFIER || p->value_type == AST_VALUE_EXPRESSION) return false;
+    return true;
+}
+
+static void profile_expr(fn_profile *p, ast_expression expr);
+
+static void profile_params(fn_profile *p, ast_parameter param) {
+    for (; param; param = param->next)
+        if (param->value_type == AST_VALUE_EXPRESSION) profile_expr(p, param->expression);
+}
+
+static void profile_expr(fn_profile *p, ast_expression expr) {
+    if (expr == NULL) return;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        count_node(p);
+        if (e->type >= AST_ADD) {  // binary and ternary operators end the enum
+            p->operations++;
+            p->op_weight += nest_weight(p->depth);
+        } else if (e->type == AST_FUNCTION_CALL) {
+            ast_parameter args = e->operands.function_call->parameters;
+            if (literal_args(args)) {
+                p->calls++;
+                p->call_weight += nest_weight(p->depth);
+            }
+            profile_params(p, args);
+        } else if (e->type == AST_IFJ_FUNCTION_EXPR) {
+            profile_params(p, e->operands.ifj_function->parameters);
+        }
+    }
+    ast_walk_free(&walk);
+}
+
+static void profile_block(fn_profile *p, ast_block block) {
+    if (block == NULL) return;
+    for (ast_node node = block->first; node; node = node->next) {
+        count_node(p);
+        switch (node->type) {
+            case AST_VAR_DECLARATION: p->locals++; break;
+            case AST_ASSIGNMENT: profile_expr(p, node->data.assignment.value); break;
+            case AST_RETURN: profile_expr(p, node->data.return_expr.output); break;
+            case AST_CALL_FUNCTION: profile_params(p, node->data.function_call->parameters); break;
+            case AST_IFJ_FUNCTION: profile_params(p, node->data.ifj_function->parameters); break;
+            case AST_CONDITION:
+                profile_expr(p, node->data.condition.condition);
+                profile_block(p, node->data.condition.if_branch);
+                profile_block(p, node->data.condition.else_branch);
+                break;
+            case AST_WHILE_LOOP:
+                p->loops++;
+                p->depth++;
+                profile_expr(p, node->data.while_loop.condition);
+                profile_block(p, node->data.while_loop.body);
+                p->depth--;
+                break;
+            case AST_BLOCK: profile_block(p, node->data.block); break;
+            default: break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------- schedule
+
+static void set_pass(budget_entry *e, unsigned index, unsigned long long cost, unsigned long long benefit) {
+    e->applicable |= 1u << index;
+    e->cost[index] = capped(cost);
+    e->benefit[index] = capped(benefit);
+}
+
+// Cost and benefit of every pass with something to do in the function
+static void estimate(budget_entry *e, ast_block body) {
+    fn_profile p;
+    memset(&p, 0, sizeof p);
+    profile_block(&p, body);
+
+    if (p.calls > 0)
+        set_pass(e, 0, p.calls * COST_CONSTEVAL_CALL, p.call_weight * 32);
+    if (p.operations > 1)
+        set_pass(e, 1, p.nodes * COST_CSE_NODE, p.op_weight);
+    if (p.locals > 0)
+        set_pass(e, 2, p.nodes * COST_SLOTS_NODE + p.locals * p.locals, p.locals * 4);
+    if (p.loops > 0) {
+        set_pass(e, 3, p.loop_nodes * COST_VERSION_NODE, p.loop_weight * 2);
+        if (options.unroll > 1 && !options.size)
+            set_pass(e, 4, p.loop_nodes * options.unroll * 2, p.loop_weight);
+    }
+}
+
+static budget_entry *add_entry(ast_node node) {
+    if (table_count == table_capacity) {
+        size_t grown = table_capacity ? 2 * table_capacity : 16;
+        budget_entry *more = realloc(table, grown * sizeof *more);
+        if (more == NULL) return NULL;
+        table = more;
+        table_capacity = grown;
+    }
+    budget_entry *e = &table[table_count++];
+    memset(e, 0, sizeof *e);
+    e->function = node;
+
+    ast_block body = NULL;
+    if (node->type == AST_FUNCTION) {
+        unsigned arity = 0;
+        for (ast_parameter p = node->data.function->parameters; p; p = p->next) arity++;
+        snprintf(e->label, BUDGET_LABEL, "%s$%u", node->data.function->name, arity);
+        body = node->data.function->code;
+    } else if (node->type == AST_GETTER) {
+        snprintf(e->label, BUDGET_LABEL, "%s$get", node->data.getter.name);
+        body = node->data.getter.body;
+    } else {
+        snprintf(e->label, BUDGET_LABEL, "%s$set", node->data.setter.name);
+        body = node->data.setter.body;
+    }
+    estimate(e, body);
+    return e;
+}
+
+// Higher benefit per cost first: b1/c1 > b2/c2 as b1*c2 > b2*c1, ties in source and pass order
+static int compare_items(const void *a, const void *b) {
+    const budget_item *x = a, *y = b;
+    const budget_entry *ex = &table[x->entry], *ey = &table[y->entry];
+    unsigned long long left = ex->benefit[x->pass] * (ey->cost[y->pass] + 1);
+    unsigned long long right = ey->benefit[y->pass] * (ex->cost[x->pass] + 1);
+    if (left != right) return left > right ? -1 : 1;
+    if (x->entry != y->entry) return x->entry < y->entry ? -1 : 1;
+    return (int)x->pass - (int)y->pass;
+}
+
+static void start_budget(void) {
+    if (table_count == 0 && !planned)
+        remaining = (unsigned long long)options.opt_budget * BUDGET_STEPS_PER_MS;
+}
+
+// Grants the passes of entries [first, table_count) while they fit in the rest of the budget
+static void schedule(size_t first) {
+    size_t count = 0;
+    for (size_t i = first; i < table_count; i++)
+        for (unsigned pass = 0; pass < BUDGET_PASSES; pass++)
+            if (table[i].applicable & (1u << pass)) count++;
+    if (count == 0) return;
+    budget_item *items = malloc(count * sizeof *items);
+    if (items == NULL) return;  // nothing granted, the cheap passes still run
+    count = 0;
+    for (size_t i = first; i < table_count; i++)
+        for (unsigned pass = 0; pass < BUDGET_PASSES; pass++)
+            if (table[i].applicable & (1u << pass)) items[count++] = (budget_item){ i, pass };
+    qsort(items, count, sizeof *items, compare_items);
+
+    for (size_t i = 0; i < count; i++) {
+        budget_entry *e = &table[items[i].entry];
+        unsigned long long cost = e->cost[items[i].pass];
+        if (cost > remaining) continue;
+        remaining -= cost;
+        e->granted |= 1u << items[i].pass;
+        opt_stats.budget_steps += (unsigned)cost;
+    }
+    free(items);
+}
+
+// ------------------------------------------------------------------ public API
+
+void budget_plan(ast tree) {
+    if (options.opt_budget < 0 || tree == NULL || tree->class_list == NULL) return;
+    start_budget();
+    planned = true;
+    for (ast_node node = tree->class_list->current->first; node; node = node->next)
+        if (node->type == AST_FUNCTION || node->type == AST_GETTER || node->type == AST_SETTER)
+            add_entry(node);
+    schedule(0);
+}
+
+unsigned budget_passes(ast_node function) {
+    if (options.opt_budget < 0) return BUDGET_ALL;
+    if (planned) {
+        for (size_t i = 0; i < table_count; i++)
+            if (table[i].function == function) return table[i].granted;
+        return 0;
+    }
+    // --stream: the function is scheduled alone, the tree of the next one may reuse its memory
+    start_budget();
+    budget_entry *e = add_entry(function);
+    if (e == NULL) return 0;
+    e->function = NULL;
+    schedule(table_count - 1);
+    return table[table_count - 1].granted;
+}
+
+void budget_reset(void) {
+    free(table);
+    table = NULL;
+    table_count = table_capacity = 0;
+    planned = false;
+    remaining = 0;
+}
+
+void budget_report(FILE *out) {
+    if (options.opt_budget < 0) return;
+    for (size_t i = 0; i < table_count; i++) {
+        budget_entry *e = &table[i];
+        fprintf(out, "budget %s: ran=", e->label);
+        const char *sep = "";
+        for (unsigned pass = 0; pass < BUDGET_PASSES; pass++)
+            if (e->granted & (1u << pass)) {
+                fprintf(out, "%s%s", sep, pass_names[pass]);
+                sep = ",";
+            }
+        fprintf(out, "%s skipped=", *sep ? "" : "-");
+        sep = "";
+        for (unsigned pass = 0; pass < BUDGET_PASSES; pass++)
+            if ((e->applicable & ~e->granted) & (1u << pass)) {
+                fprintf(out, "%s%s", sep, pass_names[pass]);
+                sep = ",";
+            }
+        fprintf(out, "%s\n", *sep ? "" : "-");
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file budget.h
+ * @brief Optimisation budget of one compilation (--opt-budget=MS).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_BUDGET
+#define IFJ_BUDGET
+
+#include <stdio.h>
+#include "ast.h"
+
+#define BUDGET_STEPS_PER_MS 20000 // estimated steps of one millisecond (the passes on a 3 GHz x86-64)
+
+/**
+ * @brief Expensive optimisations, scheduled per function.
+ *
+ * The cheap ones always run: induction variables, constant conditions, if/else-if
+ * decision trees, the analysis of the globals, the control-flow simplification and
+ * the -Os compaction.
+ */
+typedef enum budget_pass {
+    BUDGET_CONSTEVAL  = 1 << 0,  // compile-time evaluation of pure calls (consteval.c)
+    BUDGET_CSE        = 1 << 1,  // common subexpressions of basic blocks (cse.c)
+    BUDGET_SLOTS      = 1 << 2,  // locals sharing frame slots (liveness.c)
+    BUDGET_VERSIONING = 1 << 3,  // typed copies of loops (loops.c)
+    BUDGET_UNROLL     = 1 << 4   // unrolled counted loops
+} budget_pass;
+
+#define BUDGET_PASSES 5
+#define BUDGET_ALL    ((1u << BUDGET_PASSES) - 1)
+
+/**
+ * @brief Schedules the expensive passes of all functions of the program.
+ *
+ * The cost of a pass on a function is estimated from the size of the function
+ * (statements and expression nodes, loops, locals, calls with literal arguments),
+ * its benefit from the same counts weighted by the loop nesting. Passes are granted
+ * in the order of benefit per cost, ties in source order, while their cost fits in
+ * the rest of the budget. The estimates count steps, not time, so a budget gives the
+ * same code on every machine. Does nothing without --opt-budget.
+ *
+ * @param tree program after semantic analysis, before any pass rewrites it
+ */
+void budget_plan(ast tree);
+
+/**
+ * @brief Passes granted to a function (bits of @ref budget_pass).
+ *
+ * BUDGET_ALL without --opt-budget. A function budget_plan() did not see (--stream)
+ * is scheduled on its own with the rest of the budget, once per call.
+ *
+ * @param function AST_FUNCTION, AST_GETTER or AST_SETTER node
+ */
+unsigned budget_passes(ast_node function);
+
+/**
+ * @brief Forgets the schedule of the last compilation.
+ */
+void budget_reset(void);
+
+/**
+ * @brief Prints the passes run and skipped for every function, one line each (--stats).
+ *
+ * @param out output stream
+ */
+void budget_report(FILE *out);
+
+#endif /* IFJ_BUDGET */
@@ -0,0 +1,405 @@
+/**
+ * @file cfg.c
+ * @brief Control-flow simplification of the emitted IFJcode25 (-O1).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "cfg.h"
+#include "options.h"
+
+#define CFG_ROUNDS 8                  // simplification rounds, one or two are enough for generated code
+#define CFG_MAX_CODE ((size_t)128 << 20)  // larger programs are left as they are, the index would outgrow them
+
+typedef enum {
+    LINE_NOTE,    // comments and blank lines
+    LINE_LABEL,   // LABEL name
+    LINE_JUMP,    // JUMP name
+    LINE_BRANCH,  // JUMPIFEQ/JUMPIFNEQ name a b
+    LINE_CALL,    // CALL name
+    LINE_END,     // RETURN, EXIT
+    LINE_CODE     // other instructions (and comments), continue with the next line
+} line_kind;
+
+// One line of the program, or a run of plain lines (LINE_NOTE, LINE_CODE);
+// the live lines form a list in program order
+typedef struct {
+    const char *text;  // without the last newline
+    size_t len;
+    unsigned size;     // instructions
+    size_t name_at;    // label operand text[name_at, name_at + name_len)
+    size_t name_len;
+    line_kind kind;
+    int label;         // defined or referenced label, -1 if none
+    int prev, next;    // neighbours in the list, -1 at the ends
+    int at;            // labels and comments: the next instruction; removed lines: the next line
+    int run;           // labels and comments: first line of their run
+    bool removed, reached, queued;
+} cfg_line;
+
+typedef struct {
+    const char *name;
+    size_t len;
+    int def;   // its LABEL line, -1 if not defined in the program
+    int refs;  // jumps and calls to it
+} cfg_label;
+
+typedef struct {
+    cfg_line *lines;
+    int count;
+    int head;
+    cfg_label *labels;
+    int label_count, label_cap;
+    int *slots;  // label ids by name hash, open addressing, -1 free
+    size_t slot_cap;
+} cfg;
+
+static size_t hash_name(const char *s, size_t len) {
+    size_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) { h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h;
+}
+
+static bool slots_grow(cfg *c) {
+    if ((size_t)(c->label_count + 1) * 2 <= c->slot_cap) return true;
+    size_t cap = c->slot_cap ? c->slot_cap * 2 : 256;
+    int *slots = malloc(cap * sizeof *slots);
+    if (slots == NULL) return false;
+    for (size_t i = 0; i < cap; i++) slots[i] = -1;
+    for (int id = 0; id < c->label_count; id++) {
+        size_t j = hash_name(c->labels[id].name, c->labels[id].len) & (cap - 1);
+        while (slots[j] >= 0) j = (j + 1) & (cap - 1);
+        slots[j] = id;
+    }
+    free(c->slots);
+    c->slots = slots;
+    c->slot_cap = cap;
+    return true;
+}
+
+// Id of the label name[0..len), a new one on the first use; -1 on allocation failure
+static int label_id(cfg *c, const char *name, size_t len) {
+    if (!slots_grow(c)) return -1;
+    size_t j = hash_name(name, len) & (c->slot_cap - 1);
+    for (; c->slots[j] >= 0; j = (j + 1) & (c->slot_cap - 1)) {
+        cfg_label *l = &c->labels[c->slots[j]];
+        if (l->len == len && strncmp(l->name, name, len) == 0) return c->slots[j];
+    }
+    if (c->label_count == c->label_cap) {
+        int cap = c->label_cap ? c->label_cap * 2 : 256;
+        cfg_label *labels = realloc(c->labels, cap * sizeof *labels);
+        if (labels == NULL) return -1;
+        c->labels = labels;
+        c->label_cap = cap;
+    }
+    c->labels[c->label_count] = (cfg_label){ name, len, -1, 0 };
+    c->slots[j] = c->label_count;
+    return c->label_count++;
+}
+
+static bool token_is(const char *token, size_t len, const char *word) {
+    return strlen(word) == len && strncmp(token, word, len) == 0;
+}
+
+// Kind and label operand of one line
+static bool parse_line(cfg *c, cfg_line *line) {
+    const char *p = line->text, *end = line->text + line->len;
+    line->kind = LINE_NOTE;
+    line->label = -1;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p == end || *p == '#') return true;
+
+    const char *op = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') p++;
+    size_t op_len = (size_t)(p - op);
+    if (token_is(op, op_len, "RETURN") || token_is(op, op_len, "EXIT")) line->kind = LINE_END;
+    else if (token_is(op, op_len, "LABEL")) line->kind = LINE_LABEL;
+    else if (token_is(op, op_len, "JUMP")) line->kind = LINE_JUMP;
+    else if (token_is(op, op_len, "JUMPIFEQ") || token_is(op, op_len, "JUMPIFNEQ")) line->kind = LINE_BRANCH;
+    else if (token_is(op, op_len, "CALL")) line->kind = LINE_CALL;
+    else {
+        line->kind = LINE_CODE;
+        return true;
+    }
+    if (line->kind == LINE_END) return true;
+
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char *name = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') p++;
+    line->name_at = (size_t)(name - line->text);
+    line->name_len = (size_t)(p - name);
+    line->label = label_id(c, name, line->name_len);
+    return line->label >= 0;
+}
+
+static bool is_plain(cfg_line *line) {
+    return line->kind == LINE_NOTE || line->kind == LINE_CODE;
+}
+
+static bool cfg_read(cfg *c, const char *code) {
+    int cap = 0;
+    for (const char *line = code; *line; ) {
+        const char *end = strchr(line, '\n');
+        if (end == NULL) end = line + strlen(line);
+        cfg_line next = { .text = line, .len = (size_t)(end - line), .prev = c->count - 1, .next = -1 };
+        if (!parse_line(c, &next)) return false;
+        next.size = next.kind != LINE_NOTE;
+        line = *end ? end + 1 : end;
+
+        // Plain lines are kept as one run, nothing jumps between them
+        cfg_line *last = c->count > 0 ? &c->lines[c->count - 1] : NULL;
+        if (last != NULL && is_plain(last) && is_plain(&next)) {
+            last->len = (size_t)(end - last->text);
+            last->size += next.size;
+            if (next.kind == LINE_CODE) last->kind = LINE_CODE;
+            continue;
+        }
+        if (c->count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            cfg_line *lines = realloc(c->lines, cap * sizeof *lines);
+            if (lines == NULL) return false;
+            c->lines = lines;
+        }
+        c->lines[c->count] = next;
+        if (c->count > 0) c->lines[c->count - 1].next = c->count;
+        if (next.kind == LINE_LABEL && c->labels[next.label].def < 0) c->labels[next.label].def = c->count;
+        c->count++;
+    }
+    c->head = c->count > 0 ? 0 : -1;
+    return true;
+}
+
+static void unlink_range(cfg *c, int first, int last) {
+    int before = c->lines[first].prev, after = c->lines[last].next;
+    if (before >= 0) c->lines[before].next = after;
+    else c->head = after;
+    if (after >= 0) c->lines[after].prev = before;
+}
+
+static bool is_note(cfg_line *line) {
+    return line->kind == LINE_NOTE || line->kind == LINE_LABEL;
+}
+
+static void remove_line(cfg *c, int i) {
+    cfg_line *line = &c->lines[i];
+    unlink_range(c, i, i);
+    line->removed = true;
+    line->at = line->next;
+    if (line->kind == LINE_LABEL && c->labels[line->label].def == i) c->labels[line->label].def = -1;
+}
+
+// Next instruction and run start of the labels and comments, long runs are walked once per step
+static void index_lines(cfg *c) {
+    int pending = -1;
+    for (int i = c->head; i >= 0; i = c->lines[i].next) {
+        cfg_line *line = &c->lines[i];
+        if (is_note(line)) {
+            int prev = line->prev;
+            line->run = prev >= 0 && is_note(&c->lines[prev]) ? c->lines[prev].run : i;
+            if (pending < 0) pending = i;
+            continue;
+        }
+        for (; pending >= 0 && pending != i; pending = c->lines[pending].next) c->lines[pending].at = i;
+        pending = -1;
+    }
+    for (; pending >= 0; pending = c->lines[pending].next) c->lines[pending].at = -1;
+}
+
+// First instruction at or after line i, labels and comments are skipped
+static int next_instruction(cfg *c, int i) {
+    while (i >= 0 && (c->lines[i].removed || is_note(&c->lines[i]))) i = c->lines[i].at;
+    return i;
+}
+
+static int target_instruction(cfg *c, int label) {
+    return next_instruction(c, c->labels[label].def);
+}
+
+// Jumps to a `JUMP L` go to L directly
+static bool thread_jumps(cfg *c) {
+    bool changed = false;
+    for (int i = c->head; i >= 0; i = c->lines[i].next) {
+        cfg_line *line = &c->lines[i];
+        if ((line->kind != LINE_JUMP && line->kind != LINE_BRANCH) || c->labels[line->label].def < 0) continue;
+        int target = line->label;
+        int at = target_instruction(c, target);
+        for (int hops = 0; at >= 0 && c->lines[at].kind == LINE_JUMP && hops < c->label_count; hops++) {
+            int further = c->lines[at].label;
+            if (further == target || c->labels[further].def < 0) break;
+            target = further;
+            at = target_instruction(c, target);
+        }
+        if (target != line->label) {
+            line->label = target;
+            opt_stats.jumps_threaded++;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Removes the lines not reachable from the start of the program or a called label
+static bool drop_unreachable(cfg *c) {
+    int *work = malloc((c->count + 1) * sizeof *work);
+    if (work == NULL) return false;  // nothing is removed
+    int pending = 0;
+    for (int i = c->head; i >= 0; i = c->lines[i].next) c->lines[i].reached = c->lines[i].queued = false;
+    if (c->head >= 0) work[pending++] = c->head;
+    while (pending > 0) {
+        for (int i = work[--pending]; i >= 0 && !c->lines[i].reached; ) {
+            cfg_line *line = &c->lines[i];
+            line->reached = true;
+            if (line->kind == LINE_JUMP || line->kind == LINE_BRANCH || line->kind == LINE_CALL) {
+                int def = c->labels[line->label].def;
+                if (def >= 0 && !c->lines[def].queued) {  // each label line is queued once
+                    c->lines[def].queued = true;
+                    work[pending++] = def;
+                }
+            }
+            i = line->kind == LINE_JUMP || line->kind == LINE_END ? -1 : line->next;
+        }
+    }
+    free(work);
+
+    bool changed = false;
+    for (int i = c->head, next; i >= 0; i = next) {
+        next = c->lines[i].next;
+        if (c->lines[i].reached) continue;
+        if (c->lines[i].kind == LINE_NOTE && next >= 0 && c->lines[next].reached) continue;  // heading of live code
+        if (c->lines[i].kind != LINE_LABEL) opt_stats.dead_instructions += c->lines[i].size;
+        remove_line(c, i);
+        changed = true;
+    }
+    return changed;
+}
+
+// A `JUMP` to the instruction that follows anyway
+static bool drop_fallthrough_jumps(cfg *c) {
+    bool changed = false;
+    for (int i = c->head, next; i >= 0; i = next) {
+        next = c->lines[i].next;
+        cfg_line *line = &c->lines[i];
+        if (line->kind != LINE_JUMP || c->labels[line->label].def < 0) continue;
+        if (next_instruction(c, next) != target_instruction(c, line->label)) continue;
+        remove_line(c, i);
+        opt_stats.jumps_removed++;
+        changed = true;
+    }
+    return changed;
+}
+
+// A block only jumped to and left by JUMP/RETURN/EXIT is moved behind a `JUMP` to it
+static bool merge_blocks(cfg *c) {
+    bool changed = false;
+    for (int i = c->head, next; i >= 0; i = next) {
+        next = c->lines[i].next;
+        cfg_line *line = &c->lines[i];
+        if (line->kind != LINE_JUMP || c->labels[line->label].def < 0) continue;
+
+        // The block starts with the labels (and comments) around the target label
+        // A run grown by an earlier move this step starts after a label, it is left for the next round
+        int first = c->lines[c->labels[line->label].def].run;
+        int before = c->lines[first].prev;
+        if (c->lines[first].removed || before < 0 ||
+            (c->lines[before].kind != LINE_JUMP && c->lines[before].kind != LINE_END))
+            continue;
+        int last = first;
+        while (last >= 0 && c->lines[last].kind != LINE_JUMP && c->lines[last].kind != LINE_END) last = c->lines[last].next;
+        if (last < 0 || last == i) continue;
+
+        unlink_range(c, first, last);
+        c->lines[last].next = c->lines[i].next;
+        if (c->lines[i].next >= 0) c->lines[c->lines[i].next].prev = last;
+        c->lines[i].next = first;
+        c->lines[first].prev = i;
+        remove_line(c, i);
+        opt_stats.jumps_removed++;
+        changed = true;
+        next = first;
+    }
+    return changed;
+}
+
+static bool drop_unused_labels(cfg *c) {
+    for (int id = 0; id < c->label_count; id++) c->labels[id].refs = 0;
+    for (int i = c->head; i >= 0; i = c->lines[i].next)
+        if (c->lines[i].kind == LINE_JUMP || c->lines[i].kind == LINE_BRANCH || c->lines[i].kind == LINE_CALL)
+            c->labels[c->lines[i].label].refs++;
+    bool changed = false;
+    for (int i = c->head, next; i >= 0; i = next) {
+        next = c->lines[i].next;
+        if (c->lines[i].kind != LINE_LABEL || c->labels[c->lines[i].label].refs > 0) continue;
+        remove_line(c, i);
+        opt_stats.labels_removed++;
+        changed = true;
+    }
+    return changed;
+}
+
+static bool append_range(string out, const char *s, size_t len) {
+    if (out->length + len <= out->capacity) {  // only threaded labels can make the output longer
+        memcpy(out->data + out->length, s, len);
+        out->length += len;
+        out->data[out->length] = '\0';
+        return true;
+    }
+    for (size_t i = 0; i < len; i++)
+        if (!string_append_char(out, s[i])) return false;
+    return true;
+}
+
+static bool cfg_write(cfg *c, string out) {
+    for (int i = c->head; i >= 0; i = c->lines[i].next) {
+        cfg_line *line = &c->lines[i];
+        bool ok;
+        if (line->label < 0) {
+            ok = append_range(out, line->text, line->len);
+        } else {
+            cfg_label *l = &c->labels[line->label];
+            size_t rest = line->name_at + line->name_len;
+            ok = append_range(out, line->text, line->name_at) && append_range(out, l->name, l->len) &&
+                 append_range(out, line->text + rest, line->len - rest);
+        }
+        if (!ok || !string_append_char(out, '\n')) return false;
+    }
+    return true;
+}
+
+bool cfg_simplify(string code) {
+    if (code->length > CFG_MAX_CODE) return true;
+    cfg c = { NULL, 0, -1, NULL, 0, 0, NULL, 0 };
+    string out = NULL;
+    if (cfg_read(&c, code->data)) {
+        bool changed = true;
+        for (int round = 0; changed && round < CFG_ROUNDS; round++) {
+            index_lines(&c);
+            changed = thread_jumps(&c);
+            changed |= drop_unreachable(&c);
+            changed |= drop_fallthrough_jumps(&c);
+            index_lines(&c);
+            changed |= merge_blocks(&c);
+            changed |= drop_unused_labels(&c);
+        }
+        out = string_create(code->length + 16);
+        if (out != NULL && !cfg_write(&c, out)) {
+            string_destroy(out);
+            out = NULL;
+        }
+    }
+    free(c.lines);
+    free(c.labels);
+    free(c.slots);
+    if (out == NULL) return false;
+
+    // The labels point into the old text until now
+    char *old = code->data;
+    *code = *out;
+    out->data = old;
+    string_destroy(out);
+    return true;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file cfg.h
+ * @brief Control-flow simplification of the emitted IFJcode25 (-O1).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_CFG
+#define IFJ_CFG
+
+#include "string.h"
+
+/**
+ * @brief Threads jump chains, merges blocks and drops dead code and unused labels.
+ *
+ * The program is read as a list of instructions whose control flow is given by
+ * LABEL, JUMP, JUMPIFEQ/JUMPIFNEQ, CALL, RETURN and EXIT. Until nothing changes:
+ *
+ * - a jump to a label whose first instruction is `JUMP L` goes to L directly,
+ * - code not reachable from the start of the program or a CALL target is removed,
+ * - a `JUMP` to the instruction that follows it is removed,
+ * - a block entered only by jumps and ending with JUMP, RETURN or EXIT is moved
+ *   behind a `JUMP` to it, which is then removed,
+ * - labels no jump or call refers to are removed.
+ *
+ * Conditional jumps are retargeted but never removed, their comparison can end
+ * the program with a runtime error. Comments stay with the code around them.
+ * Programs over 128 MiB are left unchanged. The counts go to @ref opt_stats.
+ *
+ * @param code complete program emitted by the code generator, rewritten in place
+ * @return false on allocation failure, @p code is then unchanged
+ */
+bool cfg_simplify(string code);
+
+#endif /* IFJ_CFG */
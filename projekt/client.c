@@ -0,0 +1,127 @@
+/**
+ * @file client.c
+ * @brief Thin client of the compile daemon, same interface as the compiler:
+ *        source on stdin, IFJcode25 on stdout, messages on stderr, exit code.
+ *
+ * Usage: compiler_client [--socket=PATH] [compiler options] < source > code
+ *
+ * @authors Hana Liškařová (xliskah00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "error.h"
+
+static bool read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool write_block(int fd, const char *data, size_t len) {
+    uint32_t n = (uint32_t)len;
+    return write_full(fd, &n, sizeof n) && write_full(fd, data, len);
+}
+
+// Response block copied to a stream
+static bool forward_block(int fd, FILE *out) {
+    uint32_t len;
+    char buf[4096];
+    if (!read_full(fd, &len, sizeof len)) return false;
+    while (len > 0) {
+        size_t chunk = len < sizeof buf ? len : sizeof buf;
+        if (!read_full(fd, buf, chunk)) return false;
+        fwrite(buf, 1, chunk, out);
+        len -= (uint32_t)chunk;
+    }
+    return true;
+}
+
+static char *read_stdin(size_t *len) {
+    size_t cap = 1 << 16;
+    char *data = malloc(cap);
+    *len = 0;
+    while (data) {
+        size_t n = fread(data + *len, 1, cap - *len, stdin);
+        *len += n;
+        if (n == 0) break;
+        if (*len == cap) {
+            char *bigger = realloc(data, cap * 2);
+            if (bigger == NULL) free(data);
+            data = bigger;
+            cap *= 2;
+        }
+    }
+    return data;
+}
+
+static int client_error(const char *msg, const char *arg) {
+    fprintf(stderr, "Error:client: %s%s\n", msg, arg);
+    return ERR_INTERNAL;
+}
+
+int main(int argc, char **argv) {
+    const char *path = getenv(DAEMON_SOCKET_ENV);
+    if (path == NULL) path = DAEMON_SOCKET_DEFAULT;
+    const char *args[DAEMON_MAX_ARGS];
+    uint32_t count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--socket=", 9) == 0) path = argv[i] + 9;
+        else if (count == DAEMON_MAX_ARGS) return client_error("too many options", "");
+        else args[count++] = argv[i];
+    }
+
+    size_t len;
+    char *source = read_stdin(&len);
+    if (source == NULL || len > DAEMON_MAX_SOURCE) return client_error("cannot read the source", "");
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof addr.sun_path) return client_error("socket path too long ", path);
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof addr) != 0)
+        return client_error("no daemon on ", path);
+
+    bool ok = write_full(fd, &count, sizeof count);
+    for (uint32_t i = 0; i < count && ok; i++) ok = write_block(fd, args[i], strlen(args[i]));
+    ok = ok && write_block(fd, source, len);
+    free(source);
+
+    int32_t code;
+    ok = ok && read_full(fd, &code, sizeof code) && forward_block(fd, stdout) && forward_block(fd, stderr);
+    close(fd);
+    if (!ok) return client_error("request failed on ", path);  // e.g. the daemon stopped meanwhile
+    return code;
+}
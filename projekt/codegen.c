@@ -12,6 +12,13 @@
 #include "error.h"
 #include "string.h"
 #include "semantic.h"
+#include "options.h"
+#include "budget.h"
+#include "cse.h"
+#include "liveness.h"
+#include "fncache.h"
+#include "globals.h"
+#include "escape.h"
 
 // Forward declarations
 void generate_expression_stack(generator gen, ast_expression node); // Hlavní funkce pro stack
@@ -34,6 +41,19 @@ void generate_div_conversion(generator gen, char *left, char *right);
 void generate_repetition(generator gen, char *result, char *left, char *right);
 void generate_float_conversion(generator gen, char *var_name, char *type_name);
 void generate_type_check(generator gen, char *symb1, char *symb2, char *error_label);
+void generate_induction_update(generator gen, ast_node node);
+
+// Shared coercion subroutines of -Os, operands in GF@tmp_l/GF@tmp_r
+enum { HELPER_COERCE = 1, HELPER_ADD = 2, HELPER_MUL = 4, HELPER_DIV = 8, HELPER_ALL = 15 };
+
+static char *helper_label(unsigned helper) {
+    switch (helper) {
+        case HELPER_ADD: return "$add";
+        case HELPER_MUL: return "$mul";
+        case HELPER_DIV: return "$div";
+        default: return "$coerce";
+    }
+}
 
 const char *PREFIXES[] = {
     "int@", 
@@ -55,8 +75,8 @@ int starts_with_prefix(const char *str, const char **prefixes) {
     return 0;
 }
 
-// Returns GF if var starts with __, else returns LF
-char* var_frame_parse(char *var) {
+// Returns GF if var starts with __, else returns LF (the shared frame slot of a local of gen)
+char* var_frame_parse(generator gen, char *var) {
     if (var == NULL) {
         fprintf(stderr, "Chyba: Vstupní proměnná je NULL.\n");
         return NULL;
@@ -68,6 +88,12 @@ char* var_frame_parse(char *var) {
         prefix = "GF@";
     } else {
         prefix = "LF@";
+        int slot = liveness_slot(gen->slots, var);
+        if (slot >= 0) { // Local shares a frame slot
+            char *varout = (char*)malloc(32);
+            if (varout) snprintf(varout, 32, "LF@%%s%d", slot);
+            return varout;
+        }
     }
     size_t prefix_len = strlen(prefix);
     size_t var_len = strlen(var);
@@ -87,6 +113,10 @@ static void sem_def_globals(generator gen) {
     if (rc != SUCCESS) return;
     string_append_literal(gen->output, "\n# GLOABLS DECLARATION\n");
     for (size_t i = 0; i < count; ++i) {
+        if (!globals_defined(globals[i])) { // No read or write left (-O1)
+            free(globals[i]);
+            continue;
+        }
         string_append_literal(gen->output, "DEFVAR GF@");
         string_append_literal(gen->output, globals[i]);
         string_append_literal(gen->output, "\nMOVE GF@");
@@ -100,31 +130,24 @@ static void sem_def_globals(generator gen) {
 
 // Converting string for correct output
 char* escape_string_literal(const char* original_str) {
-    if (original_str == NULL) {
-        char* prefix_only = malloc(7 * sizeof(char));
-        if (prefix_only) prefix_only = "string@";
-        return prefix_only;
-    }
-    size_t len = strlen(original_str);
-    size_t max_size = 7 + len * 4 + 1;
-    char* result = (char*)malloc(max_size);
+    size_t len = original_str ? strlen(original_str) : 0;
+    char* result = (char*)malloc(7 + ESCAPE_MAX_LENGTH(len) + 1);
     if (result == NULL) return NULL;
-    strcpy(result, "string@");
-    char* current = result + 7;
-    for (size_t i = 0; i < len; i++) {
-        unsigned char ch = (unsigned char)original_str[i];
-        if (ch <= 32 || ch == 35 || ch == 92) {
-            current += sprintf(current, "\\%03d", ch); 
-        } else {
-            *current++ = ch;
-        }
-    }
-    *current = '\0';
+    memcpy(result, "string@", 7);
+    size_t written = original_str ? escape_literal(result + 7, original_str, len) : 0;
+    result[7 + written] = '\0';
     return result;
 }
 
+static char nil_operand[] = "nil@nil";  // shared by every null value, never freed
+
+// Frees an operand made by ast_value_to_string()
+static void operand_free(char *operand) {
+    if (operand != nil_operand) free(operand);
+}
+
 // Value to string conversion from paramenters and expressions
-char *ast_value_to_string(ast_expression expr_node, ast_parameter param_node) {
+char *ast_value_to_string(generator gen, ast_expression expr_node, ast_parameter param_node) {
     char *result = NULL;
     ast_value_type type;
     int int_val;
@@ -176,14 +199,13 @@ char *ast_value_to_string(ast_expression expr_node, ast_parameter param_node) {
             if (result) sprintf(result, "float@%a", float_val);
             break;
         case AST_VALUE_IDENTIFIER:
-            result = var_frame_parse(char_val);
+            result = var_frame_parse(gen, char_val);
             break;
         case AST_VALUE_STRING:
             result = escape_string_literal(char_val);
             break;
         case AST_VALUE_NULL:
-            result = malloc((8) * sizeof(char));
-            result = "nil@nil";
+            result = nil_operand;
             break;
         default: return NULL;
     }
@@ -193,12 +215,14 @@ char *ast_value_to_string(ast_expression expr_node, ast_parameter param_node) {
 enum arity get_op_arity(ast_expression_type type){
     switch(type){
         case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV:
-        case AST_EQUALS: case AST_NOT_EQUAL: case AST_TERNARY:
+        case AST_EQUALS: case AST_NOT_EQUAL:
         case AST_LT: case AST_LE: case AST_GT: case AST_GE:
         case AST_AND: case AST_OR: case AST_IS: case AST_CONCAT:
             return ARITY_BINARY;
         case AST_NOT:
             return ARITY_UNARY;
+        case AST_TERNARY:
+            return ARITY_TERNARY;
         default:
             return ARITY_UNDEFINED;
     }
@@ -207,6 +231,54 @@ enum arity get_op_arity(ast_expression_type type){
 void create_gen(generator gen){
     gen->output = string_create(2048);
     gen->counter = 0;
+    gen->scope = string_create(32);
+    stack_init(&gen->label_ids);
+    stack_init(&gen->loop_stack);
+    gen->block = NULL;
+    gen->induction = NULL;
+    gen->known = NULL;
+    gen->versions = 0;
+    gen->cse = NULL;
+    gen->slots = NULL;
+    gen->helpers = 0;
+    gen->passes = BUDGET_ALL;
+}
+
+// --- Labels ---
+
+// Label of a user function: name and arity, so overloads f(a) and f(a, b) do not collide
+static void function_label(string out, const char *name, ast_parameter params) {
+    char arity[16];
+    unsigned count = 0;
+    for (; params != NULL; params = params->next) count++;
+    snprintf(arity, sizeof arity, "$%u", count);
+    string_append_literal(out, (char *)name);
+    string_append_literal(out, arity);
+}
+
+// Start of a function: its local labels are numbered from zero under its label,
+// the code of a function does not depend on the functions generated before it
+static void open_label_scope(generator gen, const char *scope) {
+    string_clear(gen->scope);
+    string_append_literal(gen->scope, (char *)scope);
+    gen->counter = 0;
+}
+
+static void close_label_scope(generator gen) {
+    while (!stack_is_empty(&gen->label_ids)) free(stack_pop(&gen->label_ids));
+}
+
+// Next local label id "<function label>$<n>", valid until the end of the function
+static char *label_id(generator gen) {
+    char number[16];
+    snprintf(number, sizeof number, "$%u", gen->counter++);
+    size_t len = strlen(gen->scope->data);
+    char *id = malloc(len + strlen(number) + 1);
+    if (id == NULL) return "";
+    memcpy(id, gen->scope->data, len);
+    strcpy(id + len, number);
+    stack_push(&gen->label_ids, id);
+    return id;
 }
 
 // --- Instructions ---
@@ -230,8 +302,8 @@ void jump(generator gen, char * label){
     string_append_literal(gen->output, "\n");
 }
 void add_jumpifeq(generator gen, char * label, char * symb1, char * symb2){
-    char *nsymb1 = var_frame_parse(symb1);
-    char *nsymb2 = var_frame_parse(symb2);
+    char *nsymb1 = var_frame_parse(gen, symb1);
+    char *nsymb2 = var_frame_parse(gen, symb2);
     string_append_literal(gen->output, "JUMPIFEQ ");
     string_append_literal(gen->output, label);
     string_append_literal(gen->output, " ");
@@ -242,8 +314,8 @@ void add_jumpifeq(generator gen, char * label, char * symb1, char * symb2){
     free(nsymb1); free(nsymb2);
 }
 void add_jumpifneq(generator gen, char * label, char * symb1, char * symb2){
-    char *nsymb1 = var_frame_parse(symb1);
-    char *nsymb2 = var_frame_parse(symb2);
+    char *nsymb1 = var_frame_parse(gen, symb1);
+    char *nsymb2 = var_frame_parse(gen, symb2);
     string_append_literal(gen->output, "JUMPIFNEQ ");
     string_append_literal(gen->output, label);
     string_append_literal(gen->output, " ");
@@ -254,29 +326,29 @@ void add_jumpifneq(generator gen, char * label, char * symb1, char * symb2){
     free(nsymb1); free(nsymb2);
 }
 void push(generator gen, char * name){
-    char *nname = var_frame_parse(name);
+    char *nname = var_frame_parse(gen, name);
     string_append_literal(gen->output, "PUSHS ");
     string_append_literal(gen->output, nname);
     string_append_literal(gen->output, "\n");
     free(nname);
 }
 void pop(generator gen, char * name){
-    char *nname = var_frame_parse(name);
+    char *nname = var_frame_parse(gen, name);
     string_append_literal(gen->output, "POPS ");
     string_append_literal(gen->output, nname);
     string_append_literal(gen->output, "\n");
     free(nname);
 }
 void define_variable(generator gen, char * name){
-    char *nname = var_frame_parse(name);
+    char *nname = var_frame_parse(gen, name);
     string_append_literal(gen->output, "DEFVAR ");
     string_append_literal(gen->output, nname);
     string_append_literal(gen->output, "\n");
     free(nname);
 }
 void move_var(generator gen, char * var1, char * var2){
-    char *nvar1 = var_frame_parse(var1);
-    char *nvar2 = var_frame_parse(var2);
+    char *nvar1 = var_frame_parse(gen, var1);
+    char *nvar2 = var_frame_parse(gen, var2);
     string_append_literal(gen->output, "MOVE ");
     string_append_literal(gen->output, nvar1);
     string_append_literal(gen->output, " ");
@@ -284,10 +356,21 @@ void move_var(generator gen, char * var1, char * var2){
     string_append_literal(gen->output, "\n");
     free(nvar1); free(nvar2);
 }
+// MOVE/PUSHS of the value of an argument or parameter
+static void move_value(generator gen, char *var, ast_parameter param) {
+    char *value = ast_value_to_string(gen, NULL, param);
+    move_var(gen, var, value);
+    operand_free(value);
+}
+static void push_value(generator gen, ast_parameter param) {
+    char *value = ast_value_to_string(gen, NULL, param);
+    push(gen, value);
+    operand_free(value);
+}
 void binary_operation(generator gen, char * op, char * result, char * left, char * right){
-    char *nresult = var_frame_parse(result);
-    char *nleft = var_frame_parse(left);
-    char *nright = var_frame_parse(right);
+    char *nresult = var_frame_parse(gen, result);
+    char *nleft = var_frame_parse(gen, left);
+    char *nright = var_frame_parse(gen, right);
     string_append_literal(gen->output, op);
     string_append_literal(gen->output, " ");
     string_append_literal(gen->output, nresult);
@@ -310,8 +393,8 @@ void op_and(generator gen, char * result, char * left, char * right){ binary_ope
 void op_or(generator gen, char * result, char * left, char * right){ binary_operation(gen, "OR", result, left, right); }
 void op_concat(generator gen, char * result, char * left, char * right){ binary_operation(gen, "CONCAT", result, left, right); }
 void op_not(generator gen, char * result, char * op){
-    char *nresult = var_frame_parse(result);
-    char *nop = var_frame_parse(op);
+    char *nresult = var_frame_parse(gen, result);
+    char *nop = var_frame_parse(gen, op);
     string_append_literal(gen->output, "NOT ");
     string_append_literal(gen->output, nresult);
     string_append_literal(gen->output, " ");
@@ -320,7 +403,7 @@ void op_not(generator gen, char * result, char * op){
     free(nresult); free(nop);
 }
 void ifj_read(generator gen, char * name, char * type){
-    char *nname = var_frame_parse(name);
+    char *nname = var_frame_parse(gen, name);
     string_append_literal(gen->output, "READ ");
     string_append_literal(gen->output, nname);
     string_append_literal(gen->output, " ");
@@ -329,7 +412,7 @@ void ifj_read(generator gen, char * name, char * type){
     free(nname);
 }
 void ifj_write(generator gen, char * name){
-    char *nname = var_frame_parse(name);
+    char *nname = var_frame_parse(gen, name);
     string_append_literal(gen->output, "WRITE ");
     string_append_literal(gen->output, nname);
     string_append_literal(gen->output, "\n");
@@ -337,8 +420,8 @@ void ifj_write(generator gen, char * name){
     move_var(gen, "GF@tmp1", "nil@nil");
 }
 void ifj_strlen(generator gen, char * output, char * input){
-    char *noutput = var_frame_parse(output);
-    char *ninput = var_frame_parse(input);
+    char *noutput = var_frame_parse(gen, output);
+    char *ninput = var_frame_parse(gen, input);
     string_append_literal(gen->output, "STRLEN ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -347,8 +430,8 @@ void ifj_strlen(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_getchar(generator gen, char * output, char * input, char * position){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "GETCHAR ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -359,8 +442,8 @@ void ifj_getchar(generator gen, char * output, char * input, char * position){
     free(ninput); free(noutput);
 }
 void ifj_type(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "TYPE ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -369,8 +452,8 @@ void ifj_type(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_float2int(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "FLOAT2INT ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -379,8 +462,8 @@ void ifj_float2int(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_int2char(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "INT2CHAR ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -389,8 +472,8 @@ void ifj_int2char(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_int2str(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "INT2STR ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -399,8 +482,8 @@ void ifj_int2str(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_float2str(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "FLOAT2STR ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -409,9 +492,9 @@ void ifj_float2str(generator gen, char * output, char * input){
     free(ninput); free(noutput);
 }
 void ifj_stri2int(generator gen, char * output, char * var1, char *var2){
-    char *nvar1 = var_frame_parse(var1);
-    char *nvar2 = var_frame_parse(var2);
-    char *noutput = var_frame_parse(output);
+    char *nvar1 = var_frame_parse(gen, var1);
+    char *nvar2 = var_frame_parse(gen, var2);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "STRI2INT ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -422,8 +505,8 @@ void ifj_stri2int(generator gen, char * output, char * var1, char *var2){
     free(nvar1); free(nvar2); free(noutput);
 }
 void ifj_int2float(generator gen, char * output, char * input){
-    char *ninput = var_frame_parse(input);
-    char *noutput = var_frame_parse(output);
+    char *ninput = var_frame_parse(gen, input);
+    char *noutput = var_frame_parse(gen, output);
     string_append_literal(gen->output, "INT2FLOAT ");
     string_append_literal(gen->output, noutput);
     string_append_literal(gen->output, " ");
@@ -441,8 +524,7 @@ void exit_code(generator gen, char * code){
 
 // Float to int if variable is float
 void float_int_conversion(generator gen, char *var) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string is_float_label = string_create(20);
     string_append_literal(is_float_label, "IS_FLOAT_");
     string_append_literal(is_float_label, tmp);
@@ -456,18 +538,23 @@ void float_int_conversion(generator gen, char *var) {
     string_destroy(is_float_label);
 }
 
-// Generate string repetition, when one side of expression is string
+// Generate string repetition, when one side of expression is string;
+// square-and-multiply: the pieces double, so the copied volume stays linear in the result length
 void generate_repetition(generator gen, char *result, char *left, char *right) {
-    char tmp[20];
+    char *tmp;
     string start_label_str = string_create(20);
+    string even_label_str = string_create(20);
     string end_label_str = string_create(20);
-    snprintf(tmp, 20, "%u", gen->counter++);
+    tmp = label_id(gen);
     string_append_literal(start_label_str, "REPETITION_START_");
     string_append_literal(start_label_str, tmp); 
+    string_append_literal(even_label_str, "REPETITION_EVEN_");
+    string_append_literal(even_label_str, tmp);
     string_append_literal(end_label_str, "REPETITION_END_");
     string_append_literal(end_label_str, tmp);
     
     char *label_start = start_label_str->data;
+    char *label_even = even_label_str->data;
     char *label_end = end_label_str->data;
 
     move_var(gen, "GF@tmp2", "string@");
@@ -478,25 +565,30 @@ void generate_repetition(generator gen, char *result, char *left, char *right) {
     add_jumpifeq(gen, label_end, "GF@tmp_if", "bool@true"); 
     op_lt(gen, "GF@tmp_if", "GF@tmp1", "int@0");
     add_jumpifeq(gen, label_end, "GF@tmp_if", "bool@true"); 
+    move_var(gen, "GF@tmp3", left); // Piece of 1, 2, 4, ... copies
 
     label(gen, label_start);
-    op_concat(gen, "GF@tmp2", "GF@tmp2", left);
-    move_var(gen, "GF@tmp3", "int@1");
-    op_sub(gen, "GF@tmp1", "GF@tmp1", "GF@tmp3");
-    op_gt(gen, "GF@tmp_op", "GF@tmp1", "int@0");
-    add_jumpifeq(gen, label_start, "GF@tmp_op", "bool@true");
+    op_idiv(gen, "GF@tmp_op", "GF@tmp1", "int@2");
+    op_mul(gen, "GF@tmp_if", "GF@tmp_op", "int@2");
+    add_jumpifeq(gen, label_even, "GF@tmp_if", "GF@tmp1"); // Low bit of the count clear
+    op_concat(gen, "GF@tmp2", "GF@tmp2", "GF@tmp3");
+    label(gen, label_even);
+    move_var(gen, "GF@tmp1", "GF@tmp_op");
+    add_jumpifeq(gen, label_end, "GF@tmp1", "int@0");
+    op_concat(gen, "GF@tmp3", "GF@tmp3", "GF@tmp3");
+    jump(gen, label_start);
     label(gen, label_end);
     string_append_literal(gen->output, "# REPETITION LOOP END\n");
     move_var(gen, result, "GF@tmp2");
 
     string_destroy(start_label_str);
+    string_destroy(even_label_str);
     string_destroy(end_label_str);
 }
 
 // Check if both sides of expression are same type
 void generate_type_check(generator gen, char *symb1, char *symb2, char *error_label) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string label_end = string_create(20);
     string_append_literal(label_end, "SKIP_CHECK_");
     string_append_literal(label_end, tmp);
@@ -508,12 +600,12 @@ void generate_type_check(generator gen, char *symb1, char *symb2, char *error_la
     add_jumpifneq(gen, error_label, "GF@tmp_type_l", "GF@tmp_type_r");
     label(gen, label_end->data);
     string_append_literal(gen->output, "# TYPE CHECK: OK\n");
+    string_destroy(label_end);
 }
 
 // float to int conversion if is float
 void generate_float_conversion(generator gen, char *var_name, char *type_name) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string label_end = string_create(20);
     string_append_literal(label_end, "SKIP_INT2FLOAT_");
     string_append_literal(label_end, tmp);
@@ -531,8 +623,7 @@ void generate_float_conversion(generator gen, char *var_name, char *type_name) {
 
 // Create add, or concatenation, based on types
 void generate_add_conversion(generator gen, char *result, char *left, char *right) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string skip_val1_label = string_create(20);
     string_append_literal(skip_val1_label, "SKIP_VAL1_C_");
     string_append_literal(skip_val1_label, tmp);
@@ -580,8 +671,7 @@ void generate_add_conversion(generator gen, char *result, char *left, char *righ
 
 // Generate multiplication if both are int/float, if one is string, generates repetition
 void generate_mul_conversion(generator gen, char *result, char *left, char *right) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string skip_rep = string_create(20);
     string_append_literal(skip_rep, "SKIP_REP_");
     string_append_literal(skip_rep, tmp);
@@ -636,8 +726,7 @@ void generate_div_conversion(generator gen, char *left, char *right) {
 
 // Correct types
 void process_auto_corecion(generator gen, char *left, char *right) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string skip_v1 = string_create(20);
     string_append_literal(skip_v1, "AC_V1_");
     string_append_literal(skip_v1, tmp);
@@ -663,122 +752,486 @@ void process_auto_corecion(generator gen, char *left, char *right) {
     generate_type_check(gen, left, right, "ERR26");
 }
 
-// Recursive expression generation with the use of stack
-void generate_expression_stack(generator gen, ast_expression node) {
-    if (!node) return;
-
-    if (node->type == AST_VALUE || node->type == AST_IDENTIFIER) { // Value/ID
-        char *val = ast_value_to_string(node, NULL);
-        push(gen, val);
-        if (node->type == AST_VALUE && node->operands.identity.value_type != AST_VALUE_IDENTIFIER && node->operands.identity.value_type != AST_VALUE_NULL) free(val);
-        return;
+// Coercion of GF@tmp_l and GF@tmp_r before a binary operation, ADD/MUL leave the result in GF@tmp1
+static void generate_helper_body(generator gen, unsigned helper) {
+    switch (helper) {
+        case HELPER_ADD: generate_add_conversion(gen, "GF@tmp1", "GF@tmp_l", "GF@tmp_r"); break;
+        case HELPER_MUL: generate_mul_conversion(gen, "GF@tmp1", "GF@tmp_l", "GF@tmp_r"); break;
+        case HELPER_DIV: generate_div_conversion(gen, "GF@tmp_l", "GF@tmp_r"); break;
+        default: process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r"); break;
     }
+}
 
-    if (node->type == AST_FUNCTION_CALL) { // Function call
-        generate_function_call(gen, NULL, node);
-        push(gen, "GF@fn_ret");
+// Inline coercion, or a call of the shared subroutine in size mode (-Os)
+static void generate_coercion(generator gen, unsigned helper) {
+    if (!options.size) {
+        generate_helper_body(gen, helper);
         return;
     }
-    
-    if (node->type == AST_IFJ_FUNCTION_EXPR) { // IFJ function call
-        generate_ifjfunction(gen, node->operands.ifj_function->name, node->operands.ifj_function->parameters, "GF@tmp1");
-        push(gen, "GF@tmp1");
-        return;
+    gen->helpers |= helper;
+    fn_call(gen, helper_label(helper));
+}
+
+// Expressions which always produce bool, no truthiness check needed
+static bool expression_is_bool(ast_expression node) {
+    switch (node->type) {
+        case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE:
+        case AST_GT: case AST_GE: case AST_IS: case AST_NOT: case AST_AND: case AST_OR:
+            return true;
+        default:
+            return false;
     }
+}
 
-    if (get_op_arity(node->type) == ARITY_UNARY) { // Unary expression
-        generate_expression_stack(gen, node->operands.unary_op.expression);
-        pop(gen, "GF@tmp1");
-        
-        if (node->type == AST_NOT) {
-            op_not(gen, "GF@tmp1", "GF@tmp1");
+// Literal that can be used directly as an instruction operand
+static bool expression_is_literal(ast_expression node) {
+    return node->type == AST_VALUE && node->operands.identity.value_type != AST_VALUE_IDENTIFIER;
+}
+
+// Numeric value of an int/float literal
+static double literal_number(ast_expression node) {
+    if (node->operands.identity.value_type == AST_VALUE_INT) return node->operands.identity.value.int_value;
+    return node->operands.identity.value.double_value;
+}
+
+static bool literal_is_number(ast_expression node) {
+    return node->type == AST_VALUE && (node->operands.identity.value_type == AST_VALUE_INT ||
+                                       node->operands.identity.value_type == AST_VALUE_FLOAT);
+}
+
+// Truth value of a comparison of literals known at compile time: 1 true, 0 false, -1 known only at runtime
+static int constant_comparison(ast_expression node) {
+    if (!node) return -1;
+    if (node->type == AST_VALUE) {
+        if (node->operands.identity.value_type == AST_VALUE_IDENTIFIER) return -1;
+        return node->operands.identity.value_type == AST_VALUE_NULL ? 0 : 1; // null is false
+    }
+    if (get_op_arity(node->type) != ARITY_BINARY) return -1;
+
+    ast_expression left = node->operands.binary_op.left;
+    ast_expression right = node->operands.binary_op.right;
+    if (literal_is_number(left) && literal_is_number(right)) { // Same coercion as the runtime: int promoted to float
+        double l = literal_number(left), r = literal_number(right);
+        switch (node->type) {
+            case AST_EQUALS: return l == r;
+            case AST_NOT_EQUAL: return l != r;
+            case AST_LT: return l < r;
+            case AST_LE: return l <= r;
+            case AST_GT: return l > r;
+            case AST_GE: return l >= r;
+            default: return -1;
         }
-        
-        push(gen, "GF@tmp1");
+    }
+    if (left->type == AST_VALUE && right->type == AST_VALUE &&
+        left->operands.identity.value_type == AST_VALUE_STRING &&
+        right->operands.identity.value_type == AST_VALUE_STRING) {
+        int cmp = strcmp(left->operands.identity.value.string_value, right->operands.identity.value.string_value);
+        if (node->type == AST_EQUALS) return cmp == 0;
+        if (node->type == AST_NOT_EQUAL) return cmp != 0;
+    }
+    return -1;
+}
+
+// Truth value of a condition known at compile time: 1 true, 0 false, -1 known only at runtime
+static int constant_condition(ast_expression node) {
+    int negations = 0;
+    for (; node && node->type == AST_NOT; node = node->operands.unary_op.expression) negations++;
+    int value = constant_comparison(node);
+    if (negations == 0) return value;
+    if (value < 0) return -1;
+    return negations % 2 ? !value : value; // ! of any value follows its truth value
+}
+
+// Jump to label when the value in var is false or null, everything else is true
+static void generate_falsy_jump(generator gen, char *false_label, char *var, bool is_bool) {
+    if (is_bool) {
+        add_jumpifeq(gen, false_label, var, "bool@false");
         return;
     }
+    char *tmp = label_id(gen);
+    string truthy_label = string_create(20);
+    string_append_literal(truthy_label, "TRUTHY_");
+    string_append_literal(truthy_label, tmp);
 
-    if (get_op_arity(node->type) == ARITY_BINARY) { // Binary expression
-        generate_expression_stack(gen, node->operands.binary_op.left); // Recursive left side
-        
-        if (node->type == AST_IS) {
-            pop(gen, "GF@tmp_l");
-            char *val_type = "string@nil";
-            char *right_raw = node->operands.binary_op.right->operands.identifier.value;
-            
-            if (strcmp(right_raw, "Num") == 0) val_type = "string@int";
-            else if (strcmp(right_raw, "String") == 0) val_type = "string@string";
-            else if (strcmp(right_raw, "Null") == 0) val_type = "string@nil";
-            
-            ifj_type(gen, "GF@tmp_type_r", "GF@tmp_l");
-            op_eq(gen, "GF@tmp1", "GF@tmp_type_r", val_type);
-            push(gen, "GF@tmp1");
-            return;
+    ifj_type(gen, "GF@tmp_ifj", var);
+    add_jumpifeq(gen, false_label, "GF@tmp_ifj", "string@nil");
+    add_jumpifneq(gen, truthy_label->data, "GF@tmp_ifj", "string@bool");
+    add_jumpifeq(gen, false_label, var, "bool@false");
+    label(gen, truthy_label->data);
+    string_destroy(truthy_label);
+}
+
+// ---- expression generation with an explicit stack (the depth is limited by memory only)
+
+// Node of an expression being generated, the code of its operands is emitted between its steps
+typedef struct expr_frame {
+    ast_expression node;
+    int step;           // steps done so far
+    bool done;          // value of the node is on the stack
+    cse_entry entry;    // value is also kept in this temporary, or NULL
+    string labels[4];   // labels of a ternary or logical operator, or NULL
+    loop_type operands[3]; // types of the operands generated so far
+} expr_frame;
+
+// Labels "<prefix><id>" of one operator, all with the same id
+static void frame_labels(generator gen, expr_frame *f, char **prefixes, int count) {
+    char *tmp = label_id(gen);
+    for (int i = 0; i < count; i++) {
+        f->labels[i] = string_create(20);
+        string_append_literal(f->labels[i], prefixes[i]);
+        string_append_literal(f->labels[i], tmp);
+    }
+}
+
+// Ternary operator, only the selected branch is evaluated
+static ast_expression ternary_step(generator gen, expr_frame *f) {
+    ast_expression condition = f->node->operands.ternary_op.condition;
+    ast_expression if_true = f->node->operands.ternary_op.if_true;
+    ast_expression if_false = f->node->operands.ternary_op.if_false;
+
+    switch (f->step++) {
+        case 0: {
+            int folded = options.opt_level > 0 ? constant_condition(condition) : -1;
+            if (folded >= 0) { // Condition known at compile time, other branch is never generated
+                string_append_literal(gen->output, "\n# TERNARY (CONSTANT CONDITION)\n");
+                f->step = 4;
+                return folded ? if_true : if_false;
+            }
+            frame_labels(gen, f, (char *[]){"TERNARY_ELSE_", "TERNARY_END_"}, 2);
+            string_append_literal(gen->output, "\n# TERNARY\n");
+            return condition;
         }
+        case 1:
+            pop(gen, "GF@tmp_if");
+            if (expression_is_literal(if_true) && expression_is_literal(if_false)) { // Literal branches, no evaluation needed
+                char *true_val = ast_value_to_string(gen, if_true, NULL);
+                char *false_val = ast_value_to_string(gen, if_false, NULL);
+                if (strcmp(true_val, false_val)) {
+                    move_var(gen, "GF@tmp1", false_val);
+                    generate_falsy_jump(gen, f->labels[1]->data, "GF@tmp_if", expression_is_bool(condition));
+                    move_var(gen, "GF@tmp1", true_val);
+                    label(gen, f->labels[1]->data);
+                    push(gen, "GF@tmp1");
+                } else {
+                    push(gen, true_val);
+                }
+                operand_free(true_val);
+                operand_free(false_val);
+                string_append_literal(gen->output, "# TERNARY END\n");
+                f->done = true;
+                return NULL;
+            }
+            generate_falsy_jump(gen, f->labels[0]->data, "GF@tmp_if", expression_is_bool(condition));
+            return if_true;
+        case 2:
+            jump(gen, f->labels[1]->data);
+            label(gen, f->labels[0]->data);
+            return if_false;
+        case 3:
+            label(gen, f->labels[1]->data);
+            string_append_literal(gen->output, "# TERNARY END\n");
+            f->done = true;
+            return NULL;
+        default: // Branch of a constant condition is on the stack
+            f->done = true;
+            return NULL;
+    }
+}
 
-        generate_expression_stack(gen, node->operands.binary_op.right); // Recursive right side
-        
-        pop(gen, "GF@tmp_r"); // Get result of nested expression
-        pop(gen, "GF@tmp_l"); // Get result of nested expression
-        
-        char *res = "GF@tmp1";
+// && and || with the result as bool, the right operand is evaluated only when the left one does not decide
+static ast_expression logical_step(generator gen, expr_frame *f) {
+    ast_expression left = f->node->operands.binary_op.left;
+    ast_expression right = f->node->operands.binary_op.right;
+    bool is_or = f->node->type == AST_OR;
+
+    switch (f->step++) {
+        case 0:
+            frame_labels(gen, f, (char *[]){"LOGIC_RIGHT_", "LOGIC_TRUE_", "LOGIC_FALSE_", "LOGIC_END_"}, 4);
+            string_append_literal(gen->output, is_or ? "\n# OR\n" : "\n# AND\n");
+            return left;
+        case 1:
+            pop(gen, "GF@tmp_if");
+            if (is_or) { // True left side decides, false one leaves it to the right side
+                generate_falsy_jump(gen, f->labels[0]->data, "GF@tmp_if", expression_is_bool(left));
+                jump(gen, f->labels[1]->data);
+                label(gen, f->labels[0]->data);
+            } else {
+                generate_falsy_jump(gen, f->labels[2]->data, "GF@tmp_if", expression_is_bool(left));
+            }
+            return right;
+        default:
+            pop(gen, "GF@tmp_if");
+            generate_falsy_jump(gen, f->labels[2]->data, "GF@tmp_if", expression_is_bool(right));
+            if (is_or) label(gen, f->labels[1]->data);
+            push(gen, "bool@true");
+            jump(gen, f->labels[3]->data);
+            label(gen, f->labels[2]->data);
+            push(gen, "bool@false");
+            label(gen, f->labels[3]->data);
+            string_append_literal(gen->output, is_or ? "# OR END\n" : "# AND END\n");
+            f->done = true;
+            return NULL;
+    }
+}
 
-        switch (node->type) { // Generate all types of operations
+// Unary expression, ! follows the truth rule of if/while: false and null are false
+static ast_expression unary_step(generator gen, expr_frame *f) {
+    ast_expression operand = f->node->operands.unary_op.expression;
+    if (f->step++ == 0) return operand;
+    pop(gen, "GF@tmp1");
+
+    if (f->node->type == AST_NOT && expression_is_bool(operand)) {
+        op_not(gen, "GF@tmp1", "GF@tmp1");
+    } else if (f->node->type == AST_NOT) {
+        frame_labels(gen, f, (char *[]){"NOT_FALSY_", "NOT_END_"}, 2);
+        generate_falsy_jump(gen, f->labels[0]->data, "GF@tmp1", false);
+        move_var(gen, "GF@tmp1", "bool@false");
+        jump(gen, f->labels[1]->data);
+        label(gen, f->labels[0]->data);
+        move_var(gen, "GF@tmp1", "bool@true");
+        label(gen, f->labels[1]->data);
+    }
+
+    push(gen, "GF@tmp1");
+    f->done = true;
+    return NULL;
+}
+
+// Operation on operands whose types are known at compile time (literals, typed loop copies),
+// the coercion sequence is left out; false if the types need it
+static bool generate_typed_binary(generator gen, ast_expression node, loop_type l, loop_type r) {
+    loop_type operands[2] = { l, r };
+    loop_type type = loop_op_type(node, operands, NULL);
+    if (options.opt_level == 0 || node->type == AST_CONCAT || type == LOOP_TYPE_NONE || type == LOOP_TYPE_ANY)
+        return false;
+
+    char *res = "GF@tmp1";
+    if (node->type == AST_MUL && l == LOOP_TYPE_STRING) {
+        generate_repetition(gen, res, "GF@tmp_l", "GF@tmp_r");
+    } else {
+        if (l == LOOP_TYPE_INT && (r == LOOP_TYPE_FLOAT || node->type == AST_DIV)) ifj_int2float(gen, "GF@tmp_l", "GF@tmp_l");
+        if (r == LOOP_TYPE_INT && (l == LOOP_TYPE_FLOAT || node->type == AST_DIV)) ifj_int2float(gen, "GF@tmp_r", "GF@tmp_r");
+        switch (node->type) {
             case AST_ADD:
-                generate_add_conversion(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_SUB:
-                process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                op_sub(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_MUL:
-                generate_mul_conversion(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_DIV:
-                generate_div_conversion(gen, "GF@tmp_l", "GF@tmp_r");
-                op_div(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_LT:
-                process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                op_lt(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_GT:
-                process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                op_gt(gen, res, "GF@tmp_l", "GF@tmp_r");
+                if (l == LOOP_TYPE_STRING) op_concat(gen, res, "GF@tmp_l", "GF@tmp_r");
+                else op_add(gen, res, "GF@tmp_l", "GF@tmp_r");
                 break;
+            case AST_SUB: op_sub(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
+            case AST_MUL: op_mul(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
+            case AST_DIV: op_div(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
+            case AST_LT: op_lt(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
+            case AST_GT: op_gt(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
             case AST_LE:
-                 process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                 op_gt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
-                 op_not(gen, res, "GF@tmp2");
-                 break;
+                op_gt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
+                op_not(gen, res, "GF@tmp2");
+                break;
             case AST_GE:
-                 process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                 op_lt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
-                 op_not(gen, res, "GF@tmp2");
-                 break;
-            case AST_EQUALS:
-                process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
-                op_eq(gen, res, "GF@tmp_l", "GF@tmp_r");
+                op_lt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
+                op_not(gen, res, "GF@tmp2");
                 break;
-            case AST_NOT_EQUAL:
-                process_auto_corecion(gen, "GF@tmp_l", "GF@tmp_r");
+            case AST_EQUALS: op_eq(gen, res, "GF@tmp_l", "GF@tmp_r"); break;
+            default:
                 op_eq(gen, res, "GF@tmp_l", "GF@tmp_r");
                 op_not(gen, res, res);
                 break;
-            case AST_AND:
-                op_and(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_OR:
-                op_or(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            case AST_CONCAT:
-                op_concat(gen, res, "GF@tmp_l", "GF@tmp_r");
-                break;
-            default:
-                break;
         }
-        push(gen, res); // Push for recursive expressions
     }
+    push(gen, res);
+    opt_stats.typed_operations++;
+    return true;
+}
+
+// Binary expression, both operands on the stack
+static ast_expression binary_step(generator gen, expr_frame *f) {
+    ast_expression node = f->node;
+    switch (f->step++) {
+        case 0: return node->operands.binary_op.left;
+        case 1:
+            if (node->type != AST_IS) return node->operands.binary_op.right;
+            break;
+        default:
+            break;
+    }
+    f->done = true;
+
+    if (node->type == AST_IS) {
+        pop(gen, "GF@tmp_l");
+        char *val_type = "string@nil";
+        char *right_raw = node->operands.binary_op.right->operands.identifier.value;
+
+        if (strcmp(right_raw, "Num") == 0) val_type = "string@int";
+        else if (strcmp(right_raw, "String") == 0) val_type = "string@string";
+        else if (strcmp(right_raw, "Null") == 0) val_type = "string@nil";
+
+        ifj_type(gen, "GF@tmp_type_r", "GF@tmp_l");
+        op_eq(gen, "GF@tmp1", "GF@tmp_type_r", val_type);
+        push(gen, "GF@tmp1");
+        return NULL;
+    }
+
+    pop(gen, "GF@tmp_r"); // Get result of nested expression
+    pop(gen, "GF@tmp_l"); // Get result of nested expression
+    if (generate_typed_binary(gen, node, f->operands[0], f->operands[1])) return NULL;
+
+    char *res = "GF@tmp1";
+
+    switch (node->type) { // Generate all types of operations
+        case AST_ADD:
+            generate_coercion(gen, HELPER_ADD);
+            break;
+        case AST_SUB:
+            generate_coercion(gen, HELPER_COERCE);
+            op_sub(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        case AST_MUL:
+            generate_coercion(gen, HELPER_MUL);
+            break;
+        case AST_DIV:
+            generate_coercion(gen, HELPER_DIV);
+            op_div(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        case AST_LT:
+            generate_coercion(gen, HELPER_COERCE);
+            op_lt(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        case AST_GT:
+            generate_coercion(gen, HELPER_COERCE);
+            op_gt(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        case AST_LE:
+             generate_coercion(gen, HELPER_COERCE);
+             op_gt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
+             op_not(gen, res, "GF@tmp2");
+             break;
+        case AST_GE:
+             generate_coercion(gen, HELPER_COERCE);
+             op_lt(gen, "GF@tmp2", "GF@tmp_l", "GF@tmp_r");
+             op_not(gen, res, "GF@tmp2");
+             break;
+        case AST_EQUALS:
+            generate_coercion(gen, HELPER_COERCE);
+            op_eq(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        case AST_NOT_EQUAL:
+            generate_coercion(gen, HELPER_COERCE);
+            op_eq(gen, res, "GF@tmp_l", "GF@tmp_r");
+            op_not(gen, res, res);
+            break;
+        case AST_CONCAT:
+            op_concat(gen, res, "GF@tmp_l", "GF@tmp_r");
+            break;
+        default:
+            break;
+    }
+    push(gen, res);
+    return NULL;
+}
+
+// Next step of an expression, returns the operand to generate next; f->done is set when the value is on the stack
+static ast_expression expression_step(generator gen, expr_frame *f) {
+    ast_expression node = f->node;
+    switch (node->type) {
+        case AST_VALUE:
+        case AST_IDENTIFIER: { // Value/ID
+            char *val = ast_value_to_string(gen, node, NULL);
+            push(gen, val);
+            operand_free(val);
+            break;
+        }
+        case AST_FUNCTION_CALL: // Function call, arguments are separate expressions
+            generate_function_call(gen, NULL, node);
+            push(gen, "GF@fn_ret");
+            break;
+        case AST_IFJ_FUNCTION_EXPR: // IFJ function call
+            generate_ifjfunction(gen, node->operands.ifj_function->name, node->operands.ifj_function->parameters, "GF@tmp1");
+            push(gen, "GF@tmp1");
+            break;
+        case AST_TERNARY: // Conditional expression, only one branch is evaluated
+            return ternary_step(gen, f);
+        case AST_AND:
+        case AST_OR: // Short-circuit, the right side may be skipped
+            return logical_step(gen, f);
+        default:
+            if (get_op_arity(node->type) == ARITY_UNARY) return unary_step(gen, f);
+            if (get_op_arity(node->type) == ARITY_BINARY) return binary_step(gen, f);
+            break;
+    }
+    f->done = true;
+    return NULL;
+}
+
+// Start of an expression, values repeated in a basic block are kept in LF@%cse temporaries;
+// returns false when the value is already on the stack
+static bool expression_enter(generator gen, expr_frame *f, ast_expression node) {
+    *f = (expr_frame){ .node = node };
+    f->entry = gen->cse ? cse_find(gen->cse, node) : NULL;
+    if (f->entry == NULL) return true;
+    char temp[32];
+    cse_temp_name(f->entry, temp, 32);
+    if (cse_available(gen->cse, f->entry)) { // Value already computed in this block
+        push(gen, temp);
+        opt_stats.cse_eliminated++;
+        return false;
+    }
+    if (node->type == AST_IFJ_FUNCTION_EXPR) {
+        generate_ifjfunction(gen, node->operands.ifj_function->name, node->operands.ifj_function->parameters, temp);
+        push(gen, temp);
+        cse_set_available(gen->cse, f->entry);
+        return false;
+    }
+    return true;
+}
+
+// End of an expression, its value is on the stack
+static void expression_leave(generator gen, expr_frame *f) {
+    if (f->entry != NULL) {
+        char temp[32];
+        cse_temp_name(f->entry, temp, 32);
+        pop(gen, temp);
+        push(gen, temp);
+        cse_set_available(gen->cse, f->entry);
+    }
+    for (int i = 0; i < 4; i++) string_destroy(f->labels[i]);
+}
+
+// Type of a value now on the stack, kept by the node which will use it
+static void operand_type(expr_frame *frames, size_t count, loop_type type) {
+    if (count == 0) return;
+    int index = frames[count - 1].step - 1;
+    if (index >= 0 && index < 3) frames[count - 1].operands[index] = type;
+}
+
+// Expression on the stack
+void generate_expression_stack(generator gen, ast_expression node) {
+    expr_frame *frames = NULL;
+    size_t count = 0, capacity = 0;
+    while (true) {
+        if (node != NULL) { // Operand to generate
+            if (count == capacity) {
+                size_t grown = capacity ? 2 * capacity : 32;
+                expr_frame *tmp = realloc(frames, grown * sizeof *frames);
+                if (tmp == NULL) break; // Out of memory, the expression stays incomplete
+                frames = tmp;
+                capacity = grown;
+            }
+            if (expression_enter(gen, &frames[count], node)) count++;
+            else operand_type(frames, count, loop_expr_type(node, gen->known));
+        }
+        if (count == 0) break;
+        expr_frame *top = &frames[count - 1];
+        node = expression_step(gen, top);
+        if (top->done) {
+            loop_type type = loop_op_type(top->node, top->operands, gen->known);
+            expression_leave(gen, top);
+            count--;
+            operand_type(frames, count, type);
+        }
+    }
+    while (count > 0) {
+        count--;
+        for (int i = 0; i < 4; i++) string_destroy(frames[count].labels[i]);
+    }
+    free(frames);
 }
 
 // Start of recursive expressions
@@ -789,8 +1242,7 @@ void generate_expression(generator gen, char * result, ast_expression node){
 
 // ifj.str handling
 void generate_ifj_str(generator gen, char *result, ast_parameter param) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string label_int = string_create(20);
     string label_string = string_create(20);
     string label_end = string_create(20);
@@ -802,7 +1254,7 @@ void generate_ifj_str(generator gen, char *result, ast_parameter param) {
     string_append_literal(label_end, "STR_END_");
     string_append_literal(label_end, tmp);
     
-    move_var(gen, "GF@tmp1", ast_value_to_string(NULL, param));
+    move_value(gen, "GF@tmp1", param);
     ifj_type(gen, "GF@tmp_ifj", "GF@tmp1");
     add_jumpifeq(gen, label_int->data, "GF@tmp_ifj", "string@int");
     add_jumpifeq(gen, label_string->data, "GF@tmp_ifj", "string@float");
@@ -817,16 +1269,31 @@ void generate_ifj_str(generator gen, char *result, ast_parameter param) {
     string_destroy(label_int); string_destroy(label_string); string_destroy(label_end);
 }
 
-// ifj.substring handling
+#define SUBSTRING_CHUNK "int@64"  // characters appended one by one before a chunk is merged
+
+// ifj.substring handling; characters are collected into chunks of SUBSTRING_CHUNK on the
+// data stack and equal chunks are merged like a binary counter, so every character is
+// copied O(log m) times instead of once per following character
 void generate_substring(generator gen, char *result, char *var1, char *var2, char *var3) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string skip_label = string_create(20);
     string_append_literal(skip_label, "SKIP_SUB_");
     string_append_literal(skip_label, tmp);
-    string loop_label = string_create(20);
-    string_append_literal(loop_label, "LOOP_SUB_");
-    string_append_literal(loop_label, tmp);
+    string chunk_label = string_create(20);
+    string_append_literal(chunk_label, "CHUNK_SUB_");
+    string_append_literal(chunk_label, tmp);
+    string char_label = string_create(20);
+    string_append_literal(char_label, "CHAR_SUB_");
+    string_append_literal(char_label, tmp);
+    string merge_label = string_create(20);
+    string_append_literal(merge_label, "MERGE_SUB_");
+    string_append_literal(merge_label, tmp);
+    string fold_label = string_create(20);
+    string_append_literal(fold_label, "FOLD_SUB_");
+    string_append_literal(fold_label, tmp);
+    string next_label = string_create(20);
+    string_append_literal(next_label, "NEXT_SUB_");
+    string_append_literal(next_label, tmp);
 
     move_var(gen, "GF@tmp2", var2);
     move_var(gen, "GF@tmp3", var3);
@@ -841,34 +1308,71 @@ void generate_substring(generator gen, char *result, char *var1, char *var2, cha
     op_eq(gen, "GF@tmp_ifj", "GF@tmp_type_r", "string@int");
     add_jumpifeq(gen, "ERR26", "GF@tmp_ifj", "bool@false");
 
+    // The length goes to GF@tmp_type_l, the result may be GF@tmp1
     move_var(gen, result, "nil@nil");
-    ifj_strlen(gen, "GF@tmp1", var1);
+    ifj_strlen(gen, "GF@tmp_type_l", var1);
     op_lt(gen, "GF@tmp_ifj", "GF@tmp2", "int@0");
     add_jumpifeq(gen, skip_label->data, "GF@tmp_ifj", "bool@true");
-    op_lt(gen, "GF@tmp_ifj", "GF@tmp2", "GF@tmp1");
+    op_lt(gen, "GF@tmp_ifj", "GF@tmp2", "GF@tmp_type_l");
     add_jumpifeq(gen, skip_label->data, "GF@tmp_ifj", "bool@false");
     op_lt(gen, "GF@tmp_ifj", "GF@tmp3", "int@0");
     add_jumpifeq(gen, skip_label->data, "GF@tmp_ifj", "bool@true");
-    op_lt(gen, "GF@tmp_ifj", "GF@tmp3", "GF@tmp1");
+    op_lt(gen, "GF@tmp_ifj", "GF@tmp3", "GF@tmp_type_l");
     add_jumpifeq(gen, skip_label->data, "GF@tmp_ifj", "bool@false");
 
-    move_var(gen, result, "string@");
+    // GF@tmp_l is the position, GF@tmp_type_l counts the chunks on the stack
     move_var(gen, "GF@tmp_l", "GF@tmp2");
-    label(gen, loop_label->data);
+    move_var(gen, "GF@tmp_type_l", "int@0");
+    label(gen, chunk_label->data);
     op_lt(gen, "GF@tmp_ifj", "GF@tmp_l", "GF@tmp3");
-    add_jumpifeq(gen, skip_label->data, "GF@tmp_ifj", "bool@false");
-    ifj_getchar(gen, "GF@tmp_r", var1, "GF@tmp_l");
-    op_concat(gen, result, result, "GF@tmp_r");
+    add_jumpifeq(gen, fold_label->data, "GF@tmp_ifj", "bool@false");
+    move_var(gen, "GF@tmp_r", "string@");
+    op_add(gen, "GF@tmp2", "GF@tmp_l", SUBSTRING_CHUNK); // End of the chunk
+    op_lt(gen, "GF@tmp_ifj", "GF@tmp2", "GF@tmp3");
+    add_jumpifeq(gen, char_label->data, "GF@tmp_ifj", "bool@true");
+    move_var(gen, "GF@tmp2", "GF@tmp3");
+    label(gen, char_label->data);
+    ifj_getchar(gen, result, var1, "GF@tmp_l");
+    op_concat(gen, "GF@tmp_r", "GF@tmp_r", result);
     op_add(gen, "GF@tmp_l", "GF@tmp_l", "int@1");
-    jump(gen, loop_label->data);
+    add_jumpifneq(gen, char_label->data, "GF@tmp_l", "GF@tmp2");
+    push(gen, "GF@tmp_r");
+    op_add(gen, "GF@tmp_type_l", "GF@tmp_type_l", "int@1");
+
+    // Each trailing zero bit of the count merges the two topmost chunks of equal size
+    move_var(gen, "GF@tmp_type_r", "GF@tmp_type_l");
+    label(gen, merge_label->data);
+    op_idiv(gen, "GF@tmp2", "GF@tmp_type_r", "int@2");
+    op_mul(gen, "GF@tmp_ifj", "GF@tmp2", "int@2");
+    add_jumpifneq(gen, chunk_label->data, "GF@tmp_ifj", "GF@tmp_type_r");
+    pop(gen, "GF@tmp_r");
+    pop(gen, result);
+    op_concat(gen, result, result, "GF@tmp_r");
+    push(gen, result);
+    move_var(gen, "GF@tmp_type_r", "GF@tmp2");
+    jump(gen, merge_label->data);
+
+    // One chunk per set bit of the count is left, the smallest on top
+    label(gen, fold_label->data);
+    move_var(gen, result, "string@");
+    label(gen, next_label->data);
+    add_jumpifeq(gen, skip_label->data, "GF@tmp_type_l", "int@0");
+    op_idiv(gen, "GF@tmp2", "GF@tmp_type_l", "int@2");
+    op_mul(gen, "GF@tmp_ifj", "GF@tmp2", "int@2");
+    move_var(gen, "GF@tmp_type_r", "GF@tmp_type_l");
+    move_var(gen, "GF@tmp_type_l", "GF@tmp2");
+    add_jumpifeq(gen, next_label->data, "GF@tmp_ifj", "GF@tmp_type_r");
+    pop(gen, "GF@tmp_r");
+    op_concat(gen, result, "GF@tmp_r", result);
+    jump(gen, next_label->data);
     label(gen, skip_label->data);
-    string_destroy(loop_label); string_destroy(skip_label);
+    string_destroy(chunk_label); string_destroy(char_label); string_destroy(merge_label);
+    string_destroy(fold_label); string_destroy(next_label); string_destroy(skip_label);
 }
 
 // ifj.strcmp handling
 void generate_strcmp(generator gen, char *result, char *left, char *right) {
-    char tmp[20];
-    snprintf(tmp, 20, "%u", gen->counter++);
+    char *tmp = label_id(gen);
     string loop_label = string_create(20);
     string_append_literal(loop_label, "LOOP_CMP_");
     string_append_literal(loop_label, tmp);
@@ -906,22 +1410,61 @@ void generate_strcmp(generator gen, char *result, char *left, char *right) {
     string_destroy(loop_label); string_destroy(same_label); string_destroy(skip_label);
 }
 
+#define IFJ_MAX_ARGS 3  // substring has the most arguments
+
+// Expression arguments of a builtin (FUNEXP), arguments up to the last expression one are evaluated
+// in call order on the stack and popped to GF@tmp_argN, params is replaced by references to them
+static ast_parameter generate_ifj_args(generator gen, ast_parameter params, struct ast_parameter spilled[IFJ_MAX_ARGS]) {
+    int count = 0, last = -1;
+    for (ast_parameter p = params; p && count < IFJ_MAX_ARGS; p = p->next, count++)
+        if (p->value_type == AST_VALUE_EXPRESSION) last = count;
+    if (last < 0) return params;
+
+    ast_parameter p = params;
+    for (int i = 0; i <= last; i++, p = p->next) {
+        if (p->value_type == AST_VALUE_EXPRESSION) generate_expression_stack(gen, p->expression);
+        else push_value(gen, p);
+    }
+    static char *names[IFJ_MAX_ARGS] = { "GF@tmp_arg0", "GF@tmp_arg1", "GF@tmp_arg2" };
+    for (int i = last; i >= 0; i--) {
+        pop(gen, names[i]);
+        spilled[i].value_type = AST_VALUE_IDENTIFIER;
+        spilled[i].value.string_value = names[i];
+        spilled[i].expression = NULL;
+        spilled[i].cg_name = NULL;
+        spilled[i].next = i < last ? &spilled[i + 1] : p;
+    }
+    return &spilled[0];
+}
+
+// Type of a literal or variable argument of a builtin (typed loop copy, typed global)
+static loop_type argument_type(generator gen, ast_parameter param) {
+    switch (param->value_type) {
+        case AST_VALUE_INT: return LOOP_TYPE_INT;
+        case AST_VALUE_STRING: return LOOP_TYPE_STRING;
+        case AST_VALUE_IDENTIFIER:
+            return loop_var_type(gen->known, param->cg_name && strcmp(param->cg_name, "") ? param->cg_name : param->value.string_value);
+        default: return LOOP_TYPE_ANY;
+    }
+}
+
 // All IFJ functions handling
 void generate_ifjfunction(generator gen, char* name, ast_parameter params, char* output) {
+    struct ast_parameter spilled[IFJ_MAX_ARGS];
+    params = generate_ifj_args(gen, params, spilled);
     if(strcmp(name, "str") == 0) generate_ifj_str(gen, output, params);
     else if(strcmp(name, "chr") == 0) {
-        move_var(gen, "GF@tmp1", ast_value_to_string(NULL, params));
+        move_value(gen, "GF@tmp1", params);
         float_int_conversion(gen, "GF@tmp1");
         ifj_int2char(gen, output, "GF@tmp1");
     }
     else if(strcmp(name, "floor") == 0) {
-        char tmp[20];
-        snprintf(tmp, 20, "%u", gen->counter++);
+        char *tmp = label_id(gen);
         string is_float = string_create(20);
         string_append_literal(is_float, "IS_FLOAT_");
         string_append_literal(is_float, tmp);
 
-        move_var(gen, "GF@tmp1", ast_value_to_string(NULL, params));
+        move_value(gen, "GF@tmp1", params);
         ifj_type(gen, "GF@tmp_ifj", "GF@tmp1");
         op_eq(gen, "GF@tmp_ifj", "GF@tmp_ifj", "string@float");
         add_jumpifeq(gen, is_float->data, "GF@tmp_ifj", "bool@false");
@@ -931,15 +1474,20 @@ void generate_ifjfunction(generator gen, char* name, ast_parameter params, char*
         label(gen, is_float->data);
         string_destroy(is_float);
     }
-    else if(strcmp(name, "length") == 0) ifj_strlen(gen, output, ast_value_to_string(NULL, params));
+    else if(strcmp(name, "length") == 0) {
+        char *value = ast_value_to_string(gen, NULL, params);
+        ifj_strlen(gen, output, value);
+        operand_free(value);
+    }
     else if(strcmp(name, "ord") == 0) {
-        move_var(gen, "GF@tmp1", ast_value_to_string(NULL, params->next));
+        move_value(gen, "GF@tmp1", params->next);
         float_int_conversion(gen, "GF@tmp1");
-        ifj_stri2int(gen, output, ast_value_to_string(NULL, params), "GF@tmp1");
+        char *value = ast_value_to_string(gen, NULL, params);
+        ifj_stri2int(gen, output, value, "GF@tmp1");
+        operand_free(value);
     }
     else if(strcmp(name, "read_num") == 0) {
-        char tmp[20];
-        snprintf(tmp, 20, "%u", gen->counter++);
+        char *tmp = label_id(gen);
         string is_float = string_create(20);
         string_append_literal(is_float, "IS_FLOAT_");
         string_append_literal(is_float, tmp);
@@ -953,16 +1501,30 @@ void generate_ifjfunction(generator gen, char* name, ast_parameter params, char*
         string_destroy(is_float);
     }
     else if(strcmp(name, "read_str") == 0) ifj_read(gen, output, "string");
-    else if(strcmp(name, "strcmp") == 0) generate_strcmp(gen, output, ast_value_to_string(NULL, params), ast_value_to_string(NULL, params->next));
-    else if(strcmp(name, "substring") == 0) generate_substring(gen, output, ast_value_to_string(NULL, params), ast_value_to_string(NULL, params->next), ast_value_to_string(NULL, params->next->next));
+    else if(strcmp(name, "strcmp") == 0) {
+        char *left = ast_value_to_string(gen, NULL, params), *right = ast_value_to_string(gen, NULL, params->next);
+        generate_strcmp(gen, output, left, right);
+        operand_free(left); operand_free(right);
+    }
+    else if(strcmp(name, "substring") == 0) {
+        char *text = ast_value_to_string(gen, NULL, params), *from = ast_value_to_string(gen, NULL, params->next);
+        char *to = ast_value_to_string(gen, NULL, params->next->next);
+        generate_substring(gen, output, text, from, to);
+        operand_free(text); operand_free(from); operand_free(to);
+    }
+    else if(strcmp(name, "write") == 0 && options.opt_level > 0 &&
+            (argument_type(gen, params) == LOOP_TYPE_INT || argument_type(gen, params) == LOOP_TYPE_STRING)) {
+        char *value = ast_value_to_string(gen, NULL, params); // No float to print as an int
+        ifj_write(gen, value);
+        operand_free(value);
+    }
     else if(strcmp(name, "write") == 0) {
-        char tmp[20];
-        snprintf(tmp, 20, "%u", gen->counter++);
+        char *tmp = label_id(gen);
         string is_float_label = string_create(20);
         string_append_literal(is_float_label, "IS_FLOAT_");
         string_append_literal(is_float_label, tmp);
         
-        move_var(gen, "GF@tmp1", ast_value_to_string(NULL, params));
+        move_value(gen, "GF@tmp1", params);
 
         ifj_type(gen, "GF@tmp_ifj", "GF@tmp1");
         op_eq(gen, "GF@tmp2", "GF@tmp_ifj", "string@float");
@@ -983,8 +1545,6 @@ void generate_ifjfunction(generator gen, char* name, ast_parameter params, char*
 
 // Function generation with parameters handling
 void generate_function_call(generator gen, ast_node node, ast_expression expr_node){
-    stack stack;
-    stack_init(&stack);
     ast_parameter param;
     char *name;
     if (node) {
@@ -994,17 +1554,15 @@ void generate_function_call(generator gen, ast_node node, ast_expression expr_no
         param = expr_node->operands.function_call->parameters;
         name = expr_node->operands.function_call->name;
     }
-    while(param != NULL){
-        stack_push(&stack, ast_value_to_string(NULL, param));
+    string callee = string_create(32);
+    function_label(callee, name, param);
+    while(param != NULL){ // Arguments in call order, expressions are evaluated directly on the stack
+        if (param->value_type == AST_VALUE_EXPRESSION) generate_expression_stack(gen, param->expression);
+        else push_value(gen, param);
         param = param->next;
     }
-    char *param_name;
-    while(!stack_is_empty(&stack)){
-        param_name = stack_pop(&stack);
-        push(gen, param_name);
-    }
-    fn_call(gen, name);
-    stack_free(&stack);
+    fn_call(gen, callee->data);
+    string_destroy(callee);
 }
 
 // Return generation
@@ -1017,6 +1575,10 @@ void generate_function_return(generator gen, ast_node node){
 
 // Assignment generation
 void generate_assignment(generator gen, ast_node node){
+    if (gen->induction && gen->induction->update == node) {
+        generate_induction_update(gen, node);
+        return;
+    }
     if(node->data.assignment.value != NULL){
         if (node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, ""))
             generate_expression(gen, node->data.assignment.cg_name, node->data.assignment.value);
@@ -1024,22 +1586,206 @@ void generate_assignment(generator gen, ast_node node){
     }
 }
 
+// Local declaration, a variable with a frame slot is only reset to nil if the slot held another value
+static void declare_local(generator gen, char *name) {
+    if (liveness_slot(gen->slots, name) < 0) define_variable(gen, name);
+    else if (!liveness_is_fresh(gen->slots, name)) move_var(gen, name, "nil@nil");
+}
+
 // Declaration generation
 void generate_declaration(generator gen, ast_node node){
+    char *name = node->data.declaration.name;
     if (node->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, ""))
-        define_variable(gen, node->data.declaration.cg_name);
-    else define_variable(gen, node->data.declaration.name);
+        name = node->data.declaration.cg_name;
+    ast_node next = node->next;
+    if (liveness_slot(gen->slots, name) >= 0 && next && next->type == AST_ASSIGNMENT &&
+        next->data.assignment.cg_name && strcmp(next->data.assignment.cg_name, name) == 0 &&
+        !loop_expr_reads(next->data.assignment.value, name))
+        return; // `var x` directly followed by `x = ...`, the slot is written before any read
+    declare_local(gen, name);
+}
+
+#define IF_TREE_MIN 3   // shortest if/else-if chain lowered to a decision tree
+#define IF_TREE_LEAF 3  // keys tested one by one at the bottom of the tree
+
+// One test `var == literal` of an if/else-if chain
+typedef struct if_case {
+    ast_node node;       // the if, its branch is the body of the case
+    ast_expression var;  // the variable
+    ast_expression key;  // the literal
+    string label;        // start of the body
+} if_case;
+
+// Literal of a condition `var == literal` or `literal == var` with an int or ASCII string literal, else NULL
+static ast_expression if_case_key(ast_expression cond, ast_expression *var) {
+    if (cond == NULL || cond->type != AST_EQUALS) return NULL;
+    ast_expression l = cond->operands.binary_op.left, r = cond->operands.binary_op.right;
+    if (loop_expr_var_name(r)) { ast_expression t = l; l = r; r = t; }
+    if (!loop_expr_var_name(l) || r->type != AST_VALUE) return NULL;
+    *var = l;
+    if (r->operands.identity.value_type == AST_VALUE_INT) return r;
+    if (r->operands.identity.value_type != AST_VALUE_STRING) return NULL;
+    for (const unsigned char *c = (const unsigned char *)r->operands.identity.value.string_value; *c; c++)
+        if (*c > 127) return NULL; // LT order of the interpreter is only known for ASCII
+    return r;
+}
+
+static int if_key_compare(ast_expression a, ast_expression b) {
+    if (a->operands.identity.value_type == AST_VALUE_INT) {
+        int x = a->operands.identity.value.int_value, y = b->operands.identity.value.int_value;
+        return (x > y) - (x < y);
+    }
+    return strcmp(a->operands.identity.value.string_value, b->operands.identity.value.string_value);
+}
+
+static int if_case_order(const void *a, const void *b) {
+    return if_key_compare((*(if_case *const *)a)->key, (*(if_case *const *)b)->key);
+}
+
+// Chain `if (x == c1) {...} else { if (x == c2) {...} else ... }` of one variable against literals
+// of one type; *rest is the else block after the last test. NULL if shorter than IF_TREE_MIN.
+static if_case *if_chain(ast_node node, int *count, ast_block *rest) {
+    if_case *cases = NULL;
+    int n = 0, cap = 0;
+    *rest = NULL;
+    for (ast_node test = node;;) {
+        ast_expression var = NULL, key = if_case_key(test->data.condition.condition, &var);
+        if (key == NULL) break;
+        if (n > 0 && (strcmp(loop_expr_var_name(var), loop_expr_var_name(cases[0].var)) ||
+                      key->operands.identity.value_type != cases[0].key->operands.identity.value_type))
+            break;
+        if (n == cap) {
+            cap = cap ? 2 * cap : 8;
+            if_case *grown = realloc(cases, cap * sizeof *grown);
+            if (grown == NULL) { free(cases); return NULL; }
+            cases = grown;
+        }
+        cases[n++] = (if_case){ .node = test, .var = var, .key = key };
+        *rest = test->data.condition.else_branch;
+        ast_block next = *rest;
+        if (next == NULL || next->first == NULL || next->first->next != NULL || next->first->type != AST_CONDITION) break;
+        test = next->first;
+    }
+    *count = n;
+    if (n < IF_TREE_MIN) { free(cases); return NULL; }
+    return cases;
+}
+
+static string if_label(const char *prefix, const char *id, int index) {
+    char suffix[16];
+    string label = string_create(32);
+    string_append_literal(label, (char *)prefix);
+    string_append_literal(label, (char *)id);
+    snprintf(suffix, sizeof suffix, "_%d", index);
+    string_append_literal(label, suffix);
+    return label;
+}
+
+// Balanced search over sorted keys[lo, hi), the variable already has the type of the keys
+static void generate_if_split(generator gen, if_case **keys, int lo, int hi, char *var, char *miss, const char *id, int *splits) {
+    while (hi - lo > IF_TREE_LEAF) {
+        int mid = lo + (hi - lo) / 2;
+        char *key = ast_value_to_string(gen, keys[mid]->key, NULL);
+        string lower = if_label("ifSplit", id, (*splits)++);
+        add_jumpifeq(gen, keys[mid]->label->data, var, key);
+        op_lt(gen, "GF@tmp_if", var, key);
+        add_jumpifeq(gen, lower->data, "GF@tmp_if", "bool@true");
+        generate_if_split(gen, keys, mid + 1, hi, var, miss, id, splits);
+        label(gen, lower->data);
+        string_destroy(lower);
+        free(key);
+        hi = mid;
+    }
+    for (int i = lo; i < hi; i++) {
+        char *key = ast_value_to_string(gen, keys[i]->key, NULL);
+        add_jumpifeq(gen, keys[i]->label->data, var, key);
+        free(key);
+    }
+    jump(gen, miss);
+}
+
+// If/else-if chain comparing one variable with distinct literals: one type check and a binary search
+// of EQ/LT instead of a coerced comparison per test; other types run the tests in order
+static bool generate_if_tree(generator gen, ast_node node) {
+    int count;
+    ast_block rest;
+    if_case *cases = if_chain(node, &count, &rest);
+    if (cases == NULL) return false;
+    if_case **sorted = malloc(count * sizeof *sorted);
+    if (sorted == NULL) { free(cases); return false; }
+    for (int i = 0; i < count; i++) sorted[i] = &cases[i];
+    qsort(sorted, count, sizeof *sorted, if_case_order);
+    for (int i = 1; i < count; i++) {
+        if (if_key_compare(sorted[i - 1]->key, sorted[i]->key) == 0) { // a repeated key is never taken
+            free(sorted); free(cases);
+            return false;
+        }
+    }
+
+    char *tmp = label_id(gen);
+    string end_label = string_create(20);
+    string_append_literal(end_label, "conditionEnd");
+    string_append_literal(end_label, tmp);
+    string else_label = string_create(20);
+    string_append_literal(else_label, rest ? "ifEnd" : "conditionEnd");
+    string_append_literal(else_label, tmp);
+    string generic_label = string_create(20);
+    string_append_literal(generic_label, "ifGeneric");
+    string_append_literal(generic_label, tmp);
+    for (int i = 0; i < count; i++) cases[i].label = if_label("ifCase", tmp, i);
+
+    char *var = ast_value_to_string(gen, cases[0].var, NULL);
+    bool ints = cases[0].key->operands.identity.value_type == AST_VALUE_INT;
+    int splits = 0;
+    string_append_literal(gen->output, "\n# IF DECISION TREE\n");
+    ifj_type(gen, "GF@tmp_type_l", var);
+    add_jumpifneq(gen, generic_label->data, "GF@tmp_type_l", ints ? "string@int" : "string@string");
+    generate_if_split(gen, sorted, 0, count, var, else_label->data, tmp, &splits);
+
+    // Other types keep the coercion and the runtime type errors of the plain chain
+    label(gen, generic_label->data);
+    for (int i = 0; i < count; i++) {
+        cse_new_block(gen->cse);
+        generate_expression(gen, "GF@tmp_if", cases[i].node->data.condition.condition);
+        add_jumpifeq(gen, cases[i].label->data, "GF@tmp_if", "bool@true");
+    }
+    jump(gen, else_label->data);
+    string_append_literal(gen->output, "# IF DECISION TREE END\n\n");
+
+    for (int i = 0; i < count; i++) {
+        label(gen, cases[i].label->data);
+        string_append_literal(gen->output, "# IF BRANCH\n");
+        if (cases[i].node->data.condition.if_branch != NULL)
+            generate_block(gen, cases[i].node->data.condition.if_branch, true);
+        jump(gen, end_label->data);
+        string_destroy(cases[i].label);
+    }
+    if (rest != NULL) {
+        label(gen, else_label->data);
+        string_append_literal(gen->output, "\n# ELSE BRANCH\n");
+        generate_block(gen, rest, true);
+    }
+    label(gen, end_label->data);
+    string_append_literal(gen->output, "\n");
+
+    opt_stats.if_trees++;
+    free(var);
+    free(sorted);
+    free(cases);
+    string_destroy(end_label); string_destroy(else_label); string_destroy(generic_label);
+    return true;
 }
 
 // Condition generation
 void generate_if_statement(generator gen, ast_node node){
-    char tmp[20];
+    if (options.opt_level > 0 && generate_if_tree(gen, node)) return;
+    char *tmp;
     string end_label = string_create(20);
     string else_lable = string_create(20);
     ast_block body;
 
     string_append_literal(end_label, "conditionEnd");
-    snprintf(tmp, 20, "%u", gen->counter++);
+    tmp = label_id(gen);
     string_append_literal(end_label, tmp);
 
     if(node->data.condition.else_branch == NULL)
@@ -1047,13 +1793,12 @@ void generate_if_statement(generator gen, ast_node node){
     else{
         string_clear(else_lable);
         string_append_literal(else_lable, "ifEnd");
-        snprintf(tmp, 20, "%u", gen->counter);
         string_append_literal(else_lable, tmp);
     }
     
     string_append_literal(gen->output, "\n# IF CONDITION\n");
     generate_expression(gen, "GF@tmp_if", node->data.condition.condition);
-    add_jumpifeq(gen, else_lable->data, "GF@tmp_if", "bool@false");
+    generate_falsy_jump(gen, else_lable->data, "GF@tmp_if", expression_is_bool(node->data.condition.condition));
     string_append_literal(gen->output, "# IF CONDITION END\n\n");
 
     if(node->data.condition.if_branch != NULL){
@@ -1074,60 +1819,302 @@ void generate_if_statement(generator gen, ast_node node){
     string_destroy(end_label); string_destroy(else_lable);
 }
 
+// Specialised `var = var ± c` of an induction variable, type guard only if the entry type is unknown
+void generate_induction_update(generator gen, ast_node node) {
+    loop_info *info = gen->induction;
+    char step[32];
+    char *op = info->step < 0 ? "SUB" : "ADD";
+    snprintf(step, 32, "int@%lld", info->step < 0 ? -(long long)info->step : (long long)info->step);
+
+    string_append_literal(gen->output, "# INDUCTION UPDATE\n");
+    if (info->entry_is_int) {
+        binary_operation(gen, op, info->var, info->var, step);
+        return;
+    }
+    char *tmp = label_id(gen);
+    string generic_label = string_create(20);
+    string_append_literal(generic_label, "IV_GENERIC_");
+    string_append_literal(generic_label, tmp);
+    string end_label = string_create(20);
+    string_append_literal(end_label, "IV_END_");
+    string_append_literal(end_label, tmp);
+
+    ifj_type(gen, "GF@tmp_type_l", info->var);
+    add_jumpifneq(gen, generic_label->data, "GF@tmp_type_l", "string@int");
+    binary_operation(gen, op, info->var, info->var, step);
+    jump(gen, end_label->data);
+    label(gen, generic_label->data);
+    generate_expression(gen, info->var, node->data.assignment.value);
+    label(gen, end_label->data);
+    string_destroy(generic_label); string_destroy(end_label);
+}
+
+// Loop condition into GF@tmp_while, plain int compare for an induction variable
+static void generate_loop_condition(generator gen, ast_node node, loop_info *info) {
+    ast_expression cond = node->data.while_loop.condition;
+    if (info == NULL) {
+        generate_expression(gen, "GF@tmp_while", cond);
+        return;
+    }
+    char *bound_var = loop_expr_var_name(info->bound);
+    bool bound_int = bound_var && loop_var_type(gen->known, bound_var) == LOOP_TYPE_INT;
+    bool guarded = !info->entry_is_int || (bound_var && !bound_int);
+    long long bound_value = bound_var ? 0 : info->bound->operands.identity.value.int_value;
+    char bound[32];
+    char *tmp;
+    string generic_label = string_create(20);
+    string end_label = string_create(20);
+
+    string_append_literal(gen->output, "# INDUCTION CONDITION\n");
+    if (guarded) {
+        tmp = label_id(gen);
+        string_append_literal(generic_label, "IV_COND_GENERIC_");
+        string_append_literal(generic_label, tmp);
+        string_append_literal(end_label, "IV_COND_END_");
+        string_append_literal(end_label, tmp);
+        if (!info->entry_is_int) {
+            ifj_type(gen, "GF@tmp_type_l", info->var);
+            add_jumpifneq(gen, generic_label->data, "GF@tmp_type_l", "string@int");
+        }
+        if (bound_var && !bound_int) {
+            ifj_type(gen, "GF@tmp_type_r", bound_var);
+            add_jumpifneq(gen, generic_label->data, "GF@tmp_type_r", "string@int");
+        }
+    }
+
+    // i <= n is i < n + 1 and i >= n is i > n - 1 for literal bounds
+    ast_expression_type cmp = info->cmp;
+    if (!bound_var && cmp == AST_LE && bound_value < 2147483647LL) { cmp = AST_LT; bound_value++; }
+    if (!bound_var && cmp == AST_GE && bound_value > -2147483647LL - 1) { cmp = AST_GT; bound_value--; }
+    if (!bound_var) snprintf(bound, 32, "int@%lld", bound_value);
+    char *right = bound_var ? bound_var : bound;
+
+    switch (cmp) {
+        case AST_LT: op_lt(gen, "GF@tmp_while", info->var, right); break;
+        case AST_GT: op_gt(gen, "GF@tmp_while", info->var, right); break;
+        case AST_LE:
+            op_gt(gen, "GF@tmp_while", info->var, right);
+            op_not(gen, "GF@tmp_while", "GF@tmp_while");
+            break;
+        case AST_GE:
+            op_lt(gen, "GF@tmp_while", info->var, right);
+            op_not(gen, "GF@tmp_while", "GF@tmp_while");
+            break;
+        default:
+            op_eq(gen, "GF@tmp_while", info->var, right);
+            op_not(gen, "GF@tmp_while", "GF@tmp_while");
+            break;
+    }
+
+    if (guarded) {
+        jump(gen, end_label->data);
+        label(gen, generic_label->data);
+        generate_expression(gen, "GF@tmp_while", cond);
+        label(gen, end_label->data);
+    }
+    string_destroy(generic_label); string_destroy(end_label);
+}
+
+#define LOOP_VERSION_DEPTH 2  // nested loops emitted in two copies (typed and generic)
+
+// One emitted copy of a loop; break jumps to end, continue to start
+static void generate_loop_copy(generator gen, ast_node node, loop_info *info, long long copies, char *start, char *end) {
+    loop_labels_t *new_labels = (loop_labels_t *)malloc(sizeof(loop_labels_t)); // Alocation for break and continue handling
+    if (!new_labels) return;
+
+    // Saving the labels for break and continue handling
+    new_labels->start_label = start;
+    new_labels->end_label = end;
+    stack_push(&gen->loop_stack, new_labels);
+
+    // The induction compare is always bool, other conditions follow the falsy rule of if
+    bool is_bool = info != NULL || expression_is_bool(node->data.while_loop.condition);
+    if (options.size) { // Condition emitted once at the top, the body jumps back to it
+        label(gen, start);
+        generate_loop_condition(gen, node, info);
+        generate_falsy_jump(gen, end, "GF@tmp_while", is_bool);
+        for (long long i = 0; i < copies; i++)
+            generate_block(gen, node->data.while_loop.body, false);
+        jump(gen, start);
+    } else {
+        generate_loop_condition(gen, node, info);
+        generate_falsy_jump(gen, end, "GF@tmp_while", is_bool);
+        string_append_literal(gen->output, "\n");
+
+        label(gen, start);
+        for (long long i = 0; i < copies; i++)
+            generate_block(gen, node->data.while_loop.body, false);
+
+        string_append_literal(gen->output, "\n");
+        generate_loop_condition(gen, node, info);
+        if (is_bool) {
+            add_jumpifneq(gen, start, "GF@tmp_while", "bool@false");
+        } else {
+            generate_falsy_jump(gen, end, "GF@tmp_while", false);
+            jump(gen, start);
+        }
+    }
+
+    loop_labels_t *freed_labels = (loop_labels_t *)stack_pop(&gen->loop_stack); // Free for break and continue handling
+    if (freed_labels) free(freed_labels);
+}
+
+static char *loop_type_name(loop_type type) {
+    switch (type) {
+        case LOOP_TYPE_INT: return "string@int";
+        case LOOP_TYPE_FLOAT: return "string@float";
+        case LOOP_TYPE_STRING: return "string@string";
+        default: return "string@bool";
+    }
+}
+
+// Typed copy of a loop, behind a guard testing the entry types of its variables; the generic copy runs if it fails
+static void generate_typed_loop(generator gen, ast_node node, loop_types *types, loop_info *info, long long copies,
+                                char *id, char *generic_start, char *end) {
+    string typed_start = string_create(20);
+    string generic = string_create(20);
+    string_append_literal(typed_start, "whileTyped");
+    string_append_literal(typed_start, id);
+    string_append_literal(generic, "whileGeneric");
+    string_append_literal(generic, id);
+
+    bool guarded = false;
+    for (unsigned i = 0; i < types->count; i++) {
+        if (!types->guarded[i] || types->type[i] == LOOP_TYPE_ANY) continue;
+        if (!guarded) string_append_literal(gen->output, "# LOOP TYPE GUARD\n");
+        guarded = true;
+        ifj_type(gen, "GF@tmp_type_l", (char *)types->var[i]);
+        add_jumpifneq(gen, generic->data, "GF@tmp_type_l", loop_type_name(types->type[i]));
+    }
+
+    loop_info typed_info;
+    if (info) { // Induction variable known to be an int needs no tests
+        typed_info = *info;
+        typed_info.entry_is_int = info->entry_is_int || loop_var_type(types, info->var) == LOOP_TYPE_INT;
+        gen->induction = &typed_info;
+    }
+    const loop_types *outer = gen->known;
+    string_append_literal(gen->output, "# TYPED LOOP\n");
+    gen->known = types;
+    gen->versions += guarded;
+    generate_loop_copy(gen, node, info ? &typed_info : NULL, copies, typed_start->data, end);
+    gen->versions -= guarded;
+    gen->known = outer;
+    if (info) gen->induction = info;
+    opt_stats.typed_loops++;
+
+    if (guarded) {
+        jump(gen, end);
+        label(gen, generic->data);
+        string_append_literal(gen->output, "# GENERIC LOOP\n");
+        cse_new_block(gen->cse); // Entered from the guard
+        gen->versions++;
+        generate_loop_copy(gen, node, info, copies, generic_start, end);
+        gen->versions--;
+        opt_stats.versioned_loops++;
+    }
+    string_destroy(typed_start); string_destroy(generic);
+}
+
 // While loop generation
 void generate_while(generator gen, ast_node node){
-    char tmp[20];
+    char *tmp;
     string while_start = string_create(20);
     string while_end = string_create(20);
     string_append_literal(while_start, "whileStart");
     string_append_literal(while_end, "whileEnd");
-    snprintf(tmp, 20, "%u", gen->counter++);
+    tmp = label_id(gen);
     string_append_literal(while_start, tmp);
     string_append_literal(while_end, tmp);
 
-    loop_labels_t *new_labels = (loop_labels_t *)malloc(sizeof(loop_labels_t)); // Alocation for break and continue handling
-    if (!new_labels) return;
+    // Counter loops: int update/compare, constant trip counts are unrolled
+    loop_info info;
+    bool induction = options.opt_level > 0 && loop_analyze(gen->block, node, &info);
+    loop_info *outer_induction = gen->induction;
+    long long copies = 1;   // body copies per iteration of the emitted loop
+    long long peeled = 0;   // body copies emitted in front of the loop
+    bool emit_loop = true;
+    unsigned unroll = options.size || !(gen->passes & BUDGET_UNROLL) ? 1 : options.unroll;  // copies only grow the code in size mode
+    if (induction) {
+        gen->induction = &info;
+        opt_stats.induction_vars++;
+        if (info.trip_count >= 0 && info.unrollable) {
+            if (info.trip_count == 0) emit_loop = false;
+            else if (unroll > 1 && info.trip_count <= (long long)unroll) {
+                peeled = info.trip_count;
+                emit_loop = false;
+            } else if (unroll > 1) {
+                copies = unroll;
+                peeled = info.trip_count % copies;
+            }
+        }
+    }
 
-    // Saving whileStart and whileEnd for break and continue handling
-    new_labels->start_label = while_start->data; 
-    new_labels->end_label = while_end->data;
-    
-    stack_push(&gen->loop_stack, new_labels);
+    // Loop versioning: a copy with the variable types known, a guard in front of it if they are not proven
+    loop_types types;
+    bool typed = emit_loop && (gen->passes & BUDGET_VERSIONING) && loop_version(gen->block, node, gen->known, &types);
+    bool copy = options.size || gen->versions >= LOOP_VERSION_DEPTH; // no second copy in size mode, nor 2^n of nested loops
+    for (unsigned i = 0; typed && copy && i < types.count; i++)
+        if (types.guarded[i] && types.type[i] != LOOP_TYPE_ANY) typed = false;
 
     string_append_literal(gen->output, "\n# WHILE LOOP START\n");
-    generate_expression(gen, "GF@tmp_while", node->data.while_loop.condition);
-    add_jumpifeq(gen, while_end->data, "GF@tmp_while", "bool@false");
+    if (!emit_loop && peeled == 0) string_append_literal(gen->output, "# NEVER EXECUTED\n");
+    else {
+        ast_block body = node->data.while_loop.body;
+        ast_node current = body->first;
+        while (current) { //Declare before while for double declaration handling
+            if (current->type == AST_VAR_DECLARATION) {
+                if (current->data.declaration.cg_name && strcmp(current->data.declaration.cg_name, ""))
+                    declare_local(gen, current->data.declaration.cg_name);
+                else declare_local(gen, current->data.declaration.name);
+            }
+            current = current->next;
+        }
 
-    string_append_literal(gen->output, "\n");
-    
-    ast_block body = node->data.while_loop.body;
-    ast_node current = body->first;
-    while (current) { //Declare before while for double declaration handling
-        if (current->type == AST_VAR_DECLARATION) {
-            if (current->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, ""))
-                define_variable(gen, current->data.declaration.cg_name);
-            else define_variable(gen, current->data.declaration.name);
+        for (long long i = 0; i < peeled; i++) {
+            string_append_literal(gen->output, "# UNROLLED ITERATION\n");
+            generate_block(gen, body, false);
         }
-        current = current->next;
     }
 
-    label(gen, while_start->data);
-
-    generate_block(gen, node->data.while_loop.body, false);
-
-    string_append_literal(gen->output, "\n");
-    generate_expression(gen, "GF@tmp_while", node->data.while_loop.condition);
-    add_jumpifneq(gen, while_start->data, "GF@tmp_while", "bool@false");
-
-    label(gen, while_end->data);
+    if (typed)
+        generate_typed_loop(gen, node, &types, induction ? &info : NULL, copies, tmp, while_start->data, while_end->data);
+    else if (emit_loop)
+        generate_loop_copy(gen, node, induction ? &info : NULL, copies, while_start->data, while_end->data);
+    if (emit_loop) {
+        label(gen, while_end->data);
+        if (copies > 1) opt_stats.unrolled_loops++;
+    } else opt_stats.removed_loops++;
     string_append_literal(gen->output, "# WHILE LOOP END\n\n");
-
-    loop_labels_t *freed_labels = (loop_labels_t *)stack_pop(&gen->loop_stack); // Free for break and continue handling
-    if (freed_labels) free(freed_labels);
+    gen->induction = outer_induction;
     string_destroy(while_start); string_destroy(while_end);
 }
 
 // Generation of a node
+// Function from the --cache directory; on a miss it is generated and stored.
+// Local labels are numbered per function, so the cached code fits any program.
+static void generate_cached(generator gen, ast_node node, void (*generate)(generator, ast_node)) {
+    gen->passes = options.opt_level > 0 ? budget_passes(node) : 0;
+    if (options.cache_dir == NULL) {
+        generate(gen, node);
+        return;
+    }
+    uint64_t key = fncache_key(node, gen->passes);
+    unsigned helpers = 0;
+    if (fncache_load(options.cache_dir, key, gen->output, &helpers)) {
+        gen->helpers |= helpers;
+        opt_stats.cache_hits++;
+        return;
+    }
+    size_t start = gen->output->length;
+    unsigned outer = gen->helpers;
+    gen->helpers = 0;  // subroutines called by this function alone
+    generate(gen, node);
+    fncache_store(options.cache_dir, key, gen->output->data + start, gen->output->length - start, gen->helpers);
+    gen->helpers |= outer;
+    opt_stats.cache_misses++;
+}
+
 void generate_node(ast_node node, generator gen, bool declare){
     switch(node->type){
         case AST_CONDITION: generate_if_statement(gen, node); break;
@@ -1138,7 +2125,10 @@ void generate_node(ast_node node, generator gen, bool declare){
         case AST_CALL_FUNCTION: generate_function_call(gen, node, NULL); break;
         case AST_RETURN: generate_function_return(gen, node); break;
         case AST_BLOCK: generate_block(gen, node->data.block, true); break;
-        case AST_FUNCTION: case AST_GETTER: case AST_SETTER: generate_function(gen, node); break;
+        case AST_FUNCTION: case AST_GETTER: case AST_SETTER:
+            if (node->type != AST_FUNCTION || strcmp(node->data.function->name, "main")) // main is generated first
+                generate_cached(gen, node, generate_function);
+            break;
         case AST_BREAK: {
             loop_labels_t *current_labels = (loop_labels_t *)stack_top(&gen->loop_stack);
             jump(gen, current_labels->end_label);
@@ -1155,30 +2145,91 @@ void generate_node(ast_node node, generator gen, bool declare){
 
 // Generation of a block
 void generate_block(generator gen, ast_block block, bool declare){
+    ast_block outer = gen->block;
+    gen->block = block;
+    cse_new_block(gen->cse);
     ast_node node = block->first;
     while (node) {
         generate_node(node, gen, declare);
+        if (node->type == AST_CONDITION || node->type == AST_WHILE_LOOP || node->type == AST_BLOCK)
+            cse_new_block(gen->cse); // Basic block ends after control flow
         node = node->next;
     }
+    gen->block = outer;
+}
+
+// End of a function, values and slots of the plan are no longer valid
+static void generate_frame_epilogue(generator gen) {
+    cse_plan_free(gen->cse);
+    liveness_free(gen->slots);
+    gen->cse = NULL;
+    gen->slots = NULL;
+}
+
+// Value numbering and frame slots of a function body, DEFVAR of all slots at function entry
+static void generate_frame_prologue(generator gen, ast_block body) {
+    if (options.opt_level == 0) return;
+    generate_frame_epilogue(gen); // a function nested in a body replaces the plan of the outer one
+    gen->cse = gen->passes & BUDGET_CSE ? cse_plan_function(body) : NULL;
+    gen->slots = gen->passes & BUDGET_SLOTS ? liveness_allocate(body, gen->cse) : NULL;
+
+    char temp[32];
+    if (gen->slots) {
+        for (unsigned i = 0; i < gen->slots->slots; i++) {
+            snprintf(temp, 32, "%%s%u", i);
+            define_variable(gen, temp);
+        }
+        opt_stats.frame_locals += gen->slots->locals;
+        opt_stats.frame_slots += gen->slots->slots;
+    } else if (gen->cse) {
+        for (unsigned i = 0; i < gen->cse->temps; i++) {
+            snprintf(temp, 32, "%%cse%u", i);
+            define_variable(gen, temp);
+        }
+    }
+}
+
+// Header of the output and the global temporaries
+static void define_temporaries(generator gen) {
+    string_append_literal(gen->output, ".IFJcode25 \n\n");
+    define_variable(gen, "GF@tmp_if");
+    define_variable(gen, "GF@tmp_while");
+    define_variable(gen, "GF@tmp_l");
+    define_variable(gen, "GF@tmp_r");
+    define_variable(gen, "GF@tmp_op");
+    define_variable(gen, "GF@tmp_ifj");
+    define_variable(gen, "GF@tmp1");
+    define_variable(gen, "GF@tmp2");
+    define_variable(gen, "GF@tmp3");
+    define_variable(gen, "GF@fn_ret");
+    define_variable(gen, "GF@tmp_type_l");
+    define_variable(gen, "GF@tmp_type_r");
+    define_variable(gen, "GF@tmp_arg0");
+    define_variable(gen, "GF@tmp_arg1");
+    define_variable(gen, "GF@tmp_arg2");
+}
+
+// Subroutines called in -Os and the runtime error label, after all functions
+static void generate_trailer(generator gen) {
+    open_label_scope(gen, "");
+    for (unsigned helper = 1; helper <= HELPER_ALL; helper <<= 1) {
+        if (!(gen->helpers & helper)) continue;
+        label(gen, helper_label(helper));
+        generate_helper_body(gen, helper);
+        return_code(gen);
+    }
+    close_label_scope(gen);
+
+    label(gen, "ERR26"); // Error label for runtime error handling
+    string_append_literal(gen->output, "# ERROR: Incompatible types for binary operation.\n");
+    exit_code(gen, "int@26");
 }
 
 // Start of code initiation
 void init_code(generator gen, ast ast){
     if(ast != NULL && ast->class_list != NULL){
         create_gen(gen);
-        string_append_literal(gen->output, ".IFJcode25 \n\n");
-        define_variable(gen, "GF@tmp_if");
-        define_variable(gen, "GF@tmp_while");
-        define_variable(gen, "GF@tmp_l");
-        define_variable(gen, "GF@tmp_r");
-        define_variable(gen, "GF@tmp_op");
-        define_variable(gen, "GF@tmp_ifj");
-        define_variable(gen, "GF@tmp1");
-        define_variable(gen, "GF@tmp2");
-        define_variable(gen, "GF@tmp3");
-        define_variable(gen, "GF@fn_ret");
-        define_variable(gen, "GF@tmp_type_l");
-        define_variable(gen, "GF@tmp_type_r");
+        define_temporaries(gen);
         sem_def_globals(gen);
     }
 }
@@ -1191,64 +2242,114 @@ void generate_code(generator gen, ast ast){
         ast_node function = program_body->first;
         while (function != NULL) { // Generate main function first
             if (function->type == AST_FUNCTION && strcmp(function->data.function->name, "main") == 0) {
-                generate_main(gen, function);
+                generate_cached(gen, function, generate_main);
                 break;
             }
             function = function->next;
         }
         generate_block(gen, program_body, true); // Generate all other functions
-
-        label(gen, "ERR26"); // Error label for runtime error handling
-        string_append_literal(gen->output, "# ERROR: Incompatible types for binary operation.\n");
-        exit_code(gen, "int@26");
+        generate_trailer(gen);
         string_append_literal(gen->output, "\n#END OF FILE\n");
     }
 }
 
+// Start of a program generated one function at a time, globals are known only at its end
+void init_stream_code(generator gen){
+    create_gen(gen);
+    define_temporaries(gen);
+    jump(gen, "$globals");
+}
+
+// One function of the program, in source order
+void generate_stream_function(generator gen, ast_node node){
+    if (node->type == AST_FUNCTION && strcmp(node->data.function->name, "main") == 0)
+        generate_cached(gen, node, generate_main);
+    else
+        generate_cached(gen, node, generate_function);
+}
+
+// End of the program: globals used by all functions, then main is entered
+void finish_stream_code(generator gen){
+    generate_trailer(gen);
+    label(gen, "$globals");
+    sem_def_globals(gen);
+    jump(gen, "main$0");
+    string_append_literal(gen->output, "\n#END OF FILE\n");
+}
+
+// Parameters are popped in reverse, arguments are pushed in call order
+static void pop_params(generator gen, ast_parameter param) {
+    if (param == NULL) return;
+    pop_params(gen, param->next);
+    char *value = ast_value_to_string(gen, NULL, param);
+    pop(gen, value);
+    operand_free(value);
+}
+
+// Parameter definition
+static void generate_params(generator gen, ast_parameter param) {
+    for (ast_parameter p = param; p != NULL; p = p->next) {
+        char *value = ast_value_to_string(gen, NULL, p);
+        define_variable(gen, value);
+        operand_free(value);
+    }
+    pop_params(gen, param);
+}
+
 // Function/Getter/Setter generation without Main function
 void generate_function(generator gen, ast_node node){
     char *name;
     ast_block fun_body;
     ast_parameter param = NULL;
+    string fn_label = string_create(32);
     if(node->type == AST_FUNCTION) {
         name = node->data.function->name;
         param = node->data.function->parameters;
         fun_body = node->data.function->code;
+        function_label(fn_label, name, param);
     }
     else if(node->type == AST_GETTER) {
         name = node->data.getter.name;
         fun_body = node->data.getter.body;
+        string_append_literal(fn_label, name);
+        string_append_literal(fn_label, "$get");
     }
     else if(node->type == AST_SETTER) {
         name = node->data.setter.name;
         fun_body = node->data.setter.body;
+        string_append_literal(fn_label, name);
+        string_append_literal(fn_label, "$set");
+    }
+    else {
+        string_destroy(fn_label);
+        return;
     }
-    else return;
 
     if (strcmp(name, "main")) { // If not function Main
         string_append_literal(gen->output, "\n# START OF FUNCTION ---");
         string_append_literal(gen->output, name);
         string_append_literal(gen->output, "---\n");
-        label(gen, name);
+        open_label_scope(gen, fn_label->data);
+        label(gen, fn_label->data);
         createframe(gen);
         pushframe(gen);
-        while(param != NULL){
-            define_variable(gen, ast_value_to_string(NULL, param));
-            pop(gen, ast_value_to_string(NULL, param));
-            param = param->next;
-        }
+        generate_params(gen, param);
         if(node->type == AST_SETTER) {
             define_variable(gen, node->data.setter.param);
             pop(gen, node->data.setter.param);
         }
+        generate_frame_prologue(gen, fun_body);
         generate_block(gen, fun_body, true);
+        generate_frame_epilogue(gen);
         popframe(gen);
         string_append_literal(gen->output, "# END OF FUNCTION ---");
         string_append_literal(gen->output, name);
         string_append_literal(gen->output, "---\n");
         move_var(gen, "GF@fn_ret", "nil@nil");
         return_code(gen);
+        close_label_scope(gen);
     }
+    string_destroy(fn_label);
 }
 
 // Main function generation
@@ -1257,21 +2358,25 @@ void generate_main(generator gen, ast_node node) {
     ast_parameter param = node->data.function->parameters;
     ast_block fun_body = node->data.function->code;
 
+    string fn_label = string_create(32);
+    function_label(fn_label, name, param);
+
     string_append_literal(gen->output, "\n# START OF MAIN FUNCTION ---");
     string_append_literal(gen->output, name);
     string_append_literal(gen->output, "---\n");
-    label(gen, name);
+    open_label_scope(gen, fn_label->data);
+    label(gen, fn_label->data);
     createframe(gen);
     pushframe(gen);
-    while(param != NULL){
-        define_variable(gen, ast_value_to_string(NULL, param));
-        pop(gen, ast_value_to_string(NULL, param));
-        param = param->next;
-    }
+    generate_params(gen, param);
+    generate_frame_prologue(gen, fun_body);
     generate_block(gen, fun_body, true);
+    generate_frame_epilogue(gen);
     popframe(gen);
     string_append_literal(gen->output, "# END OF MAIN FUNCTION ---");
     string_append_literal(gen->output, name);
     string_append_literal(gen->output, "---\n");
     exit_code(gen, "int@0\n");
+    close_label_scope(gen);
+    string_destroy(fn_label);
 }
\ No newline at end of file
@@ -13,6 +13,9 @@
 #include "ast.h"
 #include "string.h"
 #include "stack.h"
+#include "loops.h"
+#include "cse.h"
+#include "liveness.h"
 
 /*
  * @brief Structure for loop labels
@@ -27,8 +30,18 @@ typedef struct loop_labels {
  */
 typedef struct generator{
     string output;
-    unsigned counter;
+    unsigned counter;         // local labels of the function being generated, numbered from zero
+    string scope;             // label of the function being generated, prefix of its local labels
+    stack label_ids;          // local label ids of the function, freed at its end
     stack loop_stack;
+    ast_block block;          // block being generated (statements before a loop are analysed)
+    loop_info *induction;     // induction variable of the innermost specialised loop, or NULL
+    const loop_types *known;  // variable types of the typed loop copy being generated, or NULL
+    unsigned versions;        // enclosing loops emitted in a typed and a generic copy
+    cse_plan cse;             // value numbering of the function being generated, or NULL
+    slot_map slots;           // frame slots of the function being generated, or NULL
+    unsigned helpers;         // shared coercion subroutines called so far (-Os)
+    unsigned passes;          // expensive passes granted to the function being generated (budget.h)
 }* generator;
 
 /*
@@ -37,6 +50,7 @@ typedef struct generator{
 enum arity{
     ARITY_UNARY,
     ARITY_BINARY,
+    ARITY_TERNARY,
     ARITY_UNDEFINED
 };
 
@@ -56,4 +70,28 @@ void init_code(generator gen, ast syntree);
  */
 void generate_code(generator gen, ast syntree);
 
+/*
+ * @brief Start of a program generated one function at a time (--stream):
+ *        temporaries and a jump to the globals defined at the end
+ * @param gen code generator
+ * @return void
+ */
+void init_stream_code(generator gen);
+
+/*
+ * @brief Code of one function, getter or setter, appended to the output (--stream)
+ * @param gen code generator
+ * @param function AST_FUNCTION, AST_GETTER or AST_SETTER node after semantic analysis
+ * @return void
+ */
+void generate_stream_function(generator gen, ast_node function);
+
+/*
+ * @brief End of a program generated one function at a time (--stream):
+ *        subroutines, error label, globals of all functions and the jump to main
+ * @param gen code generator
+ * @return void
+ */
+void finish_stream_code(generator gen);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+/**
+ * @file compact.c
+ * @brief Size-optimised rewrite of the emitted IFJcode25 (-Os).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "compact.h"
+
+#define SHORT_NAME_MAX 16
+
+/**
+ * @brief Renaming table: original name -> short name, open addressing.
+ */
+typedef struct {
+    struct rename_entry {
+        char *name;
+        char short_name[SHORT_NAME_MAX];
+    } *entries;
+    size_t cap;
+    size_t count;
+} rename_table;
+
+static size_t hash_name(const char *s, size_t len) {
+    size_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) { h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h;
+}
+
+// n-th short name: a letter followed by base-36 digits, bijective so no name repeats
+static void short_name(size_t n, char *out) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    size_t len = 0;
+    out[len++] = (char)('a' + n % 26);
+    n /= 26;
+    while (n > 0 && len < SHORT_NAME_MAX - 1) {
+        n--;
+        out[len++] = digits[n % 36];
+        n /= 36;
+    }
+    out[len] = '\0';
+}
+
+static bool table_grow(rename_table *t) {
+    if ((t->count + 1) * 2 <= t->cap) return true;
+    size_t cap = t->cap ? t->cap * 2 : 256;
+    struct rename_entry *entries = calloc(cap, sizeof(*entries));
+    if (entries == NULL) return false;
+    for (size_t i = 0; i < t->cap; i++) {
+        if (t->entries[i].name == NULL) continue;
+        size_t j = hash_name(t->entries[i].name, strlen(t->entries[i].name)) & (cap - 1);
+        while (entries[j].name) j = (j + 1) & (cap - 1);
+        entries[j] = t->entries[i];
+    }
+    free(t->entries);
+    t->entries = entries;
+    t->cap = cap;
+    return true;
+}
+
+// Short name of name[0..len), a new one on the first use
+static const char *table_rename(rename_table *t, const char *name, size_t len) {
+    if (!table_grow(t)) return NULL;
+    size_t j = hash_name(name, len) & (t->cap - 1);
+    while (t->entries[j].name) {
+        if (strlen(t->entries[j].name) == len && strncmp(t->entries[j].name, name, len) == 0)
+            return t->entries[j].short_name;
+        j = (j + 1) & (t->cap - 1);
+    }
+    char *copy = malloc(len + 1);
+    if (copy == NULL) return NULL;
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    t->entries[j].name = copy;
+    short_name(t->count++, t->entries[j].short_name);
+    return t->entries[j].short_name;
+}
+
+static void table_free(rename_table *t) {
+    for (size_t i = 0; i < t->cap; i++) free(t->entries[i].name);
+    free(t->entries);
+}
+
+static bool is_label_instruction(const char *op, size_t len) {
+    static const char *ops[] = { "LABEL", "JUMP", "JUMPIFEQ", "JUMPIFNEQ", "CALL", NULL };
+    for (int i = 0; ops[i]; i++)
+        if (strlen(ops[i]) == len && strncmp(ops[i], op, len) == 0) return true;
+    return false;
+}
+
+static bool is_variable(const char *token, size_t len) {
+    return len > 3 && token[2] == '@' && token[1] == 'F' &&
+           (token[0] == 'G' || token[0] == 'L' || token[0] == 'T');
+}
+
+static bool append_range(string out, const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        if (!string_append_char(out, s[i])) return false;
+    return true;
+}
+
+// One instruction line without its comment, operands renamed
+static bool compact_line(string out, const char *line, const char *end, rename_table *labels, rename_table *vars) {
+    const char *op = NULL;
+    size_t op_len = 0;
+    unsigned operand = 0;
+    const char *p = line;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        if (p == end || *p == '#') break;
+        const char *token = p;
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '#') p++;
+        size_t len = (size_t)(p - token);
+
+        if (op == NULL) {
+            op = token;
+            op_len = len;
+            if (!append_range(out, token, len)) return false;
+            continue;
+        }
+        if (!string_append_char(out, ' ')) return false;
+        if (operand++ == 0 && is_label_instruction(op, op_len)) {
+            const char *name = table_rename(labels, token, len);
+            if (name == NULL || !string_append_literal(out, (char *)name)) return false;
+        } else if (is_variable(token, len)) {
+            const char *name = table_rename(vars, token + 3, len - 3);
+            if (name == NULL || !append_range(out, token, 3) || !string_append_literal(out, (char *)name))
+                return false;
+        } else if (!append_range(out, token, len)) return false;
+    }
+    return op == NULL || string_append_char(out, '\n');
+}
+
+string compact_code(const char *code) {
+    string out = string_create(strlen(code) / 2 + 16);
+    if (out == NULL) return NULL;
+    rename_table labels = { NULL, 0, 0 };
+    rename_table vars = { NULL, 0, 0 };
+    bool ok = true;
+
+    for (const char *line = code; *line && ok; ) {
+        const char *end = strchr(line, '\n');
+        if (end == NULL) end = line + strlen(line);
+        ok = compact_line(out, line, end, &labels, &vars);
+        line = *end ? end + 1 : end;
+    }
+
+    table_free(&labels);
+    table_free(&vars);
+    if (!ok) {
+        string_destroy(out);
+        return NULL;
+    }
+    return out;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file compact.h
+ * @brief Size-optimised rewrite of the emitted IFJcode25 (-Os).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_COMPACT
+#define IFJ_COMPACT
+
+#include "string.h"
+
+/**
+ * @brief Removes comments and blank lines and gives labels and variables short names.
+ *
+ * Labels (operand of LABEL, JUMP*, CALL) and variable names (the part after
+ * GF@/LF@/TF@) are renamed through two tables to the shortest free names in
+ * first-use order: a letter followed by base-36 digits. The same variable name
+ * maps to the same short name in every frame. Literals are kept as they are,
+ * string literals contain no whitespace or '#' after escaping.
+ *
+ * @param code complete program emitted by the code generator
+ * @return compacted program, NULL on allocation failure
+ */
+string compact_code(const char *code);
+
+#endif /* IFJ_COMPACT */
@@ -0,0 +1,891 @@
+/**
+ * @file consteval.c
+ * @brief Compile-time evaluation of calls of pure user functions with constant arguments.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+
+#include "consteval.h"
+#include "budget.h"
+#include "loops.h"
+#include "options.h"
+
+/**
+ * @brief Runtime value, bool is kept in i.
+ */
+typedef enum { CV_INT, CV_FLOAT, CV_STRING, CV_NIL, CV_BOOL } cv_type;
+
+typedef struct {
+    cv_type type;
+    long long i;
+    double f;
+    const char *s;
+} cv_value;
+
+/**
+ * @brief Local variable of an evaluated call, set is false until the first assignment.
+ */
+typedef struct {
+    const char *name;
+    cv_value value;
+    bool set;
+} cv_var;
+
+typedef struct {
+    cv_var *vars;
+    size_t count;
+    size_t cap;
+} cv_frame;
+
+/**
+ * @brief User function: pure after the fixed point in mark_pure().
+ */
+typedef struct {
+    const char *name;
+    int arity;
+    ast_function fn;
+    bool pure;
+} ce_function;
+
+/**
+ * @brief Evaluator state: function table, limits and strings of the current call.
+ */
+typedef struct {
+    ce_function *functions;
+    size_t function_count;
+    unsigned steps;      // steps of the current top-level call
+    unsigned total;      // steps of the whole program
+    unsigned depth;
+    char **strings;
+    size_t string_count;
+    size_t string_cap;
+    ast tree;            // owns the folded string literals
+} evaluator;
+
+typedef enum { EXEC_NEXT, EXEC_RETURN, EXEC_BREAK, EXEC_FAIL } exec_status;
+
+// ------------------------------------------------------------------ helpers
+
+static const char *param_name(ast_parameter p) {
+    return p->cg_name && strcmp(p->cg_name, "") ? p->cg_name : p->value.string_value;
+}
+
+static bool is_global(const char *name) {
+    if (strncmp(name, "GF@", 3) == 0) return true;
+    return name[0] == '_' && name[1] == '_';
+}
+
+static int count_params(ast_parameter p) {
+    int count = 0;
+    for (; p; p = p->next) count++;
+    return count;
+}
+
+static ce_function *find_function(evaluator *ev, const char *name, int arity) {
+    for (size_t i = 0; i < ev->function_count; i++)
+        if (ev->functions[i].arity == arity && strcmp(ev->functions[i].name, name) == 0)
+            return &ev->functions[i];
+    return NULL;
+}
+
+static bool pure_builtin(const char *name) {
+    static const char *pure[] = { "length", "ord", "chr", "str", "floor", "substring", "strcmp", NULL };
+    for (int i = 0; pure[i]; i++)
+        if (strcmp(pure[i], name) == 0) return true;
+    return false;
+}
+
+static bool step(evaluator *ev) {
+    ev->total++;
+    return ++ev->steps <= CONSTEVAL_MAX_STEPS && ev->total <= CONSTEVAL_MAX_TOTAL;
+}
+
+// String owned by the evaluator until the end of the top-level call
+static char *new_string(evaluator *ev, size_t len) {
+    if (len > CONSTEVAL_MAX_STRING) return NULL;
+    if (ev->string_count == ev->string_cap) {
+        size_t cap = ev->string_cap ? ev->string_cap * 2 : 16;
+        char **strings = realloc(ev->strings, cap * sizeof(char *));
+        if (strings == NULL) return NULL;
+        ev->strings = strings;
+        ev->string_cap = cap;
+    }
+    char *s = malloc(len + 1);
+    if (s == NULL) return NULL;
+    ev->strings[ev->string_count++] = s;
+    s[len] = '\0';
+    return s;
+}
+
+static void free_strings(evaluator *ev) {
+    for (size_t i = 0; i < ev->string_count; i++) free(ev->strings[i]);
+    ev->string_count = 0;
+}
+
+static bool int_value(long long v, cv_value *out) {
+    if (v < INT_MIN || v > INT_MAX) return false;  // int literals of the generated code are 32-bit
+    out->type = CV_INT;
+    out->i = v;
+    return true;
+}
+
+static bool float_value(double v, cv_value *out) {
+    if (!isfinite(v)) return false;
+    out->type = CV_FLOAT;
+    out->f = v;
+    return true;
+}
+
+static void bool_value(bool v, cv_value *out) {
+    out->type = CV_BOOL;
+    out->i = v;
+}
+
+// false and null are false, every other value is true (generate_falsy_jump() in codegen.c)
+static bool truthy(const cv_value *v) {
+    return !(v->type == CV_NIL || (v->type == CV_BOOL && !v->i));
+}
+
+/**
+ * @brief Value of a literal as emitted by codegen.
+ *
+ * Float literals are written in single precision and, in expressions, the string
+ * literals "Num", "String" and "Null" are written as the type names of `is`.
+ */
+static void literal(ast_value_type type, int i, double f, const char *s, bool in_expression, cv_value *out) {
+    switch (type) {
+        case AST_VALUE_INT: out->type = CV_INT; out->i = i; break;
+        case AST_VALUE_FLOAT: out->type = CV_FLOAT; out->f = (float)f; break;
+        case AST_VALUE_NULL: out->type = CV_NIL; break;
+        default:
+            out->type = CV_STRING;
+            out->s = s ? s : "";
+            if (in_expression && strcmp(out->s, "Num") == 0) out->s = "int";
+            else if (in_expression && strcmp(out->s, "String") == 0) out->s = "string";
+            else if (in_expression && strcmp(out->s, "Null") == 0) out->s = "nil";
+            break;
+    }
+}
+
+// ------------------------------------------------------------------ frames
+
+static cv_var *frame_find(cv_frame *frame, const char *name) {
+    for (size_t i = 0; i < frame->count; i++)
+        if (strcmp(frame->vars[i].name, name) == 0) return &frame->vars[i];
+    return NULL;
+}
+
+static cv_var *frame_declare(cv_frame *frame, const char *name) {
+    cv_var *var = frame_find(frame, name);
+    if (var == NULL) {
+        if (frame->count == frame->cap) {
+            size_t cap = frame->cap ? frame->cap * 2 : 8;
+            cv_var *vars = realloc(frame->vars, cap * sizeof(cv_var));
+            if (vars == NULL) return NULL;
+            frame->vars = vars;
+            frame->cap = cap;
+        }
+        var = &frame->vars[frame->count++];
+        var->name = name;
+    }
+    var->set = false;  // a redeclared loop local keeps its old value at runtime, not modelled
+    return var;
+}
+
+// ------------------------------------------------------------------ purity
+
+static bool expr_pure(evaluator *ev, ast_expression node);
+
+static bool params_pure(evaluator *ev, ast_parameter p) {
+    for (; p; p = p->next) {
+        if (p->value_type == AST_VALUE_EXPRESSION && !expr_pure(ev, p->expression)) return false;
+        if (p->value_type == AST_VALUE_IDENTIFIER && is_global(param_name(p))) return false;
+    }
+    return true;
+}
+
+static bool call_pure(evaluator *ev, const char *name, ast_parameter params) {
+    ce_function *callee = find_function(ev, name, count_params(params));
+    return callee && callee->pure && params_pure(ev, params);
+}
+
+static bool expr_pure(evaluator *ev, ast_expression node) {
+    bool pure = true;
+    ast_walk walk;
+    ast_walk_init(&walk, node);
+    for (ast_expression e; pure && (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        const char *name = loop_expr_var_name(e);
+        if (name) {
+            pure = !is_global(name);
+            continue;
+        }
+        switch (e->type) {
+            case AST_VALUE:
+                break;
+            case AST_FUNCTION_CALL:
+                pure = call_pure(ev, e->operands.function_call->name, e->operands.function_call->parameters);
+                break;
+            case AST_IFJ_FUNCTION_EXPR:
+                pure = pure_builtin(e->operands.ifj_function->name) &&
+                       params_pure(ev, e->operands.ifj_function->parameters);
+                break;
+            default:  // operators are pure if their operands are, `is` tests the left one only
+                pure = ast_expression_operand_count(e) > 0;
+                break;
+        }
+    }
+    ast_walk_free(&walk);
+    return pure && !walk.failed;
+}
+
+static bool block_pure(evaluator *ev, ast_block block) {
+    if (block == NULL) return true;
+    for (ast_node node = block->first; node; node = node->next) {
+        switch (node->type) {
+            case AST_VAR_DECLARATION:
+                break;
+            case AST_ASSIGNMENT: {
+                const char *target = node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, "")
+                                     ? node->data.assignment.cg_name : node->data.assignment.name;
+                if (is_global(target) || !expr_pure(ev, node->data.assignment.value)) return false;
+                break;
+            }
+            case AST_RETURN:
+                if (!expr_pure(ev, node->data.return_expr.output)) return false;
+                break;
+            case AST_CALL_FUNCTION:
+                if (!call_pure(ev, node->data.function_call->name, node->data.function_call->parameters)) return false;
+                break;
+            case AST_CONDITION:
+                if (!expr_pure(ev, node->data.condition.condition) ||
+                    !block_pure(ev, node->data.condition.if_branch) ||
+                    !block_pure(ev, node->data.condition.else_branch))
+                    return false;
+                break;
+            case AST_WHILE_LOOP:
+                if (!expr_pure(ev, node->data.while_loop.condition) || !block_pure(ev, node->data.while_loop.body))
+                    return false;
+                break;
+            case AST_BLOCK:
+                if (!block_pure(ev, node->data.block)) return false;
+                break;
+            case AST_BREAK: case AST_CONTINUE:
+                break;
+            default:  // builtin statements (Ifj.write), nested definitions
+                return false;
+        }
+    }
+    return true;
+}
+
+// All functions start pure, impure ones are removed until nothing changes (recursion stays pure)
+static void mark_pure(evaluator *ev) {
+    for (size_t i = 0; i < ev->function_count; i++) ev->functions[i].pure = true;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < ev->function_count; i++) {
+            if (ev->functions[i].pure && !block_pure(ev, ev->functions[i].fn->code)) {
+                ev->functions[i].pure = false;
+                changed = true;
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------- evaluation
+
+static bool eval_expr(evaluator *ev, cv_frame *frame, ast_expression node, cv_value *out);
+static bool call_function(evaluator *ev, ce_function *fn, cv_value *args, cv_value *out);
+
+static bool read_var(cv_frame *frame, const char *name, cv_value *out) {
+    cv_var *var = frame_find(frame, name);
+    if (var == NULL || !var->set) return false;  // global, getter or uninitialised variable
+    *out = var->value;
+    return true;
+}
+
+// Arguments are evaluated in call order, at most 3 for builtins
+static bool eval_args(evaluator *ev, cv_frame *frame, ast_parameter p, cv_value *args, int max) {
+    for (int n = 0; p; p = p->next, n++) {
+        if (n >= max) return false;
+        if (p->value_type == AST_VALUE_EXPRESSION) {
+            if (!eval_expr(ev, frame, p->expression, &args[n])) return false;
+        } else if (p->value_type == AST_VALUE_IDENTIFIER) {
+            if (!read_var(frame, param_name(p), &args[n])) return false;
+        } else literal(p->value_type, p->value.int_value, p->value.double_value, p->value.string_value, false, &args[n]);
+    }
+    return true;
+}
+
+// float -> int by FLOAT2INT as the generated code does before int-only builtins
+static void float_to_int(cv_value *v) {
+    if (v->type == CV_FLOAT) {
+        v->type = CV_INT;
+        v->i = (long long)v->f;
+    }
+}
+
+static bool eval_builtin(evaluator *ev, const char *name, cv_value *a, int argc, cv_value *out) {
+    if (strcmp(name, "length") == 0 && argc == 1) {
+        if (a[0].type != CV_STRING) return false;
+        return int_value((long long)strlen(a[0].s), out);
+    }
+    if (strcmp(name, "str") == 0 && argc == 1) {
+        if (a[0].type == CV_FLOAT) return false;  // FLOAT2STR formatting is left to the interpreter
+        if (a[0].type != CV_INT) {
+            out->type = CV_NIL;
+            return true;
+        }
+        char buf[32];
+        int len = snprintf(buf, sizeof buf, "%lld", a[0].i);
+        char *s = new_string(ev, (size_t)len);
+        if (s == NULL) return false;
+        memcpy(s, buf, (size_t)len);
+        out->type = CV_STRING;
+        out->s = s;
+        return true;
+    }
+    if (strcmp(name, "chr") == 0 && argc == 1) {
+        float_to_int(&a[0]);
+        if (a[0].type != CV_INT || a[0].i < 1 || a[0].i > 127) return false;
+        char *s = new_string(ev, 1);
+        if (s == NULL) return false;
+        s[0] = (char)a[0].i;
+        out->type = CV_STRING;
+        out->s = s;
+        return true;
+    }
+    if (strcmp(name, "floor") == 0 && argc == 1) {
+        if (a[0].type != CV_FLOAT) return false;  // the generated code leaves the result unset otherwise
+        return int_value((long long)a[0].f, out);
+    }
+    if (strcmp(name, "ord") == 0 && argc == 2) {
+        float_to_int(&a[1]);
+        if (a[0].type != CV_STRING || a[1].type != CV_INT) return false;
+        if (a[1].i < 0 || a[1].i >= (long long)strlen(a[0].s)) return false;
+        return int_value((unsigned char)a[0].s[a[1].i], out);
+    }
+    if (strcmp(name, "substring") == 0 && argc == 3) {
+        float_to_int(&a[1]);
+        float_to_int(&a[2]);
+        if (a[1].type != CV_INT || a[2].type != CV_INT || a[0].type != CV_STRING) return false;
+        long long len = (long long)strlen(a[0].s), i = a[1].i, j = a[2].i;
+        if (i < 0 || i >= len || j < 0 || j >= len) {
+            out->type = CV_NIL;
+            return true;
+        }
+        size_t n = j > i ? (size_t)(j - i) : 0;
+        char *s = new_string(ev, n);
+        if (s == NULL) return false;
+        memcpy(s, a[0].s + i, n);
+        out->type = CV_STRING;
+        out->s = s;
+        return true;
+    }
+    if (strcmp(name, "strcmp") == 0 && argc == 2) {
+        if (a[0].type != CV_STRING || a[1].type != CV_STRING) return false;
+        long long la = (long long)strlen(a[0].s), lb = (long long)strlen(a[1].s);
+        long long result = la - lb, common = la < lb ? la : lb;
+        for (long long k = 0; k < common; k++)
+            if (a[0].s[k] != a[1].s[k]) result--;
+        return int_value(result, out);
+    }
+    return false;
+}
+
+// int operand next to a float is converted, as in process_auto_corecion
+static void coerce(cv_value *l, cv_value *r) {
+    if (l->type == CV_FLOAT && r->type == CV_INT) {
+        r->type = CV_FLOAT;
+        r->f = (double)r->i;
+    } else if (r->type == CV_FLOAT && l->type == CV_INT) {
+        l->type = CV_FLOAT;
+        l->f = (double)l->i;
+    }
+}
+
+static bool numeric_pair(cv_value *l, cv_value *r) {
+    return l->type == r->type && (l->type == CV_INT || l->type == CV_FLOAT);
+}
+
+static bool arithmetic(ast_expression_type op, cv_value l, cv_value r, cv_value *out) {
+    coerce(&l, &r);
+    if (!numeric_pair(&l, &r)) return false;  // error 26 or an interpreter type error
+    if (l.type == CV_INT) {
+        switch (op) {
+            case AST_ADD: return int_value(l.i + r.i, out);
+            case AST_SUB: return int_value(l.i - r.i, out);
+            default: return int_value(l.i * r.i, out);
+        }
+    }
+    switch (op) {
+        case AST_ADD: return float_value(l.f + r.f, out);
+        case AST_SUB: return float_value(l.f - r.f, out);
+        default: return float_value(l.f * r.f, out);
+    }
+}
+
+static bool concat(evaluator *ev, const char *l, const char *r, cv_value *out) {
+    size_t ll = strlen(l), lr = strlen(r);
+    char *s = new_string(ev, ll + lr);
+    if (s == NULL) return false;
+    memcpy(s, l, ll);
+    memcpy(s + ll, r, lr);
+    out->type = CV_STRING;
+    out->s = s;
+    return true;
+}
+
+static bool repetition(evaluator *ev, cv_value l, cv_value r, cv_value *out) {
+    if (r.type != CV_INT) return false;
+    long long n = r.i > 0 ? r.i : 0;
+    size_t len = strlen(l.s);
+    if (len > 0 && (unsigned long long)n > CONSTEVAL_MAX_STRING / len) return false;
+    char *s = new_string(ev, len * (size_t)n);
+    if (s == NULL) return false;
+    for (long long k = 0; k < n; k++) memcpy(s + len * (size_t)k, l.s, len);
+    out->type = CV_STRING;
+    out->s = s;
+    return true;
+}
+
+// Relational operators after coercion and the type check of the generated code
+static bool compare(ast_expression_type op, cv_value l, cv_value r, cv_value *out) {
+    coerce(&l, &r);
+    if (op == AST_EQUALS || op == AST_NOT_EQUAL) {
+        bool equal;
+        if (r.type == CV_NIL) equal = l.type == CV_NIL;
+        else if (l.type != r.type) return false;  // error 26
+        else if (l.type == CV_INT || l.type == CV_BOOL) equal = l.i == r.i;
+        else if (l.type == CV_FLOAT) equal = l.f == r.f;
+        else equal = strcmp(l.s, r.s) == 0;
+        bool_value(op == AST_EQUALS ? equal : !equal, out);
+        return true;
+    }
+    if (l.type != r.type) return false;
+    int cmp;
+    if (l.type == CV_INT) cmp = (l.i > r.i) - (l.i < r.i);
+    else if (l.type == CV_FLOAT) cmp = (l.f > r.f) - (l.f < r.f);
+    else if (l.type == CV_STRING) cmp = strcmp(l.s, r.s);
+    else return false;
+    switch (op) {
+        case AST_LT: bool_value(cmp < 0, out); break;
+        case AST_GT: bool_value(cmp > 0, out); break;
+        case AST_LE: bool_value(!(cmp > 0), out); break;
+        default: bool_value(!(cmp < 0), out); break;
+    }
+    return true;
+}
+
+static bool eval_binary(evaluator *ev, ast_expression_type op, cv_value l, cv_value r, cv_value *out) {
+    switch (op) {
+        case AST_ADD:
+            if (l.type == CV_STRING && r.type == CV_STRING) return concat(ev, l.s, r.s, out);
+            return arithmetic(AST_ADD, l, r, out);
+        case AST_SUB:
+            return arithmetic(AST_SUB, l, r, out);
+        case AST_MUL:
+            if (l.type == CV_STRING) return repetition(ev, l, r, out);
+            return arithmetic(AST_MUL, l, r, out);
+        case AST_DIV:
+            if (l.type == CV_INT) { l.type = CV_FLOAT; l.f = (double)l.i; }
+            if (r.type == CV_INT) { r.type = CV_FLOAT; r.f = (double)r.i; }
+            if (l.type != CV_FLOAT || r.type != CV_FLOAT || r.f == 0.0) return false;
+            return float_value(l.f / r.f, out);
+        case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE: case AST_GT: case AST_GE:
+            return compare(op, l, r, out);
+        case AST_AND: case AST_OR:
+            bool_value(op == AST_AND ? truthy(&l) && truthy(&r) : truthy(&l) || truthy(&r), out);
+            return true;
+        case AST_CONCAT:
+            if (l.type != CV_STRING || r.type != CV_STRING) return false;
+            return concat(ev, l.s, r.s, out);
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Expression node being evaluated, the value of its last operand is passed in the result.
+ */
+typedef struct {
+    ast_expression node;
+    int step;       // operands evaluated so far
+    cv_value left;  // value of the left operand of a binary operator
+} cv_task;
+
+typedef enum { EVAL_DONE, EVAL_OPERAND, EVAL_FAIL } eval_status;
+
+// One step of a node: its value in result, or the operand to evaluate next
+static eval_status eval_step(evaluator *ev, cv_frame *frame, cv_task *t, cv_value *result, ast_expression *operand) {
+    ast_expression node = t->node;
+    if (t->step++ == 0) {
+        if (!step(ev)) return EVAL_FAIL;
+        const char *name = loop_expr_var_name(node);
+        if (name) return read_var(frame, name, result) ? EVAL_DONE : EVAL_FAIL;
+
+        switch (node->type) {
+            case AST_VALUE:
+                literal(node->operands.identity.value_type, node->operands.identity.value.int_value,
+                        node->operands.identity.value.double_value, node->operands.identity.value.string_value, true,
+                        result);
+                return EVAL_DONE;
+            case AST_FUNCTION_CALL: {
+                ast_fun_call call = node->operands.function_call;
+                ce_function *callee = find_function(ev, call->name, count_params(call->parameters));
+                if (callee == NULL || !callee->pure || callee->arity > CONSTEVAL_MAX_DEPTH) return EVAL_FAIL;
+                cv_value args[CONSTEVAL_MAX_DEPTH];
+                if (!eval_args(ev, frame, call->parameters, args, CONSTEVAL_MAX_DEPTH)) return EVAL_FAIL;
+                return call_function(ev, callee, args, result) ? EVAL_DONE : EVAL_FAIL;
+            }
+            case AST_IFJ_FUNCTION_EXPR: {
+                cv_value args[3];
+                ast_ifj_function call = node->operands.ifj_function;
+                if (!eval_args(ev, frame, call->parameters, args, 3)) return EVAL_FAIL;
+                return eval_builtin(ev, call->name, args, count_params(call->parameters), result) ? EVAL_DONE
+                                                                                                   : EVAL_FAIL;
+            }
+            default:
+                if (ast_expression_operand_count(node) == 0) return EVAL_FAIL;
+                *operand = ast_expression_operand(node, 0);
+                return EVAL_OPERAND;
+        }
+    }
+
+    switch (node->type) {
+        case AST_NOT:
+            bool_value(!truthy(result), result);
+            return EVAL_DONE;
+        case AST_TERNARY:  // null and false select the second branch
+            if (t->step == 2) {
+                *operand = truthy(result) ? node->operands.ternary_op.if_true : node->operands.ternary_op.if_false;
+                return EVAL_OPERAND;
+            }
+            return EVAL_DONE;  // value of the selected branch
+        case AST_IS: {
+            const char *type = node->operands.binary_op.right->operands.identifier.value;
+            cv_type expected = strcmp(type, "Num") == 0 ? CV_INT : strcmp(type, "String") == 0 ? CV_STRING : CV_NIL;
+            bool_value(result->type == expected, result);  // `is Num` compares with the int type only
+            return EVAL_DONE;
+        }
+        default:
+            if (t->step == 2) {
+                t->left = *result;
+                *operand = node->operands.binary_op.right;
+                return EVAL_OPERAND;
+            }
+            return eval_binary(ev, node->type, t->left, *result, result) ? EVAL_DONE : EVAL_FAIL;
+    }
+}
+
+// Evaluated with an explicit stack of nodes, the depth of the expression is limited by memory only
+static bool eval_expr(evaluator *ev, cv_frame *frame, ast_expression node, cv_value *out) {
+    cv_task *tasks = NULL;
+    size_t count = 0, cap = 0;
+    cv_value result;
+    eval_status status = EVAL_OPERAND;
+    ast_expression operand = node;
+    while (status != EVAL_FAIL) {
+        if (status == EVAL_OPERAND) {
+            if (operand == NULL) break;
+            if (count == cap) {
+                size_t grown = cap ? cap * 2 : 16;
+                cv_task *more = realloc(tasks, grown * sizeof(*tasks));
+                if (more == NULL) break;
+                tasks = more;
+                cap = grown;
+            }
+            tasks[count++] = (cv_task){ .node = operand };
+        } else if (count == 0) {
+            break;  // value of the whole expression
+        }
+        status = eval_step(ev, frame, &tasks[count - 1], &result, &operand);
+        if (status == EVAL_DONE) count--;
+    }
+    free(tasks);
+    if (status != EVAL_DONE) return false;
+    *out = result;
+    return true;
+}
+
+// if/while take the truth value of any condition
+static bool eval_condition(evaluator *ev, cv_frame *frame, ast_expression node, bool *out) {
+    cv_value c;
+    if (!eval_expr(ev, frame, node, &c)) return false;
+    *out = truthy(&c);
+    return true;
+}
+
+static exec_status exec_block(evaluator *ev, cv_frame *frame, ast_block block, cv_value *ret) {
+    if (block == NULL) return EXEC_NEXT;
+    for (ast_node node = block->first; node; node = node->next) {
+        if (!step(ev)) return EXEC_FAIL;
+        exec_status status = EXEC_NEXT;
+        switch (node->type) {
+            case AST_VAR_DECLARATION: {
+                const char *name = node->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, "")
+                                   ? node->data.declaration.cg_name : node->data.declaration.name;
+                if (frame_declare(frame, name) == NULL) return EXEC_FAIL;
+                break;
+            }
+            case AST_ASSIGNMENT: {
+                const char *name = node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, "")
+                                   ? node->data.assignment.cg_name : node->data.assignment.name;
+                cv_var *var = frame_find(frame, name);
+                cv_value value;
+                if (var == NULL || !eval_expr(ev, frame, node->data.assignment.value, &value)) return EXEC_FAIL;
+                var->value = value;
+                var->set = true;
+                break;
+            }
+            case AST_RETURN:
+                if (node->data.return_expr.output == NULL ||
+                    !eval_expr(ev, frame, node->data.return_expr.output, ret))
+                    return EXEC_FAIL;
+                return EXEC_RETURN;
+            case AST_CALL_FUNCTION: {
+                ast_fun_call call = node->data.function_call;
+                ce_function *callee = find_function(ev, call->name, count_params(call->parameters));
+                cv_value args[CONSTEVAL_MAX_DEPTH], ignored;
+                if (callee == NULL || !callee->pure || callee->arity > CONSTEVAL_MAX_DEPTH ||
+                    !eval_args(ev, frame, call->parameters, args, CONSTEVAL_MAX_DEPTH) ||
+                    !call_function(ev, callee, args, &ignored))
+                    return EXEC_FAIL;
+                break;
+            }
+            case AST_CONDITION: {
+                bool taken;
+                if (!eval_condition(ev, frame, node->data.condition.condition, &taken)) return EXEC_FAIL;
+                status = exec_block(ev, frame, taken ? node->data.condition.if_branch
+                                                     : node->data.condition.else_branch, ret);
+                break;
+            }
+            case AST_WHILE_LOOP: {
+                bool taken;
+                while (status == EXEC_NEXT) {
+                    if (!eval_condition(ev, frame, node->data.while_loop.condition, &taken)) return EXEC_FAIL;
+                    if (!taken) break;
+                    status = exec_block(ev, frame, node->data.while_loop.body, ret);
+                }
+                if (status == EXEC_BREAK) status = EXEC_NEXT;
+                break;
+            }
+            case AST_BLOCK:
+                status = exec_block(ev, frame, node->data.block, ret);
+                break;
+            case AST_BREAK:
+                return EXEC_BREAK;
+            default:  // continue re-enters the body without the condition, not modelled
+                return EXEC_FAIL;
+        }
+        if (status != EXEC_NEXT) return status;
+    }
+    return EXEC_NEXT;
+}
+
+static bool call_function(evaluator *ev, ce_function *fn, cv_value *args, cv_value *out) {
+    if (ev->depth >= CONSTEVAL_MAX_DEPTH) return false;
+    ev->depth++;
+    cv_frame frame = { NULL, 0, 0 };
+    bool ok = true;
+    int n = 0;
+    for (ast_parameter p = fn->fn->parameters; p && ok; p = p->next, n++) {
+        cv_var *var = frame_declare(&frame, param_name(p));
+        if (var == NULL) ok = false;
+        else {
+            var->value = args[n];
+            var->set = true;
+        }
+    }
+    if (ok) {
+        exec_status status = exec_block(ev, &frame, fn->fn->code, out);
+        if (status == EXEC_NEXT) out->type = CV_NIL;  // end of the body returns null
+        ok = status == EXEC_NEXT || status == EXEC_RETURN;
+    }
+    free(frame.vars);
+    ev->depth--;
+    return ok;
+}
+
+// -------------------------------------------------------------- rewriting
+
+// Literal arguments only, identifiers are not tracked
+static bool constant_args(ast_parameter p, cv_value *args) {
+    for (int n = 0; p; p = p->next, n++) {
+        if (n >= CONSTEVAL_MAX_DEPTH) return false;
+        if (p->value_type == AST_VALUE_IDENTIFIER) return false;
+        if (p->value_type == AST_VALUE_EXPRESSION) {
+            ast_expression e = p->expression;
+            if (e->type != AST_VALUE || e->operands.identity.value_type == AST_VALUE_IDENTIFIER) return false;
+            literal(e->operands.identity.value_type, e->operands.identity.value.int_value,
+                    e->operands.identity.value.double_value, e->operands.identity.value.string_value, true, &args[n]);
+        } else literal(p->value_type, p->value.int_value, p->value.double_value, p->value.string_value, false, &args[n]);
+    }
+    return true;
+}
+
+// Result as a literal node, false for values codegen cannot write back exactly
+static bool store_literal(evaluator *ev, cv_value *v, ast_expression node) {
+    switch (v->type) {
+        case CV_INT:
+            node->operands.identity.value_type = AST_VALUE_INT;
+            node->operands.identity.value.int_value = (int)v->i;
+            break;
+        case CV_FLOAT:
+            if ((double)(float)v->f != v->f) return false;
+            node->operands.identity.value_type = AST_VALUE_FLOAT;
+            node->operands.identity.value.double_value = v->f;
+            break;
+        case CV_NIL:
+            node->operands.identity.value_type = AST_VALUE_NULL;
+            break;
+        case CV_STRING: {
+            if (strcmp(v->s, "Num") == 0 || strcmp(v->s, "String") == 0 || strcmp(v->s, "Null") == 0) return false;
+            char *copy = ast_string_copy(ev->tree, v->s);
+            if (copy == NULL) return false;
+            node->operands.identity.value_type = AST_VALUE_STRING;
+            node->operands.identity.value.string_value = copy;
+            break;
+        }
+        default:
+            return false;
+    }
+    node->type = AST_VALUE;
+    return true;
+}
+
+static void fold_call(evaluator *ev, ast_expression node) {
+    ast_fun_call call = node->operands.function_call;
+    ce_function *callee = find_function(ev, call->name, count_params(call->parameters));
+    cv_value args[CONSTEVAL_MAX_DEPTH], result;
+    if (callee == NULL || !callee->pure || callee->arity > CONSTEVAL_MAX_DEPTH ||
+        !constant_args(call->parameters, args) || ev->total >= CONSTEVAL_MAX_TOTAL)
+        return;
+    ev->steps = 0;
+    ev->depth = 0;
+    bool ok = call_function(ev, callee, args, &result);
+    opt_stats.consteval_steps += ev->steps;
+    if (ok && store_literal(ev, &result, node)) { // the literal took the place of the call
+        ast_parameters_dispose(call->parameters);
+        free(call);
+        opt_stats.consteval_folded++;
+    }
+    free_strings(ev);
+}
+
+static void fold_expr(evaluator *ev, ast_expression node);
+
+static void fold_params(evaluator *ev, ast_parameter p) {
+    for (; p; p = p->next)
+        if (p->value_type == AST_VALUE_EXPRESSION) fold_expr(ev, p->expression);
+}
+
+// Arguments are folded first, so nested calls with constant arguments fold bottom-up
+static void fold_expr(evaluator *ev, ast_expression node) {
+    ast_walk walk;
+    ast_walk_init(&walk, node);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        if (e->type == AST_FUNCTION_CALL) {
+            fold_params(ev, e->operands.function_call->parameters);
+            fold_call(ev, e);
+        } else if (e->type == AST_IFJ_FUNCTION_EXPR) {
+            fold_params(ev, e->operands.ifj_function->parameters);
+        }
+    }
+    ast_walk_free(&walk);
+}
+
+static void fold_block(evaluator *ev, ast_block block) {
+    if (block == NULL) return;
+    for (ast_node node = block->first; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT: fold_expr(ev, node->data.assignment.value); break;
+            case AST_RETURN: fold_expr(ev, node->data.return_expr.output); break;
+            case AST_CALL_FUNCTION: fold_params(ev, node->data.function_call->parameters); break;
+            case AST_IFJ_FUNCTION: fold_params(ev, node->data.ifj_function->parameters); break;
+            case AST_CONDITION:
+                fold_expr(ev, node->data.condition.condition);
+                fold_block(ev, node->data.condition.if_branch);
+                fold_block(ev, node->data.condition.else_branch);
+                break;
+            case AST_WHILE_LOOP:
+                fold_expr(ev, node->data.while_loop.condition);
+                fold_block(ev, node->data.while_loop.body);
+                break;
+            case AST_BLOCK: fold_block(ev, node->data.block); break;
+            case AST_FUNCTION:
+                if (budget_passes(node) & BUDGET_CONSTEVAL) fold_block(ev, node->data.function->code);
+                break;
+            case AST_GETTER:
+                if (budget_passes(node) & BUDGET_CONSTEVAL) fold_block(ev, node->data.getter.body);
+                break;
+            case AST_SETTER:
+                if (budget_passes(node) & BUDGET_CONSTEVAL) fold_block(ev, node->data.setter.body);
+                break;
+            default: break;
+        }
+    }
+}
+
+static bool has_empty_return(ast_block block) {
+    if (block == NULL) return false;
+    for (ast_node node = block->first; node; node = node->next) {
+        switch (node->type) {
+            case AST_RETURN:
+                if (node->data.return_expr.output == NULL) return true;
+                break;
+            case AST_CONDITION:
+                if (has_empty_return(node->data.condition.if_branch) ||
+                    has_empty_return(node->data.condition.else_branch))
+                    return true;
+                break;
+            case AST_WHILE_LOOP: if (has_empty_return(node->data.while_loop.body)) return true; break;
+            case AST_BLOCK: if (has_empty_return(node->data.block)) return true; break;
+            case AST_FUNCTION: if (has_empty_return(node->data.function->code)) return true; break;
+            case AST_GETTER: if (has_empty_return(node->data.getter.body)) return true; break;
+            case AST_SETTER: if (has_empty_return(node->data.setter.body)) return true; break;
+            default: break;
+        }
+    }
+    return false;
+}
+
+// --------------------------------------------------------------- public API
+
+void consteval_program(ast tree) {
+    if (tree == NULL || tree->class_list == NULL) return;
+    ast_block program = tree->class_list->current;
+    if (program == NULL || has_empty_return(program)) return;
+
+    evaluator ev;
+    memset(&ev, 0, sizeof ev);
+    ev.tree = tree;
+    for (ast_node node = program->first; node; node = node->next)
+        if (node->type == AST_FUNCTION) ev.function_count++;
+    if (ev.function_count == 0) return;
+    ev.functions = calloc(ev.function_count, sizeof(ce_function));
+    if (ev.functions == NULL) return;
+    size_t n = 0;
+    for (ast_node node = program->first; node; node = node->next) {
+        if (node->type != AST_FUNCTION) continue;
+        ev.functions[n].name = node->data.function->name;
+        ev.functions[n].arity = count_params(node->data.function->parameters);
+        ev.functions[n].fn = node->data.function;
+        n++;
+    }
+
+    mark_pure(&ev);
+    fold_block(&ev, program);
+    free(ev.functions);
+    free(ev.strings);
+}
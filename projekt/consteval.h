@@ -0,0 +1,35 @@
+/**
+ * @file consteval.h
+ * @brief Compile-time evaluation of calls of pure user functions with constant arguments.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_CONSTEVAL
+#define IFJ_CONSTEVAL
+
+#include "ast.h"
+
+#define CONSTEVAL_MAX_STEPS   10000    // statements and expression nodes evaluated for one call
+#define CONSTEVAL_MAX_TOTAL   1000000  // evaluation steps for the whole program
+#define CONSTEVAL_MAX_DEPTH   32       // nested user function calls
+#define CONSTEVAL_MAX_STRING  1024     // longest string value kept during evaluation
+
+/**
+ * @brief Replaces calls of pure functions with literal arguments by the literal result.
+ *
+ * A function is pure if it reads and writes no globals, calls no input/output
+ * builtin (Ifj.read_*, Ifj.write) and calls only pure functions. Calls are
+ * evaluated on the AST with the coercions of the generated code; a call is kept
+ * when its evaluation would stop with a runtime error (including error 26), runs
+ * out of steps or depth, or produces a value without a literal form (bool).
+ *
+ * Nothing is folded when the program contains a `return` without a value, such
+ * a return hands over the last call result, which a folded call no longer sets.
+ *
+ * @param tree program after semantic analysis (identifiers carry their codegen names)
+ */
+void consteval_program(ast tree);
+
+#endif /* IFJ_CONSTEVAL */
@@ -0,0 +1,455 @@
+/**
+ * @file cse.c
+ * @brief Local value numbering: reuse of repeated pure subexpressions within basic blocks.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "cse.h"
+#include "loops.h"
+#include "string.h"
+
+/**
+ * @brief Planning state of one function.
+ *
+ * - map:     key -> entry of the current basic block (open addressing),
+ * - vars:    variable name -> version (open addressing),
+ * - globals: version shared by all globals, bumped by user function calls,
+ * - position: number of the statement being visited.
+ */
+typedef struct {
+    cse_plan plan;
+    cse_entry *map;
+    size_t map_cap;
+    size_t map_count;
+    struct cse_version { const char *name; unsigned version; } *vars;
+    size_t var_cap;
+    size_t var_count;
+    unsigned globals;
+    unsigned block_temps;
+    unsigned position;
+    bool failed;
+} cse_builder;
+
+static size_t hash_str(const char *s) {
+    size_t h = 2166136261u;
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+static size_t hash_ptr(const void *p) {
+    uintptr_t v = (uintptr_t)p;
+    return (size_t)((v >> 4) * 2654435761u);
+}
+
+// ----------------------------------------------------------------- plan tables
+
+static bool plan_put(cse_plan plan, ast_expression node, cse_entry entry) {
+    if ((plan->slot_count + 1) * 2 > plan->slot_cap) {
+        size_t cap = plan->slot_cap ? plan->slot_cap * 2 : 64;
+        struct cse_slot *slots = calloc(cap, sizeof(*slots));
+        if (slots == NULL) return false;
+        for (size_t i = 0; i < plan->slot_cap; i++) {
+            if (plan->slots[i].node == NULL) continue;
+            size_t j = hash_ptr(plan->slots[i].node) & (cap - 1);
+            while (slots[j].node) j = (j + 1) & (cap - 1);
+            slots[j] = plan->slots[i];
+        }
+        free(plan->slots);
+        plan->slots = slots;
+        plan->slot_cap = cap;
+    }
+    size_t j = hash_ptr(node) & (plan->slot_cap - 1);
+    while (plan->slots[j].node && plan->slots[j].node != node) j = (j + 1) & (plan->slot_cap - 1);
+    if (plan->slots[j].node == NULL) plan->slot_count++;
+    plan->slots[j].node = node;
+    plan->slots[j].entry = entry;
+    return true;
+}
+
+static cse_entry plan_new_entry(cse_plan plan, char *key) {
+    if (plan->entry_count == plan->entry_cap) {
+        size_t cap = plan->entry_cap ? plan->entry_cap * 2 : 32;
+        cse_entry *entries = realloc(plan->entries, cap * sizeof(*entries));
+        if (entries == NULL) return NULL;
+        plan->entries = entries;
+        plan->entry_cap = cap;
+    }
+    cse_entry entry = calloc(1, sizeof(*entry));
+    if (entry == NULL) return NULL;
+    entry->key = key;
+    entry->temp = -1;
+    entry->slot = -1;
+    plan->entries[plan->entry_count++] = entry;
+    return entry;
+}
+
+// ----------------------------------------------------------- builder tables
+
+static unsigned *var_version(cse_builder *b, const char *name) {
+    if ((b->var_count + 1) * 2 > b->var_cap) {
+        size_t cap = b->var_cap ? b->var_cap * 2 : 64;
+        struct cse_version *vars = calloc(cap, sizeof(*vars));
+        if (vars == NULL) { b->failed = true; return NULL; }
+        for (size_t i = 0; i < b->var_cap; i++) {
+            if (b->vars[i].name == NULL) continue;
+            size_t j = hash_str(b->vars[i].name) & (cap - 1);
+            while (vars[j].name) j = (j + 1) & (cap - 1);
+            vars[j] = b->vars[i];
+        }
+        free(b->vars);
+        b->vars = vars;
+        b->var_cap = cap;
+    }
+    size_t j = hash_str(name) & (b->var_cap - 1);
+    while (b->vars[j].name && strcmp(b->vars[j].name, name)) j = (j + 1) & (b->var_cap - 1);
+    if (b->vars[j].name == NULL) {
+        b->vars[j].name = name;
+        b->var_count++;
+    }
+    return &b->vars[j].version;
+}
+
+static cse_entry *map_slot(cse_builder *b, const char *key) {
+    size_t j = hash_str(key) & (b->map_cap - 1);
+    while (b->map[j] && strcmp(b->map[j]->key, key)) j = (j + 1) & (b->map_cap - 1);
+    return &b->map[j];
+}
+
+static bool map_grow(cse_builder *b) {
+    if ((b->map_count + 1) * 2 <= b->map_cap) return true;
+    size_t cap = b->map_cap ? b->map_cap * 2 : 64;
+    cse_entry *map = calloc(cap, sizeof(*map));
+    if (map == NULL) return false;
+    cse_entry *old = b->map;
+    size_t old_cap = b->map_cap;
+    b->map = map;
+    b->map_cap = cap;
+    for (size_t i = 0; i < old_cap; i++)
+        if (old[i]) *map_slot(b, old[i]->key) = old[i];
+    free(old);
+    return true;
+}
+
+/**
+ * @brief Ends a basic block: repeated values get temporaries, the key map is cleared.
+ */
+static void flush_block(cse_builder *b) {
+    for (size_t i = 0; i < b->map_cap; i++) {
+        if (b->map[i] == NULL) continue;
+        if (b->map[i]->uses > 1) b->map[i]->temp = (int)b->block_temps++;
+        b->map[i] = NULL;
+    }
+    b->map_count = 0;
+    if (b->block_temps > b->plan->temps) b->plan->temps = b->block_temps;
+    b->block_temps = 0;
+}
+
+// ------------------------------------------------------------------- keys
+
+static bool pure_builtin(const char *name) {
+    static const char *pure[] = { "length", "ord", "chr", "str", "floor", "substring", "strcmp", NULL };
+    for (int i = 0; pure[i]; i++)
+        if (strcmp(pure[i], name) == 0) return true;
+    return false;
+}
+
+static const char *op_key(ast_expression_type type) {
+    switch (type) {
+        case AST_ADD: return "+"; case AST_SUB: return "-";
+        case AST_MUL: return "*"; case AST_DIV: return "/";
+        case AST_EQUALS: return "=="; case AST_NOT_EQUAL: return "!=";
+        case AST_LT: return "<"; case AST_LE: return "<=";
+        case AST_GT: return ">"; case AST_GE: return ">=";
+        case AST_AND: return "&&"; case AST_OR: return "||";
+        case AST_IS: return "is"; case AST_CONCAT: return "..";
+        case AST_NOT: return "!";
+        default: return NULL;
+    }
+}
+
+static void key_var(cse_builder *b, string key, const char *name) {
+    char buf[48];
+    unsigned *version = var_version(b, name);
+    string_append_literal(key, "v");
+    string_append_literal(key, (char *)name);
+    snprintf(buf, sizeof buf, "#%u", version ? *version : 0);
+    string_append_literal(key, buf);
+    if (name[0] == '_' && name[1] == '_') {
+        snprintf(buf, sizeof buf, ".%u", b->globals);
+        string_append_literal(key, buf);
+    }
+}
+
+static void key_value(string key, ast_value_type type, int int_value, double double_value, const char *str) {
+    char buf[64];
+    switch (type) {
+        case AST_VALUE_INT: snprintf(buf, sizeof buf, "i%d", int_value); break;
+        case AST_VALUE_FLOAT: snprintf(buf, sizeof buf, "f%a", double_value); break;
+        case AST_VALUE_NULL: snprintf(buf, sizeof buf, "n"); break;
+        default: snprintf(buf, sizeof buf, "s%zu:", str ? strlen(str) : 0); break;
+    }
+    string_append_literal(key, buf);
+    if (type == AST_VALUE_STRING && str) string_append_literal(key, (char *)str);
+}
+
+/**
+ * @brief Appends the key of a pure expression, false if the expression is not pure or too large.
+ */
+static bool build_key(cse_builder *b, ast_expression node, string key, unsigned *size) {
+    if (node == NULL || ++*size > CSE_MAX_NODES) return false;
+    const char *name = loop_expr_var_name(node);
+    if (name) {
+        key_var(b, key, name);
+        return true;
+    }
+    if (node->type == AST_VALUE) {
+        key_value(key, node->operands.identity.value_type, node->operands.identity.value.int_value,
+                  node->operands.identity.value.double_value, node->operands.identity.value.string_value);
+        return true;
+    }
+    if (node->type == AST_IFJ_FUNCTION_EXPR) {
+        if (!pure_builtin(node->operands.ifj_function->name)) return false;
+        string_append_literal(key, "(ifj.");
+        string_append_literal(key, node->operands.ifj_function->name);
+        for (ast_parameter p = node->operands.ifj_function->parameters; p; p = p->next) {
+            string_append_literal(key, " ");
+            if (p->value_type == AST_VALUE_EXPRESSION) {
+                if (!build_key(b, p->expression, key, size)) return false;
+            } else if (p->value_type == AST_VALUE_IDENTIFIER)
+                key_var(b, key, p->cg_name && strcmp(p->cg_name, "") ? p->cg_name : p->value.string_value);
+            else key_value(key, p->value_type, p->value.int_value, p->value.double_value, p->value.string_value);
+        }
+        string_append_literal(key, ")");
+        return true;
+    }
+    const char *op = op_key(node->type);
+    if (op == NULL) return false;
+    string_append_literal(key, "(");
+    string_append_literal(key, (char *)op);
+    string_append_literal(key, " ");
+    if (node->type == AST_NOT) {
+        if (!build_key(b, node->operands.unary_op.expression, key, size)) return false;
+    } else {
+        if (!build_key(b, node->operands.binary_op.left, key, size)) return false;
+        string_append_literal(key, " ");
+        if (!build_key(b, node->operands.binary_op.right, key, size)) return false;
+    }
+    string_append_literal(key, ")");
+    return true;
+}
+
+// ------------------------------------------------------------------ walk
+
+static bool contains_call(ast_expression node) {
+    ast_walk walk;
+    bool found = false;
+    ast_walk_init(&walk, node);
+    for (ast_expression e; !found && (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        if (e->type == AST_FUNCTION_CALL) found = true;
+        else if (e->type == AST_IFJ_FUNCTION_EXPR) {
+            for (ast_parameter p = e->operands.ifj_function->parameters; p && !found; p = p->next)
+                found = p->value_type == AST_VALUE_EXPRESSION && contains_call(p->expression);
+        }
+    }
+    ast_walk_free(&walk);
+    return found || walk.failed;  // out of memory: assume the worst
+}
+
+static void visit_expr(cse_builder *b, ast_expression node);
+
+// Expression arguments are evaluated in call order before the call itself
+static void visit_args(cse_builder *b, ast_parameter param) {
+    for (; param; param = param->next)
+        if (param->value_type == AST_VALUE_EXPRESSION) visit_expr(b, param->expression);
+}
+
+/**
+ * @brief Numbers the value of one node, false if it is already computed and its operands are not evaluated again.
+ */
+static bool number_value(cse_builder *b, ast_expression node) {
+    if (node->type == AST_VALUE || node->type == AST_IDENTIFIER) return true;
+
+    string key = string_create(32);
+    unsigned size = 0;
+    if (key == NULL) { b->failed = true; return false; }
+    if (!build_key(b, node, key, &size)) {
+        string_destroy(key);
+        return true;
+    }
+    if (!map_grow(b)) { b->failed = true; string_destroy(key); return false; }
+    cse_entry *slot = map_slot(b, key->data);
+    if (*slot) { // value already computed in this block
+        (*slot)->uses++;
+        (*slot)->last = b->position;
+        if (!plan_put(b->plan, node, *slot)) b->failed = true;
+        string_destroy(key);
+        return false;
+    }
+    char *owned = key->data;
+    free(key);
+    cse_entry entry = plan_new_entry(b->plan, owned);
+    if (entry == NULL || !plan_put(b->plan, node, entry)) { b->failed = true; return false; }
+    entry->uses = 1;
+    entry->first = entry->last = b->position;
+    *slot = entry;
+    b->map_count++;
+    return true;
+}
+
+/**
+ * @brief Counts value occurrences of an expression in codegen evaluation order.
+ */
+static void visit_expr(cse_builder *b, ast_expression node) {
+    ast_walk walk;
+    ast_walk_init(&walk, node);
+    for (ast_expression e; !b->failed && (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) {
+            if (e->type == AST_TERNARY) { // branches are conditional, only their calls matter
+                if (contains_call(e->operands.ternary_op.if_true) || contains_call(e->operands.ternary_op.if_false))
+                    b->globals++;
+            } else if (e->type == AST_AND || e->type == AST_OR) { // right side is conditional, only its calls matter
+                if (contains_call(e->operands.binary_op.right)) b->globals++;
+            }
+            continue;
+        }
+        if (!number_value(b, e)) {
+            ast_walk_skip(&walk);
+            continue;
+        }
+        switch (e->type) {
+            case AST_TERNARY:
+            case AST_AND: case AST_OR:
+                ast_walk_limit(&walk, 1);
+                break;
+            case AST_FUNCTION_CALL: // callee may write any global
+                visit_args(b, e->operands.function_call->parameters);
+                b->globals++;
+                break;
+            case AST_IFJ_FUNCTION_EXPR:
+                visit_args(b, e->operands.ifj_function->parameters);
+                break;
+            default:
+                if (!op_key(e->type)) ast_walk_skip(&walk);
+                break;
+        }
+    }
+    if (walk.failed) b->failed = true;
+    ast_walk_free(&walk);
+}
+
+static void bump_version(cse_builder *b, const char *name) {
+    unsigned *version = var_version(b, name);
+    if (version) (*version)++;
+}
+
+static void visit_block(cse_builder *b, ast_block block) {
+    if (block == NULL) return;
+    for (ast_node node = block->first; node && !b->failed; node = node->next) {
+        b->position++;
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                visit_expr(b, node->data.assignment.value);
+                bump_version(b, node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, "")
+                                ? node->data.assignment.cg_name : node->data.assignment.name);
+                break;
+            case AST_VAR_DECLARATION:
+                bump_version(b, node->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, "")
+                                ? node->data.declaration.cg_name : node->data.declaration.name);
+                break;
+            case AST_CALL_FUNCTION:
+                visit_args(b, node->data.function_call->parameters);
+                b->globals++;
+                break;
+            case AST_IFJ_FUNCTION:
+                visit_args(b, node->data.ifj_function->parameters);
+                break;
+            case AST_RETURN:
+                visit_expr(b, node->data.return_expr.output);
+                break;
+            case AST_CONDITION:
+                visit_expr(b, node->data.condition.condition);
+                flush_block(b);
+                visit_block(b, node->data.condition.if_branch);
+                visit_block(b, node->data.condition.else_branch);
+                break;
+            case AST_WHILE_LOOP: // condition is emitted twice, it is not numbered
+                flush_block(b);
+                visit_block(b, node->data.while_loop.body);
+                break;
+            case AST_BLOCK:
+                flush_block(b);
+                visit_block(b, node->data.block);
+                break;
+            default:
+                break;
+        }
+    }
+    flush_block(b);
+}
+
+// --------------------------------------------------------------- public API
+
+cse_plan cse_plan_function(ast_block body) {
+    cse_plan plan = calloc(1, sizeof(*plan));
+    if (plan == NULL) return NULL;
+    plan->epoch = 1;
+
+    cse_builder b;
+    memset(&b, 0, sizeof b);
+    b.plan = plan;
+    visit_block(&b, body);
+    free(b.map);
+    free(b.vars);
+    if (b.failed) {
+        cse_plan_free(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+void cse_plan_free(cse_plan plan) {
+    if (plan == NULL) return;
+    for (size_t i = 0; i < plan->entry_count; i++) {
+        free(plan->entries[i]->key);
+        free(plan->entries[i]);
+    }
+    free(plan->entries);
+    free(plan->slots);
+    free(plan);
+}
+
+cse_entry cse_find(cse_plan plan, ast_expression node) {
+    if (plan == NULL || plan->slot_cap == 0) return NULL;
+    size_t j = hash_ptr(node) & (plan->slot_cap - 1);
+    while (plan->slots[j].node) {
+        if (plan->slots[j].node == node)
+            return plan->slots[j].entry->temp >= 0 ? plan->slots[j].entry : NULL;
+        j = (j + 1) & (plan->slot_cap - 1);
+    }
+    return NULL;
+}
+
+void cse_new_block(cse_plan plan) {
+    if (plan) plan->epoch++;
+}
+
+bool cse_available(cse_plan plan, cse_entry entry) {
+    return entry->epoch == plan->epoch;
+}
+
+void cse_set_available(cse_plan plan, cse_entry entry) {
+    entry->epoch = plan->epoch;
+}
+
+void cse_temp_name(cse_entry entry, char *buffer, size_t size) {
+    if (entry->slot >= 0) snprintf(buffer, size, "%%s%d", entry->slot);
+    else snprintf(buffer, size, "%%cse%d", entry->temp);
+}
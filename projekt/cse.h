@@ -0,0 +1,95 @@
+/**
+ * @file cse.h
+ * @brief Local value numbering: reuse of repeated pure subexpressions within basic blocks.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_CSE
+#define IFJ_CSE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ast.h"
+
+#define CSE_MAX_NODES 16   // largest subexpression (in nodes) that is numbered
+
+/**
+ * @brief One value computed more than once in a basic block.
+ *
+ * - key:   structural key of the expression (operands carry variable versions),
+ * - uses:  occurrences evaluated in the block,
+ * - temp:  index of the frame temporary LF@%cse<temp>, -1 if the value is used once,
+ * - slot:  frame slot LF@%s<slot> assigned by liveness analysis, -1 if none,
+ * - first, last: positions of the first and last statement using the value
+ *   (pre-order statement numbering shared with liveness.c),
+ * - epoch: generation epoch in which the temporary was filled.
+ */
+typedef struct cse_entry {
+    char *key;
+    unsigned uses;
+    int temp;
+    int slot;
+    unsigned first;
+    unsigned last;
+    unsigned epoch;
+} *cse_entry;
+
+/**
+ * @brief Plan of one function: expression node -> value entry.
+ */
+typedef struct cse_plan {
+    struct cse_slot { ast_expression node; cse_entry entry; } *slots;
+    size_t slot_cap;
+    size_t slot_count;
+    cse_entry *entries;
+    size_t entry_count;
+    size_t entry_cap;
+    unsigned temps;      // number of LF@%cse temporaries the function needs
+    unsigned epoch;      // current basic block during generation
+} *cse_plan;
+
+/**
+ * @brief Numbers the values of all basic blocks of a function body.
+ *
+ * Basic blocks end at if/while/nested blocks. Assignments bump the version of
+ * the assigned variable, user function calls bump the version of all globals.
+ * Branches of the ternary operator are conditional and are not numbered.
+ *
+ * @param body function body
+ * @return plan or NULL on allocation error
+ */
+cse_plan cse_plan_function(ast_block body);
+
+/**
+ * @brief Frees the plan.
+ */
+void cse_plan_free(cse_plan plan);
+
+/**
+ * @brief Returns the entry of @p node if its value is used more than once, else NULL.
+ */
+cse_entry cse_find(cse_plan plan, ast_expression node);
+
+/**
+ * @brief Starts a new basic block during generation, all temporaries become stale.
+ */
+void cse_new_block(cse_plan plan);
+
+/**
+ * @brief Checks if the temporary of @p entry already holds its value in this block.
+ */
+bool cse_available(cse_plan plan, cse_entry entry);
+
+/**
+ * @brief Marks the temporary of @p entry as filled in this block.
+ */
+void cse_set_available(cse_plan plan, cse_entry entry);
+
+/**
+ * @brief Writes the name of the temporary ("%s<slot>" or "%cse<N>") into @p buffer.
+ */
+void cse_temp_name(cse_entry entry, char *buffer, size_t size);
+
+#endif /* IFJ_CSE */
@@ -0,0 +1,369 @@
+/**
+ * @file daemon.c
+ * @brief Compile daemon on a local Unix socket (--daemon=PATH).
+ *
+ * @authors Hana Liškařová (xliskah00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "daemon.h"
+#include "options.h"
+#include "error.h"
+
+// Program compiled once at start-up, touches every stage of the pipeline
+static const char WARMUP_SOURCE[] =
+    "import \"ifj25\" for Ifj\n"
+    "class Program {\n"
+    "    static twice(x) {\n"
+    "        return x + x\n"
+    "    }\n"
+    "    static main() {\n"
+    "        var i\n"
+    "        i = 0\n"
+    "        while (i < 3) {\n"
+    "            Ifj.write(twice(i) * 1.5)\n"
+    "            i = i + 1\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void daemon_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+static bool read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Length-prefixed block, NUL terminated in memory
+static char *read_block(int fd, uint32_t max, uint32_t *len) {
+    if (!read_full(fd, len, sizeof *len) || *len > max) return NULL;
+    char *data = malloc((size_t)*len + 1);
+    if (data == NULL) return NULL;
+    if (!read_full(fd, data, *len)) {
+        free(data);
+        return NULL;
+    }
+    data[*len] = '\0';
+    return data;
+}
+
+static bool write_block(int fd, const char *data, size_t len) {
+    uint32_t n = (uint32_t)len;
+    return write_full(fd, &n, sizeof n) && write_full(fd, data, len);
+}
+
+/**
+ * @brief Compiles a source held in memory, output and messages into memory streams.
+ */
+static int compile_buffer(daemon_compile_fn compile, char *source, size_t len, FILE *output, FILE *diag) {
+    // fmemopen() of an empty buffer is not portable, an empty source reads /dev/null
+    FILE *input = len > 0 ? fmemopen(source, len, "r") : fopen("/dev/null", "r");
+    if (input == NULL) return error(ERR_INTERNAL, "daemon: cannot open the source buffer");
+    int result = compile(input, output, diag);
+    fclose(input);
+    return result;
+}
+
+// Everything written to stderr since the start of the request; fd 2 writes the
+// file directly, so only the descriptor is used (the FILE caches its offset)
+static char *read_diag(int diag, size_t *len) {
+    fflush(stderr);
+    off_t end = lseek(diag, 0, SEEK_CUR);
+    char *data = end > 0 ? malloc((size_t)end) : NULL;
+    ssize_t n = data ? pread(diag, data, (size_t)end, 0) : 0;
+    *len = n > 0 ? (size_t)n : 0;
+    return data;
+}
+
+/**
+ * @brief Compiles one request and answers it.
+ *
+ * stderr is the diag file, emptied by the supervisor, for the time of the
+ * compilation, so error() as well as any other message of the compiler reaches
+ * the client and not the terminal of the daemon.
+ */
+static void daemon_respond(int fd, daemon_compile_fn compile, int argc, char **argv, char *source, size_t len,
+                           int diag, int terminal) {
+    char *out_data = NULL, *diag_data = NULL;
+    size_t out_len = 0, diag_len = 0;
+    FILE *output = open_memstream(&out_data, &out_len);
+    if (output == NULL) return;
+    fflush(stderr);
+    if (dup2(diag, STDERR_FILENO) < 0) {
+        fclose(output);
+        free(out_data);
+        return;
+    }
+
+    options_reset();
+    int result = options_parse(argc, argv);
+    if (result == SUCCESS && options.daemon_socket)
+        result = error(ERR_INTERNAL, "daemon: --daemon is not accepted in a request");
+    if (result == SUCCESS) result = compile_buffer(compile, source, len, output, stderr);
+
+    fclose(output);
+    diag_data = read_diag(diag, &diag_len);
+    dup2(terminal, STDERR_FILENO);
+    int32_t code = result;
+    if (write_full(fd, &code, sizeof code) && write_block(fd, out_data, out_len))
+        write_block(fd, diag_data, diag_len);
+    free(out_data);
+    free(diag_data);
+}
+
+// One connection: reads the request, compiles it and frees it
+static void daemon_serve(int fd, daemon_compile_fn compile, int diag, int terminal) {
+    char *argv[DAEMON_MAX_ARGS + 1] = { "compiler" };
+    uint32_t argc = 0, args = 0, len = 0;
+    if (!read_full(fd, &argc, sizeof argc) || argc > DAEMON_MAX_ARGS) return;
+    while (args < argc && (argv[args + 1] = read_block(fd, DAEMON_MAX_ARG, &len)) != NULL) args++;
+    char *source = args == argc ? read_block(fd, DAEMON_MAX_SOURCE, &len) : NULL;
+    if (source != NULL) daemon_respond(fd, compile, (int)argc + 1, argv, source, len, diag, terminal);
+    free(source);
+    for (uint32_t i = 1; i <= args; i++) free(argv[i]);
+}
+
+/**
+ * @brief Runs the pipeline once, so the first request finds the allocator and
+ *        the symbol table pool (symtable.c) warm.
+ */
+static void daemon_warm_up(daemon_compile_fn compile) {
+    char *out_data = NULL;
+    size_t out_len = 0;
+    FILE *output = open_memstream(&out_data, &out_len);
+    if (output) {
+        compile_buffer(compile, (char *)WARMUP_SOURCE, sizeof WARMUP_SOURCE - 1, output, stderr);
+        fclose(output);
+    }
+    free(out_data);
+    options_reset();
+}
+
+// No descriptor of the daemon is inherited by a program started from it
+static int close_on_exec(int fd) {
+    if (fd >= 0) fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+// Worker process serving the requests, channel is the supervisor end of its socketpair
+typedef struct {
+    pid_t pid;
+    int channel;  // -1 without a worker
+} daemon_worker;
+
+// Hands a connection to the worker as an SCM_RIGHTS message with one data byte
+static bool send_connection(int channel, int fd) {
+    char byte = 0;
+    struct iovec iov = { &byte, 1 };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&control, 0, sizeof control);
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.space;
+    msg.msg_controllen = sizeof control.space;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof fd);
+    ssize_t n;
+    while ((n = sendmsg(channel, &msg, 0)) < 0 && errno == EINTR) {}
+    return n == 1;
+}
+
+// Connection handed over by the supervisor, -1 once the channel is closed
+static int receive_connection(int channel) {
+    char byte;
+    struct iovec iov = { &byte, 1 };
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.space;
+    msg.msg_controllen = sizeof control.space;
+    ssize_t n;
+    while ((n = recvmsg(channel, &msg, 0)) < 0 && errno == EINTR) {}
+    struct cmsghdr *cmsg = n == 1 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof fd);
+    return close_on_exec(fd);
+}
+
+/**
+ * @brief Forks a worker, which answers the connections handed to it over the
+ *        channel in its own process until the supervisor closes the channel.
+ *
+ * The worker leaves the signals to the supervisor and acknowledges every
+ * answered connection with one byte.
+ */
+static bool worker_start(daemon_worker *worker, int listener, daemon_compile_fn compile, int diag, int terminal) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) return false;
+    close_on_exec(pair[0]);
+    close_on_exec(pair[1]);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pair[0]);
+        close(pair[1]);
+        return false;
+    }
+    if (pid == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = SIG_IGN;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        close(listener);
+        close(pair[0]);
+        char done = 0;
+        int fd;
+        while ((fd = receive_connection(pair[1])) >= 0) {
+            daemon_serve(fd, compile, diag, terminal);
+            close(fd);
+            if (!write_full(pair[1], &done, 1)) break;
+        }
+        _exit(SUCCESS);
+    }
+    close(pair[1]);
+    worker->pid = pid;
+    worker->channel = pair[0];
+    return true;
+}
+
+// Waits for the worker to end, returns its exit code as a shell reports it (128 + signal)
+static int worker_reap(daemon_worker *worker) {
+    int status = 0;
+    close(worker->channel);
+    while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR) {}
+    worker->pid = -1;
+    worker->channel = -1;
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : ERR_INTERNAL;
+}
+
+/**
+ * @brief Has the worker answer one connection; if the worker dies on it, the
+ *        supervisor answers instead with what a direct run leaves behind: the
+ *        exit code, no output and the messages written up to the crash.
+ */
+static void daemon_dispatch(daemon_worker *worker, int fd, int diag) {
+    char done;
+    if (ftruncate(diag, 0) != 0 || lseek(diag, 0, SEEK_SET) != 0) return;
+    if (send_connection(worker->channel, fd) && read_full(worker->channel, &done, 1)) return;
+
+    int32_t code = worker_reap(worker);
+    size_t diag_len = 0;
+    char *diag_data = read_diag(diag, &diag_len);
+    if (write_full(fd, &code, sizeof code) && write_block(fd, "", 0)) write_block(fd, diag_data, diag_len);
+    free(diag_data);
+}
+
+int daemon_run(const char *path, daemon_compile_fn compile) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof addr.sun_path)
+        return error(ERR_INTERNAL, "daemon: socket path too long '%s'", path);
+    strcpy(addr.sun_path, path);
+
+    int listener = close_on_exec(socket(AF_UNIX, SOCK_STREAM, 0));
+    if (listener < 0) return error(ERR_INTERNAL, "daemon: cannot create socket");
+    unlink(path);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof addr) != 0 || listen(listener, 64) != 0) {
+        close(listener);
+        return error(ERR_INTERNAL, "daemon: cannot listen on '%s'", path);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = daemon_signal;  // no SA_RESTART: accept() returns on the signal
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);  // client or worker gone before the response
+
+    // stderr of a request is collected here, the daemon keeps its own in terminal
+    FILE *diag = tmpfile();
+    int terminal = close_on_exec(dup(STDERR_FILENO));
+    if (diag == NULL || terminal < 0) {
+        if (diag) fclose(diag);
+        close(listener);
+        return error(ERR_INTERNAL, "daemon: cannot redirect stderr");
+    }
+    close_on_exec(fileno(diag));
+    // Warmed up in the supervisor, so every worker forked from it starts warm
+    daemon_warm_up(compile);
+
+    int result = SUCCESS;
+    daemon_worker worker = { -1, -1 };
+    while (!daemon_stop) {
+        // Started here, with no connection open, so no worker inherits one
+        if (worker.channel < 0 && !worker_start(&worker, listener, compile, fileno(diag), terminal)) {
+            result = error(ERR_INTERNAL, "daemon: cannot start a worker");
+            break;
+        }
+        int fd = close_on_exec(accept(listener, NULL, NULL));
+        if (fd < 0) continue;
+        struct timeval timeout = { DAEMON_TIMEOUT, 0 };  // a stalled client does not block the next ones
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+        daemon_dispatch(&worker, fd, fileno(diag));
+        close(fd);
+    }
+
+    if (worker.channel >= 0) worker_reap(&worker);
+    fclose(diag);
+    close(terminal);
+    close(listener);
+    unlink(path);
+    return result;
+}
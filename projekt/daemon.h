@@ -0,0 +1,56 @@
+/**
+ * @file daemon.h
+ * @brief Compile daemon on a local Unix socket (--daemon=PATH) and its wire format.
+ *
+ * @authors Hana Liškařová (xliskah00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_DAEMON
+#define IFJ_DAEMON
+
+#include <stdio.h>
+
+#define DAEMON_SOCKET_DEFAULT "/tmp/ifj25-compiler.sock"  // used by the client without --socket
+#define DAEMON_SOCKET_ENV     "IFJ25_SOCKET"              // overrides the default socket of the client
+#define DAEMON_MAX_ARGS       32                          // compiler options in one request
+#define DAEMON_MAX_ARG        256                         // length of one option
+#define DAEMON_MAX_SOURCE     (64u << 20)                 // longest accepted source
+#define DAEMON_TIMEOUT        10                          // seconds to receive a request
+
+/*
+ * Wire format, all integers are uint32_t in host byte order (local socket only):
+ *
+ *   request:  argc, argc x (length, bytes), source length, source bytes
+ *   response: exit code, output length, output bytes, stderr length, stderr bytes
+ *
+ * One request per connection, the daemon closes the connection after the response.
+ */
+
+/**
+ * @brief Compiles one program: reads the source from input, writes IFJcode25 to
+ *        output and statistics to diag, returns the exit code of the compiler.
+ */
+typedef int (*daemon_compile_fn)(FILE *input, FILE *output, FILE *diag);
+
+/**
+ * @brief Serves compile requests on a Unix socket until SIGINT or SIGTERM.
+ *
+ * The daemon warms itself up with one compilation and forks a worker, which
+ * inherits the warm allocator arenas and symbol table pool (symtable.c). The
+ * daemon accepts the connections and hands them to the worker one after
+ * another; the worker resets the options and statistics, parses the options of
+ * the request and compiles the source from memory, its stderr is collected
+ * into the response. The pipeline frees all it allocates, so the worker stays
+ * warm from one request to the next. A worker killed on a request is replaced
+ * by a new one forked from the daemon, and the request is answered with exit
+ * code 128 + signal and the messages written up to the crash, as a direct run
+ * would end. A request that does not arrive within DAEMON_TIMEOUT seconds is dropped.
+ *
+ * @param path    socket path, an existing file at the path is replaced
+ * @param compile compiler pipeline run for each request
+ * @return SUCCESS after a signal, ERR_INTERNAL if the socket or a worker cannot be set up.
+ */
+int daemon_run(const char *path, daemon_compile_fn compile);
+
+#endif /* IFJ_DAEMON */
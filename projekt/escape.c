@@ -0,0 +1,137 @@
+/**
+ * @file escape.c
+ * @brief Escaping of string literals for IFJcode25 operands (`string@...`).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <string.h>
+
+#include "escape.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ESCAPE_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ESCAPE_SSE2
+#endif
+
+#define ESCAPE_SPACE 32  // highest code escaped as a control character or space
+
+// `\ddd` of the escaped bytes: 0-32 at their code, then `#` and `\`
+#define E(n) { '\\', (char)('0' + (n) / 100), (char)('0' + (n) / 10 % 10), (char)('0' + (n) % 10) }
+#define E8(n) E(n), E(n + 1), E(n + 2), E(n + 3), E(n + 4), E(n + 5), E(n + 6), E(n + 7)
+static const char escape_table[ESCAPE_SPACE + 3][4] = { E8(0), E8(8), E8(16), E8(24), E(32), E('#'), E('\\') };
+#undef E8
+#undef E
+
+static int escape_index(unsigned char ch) {
+    if (ch <= ESCAPE_SPACE) return ch;
+    if (ch == '#') return ESCAPE_SPACE + 1;
+    if (ch == '\\') return ESCAPE_SPACE + 2;
+    return -1;
+}
+
+// Copies one byte or writes its escape, returns the bytes written
+static size_t escape_byte(char *out, unsigned char ch) {
+    int index = escape_index(ch);
+    if (index < 0) {
+        *out = (char)ch;
+        return 1;
+    }
+    memcpy(out, escape_table[index], 4);
+    return 4;
+}
+
+size_t escape_literal_scalar(char *out, const char *text, size_t len) {
+    size_t written = 0;
+    for (size_t i = 0; i < len; i++) written += escape_byte(out + written, (unsigned char)text[i]);
+    return written;
+}
+
+#if defined(ESCAPE_AVX2) || defined(ESCAPE_SSE2)
+
+// Writes a block with escapes at the set bits of mask: the runs between them are copied whole
+static size_t escape_block(char *out, const char *block, unsigned mask, unsigned width) {
+    size_t written = 0;
+    unsigned start = 0;
+    while (mask != 0) {
+        unsigned at = (unsigned)__builtin_ctz(mask);
+        memcpy(out + written, block + start, at - start);
+        written += at - start;
+        memcpy(out + written, escape_table[escape_index((unsigned char)block[at])], 4);
+        written += 4;
+        start = at + 1;
+        mask &= mask - 1;
+    }
+    memcpy(out + written, block + start, width - start);
+    return written + width - start;
+}
+
+#endif
+
+#if defined(ESCAPE_AVX2)
+
+// Bytes of the block that need an escape, one bit each (unsigned v <= 32 as min(v, 32) == v)
+static unsigned escape_mask(__m256i v) {
+    __m256i low = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(ESCAPE_SPACE)), v);
+    __m256i hash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'));
+    __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+    return (unsigned)_mm256_movemask_epi8(_mm256_or_si256(low, _mm256_or_si256(hash, backslash)));
+}
+
+size_t escape_literal(char *out, const char *text, size_t len) {
+    size_t i = 0, written = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+        unsigned mask = escape_mask(v);
+        if (mask == 0) {
+            _mm256_storeu_si256((__m256i *)(out + written), v);
+            written += 32;
+        } else {
+            written += escape_block(out + written, text + i, mask, 32);
+        }
+    }
+    return written + escape_literal_scalar(out + written, text + i, len - i);
+}
+
+const char *escape_implementation(void) { return "avx2"; }
+
+#elif defined(ESCAPE_SSE2)
+
+// Bytes of the block that need an escape, one bit each (unsigned v <= 32 as min(v, 32) == v)
+static unsigned escape_mask(__m128i v) {
+    __m128i low = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(ESCAPE_SPACE)), v);
+    __m128i hash = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+    __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(low, _mm_or_si128(hash, backslash)));
+}
+
+size_t escape_literal(char *out, const char *text, size_t len) {
+    size_t i = 0, written = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+        unsigned mask = escape_mask(v);
+        if (mask == 0) {
+            _mm_storeu_si128((__m128i *)(out + written), v);
+            written += 16;
+        } else {
+            written += escape_block(out + written, text + i, mask, 16);
+        }
+    }
+    return written + escape_literal_scalar(out + written, text + i, len - i);
+}
+
+const char *escape_implementation(void) { return "sse2"; }
+
+#else
+
+size_t escape_literal(char *out, const char *text, size_t len) {
+    return escape_literal_scalar(out, text, len);
+}
+
+const char *escape_implementation(void) { return "scalar"; }
+
+#endif
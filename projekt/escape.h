@@ -0,0 +1,44 @@
+/**
+ * @file escape.h
+ * @brief Escaping of string literals for IFJcode25 operands (`string@...`).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_ESCAPE
+#define IFJ_ESCAPE
+
+#include <stddef.h>
+
+/**
+ * @brief Longest output of escape_literal() for @p len bytes (every byte escaped).
+ */
+#define ESCAPE_MAX_LENGTH(len) ((len) * 4)
+
+/**
+ * @brief Writes the bytes of a string in the form of a `string@` operand.
+ *
+ * Bytes 0-32, `#` and `\` become `\ddd` (decimal code, three digits), the other
+ * bytes are copied. Runs of bytes without an escape are found 32 (AVX2) or 16
+ * (SSE2) bytes at a time and copied in bulk, the escapes come from a table;
+ * without SSE2 the bytes are checked one by one. All give the same output.
+ *
+ * @param out  buffer of at least ESCAPE_MAX_LENGTH(@p len) bytes, not terminated
+ * @param text bytes of the string (may contain NUL)
+ * @param len  number of bytes
+ * @return number of bytes written
+ */
+size_t escape_literal(char *out, const char *text, size_t len);
+
+/**
+ * @brief Byte-by-byte version of escape_literal(), the reference of the vector code.
+ */
+size_t escape_literal_scalar(char *out, const char *text, size_t len);
+
+/**
+ * @brief Instruction set escape_literal() was built for: "avx2", "sse2" or "scalar".
+ */
+const char *escape_implementation(void);
+
+#endif /* IFJ_ESCAPE */
@@ -4,11 +4,12 @@
 *   -   Maťej Kurta (xkurtam00)
  *
  * @file expressions.h
- * @brief Precedence parser for expressions.
+ * @brief Pratt and precedence table parsers for expressions.
  * BUT FIT
  */
 
 #include "expressions.h"
+#include "options.h"
 #include <string.h>
 
 /*
@@ -121,7 +122,9 @@ bool reduce_rule(stack *stack) {
     expr_item top = *(expr_item *)stack->top->data;
     // Rule: i -> E (reduce identifier/literal to expression)
     if(top.symbol == INT || top.symbol == FLOAT || top.symbol == STRING || top.symbol == ID || top.symbol == NULL_VAR) {
-        expr_item item = *(expr_item *)stack_pop(stack);
+        expr_item *popped = stack_pop(stack);
+        expr_item item = *popped;
+        free(popped);
 
         if (item.expr == NULL) { 
             // Create new AST expression node for this value
@@ -135,6 +138,7 @@ bool reduce_rule(stack *stack) {
                 if(item.token != NULL) {
                     item.expr->type = AST_IDENTIFIER;
                     item.expr->operands.identifier.value = item.token->value->data;
+                    item.expr->operands.identifier.cg_name = NULL;
                 } else {
                     // Already processed as function call
                     item.expr->type = AST_IFJ_FUNCTION_EXPR;
@@ -258,6 +262,7 @@ bool reduce_rule(stack *stack) {
             }
 
             stack_push_value(stack, expr, sizeof(expr_item));
+            free(expr);
             return true;
         }
     }
@@ -277,8 +282,7 @@ void push_shift(stack *s) {
 
     // Pop all non-terminals from top until we find terminal or dollar
     while((*(expr_item *)s->top->data).symbol != DOLLAR && (*(expr_item *)s->top->data).symbol != SHIFT_MARK) {
-        void *p = stack_pop(s);
-        stack_push_value(&tmpStack, p, sizeof(expr_item));
+        stack_push(&tmpStack, stack_pop(s));
     }
 
     // Insert shift marker if not already present
@@ -289,8 +293,7 @@ void push_shift(stack *s) {
 
     // Put non-terminals back on top
     while(!stack_is_empty(&tmpStack)) {
-        void *p = stack_pop(&tmpStack);
-        stack_push_value(s, p, sizeof(expr_item));
+        stack_push(s, stack_pop(&tmpStack));
     }
 }
 
@@ -315,11 +318,105 @@ prec_table_enum get_top_terminal(stack *stack) {
     return DOLLAR;
 }
 
+/// @brief Checks whether a token can be a call argument on its own (identifier or literal)
+static bool is_simple_argument(int type) {
+    return type == T_IDENT || type == T_GLOB_IDENT || type == T_STRING || type == T_ML_STRING ||
+           type == T_FLOAT || type == T_INT || type == T_BOOL_FALSE || type == T_BOOL_TRUE ||
+           type == T_KW_NULL;
+}
+
+/// @brief Builds a call argument from a single identifier or literal token
+static ast_parameter simple_argument(tokenPtr token) {
+    ast_parameter param = malloc(sizeof(struct ast_parameter));
+    if (param == NULL) {
+        return NULL;
+    }
+    param->expression = NULL;
+    param->cg_name = NULL;
+    param->next = NULL;
+    if (token->type == T_FLOAT) {
+        param->value_type = AST_VALUE_FLOAT;
+        param->value.double_value = token->value_float;
+    } else if (token->type == T_INT) {
+        param->value_type = AST_VALUE_INT;
+        param->value.int_value = token->value_int;
+    } else if (token->type == T_KW_NULL) {
+        param->value_type = AST_VALUE_NULL;
+    } else {
+        if (token->type == T_IDENT || token->type == T_GLOB_IDENT)
+            param->value_type = AST_VALUE_IDENTIFIER;
+        else param->value_type = AST_VALUE_STRING;
+        param->value.string_value = token->value->data;
+    }
+    return param;
+}
+
+static int parse_conditional(DLListTokens *tokenlist, ast_expression *out_ast, int depth);
+
+/// @brief Parses call arguments of a call nested depth levels deep in an expression
+static int parse_arguments(DLListTokens *tokenlist, ast_parameter *out_params, int depth) {
+    *out_params = NULL;
+    ast_parameter last_param = NULL;
+
+    while (tokenlist->active->token->type != T_RPAREN) {
+        ast_parameter new_param;
+        tokenPtr token = tokenlist->active->token;
+        int next_type = tokenlist->active->next != NULL ? tokenlist->active->next->token->type : T_EOF;
+
+        // Identifier or literal alone keeps the plain form, anything else is an expression (FUNEXP)
+        if (is_simple_argument(token->type) && (next_type == T_COMMA || next_type == T_RPAREN)) {
+            new_param = simple_argument(token);
+            if (new_param == NULL) {
+                return ERR_INTERNAL;
+            }
+            DLLTokens_Next(tokenlist);
+        } else {
+            ast_expression expr;
+            int err = parse_conditional(tokenlist, &expr, depth);
+            if (err != SUCCESS) {
+                return err;
+            }
+            new_param = malloc(sizeof(struct ast_parameter));
+            if (new_param == NULL) {
+                ast_expression_dispose(expr);
+                return ERR_INTERNAL;
+            }
+            new_param->value_type = AST_VALUE_EXPRESSION;
+            new_param->expression = expr;
+            new_param->cg_name = NULL;
+            new_param->next = NULL;
+        }
+
+        // Link argument to the list
+        if (*out_params == NULL) {
+            *out_params = new_param;
+        } else {
+            last_param->next = new_param;
+        }
+        last_param = new_param;
+
+        // Arguments are separated by comma, the list ends with closing paren
+        if (tokenlist->active->token->type == T_COMMA) {
+            DLLTokens_Next(tokenlist);
+            if (tokenlist->active->token->type == T_RPAREN) {
+                return ERR_SYN;
+            }
+        } else if (tokenlist->active->token->type != T_RPAREN) {
+            return ERR_SYN;
+        }
+    }
+    return SUCCESS;
+}
+
+int parse_call_arguments(DLListTokens *tokenlist, ast_parameter *out_params) {
+    return parse_arguments(tokenlist, out_params, 0);
+}
+
 /// @brief Checks the precedence table and returns the error code and list of applied rules
 /// @param tokenlist List of tokens from the scanner
 /// @param out_ast Pointer to store the constructed AST expression
 /// @return Error code indicating success or failure
-int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast){
+int parse_expr_precedence(DLListTokens *tokenlist, ast_expression *out_ast){
     (void)out_ast;
     stack stack;
     stack_init(&stack);
@@ -381,64 +478,10 @@ int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast){
                 }
                 DLLTokens_Next(tokenlist);
                 
-                // Initialize parameter list
-                item.expr->operands.function_call->parameters = NULL;
-                struct ast_parameter *last_param = NULL;
-
-                // Parse all parameters until closing paren
-                while (tokenlist->active->token->type != T_RPAREN) {
-                    // Validate parameter token type
-                    int type = tokenlist->active->token->type;
-                    if(type != T_IDENT && type != T_STRING && type != T_ML_STRING && 
-                        type != T_FLOAT && type != T_INT && 
-                        type != T_BOOL_FALSE && type != T_BOOL_TRUE &&
-                        type != T_GLOB_IDENT) {
-                        return ERR_SYN;
-                    }
-
-                    // Allocate new parameter node
-                    struct ast_parameter *new_param = malloc(sizeof(struct ast_parameter));
-                    if (new_param == NULL) {
-                        return ERR_INTERNAL;
-                    }
-                    
-                    // Set parameter value based on type
-                    if(tokenlist->active->token->type == T_FLOAT) {
-                        new_param->value_type = AST_VALUE_FLOAT;
-                        new_param->value.double_value = tokenlist->active->token->value_float;
-                    } else if (tokenlist->active->token->type == T_INT) {
-                        new_param->value_type = AST_VALUE_INT;
-                        new_param->value.int_value = tokenlist->active->token->value_int;
-                    } else if (tokenlist->active->token->type == T_KW_NULL)
-                        new_param->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenlist->active->token->type == T_IDENT || tokenlist->active->token->type == T_GLOB_IDENT)
-                            new_param->value_type = AST_VALUE_IDENTIFIER;
-                        else new_param->value_type = AST_VALUE_STRING;
-                        new_param->value.string_value = tokenlist->active->token->value->data;
-                    }
-
-                    new_param->next = NULL;
-
-                    // Link parameter to the list
-                    if (item.expr->operands.function_call->parameters == NULL) {
-                        item.expr->operands.function_call->parameters = new_param;
-                    } else {
-                        last_param->next = new_param;
-                    }
-                    last_param = new_param;
-
-                    DLLTokens_Next(tokenlist);
-
-                    // Handle comma between parameters
-                    if (tokenlist->active->token->type == T_COMMA) {
-                        DLLTokens_Next(tokenlist);
-                        if (tokenlist->active->token->type == T_RPAREN) {
-                            return ERR_SYN;
-                        }
-                    } else if (tokenlist->active->token->type != T_RPAREN) {
-                        return ERR_SYN;
-                    }
+                // Parse all arguments until closing paren
+                int err = parse_call_arguments(tokenlist, &item.expr->operands.function_call->parameters);
+                if (err != SUCCESS) {
+                    return err;
                 }
 
                 stack_push_value(&stack, &item, sizeof(expr_item));
@@ -470,59 +513,12 @@ int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast){
                 }
                 DLLTokens_Next(tokenlist);
                 
-                // Initialize IFJ function parameters
-                item.expr->operands.ifj_function->parameters = NULL;
-                struct ast_parameter *last_param = NULL;
-
-                // Parse IFJ function parameters
-                while (tokenlist->active->token->type != T_RPAREN) {
-                    int type = tokenlist->active->token->type;
-                    if(type != T_IDENT && type != T_STRING && type != T_ML_STRING && 
-                        type != T_FLOAT && type != T_INT && 
-                        type != T_BOOL_FALSE && type != T_BOOL_TRUE &&
-                        type != T_GLOB_IDENT && type != T_KW_NULL) {
-                        return ERR_SYN;
-                    }
-
-                    struct ast_parameter *new_param = malloc(sizeof(struct ast_parameter));
-                    if (new_param == NULL) {
-                        return ERR_INTERNAL;
-                    }
-                    if(tokenlist->active->token->type == T_FLOAT) {
-                        new_param->value_type = AST_VALUE_FLOAT;
-                        new_param->value.double_value = tokenlist->active->token->value_float;
-                    } else if (tokenlist->active->token->type == T_INT) {
-                        new_param->value_type = AST_VALUE_INT;
-                        new_param->value.int_value = tokenlist->active->token->value_int;
-                    } else if (tokenlist->active->token->type == T_KW_NULL)
-                        new_param->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenlist->active->token->type == T_IDENT || tokenlist->active->token->type == T_GLOB_IDENT)
-                            new_param->value_type = AST_VALUE_IDENTIFIER;
-                        else new_param->value_type = AST_VALUE_STRING;
-                        new_param->value.string_value = tokenlist->active->token->value->data;
-                    }
-                    new_param->next = NULL;
-
-                    if (item.expr->operands.ifj_function->parameters == NULL) {
-                        item.expr->operands.ifj_function->parameters = new_param;
-                    } else {
-                        last_param->next = new_param;
-                    }
-                    last_param = new_param;
-
-                    DLLTokens_Next(tokenlist);
-
-                    if (tokenlist->active->token->type == T_COMMA) {
-                        DLLTokens_Next(tokenlist);
-                        if (tokenlist->active->token->type == T_RPAREN) {
-                            return ERR_SYN;
-                        }
-                    } else if (tokenlist->active->token->type != T_RPAREN) {
-                        return ERR_SYN;
-                    }
+                // Parse IFJ function arguments
+                int err = parse_call_arguments(tokenlist, &item.expr->operands.ifj_function->parameters);
+                if (err != SUCCESS) {
+                    return err;
                 }
-                
+
                 stack_push_value(&stack, &item, sizeof(expr_item));
             } else {
                 // Simple value/identifier - just push it
@@ -587,4 +583,390 @@ int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast){
     }
 
     return SUCCESS;
-}
\ No newline at end of file
+}
+
+// ---- Pratt parser ----
+
+/// @brief Binding power of a binary operator token, 0 if the token ends the expression
+/// The levels of prec_table (* / over + - over relations over is over == !=) continue
+/// with && and || below them
+static int binary_power(int token_type) {
+    switch (token_type) {
+        case T_OR: return 1;
+        case T_AND: return 2;
+        case T_EQ: case T_NEQ: return 3;
+        case T_KW_IS: return 4;
+        case T_LT: case T_LE: case T_GT: case T_GE: return 5;
+        case T_PLUS: case T_MINUS: return 6;
+        case T_MUL: case T_DIV: return 7;
+        default: return 0;
+    }
+}
+
+/// @brief Expression type built by a binary operator token
+static ast_expression_type binary_type(int token_type) {
+    switch (token_type) {
+        case T_OR: return AST_OR;
+        case T_AND: return AST_AND;
+        case T_EQ: return AST_EQUALS;
+        case T_NEQ: return AST_NOT_EQUAL;
+        case T_KW_IS: return AST_IS;
+        case T_LT: return AST_LT;
+        case T_LE: return AST_LE;
+        case T_GT: return AST_GT;
+        case T_GE: return AST_GE;
+        case T_PLUS: return AST_ADD;
+        case T_MINUS: return AST_SUB;
+        case T_MUL: return AST_MUL;
+        default: return AST_DIV;
+    }
+}
+
+/// @brief Checks whether a token starts an operand, which cannot follow another operand
+static bool starts_operand(tokenPtr token) {
+    prec_table_index index = get_prec_index(token_to_expr(token));
+    return index == I_DATA || index == I_LEFT_BRAC || token->type == T_NOT;
+}
+
+/// @brief Allocates an expression node of the given type
+static ast_expression new_expression(ast_expression_type type) {
+    ast_expression expr = malloc(sizeof(struct ast_expression));
+    if (expr != NULL) {
+        expr->type = type;
+    }
+    return expr;
+}
+
+/// @brief Parses the arguments of a call, the active token is `(`; the closing paren is consumed
+static int parse_call(DLListTokens *tokenlist, ast_expression call, ast_parameter *params, int depth) {
+    DLLTokens_Next(tokenlist);
+    int err = parse_arguments(tokenlist, params, depth + 1);
+    if (err != SUCCESS) {
+        ast_expression_dispose(call);
+        return err;
+    }
+    DLLTokens_Next(tokenlist);
+    return SUCCESS;
+}
+
+/// @brief Parses an identifier, a call `name(args)` or a built-in call `Ifj.name(args)`
+static int parse_identifier(DLListTokens *tokenlist, ast_expression *out_ast, int depth) {
+    tokenPtr name = tokenlist->active->token;
+    DLLTokens_Next(tokenlist);
+
+    // Regular function call
+    if (tokenlist->active->token->type == T_LPAREN) {
+        ast_expression call = new_expression(AST_FUNCTION_CALL);
+        if (call == NULL) {
+            return ERR_INTERNAL;
+        }
+        call->operands.function_call = malloc(sizeof(struct ast_fun_call));
+        if (call->operands.function_call == NULL) {
+            free(call);
+            return ERR_INTERNAL;
+        }
+        call->operands.function_call->name = name->value->data;
+        call->operands.function_call->parameters = NULL;
+        int err = parse_call(tokenlist, call, &call->operands.function_call->parameters, depth);
+        if (err == SUCCESS) {
+            *out_ast = call;
+        }
+        return err;
+    }
+
+    // Built-in call Ifj.name(args)
+    if (strcmp(name->value->data, "Ifj") == 0) {
+        if (tokenlist->active->token->type != T_DOT) {
+            return ERR_SYN;
+        }
+        DLLTokens_Next(tokenlist);
+        name = tokenlist->active->token;
+        if (name->type != T_IDENT) {
+            return ERR_SYN;
+        }
+        DLLTokens_Next(tokenlist);
+        if (tokenlist->active->token->type != T_LPAREN) {
+            return ERR_SYN;
+        }
+        ast_expression call = new_expression(AST_IFJ_FUNCTION_EXPR);
+        if (call == NULL) {
+            return ERR_INTERNAL;
+        }
+        call->operands.ifj_function = malloc(sizeof(struct ast_ifj_function));
+        if (call->operands.ifj_function == NULL) {
+            free(call);
+            return ERR_INTERNAL;
+        }
+        call->operands.ifj_function->name = name->value->data;
+        call->operands.ifj_function->parameters = NULL;
+        int err = parse_call(tokenlist, call, &call->operands.ifj_function->parameters, depth);
+        if (err == SUCCESS) {
+            *out_ast = call;
+        }
+        return err;
+    }
+
+    ast_expression identifier = new_expression(AST_IDENTIFIER);
+    if (identifier == NULL) {
+        return ERR_INTERNAL;
+    }
+    identifier->operands.identifier.value = name->value->data;
+    identifier->operands.identifier.cg_name = NULL;
+    *out_ast = identifier;
+    return SUCCESS;
+}
+
+/// @brief Parses a literal, an identifier or a call
+static int parse_primary(DLListTokens *tokenlist, ast_expression *out_ast, int depth) {
+    tokenPtr token = tokenlist->active->token;
+    prec_table_enum symbol = token_to_expr(token);
+    if (symbol == ID) {
+        return parse_identifier(tokenlist, out_ast, depth);
+    }
+    if (symbol != INT && symbol != FLOAT && symbol != STRING && symbol != NULL_VAR) {
+        return ERR_SYN;
+    }
+
+    // Literal value
+    ast_expression value = new_expression(AST_VALUE);
+    if (value == NULL) {
+        return ERR_INTERNAL;
+    }
+    value->operands.identity.value_type =
+        (symbol == INT) ? AST_VALUE_INT :
+        (symbol == FLOAT) ? AST_VALUE_FLOAT :
+        (symbol == STRING) ? AST_VALUE_STRING :
+        AST_VALUE_NULL;
+    if (symbol == INT) {
+        value->operands.identity.value.int_value = token->value_int;
+    } else if (symbol == FLOAT) {
+        value->operands.identity.value.double_value = token->value_float;
+    } else {
+        value->operands.identity.value.string_value = token->value->data;
+    }
+    DLLTokens_Next(tokenlist);
+    *out_ast = value;
+    return SUCCESS;
+}
+
+/// @brief Part of an expression waiting for the rest of it
+typedef enum {
+    PENDING_NOT,        ///< `!` waiting for its operand
+    PENDING_PAREN,      ///< `(` waiting for the expression and `)`
+    PENDING_BINARY,     ///< left operand and operator waiting for the right operand
+    PENDING_IF_TRUE,    ///< condition and `?` waiting for the first branch
+    PENDING_IF_FALSE    ///< condition, first branch and `:` waiting for the second branch
+} pending_kind;
+
+typedef struct pending {
+    pending_kind kind;
+    ast_expression_type type;   ///< operator of PENDING_BINARY
+    int power;                  ///< binding power of PENDING_BINARY
+    ast_expression first;       ///< left operand or condition
+    ast_expression second;      ///< first branch
+} pending;
+
+/// @brief Stack of the pending parts, the parser keeps the nesting here instead of the C stack
+typedef struct pending_stack {
+    pending *items;
+    size_t count;
+    size_t capacity;
+} pending_stack;
+
+/// @brief What the parser expects next
+typedef enum {
+    EXPECT_BRANCH,      ///< whole expression or a branch of `? :`
+    EXPECT_OPERAND,     ///< operand of an operator, may start with `!` or `(`
+    EXPECT_OPERATOR,    ///< binary operator after a complete operand
+    EXPECT_END,         ///< `?`, `:` or `)` after a complete expression
+    EXPECT_NOTHING      ///< expression is complete
+} parse_state;
+
+/// @brief Pushes a pending part, first is the expression it owns
+static int pending_push(pending_stack *stack, pending_kind kind, ast_expression first) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = stack->capacity ? 2 * stack->capacity : 32;
+        pending *items = realloc(stack->items, capacity * sizeof(pending));
+        if (items == NULL) {
+            return ERR_INTERNAL;
+        }
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    pending *item = &stack->items[stack->count++];
+    item->kind = kind;
+    item->first = first;
+    item->second = NULL;
+    return SUCCESS;
+}
+
+/// @brief Disposes the expressions of all pending parts and frees the stack
+static void pending_dispose(pending_stack *stack) {
+    for (size_t i = 0; i < stack->count; i++) {
+        ast_expression_dispose(stack->items[i].first);
+        ast_expression_dispose(stack->items[i].second);
+    }
+    free(stack->items);
+}
+
+/// @brief Completes the pending part on top of the stack with value, the result is the new value
+static int pending_reduce(pending_stack *stack, ast_expression *value) {
+    pending *top = &stack->items[stack->count - 1];
+    ast_expression node = new_expression(top->kind == PENDING_NOT ? AST_NOT :
+                                          top->kind == PENDING_BINARY ? top->type : AST_TERNARY);
+    if (node == NULL) {
+        return ERR_INTERNAL;
+    }
+    if (top->kind == PENDING_NOT) {
+        node->operands.unary_op.expression = *value;
+    } else if (top->kind == PENDING_BINARY) {
+        node->operands.binary_op.left = top->first;
+        node->operands.binary_op.right = *value;
+    } else {
+        node->operands.ternary_op.condition = top->first;
+        node->operands.ternary_op.if_true = top->second;
+        node->operands.ternary_op.if_false = *value;
+    }
+    stack->count--;
+    *value = node;
+    return SUCCESS;
+}
+
+/// @brief Parses an expression, optionally with the conditional operator `cond ? a : b`
+/// The conditional operator has the lowest priority and is right associative.
+/// Operators, parentheses, negations and conditional operators wait on an explicit stack, so the
+/// nesting of an expression is limited by memory only; only call arguments are parsed by recursion
+/// @param tokenlist List of tokens from the scanner
+/// @param out_ast Pointer to store the constructed AST expression
+/// @param depth Nesting level of calls around the expression
+/// @return Error code indicating success or failure
+static int parse_conditional(DLListTokens *tokenlist, ast_expression *out_ast, int depth) {
+    if (depth > EXPR_MAX_DEPTH) {
+        return error(ERR_INTERNAL, "Calls nested deeper than %d levels in an expression", EXPR_MAX_DEPTH);
+    }
+    pending_stack stack = { NULL, 0, 0 };
+    ast_expression value = NULL;
+    parse_state state = EXPECT_BRANCH;
+    int err = SUCCESS;
+
+    while (err == SUCCESS && state != EXPECT_NOTHING) {
+        tokenPtr token = tokenlist->active->token;
+        switch (state) {
+            case EXPECT_BRANCH:
+                if (options.table_expr) {
+                    // Precedence table parses the operators and parentheses of a condition or branch
+                    ast_expression branch;
+                    err = parse_expr_precedence(tokenlist, &branch);
+                    if (err == SUCCESS) {
+                        value = branch;
+                    }
+                    state = EXPECT_END;
+                    break;
+                }
+                state = EXPECT_OPERAND;
+                break;
+
+            case EXPECT_OPERAND:
+                // Negation binds tighter than any binary operator, parentheses may contain `? :`
+                if (token->type == T_NOT || token->type == T_LPAREN) {
+                    err = pending_push(&stack, token->type == T_NOT ? PENDING_NOT : PENDING_PAREN, NULL);
+                    DLLTokens_Next(tokenlist);
+                    break;
+                }
+                ast_expression operand;
+                err = parse_primary(tokenlist, &operand, depth);
+                if (err == SUCCESS) {
+                    value = operand;
+                }
+                state = EXPECT_OPERATOR;
+                break;
+
+            case EXPECT_OPERATOR: {
+                while (err == SUCCESS && stack.count > 0 && stack.items[stack.count - 1].kind == PENDING_NOT) {
+                    err = pending_reduce(&stack, &value);
+                }
+                int power = binary_power(token->type);
+                if (err == SUCCESS && power == 0 && starts_operand(token)) {
+                    err = ERR_SYN;
+                }
+                // Operators of one level are left associative: the operators on the left binding
+                // at least as tight are complete
+                while (err == SUCCESS && stack.count > 0 && stack.items[stack.count - 1].kind == PENDING_BINARY &&
+                       stack.items[stack.count - 1].power >= power) {
+                    err = pending_reduce(&stack, &value);
+                }
+                if (err != SUCCESS || power == 0) {
+                    state = EXPECT_END;
+                    break;
+                }
+                err = pending_push(&stack, PENDING_BINARY, value);
+                if (err == SUCCESS) {
+                    stack.items[stack.count - 1].type = binary_type(token->type);
+                    stack.items[stack.count - 1].power = power;
+                    value = NULL;
+                    DLLTokens_Next(tokenlist);
+                    state = EXPECT_OPERAND;
+                }
+                break;
+            }
+
+            case EXPECT_END: {
+                if (token->type == T_QUESTION) {
+                    // Condition of a conditional operator, the branches may be other conditionals
+                    err = pending_push(&stack, PENDING_IF_TRUE, value);
+                    if (err == SUCCESS) {
+                        value = NULL;
+                        DLLTokens_Next(tokenlist);
+                        state = EXPECT_BRANCH;
+                    }
+                    break;
+                }
+                if (stack.count == 0) {
+                    state = EXPECT_NOTHING;
+                    break;
+                }
+                pending *top = &stack.items[stack.count - 1];
+                if (top->kind == PENDING_IF_FALSE) {
+                    err = pending_reduce(&stack, &value);
+                } else if (top->kind == PENDING_IF_TRUE) {
+                    // Branches are separated by colon
+                    if (token->type != T_COLON) {
+                        err = ERR_SYN;
+                        break;
+                    }
+                    top->kind = PENDING_IF_FALSE;
+                    top->second = value;
+                    value = NULL;
+                    DLLTokens_Next(tokenlist);
+                    state = EXPECT_BRANCH;
+                } else {
+                    // Parenthesized expression is an operand
+                    if (token->type != T_RPAREN) {
+                        err = ERR_SYN;
+                        break;
+                    }
+                    stack.count--;
+                    DLLTokens_Next(tokenlist);
+                    state = EXPECT_OPERATOR;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    if (err != SUCCESS) {
+        ast_expression_dispose(value);
+        pending_dispose(&stack);
+        return err;
+    }
+    free(stack.items);
+    *out_ast = value;
+    return SUCCESS;
+}
+
+int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast) {
+    return parse_conditional(tokenlist, out_ast, 0);
+}
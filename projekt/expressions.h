@@ -4,7 +4,7 @@
 *   -   Maťej Kurta (xkurtam00)
  *
  * @file expressions.h
- * @brief Precedence parser for expressions.
+ * @brief Pratt and precedence table parsers for expressions.
  * BUT FIT
  */
 
@@ -22,6 +22,10 @@
 /* Precedence table size */
 #define TABLE_SIZE 9
 
+/* Deepest nesting of calls in the arguments of calls; the parser and the later passes recurse
+ * through call arguments, operators and parentheses nest without a limit */
+#define EXPR_MAX_DEPTH 1000
+
 /*
  * Precedence table symbol types
  */
@@ -103,11 +107,24 @@ typedef struct expr_rule {
 } expr_rule;
 
 /*
- * @brief Checks the precedence table and returns the error code and list of applied rules
+ * @brief Parses an expression (Pratt parser + conditional operator `?:`)
+ * Operators from the lowest priority: `?:`, `||`, `&&`, `== !=`, `is`, `< <= > >=`,
+ * `+ -`, `* /`, prefix `!`; with --table-expr the precedence table parses the operands
+ * of `?:` instead (no `||`, `&&` and `!`)
  * @param tokenlist List of tokens from the scanner
  * @param out_ast Pointer to store the constructed AST expression
  * @return Error code indicating success or failure
  */
 int parse_expr(DLListTokens *tokenlist, ast_expression *out_ast);
 
+/*
+ * @brief Parses call arguments up to the closing parenthesis, which stays active
+ * A lone identifier or literal is stored as a plain parameter, any other
+ * argument as AST_VALUE_EXPRESSION (extension FUNEXP)
+ * @param tokenlist List of tokens, active token is the first argument or `)`
+ * @param out_params Pointer to store the argument list
+ * @return Error code indicating success or failure
+ */
+int parse_call_arguments(DLListTokens *tokenlist, ast_parameter *out_params);
+
 #endif // EXPRESSIONS_H
\ No newline at end of file
@@ -0,0 +1,239 @@
+/**
+ * @file fncache.c
+ * @brief Cache of the generated code of single functions (--cache=DIR).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fncache.h"
+#include "globals.h"
+#include "options.h"
+
+#define FNCACHE_BUILD   __DATE__ " " __TIME__  // compiler build, part of every key
+#define FNCACHE_PATH    4096
+#define FNV_OFFSET      14695981039346656037ULL
+#define FNV_PRIME       1099511628211ULL
+
+// ---- AST hashing (FNV-1a over a pre-order walk) ----
+
+static void hash_bytes(uint64_t *h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        *h ^= p[i];
+        *h *= FNV_PRIME;
+    }
+}
+
+static void hash_int(uint64_t *h, long long value) {
+    hash_bytes(h, &value, sizeof value);
+}
+
+// NULL and "" differ, the terminator separates neighbouring strings
+static void hash_str(uint64_t *h, const char *s) {
+    hash_int(h, s != NULL);
+    if (s) hash_bytes(h, s, strlen(s) + 1);
+}
+
+static void hash_expression(uint64_t *h, ast_expression e);
+static void hash_block(uint64_t *h, ast_block block);
+
+static void hash_value(uint64_t *h, ast_value_type type, int int_value, double double_value, const char *string_value) {
+    hash_int(h, type);
+    switch (type) {
+        case AST_VALUE_INT: hash_int(h, int_value); break;
+        case AST_VALUE_FLOAT: hash_bytes(h, &double_value, sizeof double_value); break;
+        case AST_VALUE_NULL: case AST_VALUE_EXPRESSION: break;
+        default: hash_str(h, string_value); break;
+    }
+    if (type == AST_VALUE_IDENTIFIER) hash_int(h, globals_type(string_value));  // typed globals shape the code
+}
+
+static void hash_params(uint64_t *h, ast_parameter p) {
+    for (; p; p = p->next) {
+        hash_value(h, p->value_type, p->value.int_value, p->value.double_value,
+                   p->value_type == AST_VALUE_INT || p->value_type == AST_VALUE_FLOAT ? NULL : p->value.string_value);
+        if (p->value_type == AST_VALUE_EXPRESSION) hash_expression(h, p->expression);
+        hash_str(h, p->cg_name);
+    }
+    hash_int(h, -1);  // end of the list
+}
+
+// Operands are hashed in order from an explicit stack, NULL operands too
+static void hash_expression(uint64_t *h, ast_expression root) {
+    ast_expression *stack = NULL;
+    size_t count = 0, cap = 0;
+    ast_expression e = root;
+    while (true) {
+        if (e == NULL) {
+            hash_int(h, -1);
+        } else {
+            hash_int(h, e->type);
+            ast_expression operands[3] = { NULL, NULL, NULL };
+            int n = 0;
+            switch (e->type) {
+                case AST_VALUE: {
+                    struct ast_value *v = &e->operands.identity;
+                    bool number = v->value_type == AST_VALUE_INT || v->value_type == AST_VALUE_FLOAT;
+                    hash_value(h, v->value_type, v->value.int_value, v->value.double_value, number ? NULL : v->value.string_value);
+                    break;
+                }
+                case AST_IDENTIFIER:
+                    hash_str(h, e->operands.identifier.value);
+                    hash_str(h, e->operands.identifier.cg_name);
+                    hash_int(h, globals_type(loop_expr_var_name(e)));
+                    break;
+                case AST_FUNCTION_CALL:
+                    hash_str(h, e->operands.function_call->name);
+                    hash_params(h, e->operands.function_call->parameters);
+                    break;
+                case AST_IFJ_FUNCTION_EXPR:
+                    hash_str(h, e->operands.ifj_function->name);
+                    hash_params(h, e->operands.ifj_function->parameters);
+                    break;
+                case AST_NOT: case AST_NOT_NULL:
+                    operands[n++] = e->operands.unary_op.expression;
+                    break;
+                case AST_TERNARY:
+                    operands[n++] = e->operands.ternary_op.condition;
+                    operands[n++] = e->operands.ternary_op.if_true;
+                    operands[n++] = e->operands.ternary_op.if_false;
+                    break;
+                case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV:
+                case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE: case AST_GT: case AST_GE:
+                case AST_AND: case AST_OR: case AST_CONCAT: case AST_IS:
+                    operands[n++] = e->operands.binary_op.left;
+                    operands[n++] = e->operands.binary_op.right;
+                    break;
+                default:  // AST_ID, AST_NONE, AST_NIL carry no operands
+                    break;
+            }
+            if (count + n > cap) {
+                size_t grown = cap ? cap * 2 : 64;
+                ast_expression *more = realloc(stack, grown * sizeof *more);
+                if (more == NULL) {  // the key is unique to this run, the entry is never found again
+                    hash_int(h, (long long)getpid());
+                    hash_bytes(h, &root, sizeof root);
+                    break;
+                }
+                stack = more;
+                cap = grown;
+            }
+            while (n > 0) stack[count++] = operands[--n];
+        }
+        if (count == 0) break;
+        e = stack[--count];
+    }
+    free(stack);
+}
+
+static void hash_node(uint64_t *h, ast_node node) {
+    hash_int(h, node->type);
+    switch (node->type) {
+        case AST_BLOCK: hash_block(h, node->data.block); break;
+        case AST_CONDITION:
+            hash_expression(h, node->data.condition.condition);
+            hash_block(h, node->data.condition.if_branch);
+            hash_block(h, node->data.condition.else_branch);
+            break;
+        case AST_WHILE_LOOP:
+            hash_expression(h, node->data.while_loop.condition);
+            hash_block(h, node->data.while_loop.body);
+            break;
+        case AST_EXPRESSION: hash_expression(h, node->data.expression); break;
+        case AST_VAR_DECLARATION:
+            hash_str(h, node->data.declaration.name);
+            hash_str(h, node->data.declaration.cg_name);
+            break;
+        case AST_ASSIGNMENT:
+            hash_str(h, node->data.assignment.name);
+            hash_str(h, node->data.assignment.cg_name);
+            hash_expression(h, node->data.assignment.value);
+            break;
+        case AST_FUNCTION:
+            hash_str(h, node->data.function->name);
+            hash_params(h, node->data.function->parameters);
+            hash_block(h, node->data.function->code);
+            break;
+        case AST_CALL_FUNCTION:
+            hash_str(h, node->data.function_call->name);
+            hash_params(h, node->data.function_call->parameters);
+            break;
+        case AST_RETURN: hash_expression(h, node->data.return_expr.output); break;
+        case AST_GETTER:
+            hash_str(h, node->data.getter.name);
+            hash_block(h, node->data.getter.body);
+            break;
+        case AST_SETTER:
+            hash_str(h, node->data.setter.name);
+            hash_str(h, node->data.setter.param);
+            hash_block(h, node->data.setter.body);
+            break;
+        case AST_IFJ_FUNCTION:
+            hash_str(h, node->data.ifj_function->name);
+            hash_params(h, node->data.ifj_function->parameters);
+            break;
+        default:  // AST_BREAK, AST_CONTINUE
+            break;
+    }
+}
+
+static void hash_block(uint64_t *h, ast_block block) {
+    if (block != NULL)
+        for (ast_node node = block->first; node; node = node->next) hash_node(h, node);
+    hash_int(h, -1);  // end of the block
+}
+
+uint64_t fncache_key(ast_node function, unsigned passes) {
+    uint64_t h = FNV_OFFSET;
+    hash_str(&h, FNCACHE_BUILD);
+    hash_int(&h, options.opt_level);
+    hash_int(&h, passes);
+    hash_int(&h, options.unroll);
+    hash_int(&h, options.size);
+    hash_node(&h, function);
+    return h;
+}
+
+// ---- cache files: "IFJC <helpers> <length>\n" followed by the code ----
+
+static bool entry_path(char *path, const char *dir, uint64_t key, const char *suffix) {
+    int n = snprintf(path, FNCACHE_PATH, "%s/%016llx.ifjc%s", dir, (unsigned long long)key, suffix);
+    return n > 0 && n < FNCACHE_PATH;
+}
+
+bool fncache_load(const char *dir, uint64_t key, string out, unsigned *helpers) {
+    char path[FNCACHE_PATH];
+    if (!entry_path(path, dir, key, "")) return false;
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    unsigned long len = 0;
+    char *code = NULL;
+    bool ok = fscanf(f, "IFJC %u %lu", helpers, &len) == 2 && fgetc(f) == '\n' && (code = malloc(len + 1)) != NULL &&
+              fread(code, 1, len, f) == len && fgetc(f) == EOF;
+    fclose(f);
+    if (ok) {
+        code[len] = '\0';
+        ok = string_append_literal(out, code);
+    }
+    free(code);
+    return ok;
+}
+
+void fncache_store(const char *dir, uint64_t key, const char *code, size_t len, unsigned helpers) {
+    char path[FNCACHE_PATH], tmp[FNCACHE_PATH], suffix[32];
+    snprintf(suffix, sizeof suffix, ".%ld", (long)getpid());
+    if (!entry_path(path, dir, key, "") || !entry_path(tmp, dir, key, suffix)) return;
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) return;
+    bool ok = fprintf(f, "IFJC %u %lu\n", helpers, (unsigned long)len) > 0 && fwrite(code, 1, len, f) == len;
+    if (fclose(f) != 0 || !ok || rename(tmp, path) != 0) remove(tmp);
+}
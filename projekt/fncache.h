@@ -0,0 +1,53 @@
+/**
+ * @file fncache.h
+ * @brief Cache of the generated code of single functions (--cache=DIR).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_FNCACHE
+#define IFJ_FNCACHE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ast.h"
+#include "string.h"
+
+/**
+ * @brief Key of a function: hash of its AST after semantic analysis and
+ *        compile-time evaluation, and of the options that change its code.
+ *
+ * The AST contains the signature of the function (name, parameters) and,
+ * through the call labels (name and arity), everything the body depends on
+ * in other functions. Calls folded by consteval are already literals, so an
+ * edit of a pure callee changes the key of every caller it was folded into.
+ * The key includes the build time of the compiler, a rebuilt compiler never
+ * reads code cached by another build.
+ *
+ * @param function AST_FUNCTION, AST_GETTER or AST_SETTER node
+ * @param passes   expensive passes run on the function (budget_passes())
+ */
+uint64_t fncache_key(ast_node function, unsigned passes);
+
+/**
+ * @brief Appends the cached code of a function to out.
+ *
+ * @param dir     cache directory
+ * @param key     key from fncache_key()
+ * @param out     generator output
+ * @param helpers set to the -Os subroutines the cached code calls
+ * @return true on a hit, false if the function has to be generated.
+ */
+bool fncache_load(const char *dir, uint64_t key, string out, unsigned *helpers);
+
+/**
+ * @brief Stores the code of a function; the file is renamed into place, so
+ *        concurrent compilers (daemon requests) never read a partial entry.
+ *        Failures are ignored, the cache is only an accelerator.
+ */
+void fncache_store(const char *dir, uint64_t key, const char *code, size_t len, unsigned helpers);
+
+#endif /* IFJ_FNCACHE */
@@ -0,0 +1,365 @@
+/**
+ * @file globals.c
+ * @brief Whole-program analysis of the global variables (-O1).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals.h"
+#include "options.h"
+
+/**
+ * @brief Uses of one global in the whole program.
+ */
+typedef struct global_info {
+    const char *name;
+    unsigned reads;      // identifiers and call arguments
+    unsigned writes;     // assignments
+    ast_node init;       // assignment at the top level of main before any possible read, or NULL
+    unsigned stamp;      // last statement of main mentioning the global
+    bool settled;        // the statements of main up to the first mention were seen
+    bool constant;       // reads are replaced by the literal of init
+    bool removed;        // no read or write is left
+    loop_type type;      // type every read sees
+    loop_type stored;    // join of the types stored in one round of the analysis
+} global_info;
+
+typedef enum {
+    SCAN_COUNT,    // reads and writes of every global
+    SCAN_MENTION,  // globals mentioned by one statement, user calls
+    SCAN_TYPE,     // types of the stored values
+    SCAN_INLINE,   // reads of constants become literals
+    SCAN_DROP      // writes of unread globals are removed
+} scan_mode;
+
+typedef struct {
+    scan_mode mode;
+    unsigned stamp;
+    bool calls;
+    bool failed;
+} scan;
+
+static global_info *table = NULL;
+static size_t table_count = 0;
+static size_t table_capacity = 0;
+
+// ------------------------------------------------------------------ helpers
+
+static bool is_global(const char *name) {
+    return name != NULL && name[0] == '_' && name[1] == '_';
+}
+
+static global_info *find_global(const char *name) {
+    for (size_t i = 0; i < table_count; i++)
+        if (strcmp(table[i].name, name) == 0) return &table[i];
+    return NULL;
+}
+
+static global_info *add_global(const char *name) {
+    global_info *g = find_global(name);
+    if (g != NULL) return g;
+    if (table_count == table_capacity) {
+        size_t grown = table_capacity ? 2 * table_capacity : 16;
+        global_info *more = realloc(table, grown * sizeof *more);
+        if (more == NULL) return NULL;
+        table = more;
+        table_capacity = grown;
+    }
+    g = &table[table_count++];
+    memset(g, 0, sizeof *g);
+    g->name = name;
+    g->type = LOOP_TYPE_ANY;
+    return g;
+}
+
+static const char *param_name(ast_parameter p) {
+    return p->cg_name && strcmp(p->cg_name, "") ? p->cg_name : p->value.string_value;
+}
+
+static const char *assignment_target(ast_node node) {
+    if (node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, ""))
+        return node->data.assignment.cg_name;
+    return node->data.assignment.name;
+}
+
+static loop_type join_type(loop_type a, loop_type b) {
+    if (a == LOOP_TYPE_NONE) return b;
+    if (b == LOOP_TYPE_NONE || a == b) return a;
+    return LOOP_TYPE_ANY;
+}
+
+// Literal codegen writes back exactly (floats are emitted in single precision,
+// strings naming a type are read as the type by `is`)
+static bool constant_value(ast_expression value) {
+    if (value == NULL || value->type != AST_VALUE) return false;
+    struct ast_value *v = &value->operands.identity;
+    switch (v->value_type) {
+        case AST_VALUE_INT: case AST_VALUE_NULL:
+            return true;
+        case AST_VALUE_FLOAT:
+            return (double)(float)v->value.double_value == v->value.double_value;
+        case AST_VALUE_STRING:
+            return strcmp(v->value.string_value, "Num") && strcmp(v->value.string_value, "String") &&
+                   strcmp(v->value.string_value, "Null");
+        default:
+            return false;
+    }
+}
+
+// A write of an unread global can go if computing its value has no effect and cannot fail
+static bool removable_value(ast_expression value) {
+    return value != NULL && (value->type == AST_IDENTIFIER || value->type == AST_VALUE);
+}
+
+static void inline_constant(global_info *g, ast_expression expr, ast_parameter param) {
+    struct ast_value *v = &g->init->data.assignment.value->operands.identity;
+    if (expr != NULL) {
+        expr->type = AST_VALUE;
+        expr->operands.identity = *v;
+    } else {
+        param->value_type = v->value_type;
+        memcpy(&param->value, &v->value, sizeof param->value);
+        param->cg_name = NULL;
+    }
+}
+
+// ------------------------------------------------------------------- walker
+
+static void scan_expr(scan *s, ast_expression expr);
+
+// A read of a variable, from an expression node or a call argument
+static void scan_read(scan *s, const char *name, ast_expression expr, ast_parameter param) {
+    if (!is_global(name)) return;
+    global_info *g = s->mode == SCAN_COUNT ? add_global(name) : find_global(name);
+    if (g == NULL) {
+        s->failed = true;
+        return;
+    }
+    switch (s->mode) {
+        case SCAN_COUNT: g->reads++; break;
+        case SCAN_MENTION: g->stamp = s->stamp; break;
+        case SCAN_INLINE: if (g->constant) inline_constant(g, expr, param); break;
+        default: break;
+    }
+}
+
+static void scan_params(scan *s, ast_parameter p) {
+    for (; p; p = p->next) {
+        if (p->value_type == AST_VALUE_EXPRESSION) scan_expr(s, p->expression);
+        else if (p->value_type == AST_VALUE_IDENTIFIER) scan_read(s, param_name(p), NULL, p);
+    }
+}
+
+static void scan_expr(scan *s, ast_expression expr) {
+    if (expr == NULL) return;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        const char *var = loop_expr_var_name(e);
+        if (var != NULL) {
+            scan_read(s, var, e, NULL);
+        } else if (e->type == AST_FUNCTION_CALL) {
+            s->calls = true;
+            scan_params(s, e->operands.function_call->parameters);
+        } else if (e->type == AST_IFJ_FUNCTION_EXPR) {
+            scan_params(s, e->operands.ifj_function->parameters);
+        }
+    }
+    if (walk.failed) s->failed = true;
+    ast_walk_free(&walk);
+}
+
+static void scan_block(scan *s, ast_block block);
+
+// A write of a variable; false if the assignment is to be removed
+static bool scan_write(scan *s, ast_node node) {
+    const char *name = assignment_target(node);
+    ast_expression value = node->data.assignment.value;
+    if (!is_global(name)) return true;
+    global_info *g = s->mode == SCAN_COUNT ? add_global(name) : find_global(name);
+    if (g == NULL) {
+        s->failed = true;
+        return true;
+    }
+    switch (s->mode) {
+        case SCAN_COUNT: g->writes++; break;
+        case SCAN_MENTION: g->stamp = s->stamp; break;
+        case SCAN_TYPE: g->stored = join_type(g->stored, loop_expr_type(value, NULL)); break;
+        case SCAN_DROP:
+            if (g->reads == 0 && removable_value(value)) {
+                g->writes--;
+                return false;
+            }
+            break;
+        default: break;
+    }
+    return true;
+}
+
+// Statement and the statements nested in it; false if it is to be removed
+static bool scan_node(scan *s, ast_node node) {
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+            if (!scan_write(s, node)) return false;
+            scan_expr(s, node->data.assignment.value);
+            break;
+        case AST_RETURN: scan_expr(s, node->data.return_expr.output); break;
+        case AST_CALL_FUNCTION:
+            s->calls = true;
+            scan_params(s, node->data.function_call->parameters);
+            break;
+        case AST_IFJ_FUNCTION: scan_params(s, node->data.ifj_function->parameters); break;
+        case AST_CONDITION:
+            scan_expr(s, node->data.condition.condition);
+            scan_block(s, node->data.condition.if_branch);
+            scan_block(s, node->data.condition.else_branch);
+            break;
+        case AST_WHILE_LOOP:
+            scan_expr(s, node->data.while_loop.condition);
+            scan_block(s, node->data.while_loop.body);
+            break;
+        case AST_BLOCK: scan_block(s, node->data.block); break;
+        case AST_FUNCTION: scan_block(s, node->data.function->code); break;
+        case AST_GETTER: scan_block(s, node->data.getter.body); break;
+        case AST_SETTER: scan_block(s, node->data.setter.body); break;
+        default: break;
+    }
+    return true;
+}
+
+static void scan_block(scan *s, ast_block block) {
+    if (block == NULL) return;
+    ast_node prev = NULL;
+    for (ast_node node = block->first, next; node; node = next) {
+        next = node->next;
+        if (scan_node(s, node)) {
+            prev = node;
+            continue;
+        }
+        if (prev) prev->next = next;
+        else block->first = next;
+        if (block->current == node) block->current = prev;
+        ast_node_dispose(node);  // SCAN_DROP runs last, no init points to it any more
+    }
+}
+
+static void scan_program(scan_mode mode, ast_block program, bool *failed) {
+    scan s = { .mode = mode };
+    scan_block(&s, program);
+    if (s.failed) *failed = true;
+}
+
+// ------------------------------------------------------------------ analysis
+
+static ast_block main_code(ast_block program) {
+    for (ast_node node = program->first; node; node = node->next)
+        if (node->type == AST_FUNCTION && strcmp(node->data.function->name, "main") == 0 &&
+            node->data.function->parameters == NULL)
+            return node->data.function->code;
+    return NULL;
+}
+
+// The first statement of main mentioning a global initialises it if it assigns a value
+// computed without the global; a user call before it may read the global anywhere
+static void find_inits(ast_block code) {
+    scan s = { .mode = SCAN_MENTION };
+    for (ast_node node = code ? code->first : NULL; node; node = node->next) {
+        s.stamp++;
+        s.calls = false;
+        scan_node(&s, node);
+        if (s.failed) s.calls = true;
+        for (size_t i = 0; i < table_count; i++) {
+            global_info *g = &table[i];
+            if (g->settled || (g->stamp != s.stamp && !s.calls)) continue;
+            g->settled = true;
+            if (!s.calls && node->type == AST_ASSIGNMENT && strcmp(assignment_target(node), g->name) == 0 &&
+                !loop_expr_reads(node->data.assignment.value, g->name))
+                g->init = node;
+        }
+    }
+}
+
+// Optimistic fixed point: initialised globals start without a type and take the
+// join of the types of all their writes until nothing changes
+static void infer_types(ast_block program, bool *failed) {
+    for (size_t i = 0; i < table_count; i++)
+        table[i].type = table[i].init ? LOOP_TYPE_NONE : LOOP_TYPE_ANY;
+    bool changed = true;
+    while (changed && !*failed) {
+        for (size_t i = 0; i < table_count; i++) table[i].stored = LOOP_TYPE_NONE;
+        scan_program(SCAN_TYPE, program, failed);
+        changed = false;
+        for (size_t i = 0; i < table_count; i++) {
+            loop_type type = join_type(table[i].type, table[i].stored);
+            if (type == table[i].type) continue;
+            table[i].type = type;
+            changed = true;
+        }
+    }
+    for (size_t i = 0; i < table_count; i++)
+        if (*failed || table[i].type == LOOP_TYPE_NONE) table[i].type = LOOP_TYPE_ANY;
+}
+
+// --------------------------------------------------------------- public API
+
+void globals_reset(void) {
+    free(table);
+    table = NULL;
+    table_count = table_capacity = 0;
+}
+
+void globals_program(ast tree) {
+    globals_reset();
+    if (tree == NULL || tree->class_list == NULL || tree->class_list->current == NULL) return;
+    ast_block program = tree->class_list->current;
+
+    bool failed = false;
+    scan_program(SCAN_COUNT, program, &failed);
+    if (failed) {
+        globals_reset();
+        return;
+    }
+    find_inits(main_code(program));
+    infer_types(program, &failed);
+
+    // Constants: their reads become literals, then the uses are counted again
+    bool constants = false;
+    for (size_t i = 0; i < table_count; i++) {
+        global_info *g = &table[i];
+        g->constant = g->init && g->writes == 1 && constant_value(g->init->data.assignment.value);
+        if (g->constant) {
+            constants = true;
+            opt_stats.globals_constant++;
+        }
+    }
+    if (constants) {
+        scan_program(SCAN_INLINE, program, &failed);
+        for (size_t i = 0; i < table_count; i++) table[i].reads = table[i].writes = 0;
+        scan_program(SCAN_COUNT, program, &failed);
+        if (failed) return;  // reads may be missing from the counts, nothing is removed
+    }
+
+    scan_program(SCAN_DROP, program, &failed);
+    for (size_t i = 0; i < table_count; i++) {
+        global_info *g = &table[i];
+        g->removed = g->reads == 0 && g->writes == 0;
+        if (g->removed) opt_stats.globals_removed++;
+        else if (g->type != LOOP_TYPE_ANY) opt_stats.globals_typed++;
+    }
+}
+
+loop_type globals_type(const char *name) {
+    if (!is_global(name)) return LOOP_TYPE_ANY;
+    global_info *g = find_global(name);
+    return g ? g->type : LOOP_TYPE_ANY;
+}
+
+bool globals_defined(const char *name) {
+    global_info *g = find_global(name);
+    return g == NULL || !g->removed;
+}
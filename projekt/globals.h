@@ -0,0 +1,52 @@
+/**
+ * @file globals.h
+ * @brief Whole-program analysis of the global variables (-O1).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_GLOBALS
+#define IFJ_GLOBALS
+
+#include <stdbool.h>
+#include "ast.h"
+#include "loops.h"
+
+/**
+ * @brief Rewrites the uses of the globals (`__name`) of the whole program.
+ *
+ * Reads and writes are collected over all functions, getters and setters. A global
+ * is initialised when the top level of `main` assigns it before any statement
+ * reads or writes it or calls a user function, so no read can see its nil. Then:
+ *
+ * - a global initialised by a literal and written nowhere else is a constant,
+ *   its reads are replaced by the literal,
+ * - the writes of a global nobody reads are removed when their value is a literal
+ *   or a variable; once none is left its DEFVAR is left out too,
+ * - an initialised global whose writes all store values of one type (given the
+ *   types of the other globals) gets that type, see globals_type().
+ *
+ * The results stay valid until the next call or globals_reset(). The counts go
+ * to @ref opt_stats.
+ *
+ * @param tree program after semantic analysis (identifiers carry their codegen names)
+ */
+void globals_program(ast tree);
+
+/**
+ * @brief Forgets the results of the last globals_program() (the program is compiled without it).
+ */
+void globals_reset(void);
+
+/**
+ * @brief Type every read of the global sees, LOOP_TYPE_ANY if unknown or @p name is no global.
+ */
+loop_type globals_type(const char *name);
+
+/**
+ * @brief Checks if the global still needs its DEFVAR (false once all its uses were removed).
+ */
+bool globals_defined(const char *name);
+
+#endif /* IFJ_GLOBALS */
@@ -0,0 +1,331 @@
+/**
+ * @file liveness.c
+ * @brief Live ranges of function locals and temporaries, assignment to shared frame slots.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "liveness.h"
+#include "loops.h"
+
+/**
+ * @brief Live range of a local (name set) or of a CSE temporary (entry set).
+ */
+typedef struct {
+    const char *name;
+    cse_entry entry;
+    unsigned first;
+    unsigned last;
+    bool declared;
+} live_range;
+
+/**
+ * @brief Walk state: ranges, name index into ranges and loop spans.
+ */
+typedef struct {
+    live_range *ranges;
+    size_t count;
+    size_t cap;
+    struct live_index { const char *name; size_t range; } *index;
+    size_t index_cap;
+    struct live_loop { unsigned start; unsigned end; } *loops;
+    size_t loop_count;
+    size_t loop_cap;
+    unsigned position;
+    bool failed;
+} live_walker;
+
+static size_t hash_name(const char *s) {
+    size_t h = 2166136261u;
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
+}
+
+static bool is_global(const char *name) {
+    return name[0] == '_' && name[1] == '_';
+}
+
+// --------------------------------------------------------------- ranges
+
+static bool index_grow(live_walker *w) {
+    if ((w->count + 1) * 2 <= w->index_cap) return true;
+    size_t cap = w->index_cap ? w->index_cap * 2 : 64;
+    struct live_index *index = calloc(cap, sizeof(*index));
+    if (index == NULL) return false;
+    for (size_t i = 0; i < w->index_cap; i++) {
+        if (w->index[i].name == NULL) continue;
+        size_t j = hash_name(w->index[i].name) & (cap - 1);
+        while (index[j].name) j = (j + 1) & (cap - 1);
+        index[j] = w->index[i];
+    }
+    free(w->index);
+    w->index = index;
+    w->index_cap = cap;
+    return true;
+}
+
+static live_range *new_range(live_walker *w) {
+    if (w->count == w->cap) {
+        size_t cap = w->cap ? w->cap * 2 : 64;
+        live_range *ranges = realloc(w->ranges, cap * sizeof(*ranges));
+        if (ranges == NULL) { w->failed = true; return NULL; }
+        w->ranges = ranges;
+        w->cap = cap;
+    }
+    live_range *range = &w->ranges[w->count++];
+    memset(range, 0, sizeof(*range));
+    return range;
+}
+
+/**
+ * @brief Records a use or definition of a local at the current position.
+ */
+static void touch(live_walker *w, const char *name, bool declaration) {
+    if (name == NULL || is_global(name) || w->failed) return;
+    if (!index_grow(w)) { w->failed = true; return; }
+    size_t j = hash_name(name) & (w->index_cap - 1);
+    while (w->index[j].name && strcmp(w->index[j].name, name)) j = (j + 1) & (w->index_cap - 1);
+    live_range *range;
+    if (w->index[j].name == NULL) {
+        range = new_range(w);
+        if (range == NULL) return;
+        w->index[j].name = name;
+        w->index[j].range = w->count - 1;
+        range->name = name;
+        range->first = w->position;
+    } else range = &w->ranges[w->index[j].range];
+    range->last = w->position;
+    if (declaration) range->declared = true;
+}
+
+// ----------------------------------------------------------------- walk
+
+static void walk_expr(live_walker *w, ast_expression node);
+
+static void touch_params(live_walker *w, ast_parameter param) {
+    for (; param; param = param->next) {
+        if (param->value_type == AST_VALUE_EXPRESSION) walk_expr(w, param->expression);
+        if (param->value_type != AST_VALUE_IDENTIFIER) continue;
+        touch(w, param->cg_name && strcmp(param->cg_name, "") ? param->cg_name : param->value.string_value, false);
+    }
+}
+
+static void walk_expr(live_walker *w, ast_expression node) {
+    ast_walk walk;
+    ast_walk_init(&walk, node);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        const char *name = loop_expr_var_name(e);
+        if (name) {
+            touch(w, name, false);
+            ast_walk_skip(&walk);
+        } else if (e->type == AST_FUNCTION_CALL) {
+            touch_params(w, e->operands.function_call->parameters);
+        } else if (e->type == AST_IFJ_FUNCTION_EXPR) {
+            touch_params(w, e->operands.ifj_function->parameters);
+        }
+    }
+    if (walk.failed) w->failed = true;
+    ast_walk_free(&walk);
+}
+
+static const char *target_name(ast_node node) {
+    if (node->type == AST_ASSIGNMENT)
+        return node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, "")
+               ? node->data.assignment.cg_name : node->data.assignment.name;
+    return node->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, "")
+           ? node->data.declaration.cg_name : node->data.declaration.name;
+}
+
+// Statement numbering must stay in sync with visit_block in cse.c
+static void walk_block(live_walker *w, ast_block block) {
+    if (block == NULL) return;
+    for (ast_node node = block->first; node && !w->failed; node = node->next) {
+        w->position++;
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                walk_expr(w, node->data.assignment.value);
+                touch(w, target_name(node), false);
+                break;
+            case AST_VAR_DECLARATION:
+                touch(w, target_name(node), true);
+                break;
+            case AST_CALL_FUNCTION:
+                touch_params(w, node->data.function_call->parameters);
+                break;
+            case AST_IFJ_FUNCTION:
+                touch_params(w, node->data.ifj_function->parameters);
+                break;
+            case AST_RETURN:
+                walk_expr(w, node->data.return_expr.output);
+                break;
+            case AST_CONDITION:
+                walk_expr(w, node->data.condition.condition);
+                walk_block(w, node->data.condition.if_branch);
+                walk_block(w, node->data.condition.else_branch);
+                break;
+            case AST_WHILE_LOOP: {
+                unsigned start = w->position;
+                walk_expr(w, node->data.while_loop.condition);
+                walk_block(w, node->data.while_loop.body);
+                if (w->loop_count == w->loop_cap) {
+                    size_t cap = w->loop_cap ? w->loop_cap * 2 : 16;
+                    struct live_loop *loops = realloc(w->loops, cap * sizeof(*loops));
+                    if (loops == NULL) { w->failed = true; return; }
+                    w->loops = loops;
+                    w->loop_cap = cap;
+                }
+                w->loops[w->loop_count].start = start;
+                w->loops[w->loop_count].end = w->position;
+                w->loop_count++;
+                break;
+            }
+            case AST_BLOCK:
+                walk_block(w, node->data.block);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// ----------------------------------------------------------- allocation
+
+/**
+ * @brief Extends ranges that touch a loop to the whole loop, until nothing changes.
+ */
+static void extend_over_loops(live_walker *w) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < w->count; i++) {
+            live_range *r = &w->ranges[i];
+            if (r->entry) continue; // temporaries are recomputed in every iteration
+            for (size_t l = 0; l < w->loop_count; l++) {
+                struct live_loop *loop = &w->loops[l];
+                if (r->first > loop->end || r->last < loop->start) continue;
+                if (r->first <= loop->start && r->last >= loop->end) continue;
+                if (loop->start < r->first) r->first = loop->start;
+                if (loop->end > r->last) r->last = loop->end;
+                changed = true;
+            }
+        }
+    }
+}
+
+static int compare_ranges(const void *a, const void *b) {
+    const live_range *x = *(live_range *const *)a;
+    const live_range *y = *(live_range *const *)b;
+    if (x->first != y->first) return x->first < y->first ? -1 : 1;
+    if (x->last != y->last) return x->last < y->last ? -1 : 1;
+    return 0;
+}
+
+static void map_put(slot_map map, const char *name, int slot, bool fresh) {
+    size_t j = hash_name(name) & (map->cap - 1);
+    while (map->names[j].name) j = (j + 1) & (map->cap - 1);
+    map->names[j].name = name;
+    map->names[j].slot = slot;
+    map->names[j].fresh = fresh;
+}
+
+static struct slot_name *map_find(slot_map map, const char *name) {
+    if (map == NULL || map->cap == 0) return NULL;
+    size_t j = hash_name(name) & (map->cap - 1);
+    while (map->names[j].name) {
+        if (strcmp(map->names[j].name, name) == 0) return &map->names[j];
+        j = (j + 1) & (map->cap - 1);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Linear scan: each range takes the lowest slot that is free before it starts.
+ */
+static slot_map assign_slots(live_walker *w) {
+    slot_map map = calloc(1, sizeof(*map));
+    if (map == NULL) return NULL;
+    size_t n = 0;
+    for (size_t i = 0; i < w->count; i++)
+        if (w->ranges[i].declared || w->ranges[i].entry) n++;
+    map->cap = 16;
+    while (map->cap < n * 2 + 2) map->cap *= 2;
+    map->names = calloc(map->cap, sizeof(*map->names));
+    live_range **order = malloc((n ? n : 1) * sizeof(*order));
+    unsigned *free_at = malloc((n ? n : 1) * sizeof(*free_at));
+    if (map->names == NULL || order == NULL || free_at == NULL) {
+        free(order); free(free_at); liveness_free(map);
+        return NULL;
+    }
+    n = 0;
+    for (size_t i = 0; i < w->count; i++)
+        if (w->ranges[i].declared || w->ranges[i].entry) order[n++] = &w->ranges[i];
+    qsort(order, n, sizeof(*order), compare_ranges);
+
+    for (size_t i = 0; i < n; i++) {
+        live_range *r = order[i];
+        unsigned slot = 0;
+        while (slot < map->slots && free_at[slot] >= r->first) slot++;
+        bool fresh = slot == map->slots;
+        if (fresh) map->slots++;
+        free_at[slot] = r->last;
+        if (r->entry) r->entry->slot = (int)slot;
+        else {
+            map_put(map, r->name, (int)slot, fresh);
+            map->locals++;
+        }
+    }
+    free(order);
+    free(free_at);
+    return map;
+}
+
+// --------------------------------------------------------------- public API
+
+slot_map liveness_allocate(ast_block body, cse_plan cse) {
+    live_walker w;
+    memset(&w, 0, sizeof w);
+    walk_block(&w, body);
+
+    if (cse && !w.failed) { // value temporaries live between their first and last use
+        for (size_t i = 0; i < cse->entry_count; i++) {
+            cse_entry entry = cse->entries[i];
+            if (entry->temp < 0) continue;
+            live_range *range = new_range(&w);
+            if (range == NULL) break;
+            range->entry = entry;
+            range->first = entry->first;
+            range->last = entry->last;
+        }
+    }
+    slot_map map = NULL;
+    if (!w.failed) {
+        extend_over_loops(&w);
+        map = assign_slots(&w);
+    }
+    free(w.ranges);
+    free(w.index);
+    free(w.loops);
+    return map;
+}
+
+int liveness_slot(slot_map map, const char *name) {
+    struct slot_name *entry = map_find(map, name);
+    return entry ? entry->slot : -1;
+}
+
+bool liveness_is_fresh(slot_map map, const char *name) {
+    struct slot_name *entry = map_find(map, name);
+    return entry && entry->fresh;
+}
+
+void liveness_free(slot_map map) {
+    if (map == NULL) return;
+    free(map->names);
+    free(map);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file liveness.h
+ * @brief Live ranges of function locals and temporaries, assignment to shared frame slots.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_LIVENESS
+#define IFJ_LIVENESS
+
+#include <stdbool.h>
+#include "ast.h"
+#include "cse.h"
+
+/**
+ * @brief Frame slots of one function.
+ *
+ * Every local declared in the function body and every value temporary of the
+ * CSE plan gets a slot LF@%s<N>. Values whose live ranges do not overlap share
+ * a slot. Ranges are intervals over the pre-order statement numbering; a range
+ * touching a loop is extended to the whole loop (values flow over the back edge).
+ *
+ * - names:  local codegen name -> slot (open addressing), fresh if the local is the
+ *           first value of its slot (the slot is still undefined at its declaration),
+ * - slots:  number of slots (DEFVARs at function entry),
+ * - locals: number of declared locals that were mapped.
+ */
+typedef struct slot_map {
+    struct slot_name { const char *name; int slot; bool fresh; } *names;
+    size_t cap;
+    unsigned slots;
+    unsigned locals;
+} *slot_map;
+
+/**
+ * @brief Computes live ranges of a function body and assigns slots.
+ *
+ * @param body function body
+ * @param cse  CSE plan of the same body (temporaries get slots too), may be NULL
+ * @return slot map or NULL on allocation error
+ */
+slot_map liveness_allocate(ast_block body, cse_plan cse);
+
+/**
+ * @brief Returns the slot of a local, -1 if @p name is not a mapped local.
+ */
+int liveness_slot(slot_map map, const char *name);
+
+/**
+ * @brief Checks if the local is the first value of its slot, so its declaration needs no reset.
+ */
+bool liveness_is_fresh(slot_map map, const char *name);
+
+/**
+ * @brief Frees the slot map.
+ */
+void liveness_free(slot_map map);
+
+#endif /* IFJ_LIVENESS */
@@ -0,0 +1,691 @@
+/**
+ * @file loops.c
+ * @brief Analysis of while loops (induction variables, trip counts, variable types).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "loops.h"
+#include "globals.h"
+
+char *loop_expr_var_name(ast_expression expr) {
+    if (expr == NULL) return NULL;
+    if (expr->type == AST_IDENTIFIER) {
+        if (expr->operands.identifier.cg_name && strcmp(expr->operands.identifier.cg_name, ""))
+            return expr->operands.identifier.cg_name;
+        return expr->operands.identifier.value;
+    }
+    if (expr->type == AST_VALUE && expr->operands.identity.value_type == AST_VALUE_IDENTIFIER)
+        return expr->operands.identity.value.string_value;
+    return NULL;
+}
+
+bool loop_expr_reads(ast_expression expr, const char *name) {
+    bool reads = false;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; !reads && (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        const char *var = loop_expr_var_name(e);
+        if (var) {
+            reads = strcmp(var, name) == 0;
+            continue;
+        }
+        ast_parameter param = NULL;
+        if (e->type == AST_FUNCTION_CALL) param = e->operands.function_call->parameters;
+        if (e->type == AST_IFJ_FUNCTION_EXPR) param = e->operands.ifj_function->parameters;
+        for (; param && !reads; param = param->next) {
+            if (param->value_type == AST_VALUE_EXPRESSION) reads = loop_expr_reads(param->expression, name);
+            else if (param->value_type == AST_VALUE_IDENTIFIER)
+                reads = strcmp(param->cg_name && strcmp(param->cg_name, "") ? param->cg_name : param->value.string_value, name) == 0;
+        }
+    }
+    ast_walk_free(&walk);
+    return reads || walk.failed;  // out of memory: assume it does
+}
+
+/**
+ * @brief Codegen name of the variable written by an assignment or declaration node.
+ */
+static const char *node_target(ast_node node) {
+    if (node->type == AST_ASSIGNMENT) {
+        if (node->data.assignment.cg_name && strcmp(node->data.assignment.cg_name, ""))
+            return node->data.assignment.cg_name;
+        return node->data.assignment.name;
+    }
+    if (node->type == AST_VAR_DECLARATION) {
+        if (node->data.declaration.cg_name && strcmp(node->data.declaration.cg_name, ""))
+            return node->data.declaration.cg_name;
+        return node->data.declaration.name;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Checks if the expression is an int literal and stores its value.
+ */
+static bool int_literal(ast_expression expr, int *value) {
+    if (expr == NULL || expr->type != AST_VALUE || expr->operands.identity.value_type != AST_VALUE_INT)
+        return false;
+    *value = expr->operands.identity.value.int_value;
+    return true;
+}
+
+/**
+ * @brief Counts statements writing @p var in the block and all nested blocks.
+ */
+static unsigned block_writes(ast_block block, const char *var);
+
+static unsigned node_writes(ast_node node, const char *var) {
+    const char *target;
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+        case AST_VAR_DECLARATION:
+            target = node_target(node);
+            return target && strcmp(target, var) == 0;
+        case AST_CONDITION:
+            return block_writes(node->data.condition.if_branch, var) +
+                   block_writes(node->data.condition.else_branch, var);
+        case AST_WHILE_LOOP:
+            return block_writes(node->data.while_loop.body, var);
+        case AST_BLOCK:
+            return block_writes(node->data.block, var);
+        default:
+            return 0;
+    }
+}
+
+static unsigned block_writes(ast_block block, const char *var) {
+    unsigned count = 0;
+    if (block == NULL) return 0;
+    for (ast_node node = block->first; node; node = node->next)
+        count += node_writes(node, var);
+    return count;
+}
+
+static unsigned expr_size(ast_expression expr);
+
+// Nodes of the expression arguments of a call
+static unsigned args_size(ast_parameter param) {
+    unsigned size = 0;
+    for (; param; param = param->next)
+        if (param->value_type == AST_VALUE_EXPRESSION) size += expr_size(param->expression);
+    return size;
+}
+
+/**
+ * @brief Number of nodes of an expression tree.
+ */
+static unsigned expr_size(ast_expression expr) {
+    unsigned size = 0;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        size++;
+        if (e->type == AST_FUNCTION_CALL) size += args_size(e->operands.function_call->parameters);
+        else if (e->type == AST_IFJ_FUNCTION_EXPR) size += args_size(e->operands.ifj_function->parameters);
+        else if (e->type == AST_IS && e->operands.binary_op.right) size++;  // type name
+    }
+    ast_walk_free(&walk);
+    return size;
+}
+
+/**
+ * @brief Checks if a loop body may be emitted several times.
+ *
+ * Declarations are allowed only on the top level of the body (codegen hoists
+ * them in front of the loop), break/continue would need per-copy labels.
+ */
+static bool block_copyable(ast_block block, int depth, unsigned *size) {
+    if (block == NULL) return true;
+    for (ast_node node = block->first; node; node = node->next) {
+        (*size)++;
+        switch (node->type) {
+            case AST_BREAK: case AST_CONTINUE:
+            case AST_FUNCTION: case AST_GETTER: case AST_SETTER:
+                return false;
+            case AST_VAR_DECLARATION:
+                if (depth > 0) return false;
+                break;
+            case AST_ASSIGNMENT:
+                *size += expr_size(node->data.assignment.value);
+                break;
+            case AST_RETURN:
+                *size += expr_size(node->data.return_expr.output);
+                break;
+            case AST_CALL_FUNCTION:
+                *size += args_size(node->data.function_call->parameters);
+                break;
+            case AST_IFJ_FUNCTION:
+                *size += args_size(node->data.ifj_function->parameters);
+                break;
+            case AST_CONDITION:
+                *size += expr_size(node->data.condition.condition);
+                if (!block_copyable(node->data.condition.if_branch, depth + 1, size) ||
+                    !block_copyable(node->data.condition.else_branch, depth + 1, size))
+                    return false;
+                break;
+            case AST_WHILE_LOOP:
+                *size += 2 * expr_size(node->data.while_loop.condition);
+                if (!block_copyable(node->data.while_loop.body, depth + 1, size)) return false;
+                break;
+            case AST_BLOCK:
+                if (!block_copyable(node->data.block, depth + 1, size)) return false;
+                break;
+            default:
+                break;
+        }
+        if (*size > LOOP_UNROLL_MAX_NODES) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Recognises `var = var + c`, `var = c + var` and `var = var - c`.
+ */
+static bool update_step(ast_node node, const char *var, int *step) {
+    int c;
+    if (node->type != AST_ASSIGNMENT || node->data.assignment.value == NULL) return false;
+    const char *target = node_target(node);
+    if (target == NULL || strcmp(target, var)) return false;
+
+    ast_expression value = node->data.assignment.value;
+    if (value->type != AST_ADD && value->type != AST_SUB) return false;
+    ast_expression left = value->operands.binary_op.left;
+    ast_expression right = value->operands.binary_op.right;
+    const char *lname = loop_expr_var_name(left);
+
+    if (lname && strcmp(lname, var) == 0 && int_literal(right, &c)) {
+        if (value->type == AST_SUB && c == -2147483647 - 1) return false;
+        *step = value->type == AST_ADD ? c : -c;
+        return true;
+    }
+    const char *rname = loop_expr_var_name(right);
+    if (value->type == AST_ADD && rname && strcmp(rname, var) == 0 && int_literal(left, &c)) {
+        *step = c;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Assignment of @p block that is the last write of @p var before @p loop, or NULL.
+ */
+static ast_node entry_assignment(ast_block block, ast_node loop, const char *var) {
+    ast_node last = NULL;
+    if (block == NULL) return NULL;
+    for (ast_node node = block->first; node; node = node->next) {
+        if (node == loop) return last;
+        if (node_writes(node, var))
+            last = node->type == AST_ASSIGNMENT ? node : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds the int literal assigned to @p var right before @p loop in @p block.
+ */
+static bool entry_value(ast_block block, ast_node loop, const char *var, int *value) {
+    ast_node node = entry_assignment(block, loop, var);
+    return node && int_literal(node->data.assignment.value, value);
+}
+
+/**
+ * @brief Number of iterations of `for (x = x0; x CMP n; x += step)`, -1 if unknown or unbounded.
+ */
+static long long trip_count(ast_expression_type cmp, long long x0, long long n, long long step) {
+    switch (cmp) {
+        case AST_LE: n += 1; /* fall through */
+        case AST_LT:
+            if (x0 >= n) return 0;
+            return step > 0 ? (n - x0 + step - 1) / step : -1;
+        case AST_GE: n -= 1; /* fall through */
+        case AST_GT:
+            if (x0 <= n) return 0;
+            return step < 0 ? (x0 - n - step - 1) / -step : -1;
+        case AST_NOT_EQUAL:
+            if (x0 == n) return 0;
+            if (step == 0 || (n - x0) % step != 0 || (n - x0) / step < 0) return -1;
+            return (n - x0) / step;
+        default:
+            return -1;
+    }
+}
+
+bool loop_analyze(ast_block block, ast_node loop, loop_info *info) {
+    ast_expression cond = loop->data.while_loop.condition;
+    ast_block body = loop->data.while_loop.body;
+    if (cond == NULL || body == NULL) return false;
+
+    switch (cond->type) {
+        case AST_LT: case AST_LE: case AST_GT: case AST_GE: case AST_NOT_EQUAL: break;
+        default: return false;
+    }
+    char *var = loop_expr_var_name(cond->operands.binary_op.left);
+    if (var == NULL || (var[0] == '_' && var[1] == '_')) return false; // globals may change in calls
+
+    ast_expression bound = cond->operands.binary_op.right;
+    int bound_value;
+    bool bound_literal = int_literal(bound, &bound_value);
+    if (!bound_literal && loop_expr_var_name(bound) == NULL) return false;
+
+    // exactly one write of the variable, a top-level `var = var ± c`
+    if (block_writes(body, var) != 1) return false;
+    ast_node update = NULL;
+    int step = 0;
+    for (ast_node node = body->first; node; node = node->next) {
+        if (update_step(node, var, &step)) { update = node; break; }
+    }
+    if (update == NULL) return false;
+
+    int init;
+    info->var = var;
+    info->update = update;
+    info->step = step;
+    info->cmp = cond->type;
+    info->bound = bound;
+    info->entry_is_int = entry_value(block, loop, var, &init);
+    info->trip_count = -1;
+    if (info->entry_is_int && bound_literal)
+        info->trip_count = trip_count(cond->type, init, bound_value, step);
+
+    unsigned size = expr_size(cond);
+    info->unrollable = block_copyable(body, 0, &size);
+    return true;
+}
+
+// ---- types of the variables of a loop (loop versioning)
+
+static loop_type join_type(loop_type a, loop_type b) {
+    if (a == LOOP_TYPE_NONE) return b;
+    if (b == LOOP_TYPE_NONE || a == b) return a;
+    return LOOP_TYPE_ANY;
+}
+
+static bool type_known(loop_type type) {
+    return type != LOOP_TYPE_NONE && type != LOOP_TYPE_ANY;
+}
+
+static bool type_numeric(loop_type type) {
+    return type == LOOP_TYPE_INT || type == LOOP_TYPE_FLOAT;
+}
+
+loop_type loop_var_type(const loop_types *types, const char *var) {
+    if (var != NULL && var[0] == '_' && var[1] == '_') return globals_type(var);
+    if (types == NULL || var == NULL) return LOOP_TYPE_ANY;
+    for (unsigned i = 0; i < types->count; i++)
+        if (strcmp(types->var[i], var) == 0) return types->type[i];
+    return LOOP_TYPE_ANY;
+}
+
+static loop_type expr_types(ast_expression expr, const loop_types *types, unsigned *typed);
+
+// Type of a call argument
+static loop_type param_type(ast_parameter param, const loop_types *types) {
+    if (param == NULL) return LOOP_TYPE_ANY;
+    switch (param->value_type) {
+        case AST_VALUE_INT: return LOOP_TYPE_INT;
+        case AST_VALUE_FLOAT: return LOOP_TYPE_FLOAT;
+        case AST_VALUE_STRING: return LOOP_TYPE_STRING;
+        case AST_VALUE_IDENTIFIER:
+            return loop_var_type(types, param->cg_name && strcmp(param->cg_name, "") ? param->cg_name : param->value.string_value);
+        case AST_VALUE_EXPRESSION: return expr_types(param->expression, types, NULL);
+        default: return LOOP_TYPE_ANY;
+    }
+}
+
+// Same results as the runtime coercion: int with float gives float, `/` always float,
+// string * int repeats; other mixes end with error 26 or depend on values
+loop_type loop_op_type(ast_expression node, const loop_type *operands, const loop_types *types) {
+    loop_type l, r;
+    switch (node->type) {
+        case AST_VALUE:
+            switch (node->operands.identity.value_type) {
+                case AST_VALUE_INT: return LOOP_TYPE_INT;
+                case AST_VALUE_FLOAT: return LOOP_TYPE_FLOAT;
+                case AST_VALUE_STRING: return LOOP_TYPE_STRING;
+                case AST_VALUE_IDENTIFIER: return loop_var_type(types, loop_expr_var_name(node));
+                default: return LOOP_TYPE_ANY;
+            }
+        case AST_IDENTIFIER:
+            return loop_var_type(types, loop_expr_var_name(node));
+        case AST_IFJ_FUNCTION_EXPR: {
+            const char *name = node->operands.ifj_function->name;
+            if (strcmp(name, "length") == 0 || strcmp(name, "ord") == 0) return LOOP_TYPE_INT;
+            if (strcmp(name, "chr") == 0) return LOOP_TYPE_STRING;
+            if (strcmp(name, "floor") == 0) { // int arguments are not converted
+                loop_type arg = param_type(node->operands.ifj_function->parameters, types);
+                return arg == LOOP_TYPE_FLOAT ? LOOP_TYPE_INT : arg == LOOP_TYPE_NONE ? LOOP_TYPE_NONE : LOOP_TYPE_ANY;
+            }
+            return LOOP_TYPE_ANY;
+        }
+        case AST_NOT: case AST_IS: case AST_AND: case AST_OR:
+            return LOOP_TYPE_BOOL;
+        case AST_TERNARY:
+            l = operands[1];
+            r = operands[2];
+            break;
+        case AST_ADD: case AST_SUB: case AST_MUL: case AST_DIV: case AST_CONCAT:
+        case AST_EQUALS: case AST_NOT_EQUAL: case AST_LT: case AST_LE: case AST_GT: case AST_GE:
+            l = operands[0];
+            r = operands[1];
+            break;
+        default:  // calls
+            return LOOP_TYPE_ANY;
+    }
+    if (l == LOOP_TYPE_ANY || r == LOOP_TYPE_ANY) return LOOP_TYPE_ANY;
+    if (l == LOOP_TYPE_NONE || r == LOOP_TYPE_NONE) return LOOP_TYPE_NONE;
+
+    bool numeric = type_numeric(l) && type_numeric(r);
+    loop_type number = l == r ? l : LOOP_TYPE_FLOAT;
+    switch (node->type) {
+        case AST_TERNARY:
+            return l == r ? l : LOOP_TYPE_ANY;
+        case AST_ADD:
+            if (l == LOOP_TYPE_STRING && r == LOOP_TYPE_STRING) return LOOP_TYPE_STRING;
+            return numeric ? number : LOOP_TYPE_ANY;
+        case AST_SUB:
+            return numeric ? number : LOOP_TYPE_ANY;
+        case AST_MUL:
+            if (l == LOOP_TYPE_STRING && r == LOOP_TYPE_INT) return LOOP_TYPE_STRING;
+            return numeric ? number : LOOP_TYPE_ANY;
+        case AST_DIV:
+            return numeric ? LOOP_TYPE_FLOAT : LOOP_TYPE_ANY;
+        case AST_CONCAT:
+            return l == LOOP_TYPE_STRING && r == LOOP_TYPE_STRING ? LOOP_TYPE_STRING : LOOP_TYPE_ANY;
+        case AST_EQUALS: case AST_NOT_EQUAL:
+            return numeric || l == r ? LOOP_TYPE_BOOL : LOOP_TYPE_ANY;
+        default:  // relations
+            return numeric || (l == LOOP_TYPE_STRING && r == LOOP_TYPE_STRING) ? LOOP_TYPE_BOOL : LOOP_TYPE_ANY;
+    }
+}
+
+// Counts the operations typed by @p types, the types are computed bottom-up on a stack
+static loop_type expr_types(ast_expression expr, const loop_types *types, unsigned *typed) {
+    loop_type *stack = NULL;
+    size_t count = 0, capacity = 0;
+    loop_type result = LOOP_TYPE_ANY;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (!walk.leaving) continue;
+        loop_type operands[3] = { LOOP_TYPE_ANY, LOOP_TYPE_ANY, LOOP_TYPE_ANY };
+        for (int i = ast_expression_operand_count(e) - 1; i >= 0; i--)
+            if (ast_expression_operand(e, i) != NULL) operands[i] = stack[--count];
+        loop_type type = loop_op_type(e, operands, types);
+        if (typed && type_known(type) && e->type >= AST_ADD && e->type <= AST_GE) (*typed)++;
+        if (count == capacity) {
+            size_t grown = capacity ? 2 * capacity : 32;
+            loop_type *more = realloc(stack, grown * sizeof *more);
+            if (more == NULL) break;
+            stack = more;
+            capacity = grown;
+        }
+        stack[count++] = type;
+    }
+    if (!walk.failed && count == 1) result = stack[0];
+    ast_walk_free(&walk);
+    free(stack);
+    return result;
+}
+
+loop_type loop_expr_type(ast_expression expr, const loop_types *types) {
+    return expr_types(expr, types, NULL);
+}
+
+// Statements and expressions of a loop collected for the type analysis
+typedef struct version_scan {
+    loop_types *types;
+    ast_node writes[LOOP_VERSION_MAX_NODES];        // assignments
+    unsigned write_count;
+    ast_expression roots[LOOP_VERSION_MAX_NODES];   // expression trees, call arguments included
+    unsigned root_count;
+    unsigned size;
+    bool ok;
+} version_scan;
+
+// Index of a tracked variable, -1 for globals and when the table is full
+static int scan_var(version_scan *scan, const char *var) {
+    loop_types *types = scan->types;
+    if (var == NULL || (var[0] == '_' && var[1] == '_')) return -1;
+    for (unsigned i = 0; i < types->count; i++)
+        if (strcmp(types->var[i], var) == 0) return (int)i;
+    if (types->count == LOOP_VERSION_MAX_VARS) return -1;
+    types->var[types->count] = var;
+    types->type[types->count] = LOOP_TYPE_NONE;
+    types->guarded[types->count] = true;
+    return (int)types->count++;
+}
+
+static void scan_args(version_scan *scan, ast_parameter param);
+
+static void scan_expr(version_scan *scan, ast_expression expr) {
+    if (expr == NULL) return;
+    if (scan->root_count == LOOP_VERSION_MAX_NODES) {
+        scan->ok = false;
+        return;
+    }
+    scan->roots[scan->root_count++] = expr;
+    scan->size += expr_size(expr);
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving) continue;
+        if (loop_expr_var_name(e)) scan_var(scan, loop_expr_var_name(e));
+        else if (e->type == AST_FUNCTION_CALL) scan_args(scan, e->operands.function_call->parameters);
+        else if (e->type == AST_IFJ_FUNCTION_EXPR) scan_args(scan, e->operands.ifj_function->parameters);
+    }
+    if (walk.failed) scan->ok = false;
+    ast_walk_free(&walk);
+}
+
+static void scan_args(version_scan *scan, ast_parameter param) {
+    for (; param; param = param->next)
+        if (param->value_type == AST_VALUE_EXPRESSION) scan_expr(scan, param->expression);
+}
+
+static void scan_block(version_scan *scan, ast_block block, int depth) {
+    if (block == NULL) return;
+    for (ast_node node = block->first; node && scan->ok; node = node->next) {
+        scan->size++;
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                if (node->data.assignment.value == NULL) break;
+                scan_var(scan, node_target(node));
+                scan->writes[scan->write_count++] = node;
+                scan_expr(scan, node->data.assignment.value);
+                break;
+            case AST_VAR_DECLARATION: {  // nested declarations reset the variable to nil
+                int var = scan_var(scan, node_target(node));
+                if (depth > 0 && var >= 0) scan->types->type[var] = LOOP_TYPE_ANY;
+                break;
+            }
+            case AST_CONDITION:
+                scan_expr(scan, node->data.condition.condition);
+                scan_block(scan, node->data.condition.if_branch, depth + 1);
+                scan_block(scan, node->data.condition.else_branch, depth + 1);
+                break;
+            case AST_WHILE_LOOP:
+                scan_expr(scan, node->data.while_loop.condition);
+                scan_block(scan, node->data.while_loop.body, depth + 1);
+                break;
+            case AST_BLOCK:
+                scan_block(scan, node->data.block, depth + 1);
+                break;
+            case AST_EXPRESSION:
+                scan_expr(scan, node->data.expression);
+                break;
+            case AST_RETURN:
+                scan_expr(scan, node->data.return_expr.output);
+                break;
+            case AST_CALL_FUNCTION:
+                scan_args(scan, node->data.function_call->parameters);
+                break;
+            case AST_IFJ_FUNCTION:
+                scan_args(scan, node->data.ifj_function->parameters);
+                break;
+            case AST_BREAK: case AST_CONTINUE:
+                break;
+            default:
+                scan->ok = false;
+                break;
+        }
+        if (scan->size > LOOP_VERSION_MAX_NODES) scan->ok = false;
+    }
+}
+
+static bool args_read(ast_parameter param, const char *var) {
+    for (; param; param = param->next) {
+        if (param->value_type == AST_VALUE_EXPRESSION && loop_expr_reads(param->expression, var)) return true;
+        if (param->value_type == AST_VALUE_IDENTIFIER &&
+            strcmp(param->cg_name && strcmp(param->cg_name, "") ? param->cg_name : param->value.string_value, var) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool block_mentions(ast_block block, const char *var);
+
+// Reads or writes of @p var in a statement; top-level declarations of a loop body are emitted in front of the loop
+static bool node_mentions(ast_node node, const char *var) {
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+            return node_writes(node, var) || loop_expr_reads(node->data.assignment.value, var);
+        case AST_VAR_DECLARATION:
+            return false;
+        case AST_CONDITION:
+            return loop_expr_reads(node->data.condition.condition, var) ||
+                   block_mentions(node->data.condition.if_branch, var) ||
+                   block_mentions(node->data.condition.else_branch, var);
+        case AST_WHILE_LOOP:
+            return loop_expr_reads(node->data.while_loop.condition, var) ||
+                   block_mentions(node->data.while_loop.body, var);
+        case AST_BLOCK:
+            return block_mentions(node->data.block, var);
+        case AST_EXPRESSION:
+            return loop_expr_reads(node->data.expression, var);
+        case AST_RETURN:
+            return node->data.return_expr.output && loop_expr_reads(node->data.return_expr.output, var);
+        case AST_CALL_FUNCTION:
+            return args_read(node->data.function_call->parameters, var);
+        case AST_IFJ_FUNCTION:
+            return args_read(node->data.ifj_function->parameters, var);
+        default:
+            return false;
+    }
+}
+
+static bool block_mentions(ast_block block, const char *var) {
+    if (block == NULL) return false;
+    for (ast_node node = block->first; node; node = node->next)
+        if (node_mentions(node, var)) return true;
+    return false;
+}
+
+/**
+ * @brief Checks if every iteration writes @p var by a top-level `var = e` before reading it.
+ */
+static bool written_first(ast_node loop, const char *var) {
+    if (loop_expr_reads(loop->data.while_loop.condition, var)) return false;
+    for (ast_node node = loop->data.while_loop.body->first; node; node = node->next) {
+        if (!node_mentions(node, var)) continue;
+        return node->type == AST_ASSIGNMENT && node_writes(node, var) &&
+               !loop_expr_reads(node->data.assignment.value, var);
+    }
+    return false;
+}
+
+/**
+ * @brief Guesses the type of a guarded variable from an operation with an operand of known type.
+ */
+static bool unify_types(version_scan *scan, ast_expression expr) {
+    loop_types *types = scan->types;
+    bool changed = false;
+    ast_walk walk;
+    ast_walk_init(&walk, expr);
+    for (ast_expression e; (e = ast_walk_next(&walk)) != NULL;) {
+        if (walk.leaving || e->type < AST_ADD || e->type > AST_GE) continue;
+        for (int side = 0; side < 2; side++) {
+            int var = scan_var(scan, loop_expr_var_name(ast_expression_operand(e, side)));
+            if (var < 0 || !types->guarded[var] || types->type[var] != LOOP_TYPE_NONE) continue;
+            loop_type other = loop_expr_type(ast_expression_operand(e, 1 - side), types);
+            if (other == LOOP_TYPE_INT || other == LOOP_TYPE_FLOAT || other == LOOP_TYPE_STRING) {
+                types->type[var] = other;
+                changed = true;
+            }
+        }
+    }
+    ast_walk_free(&walk);
+    return changed;
+}
+
+bool loop_version(ast_block block, ast_node loop, const loop_types *outer, loop_types *types) {
+    ast_expression cond = loop->data.while_loop.condition;
+    ast_block body = loop->data.while_loop.body;
+    if (cond == NULL || body == NULL) return false;
+
+    version_scan scan = { .types = types, .ok = true };
+    types->count = 0;
+    scan_expr(&scan, cond);
+    scan_block(&scan, body, 0);
+    if (!scan.ok) return false;
+
+    // Entry types are guesses tested by the guard; variables typed by the enclosing loop
+    // and those whose first write defines them need no test
+    for (unsigned i = 0; i < types->count; i++) {
+        if (types->type[i] == LOOP_TYPE_ANY) continue;
+        loop_type known = loop_var_type(outer, types->var[i]);
+        if (type_known(known) || written_first(loop, types->var[i])) {
+            types->type[i] = type_known(known) ? known : LOOP_TYPE_NONE;
+            types->guarded[i] = false;
+            continue;
+        }
+        ast_node entry = entry_assignment(block, loop, types->var[i]);
+        loop_type type = entry ? loop_expr_type(entry->data.assignment.value, NULL) : LOOP_TYPE_ANY;
+        if (type_known(type)) types->type[i] = type;
+    }
+
+    // Fixed point: writes keep the type or make it ANY, then guesses, then the rest is ANY
+    bool changed;
+    do {
+        changed = false;
+        for (unsigned i = 0; i < scan.write_count; i++) {
+            int var = scan_var(&scan, node_target(scan.writes[i]));
+            if (var < 0) continue;
+            loop_type type = join_type(types->type[var], loop_expr_type(scan.writes[i]->data.assignment.value, types));
+            if (type != types->type[var]) {
+                types->type[var] = type;
+                changed = true;
+            }
+        }
+        for (unsigned i = 0; !changed && i < scan.root_count; i++)
+            changed = unify_types(&scan, scan.roots[i]);
+        if (changed) continue;
+        for (unsigned i = 0; i < types->count; i++) {
+            if (types->type[i] == LOOP_TYPE_NONE) {
+                types->type[i] = LOOP_TYPE_ANY;
+                changed = true;
+            }
+        }
+    } while (changed);
+
+    for (unsigned i = 0; i < types->count; i++) { // facts of the enclosing loop hold here too
+        loop_type known = loop_var_type(outer, types->var[i]);
+        if (types->type[i] == LOOP_TYPE_ANY && type_known(known)) {
+            types->type[i] = known;
+            types->guarded[i] = false;
+        }
+    }
+
+    unsigned typed = 0, untyped = 0;
+    for (unsigned i = 0; i < scan.root_count; i++) {
+        expr_types(scan.roots[i], types, &typed);
+        expr_types(scan.roots[i], outer, &untyped);
+    }
+    return typed > untyped;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file loops.h
+ * @brief Analysis of while loops (induction variables, trip counts, variable types).
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_LOOPS
+#define IFJ_LOOPS
+
+#include <stdbool.h>
+#include "ast.h"
+
+#define LOOP_UNROLL_MAX_NODES 48   // largest body (statements + expression nodes) that is copied
+#define LOOP_VERSION_MAX_NODES 256 // largest loop (condition + body) that gets a typed copy
+#define LOOP_VERSION_MAX_VARS 16   // variables whose types are tracked in one loop
+
+/**
+ * @brief Induction variable of a `while (i OP bound) { ... i = i ± c ... }` loop.
+ *
+ * - var:          codegen name of the induction variable (always a local),
+ * - update:       the only statement in the body writing @c var (top level of the body),
+ * - step:         signed int step of the update,
+ * - cmp:          AST_LT, AST_LE, AST_GT, AST_GE or AST_NOT_EQUAL,
+ * - bound:        right operand of the condition (int literal or identifier),
+ * - entry_is_int: @c var provably holds an int when the loop is entered,
+ * - trip_count:   exact number of iterations, -1 if unknown,
+ * - unrollable:   body can be copied (no break/continue, no nested declarations, small).
+ */
+typedef struct loop_info {
+    char *var;
+    ast_node update;
+    int step;
+    ast_expression_type cmp;
+    ast_expression bound;
+    bool entry_is_int;
+    long long trip_count;
+    bool unrollable;
+} loop_info;
+
+/**
+ * @brief Type of a value known at compile time.
+ *
+ * LOOP_TYPE_NONE is the optimistic start of the analysis (no value seen yet),
+ * LOOP_TYPE_ANY a value whose type is only known at runtime.
+ */
+typedef enum loop_type {
+    LOOP_TYPE_NONE,
+    LOOP_TYPE_INT,
+    LOOP_TYPE_FLOAT,
+    LOOP_TYPE_STRING,
+    LOOP_TYPE_BOOL,
+    LOOP_TYPE_ANY
+} loop_type;
+
+/**
+ * @brief Types of the local variables of a loop, valid everywhere in its typed copy.
+ *
+ * - var:     codegen names of the tracked variables,
+ * - type:    type of the variable, LOOP_TYPE_ANY if not provable,
+ * - guarded: the type is tested on loop entry; other typed variables are written
+ *            before any read in every iteration and need no test.
+ */
+typedef struct loop_types {
+    unsigned count;
+    const char *var[LOOP_VERSION_MAX_VARS];
+    loop_type type[LOOP_VERSION_MAX_VARS];
+    bool guarded[LOOP_VERSION_MAX_VARS];
+} loop_types;
+
+/**
+ * @brief Returns the codegen name of an identifier expression, NULL for other nodes.
+ */
+char *loop_expr_var_name(ast_expression expr);
+
+/**
+ * @brief Checks if the expression (call arguments included) reads the variable @p name.
+ */
+bool loop_expr_reads(ast_expression expr, const char *name);
+
+/**
+ * @brief Type of a variable, LOOP_TYPE_ANY if it is not tracked.
+ *
+ * Globals have the type proved for the whole program by globals_program().
+ *
+ * @param types types of a loop, may be NULL
+ * @param var   codegen name of the variable
+ */
+loop_type loop_var_type(const loop_types *types, const char *var);
+
+/**
+ * @brief Type of the value of one expression node given the types of its operands.
+ *
+ * @param node     expression node
+ * @param operands types of the operands in evaluation order (ast_expression_operand())
+ * @param types    types of the variables, may be NULL
+ * @return LOOP_TYPE_ANY if the operation may coerce to different types or fail
+ */
+loop_type loop_op_type(ast_expression node, const loop_type *operands, const loop_types *types);
+
+/**
+ * @brief Type of the value of an expression tree, see loop_op_type().
+ */
+loop_type loop_expr_type(ast_expression expr, const loop_types *types);
+
+/**
+ * @brief Recognises an integer induction variable of a while loop.
+ *
+ * @param block block containing @p loop (statements before the loop are used to
+ *              prove the entry value), may be NULL
+ * @param loop  AST_WHILE_LOOP node
+ * @param info  filled on success
+ * @return true if the loop has an induction variable usable for specialisation.
+ */
+bool loop_analyze(ast_block block, ast_node loop, loop_info *info);
+
+/**
+ * @brief Proves the types of the variables of a while loop for its typed copy.
+ *
+ * Every write of a typed variable in the loop stores a value of the same type,
+ * given the types of all variables. The guarded variables are assumed to hold
+ * their type on loop entry (the code generator tests it), the others are written
+ * before any read in every iteration or typed by the enclosing loop. Globals may
+ * change in calls and are only typed by the whole-program analysis (globals.h).
+ *
+ * @param block block containing @p loop (statements before the loop suggest the
+ *              entry types), may be NULL
+ * @param loop  AST_WHILE_LOOP node
+ * @param outer types valid in the enclosing typed loop copy, or NULL
+ * @param types filled on success
+ * @return true if the typed copy saves a coercion of at least one operation
+ *         over the code typed by @p outer.
+ */
+bool loop_version(ast_block block, ast_node loop, const loop_types *outer, loop_types *types);
+
+#endif /* IFJ_LOOPS */
@@ -17,68 +17,116 @@
 #include "error.h"
 #include "codegen.h"
 #include "semantic.h"
+#include "options.h"
+#include "globals.h"
+#include "consteval.h"
+#include "budget.h"
+#include "compact.h"
+#include "cfg.h"
+#include "daemon.h"
+#include "stream.h"
 
 /* Main compiler pipeline:
+ * 0) Command line options (-O0, -Os, --unroll=N, --stats, --stream, --opt-budget=MS);
+ *    with --daemon=PATH steps 1) to 5) run once per request on the socket
  * 1) Lexical analysis
  * 2) Syntactic analysis (AST construction)
- * 3) Semantic analysis
- * 4) Code generation
+ * 3) Semantic analysis; with -O1 the uses of globals are analysed over the
+ *    whole program (constants inlined, unread globals dropped, types proved)
+ *    and calls of pure functions with literal arguments are then evaluated
+ *    at compile time; with --opt-budget=MS the expensive passes are first
+ *    scheduled per function to fit in the budget (budget.c)
+ * 4) Code generation; with -O1 jump chains are threaded and dead code and labels
+ *    are dropped, with -Os the output is compacted (no comments, short names)
+ *    and with --cache=DIR unchanged functions are copied from the cache
  * 5) Cleanup
+ * With --stream steps 1) to 5) run for one function at a time (stream.c),
+ * this whole-program pipeline compiles the sources that cannot be split.
  */
-int main(void) {
-    int result;
+// Steps 4) and 5) of a checked program, the generator is freed before returning
+static int generate_program(ast ast_tree, FILE *output, FILE *diag) {
+    generator gen = malloc(sizeof(*gen));
+    if (gen == NULL) return error(ERR_INTERNAL, "Allocation error");
+
+    init_code(gen, ast_tree);
+    generate_code(gen, ast_tree);
+    int result = SUCCESS;
+    if (options.opt_level > 0 && !cfg_simplify(gen->output))
+        result = error(ERR_INTERNAL, "Allocation error");
+    if (result == SUCCESS && options.size) {
+        string compact = compact_code(gen->output->data);
+        if (compact == NULL) {
+            result = error(ERR_INTERNAL, "Allocation error");
+        } else {
+            opt_stats.code_bytes = (unsigned)gen->output->length;
+            opt_stats.compact_bytes = (unsigned)compact->length;
+            string_destroy(gen->output);
+            gen->output = compact;
+        }
+    }
+    if (result == SUCCESS) {
+        fputs(gen->output->data, output);
+        if (options.stats) {
+            options_print_stats(diag);
+            budget_report(diag);
+        }
+    }
+
+    // ===== 5) Cleanup =====
+    string_destroy(gen->output);
+    string_destroy(gen->scope);
+    stack_free(&gen->label_ids);
+    stack_free(&gen->loop_stack);
+    free(gen);
+    return result;
+}
 
+static int compile_program(FILE *input, FILE *output, FILE *diag) {
     // ===== 1) Lexical analysis =====
     DLListTokens token_list;
     DLLTokens_Init(&token_list);
+    ast ast_tree = NULL;
 
-    result = scanner(stdin, &token_list);
-    if (result != SUCCESS) {
-        DLLTokens_Dispose(&token_list);
-        return result;
-    }
-
-    DLLTokens_First(&token_list);
+    int result = scanner(input, &token_list);
 
     // ===== 2) Build AST=====
-    ast ast_tree = NULL;
-    ast_init(&ast_tree);
-
-    result = parser(&token_list, ast_tree, GRAMMAR_PROGRAM);
-    if (result != SUCCESS) {
-        DLLTokens_Dispose(&token_list);
-        // ast_dispose(ast_tree);
-        return result;
+    if (result == SUCCESS) {
+        DLLTokens_First(&token_list);
+        ast_init(&ast_tree);
+        result = parser(&token_list, ast_tree, GRAMMAR_PROGRAM);
     }
 
     // ===== 3) Semantic analysis – Pass 1 =====
-    result = semantic_pass1(ast_tree);
-    if (result != SUCCESS) {
-        DLLTokens_Dispose(&token_list);
-        // ast_dispose(ast_tree);
-        return result;
+    if (result == SUCCESS) result = semantic_pass1(ast_tree);
+    if (result == SUCCESS && options.opt_level > 0) {
+        budget_plan(ast_tree);
+        globals_program(ast_tree);
+        consteval_program(ast_tree);
     }
 
-
     //ast_print(ast_tree);
 
     // ===== 4) Code generation =====
-    generator gen = malloc(sizeof(*gen));
-    if (gen == NULL) {
-        DLLTokens_Dispose(&token_list);
-        // ast_dispose(ast_tree);
-        return error(ERR_INTERNAL, "Allocation error");
-    }
-
-    init_code(gen, ast_tree);
-    generate_code(gen, ast_tree);
-    fputs(gen->output->data, stdout);
+    if (result == SUCCESS) result = generate_program(ast_tree, output, diag);
 
-    result = 0;
-    // ===== 5) Cleanup =====
-    free(gen);
-    //ast_dispose(ast_tree);
+    // The tree borrows the names of the tokens, it goes first
+    if (ast_tree != NULL) ast_dispose(ast_tree);
     DLLTokens_Dispose(&token_list);
+    return result;
+}
+
+static int compile(FILE *input, FILE *output, FILE *diag) {
+    globals_reset();  // the analysis of the last request, streamed functions are compiled without it
+    budget_reset();
+    if (options.stream) return stream_compile(input, output, diag, compile_program);
+    return compile_program(input, output, diag);
+}
+
+int main(int argc, char **argv) {
+    // ===== 0) Options =====
+    int result = options_parse(argc, argv);
+    if (result != SUCCESS) return result;
 
-    return SUCCESS;
+    if (options.daemon_socket) return daemon_run(options.daemon_socket, compile);
+    return compile(stdin, stdout, stderr);
 }
@@ -0,0 +1,103 @@
+/**
+ * @file options.c
+ * @brief Command line options of the compiler and optimisation statistics.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "options.h"
+#include "error.h"
+
+#define OPTIONS_DEFAULT { 1, OPT_UNROLL_DEFAULT, false, false, NULL, NULL, false, false, -1 }
+
+compiler_options options = OPTIONS_DEFAULT;
+optimisation_stats opt_stats;
+
+void options_reset(void) {
+    compiler_options defaults = OPTIONS_DEFAULT;
+    options = defaults;
+    memset(&opt_stats, 0, sizeof opt_stats);
+}
+
+/**
+ * @brief Parses the unsigned value after '=' of a "--name=N" argument.
+ *
+ * @param arg   whole argument
+ * @param out   parsed value
+ * @return true if the value is a valid decimal number.
+ */
+static bool parse_unsigned_value(const char *arg, unsigned *out) {
+    const char *eq = strchr(arg, '=');
+    if (eq == NULL || eq[1] == '\0') return false;
+    char *end = NULL;
+    unsigned long value = strtoul(eq + 1, &end, 10);
+    if (*end != '\0' || value > 1000000UL) return false;
+    *out = (unsigned)value;
+    return true;
+}
+
+int options_parse(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "-O0") == 0) options.opt_level = 0;
+        else if (strcmp(arg, "-O1") == 0) options.opt_level = 1;
+        else if (strcmp(arg, "-Os") == 0) {
+            options.opt_level = 1;
+            options.size = true;
+        }
+        else if (strcmp(arg, "--stats") == 0) options.stats = true;
+        else if (strcmp(arg, "--stream") == 0) options.stream = true;
+        else if (strcmp(arg, "--table-expr") == 0) options.table_expr = true;
+        else if (strncmp(arg, "--daemon=", 9) == 0 && arg[9] != '\0') options.daemon_socket = arg + 9;
+        else if (strncmp(arg, "--cache=", 8) == 0 && arg[8] != '\0') options.cache_dir = arg + 8;
+        else if (strncmp(arg, "--unroll=", 9) == 0) {
+            if (!parse_unsigned_value(arg, &options.unroll) || options.unroll > OPT_UNROLL_MAX)
+                return error(ERR_INTERNAL, "Invalid unroll factor '%s' (0-%d)", arg, OPT_UNROLL_MAX);
+            if (options.unroll == 0) options.unroll = 1;
+        }
+        else if (strncmp(arg, "--opt-budget=", 13) == 0) {
+            unsigned ms;
+            if (!parse_unsigned_value(arg, &ms))
+                return error(ERR_INTERNAL, "Invalid optimisation budget '%s' (milliseconds)", arg);
+            options.opt_budget = (int)ms;
+        }
+        else return error(ERR_INTERNAL, "Unknown option '%s'", arg);
+    }
+    return SUCCESS;
+}
+
+void options_print_stats(FILE *out) {
+    fprintf(out, "induction_vars: %u\n", opt_stats.induction_vars);
+    fprintf(out, "unrolled_loops: %u\n", opt_stats.unrolled_loops);
+    fprintf(out, "removed_loops: %u\n", opt_stats.removed_loops);
+    fprintf(out, "cse_eliminated: %u\n", opt_stats.cse_eliminated);
+    fprintf(out, "frame_locals: %u\n", opt_stats.frame_locals);
+    fprintf(out, "frame_slots: %u\n", opt_stats.frame_slots);
+    fprintf(out, "consteval_folded: %u\n", opt_stats.consteval_folded);
+    fprintf(out, "consteval_steps: %u\n", opt_stats.consteval_steps);
+    fprintf(out, "if_trees: %u\n", opt_stats.if_trees);
+    fprintf(out, "typed_loops: %u\n", opt_stats.typed_loops);
+    fprintf(out, "versioned_loops: %u\n", opt_stats.versioned_loops);
+    fprintf(out, "typed_operations: %u\n", opt_stats.typed_operations);
+    fprintf(out, "globals_constant: %u\n", opt_stats.globals_constant);
+    fprintf(out, "globals_removed: %u\n", opt_stats.globals_removed);
+    fprintf(out, "globals_typed: %u\n", opt_stats.globals_typed);
+    fprintf(out, "jumps_threaded: %u\n", opt_stats.jumps_threaded);
+    fprintf(out, "jumps_removed: %u\n", opt_stats.jumps_removed);
+    fprintf(out, "dead_instructions: %u\n", opt_stats.dead_instructions);
+    fprintf(out, "labels_removed: %u\n", opt_stats.labels_removed);
+    if (options.size) {
+        fprintf(out, "code_bytes: %u\n", opt_stats.code_bytes);
+        fprintf(out, "compact_bytes: %u\n", opt_stats.compact_bytes);
+    }
+    if (options.cache_dir) {
+        fprintf(out, "cache_hits: %u\n", opt_stats.cache_hits);
+        fprintf(out, "cache_misses: %u\n", opt_stats.cache_misses);
+    }
+    if (options.stream) fprintf(out, "stream_functions: %u\n", opt_stats.stream_functions);
+    if (options.opt_budget >= 0) fprintf(out, "budget_steps: %u\n", opt_stats.budget_steps);
+}
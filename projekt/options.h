@@ -0,0 +1,105 @@
+/**
+ * @file options.h
+ * @brief Command line options of the compiler and optimisation statistics.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_OPTIONS
+#define IFJ_OPTIONS
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define OPT_UNROLL_DEFAULT 4    // default unroll factor of counted loops
+#define OPT_UNROLL_MAX     16   // upper bound accepted for --unroll=N
+
+/**
+ * @brief Compiler options.
+ *
+ * - opt_level: 0 disables all optimisations (-O0), 1 is the default (-O1),
+ * - unroll:    unroll factor of loops with a constant trip count (1 = off),
+ * - stats:     print optimisation statistics to stderr after compilation,
+ * - size:      size-optimised output (-Os), no comments, short names, shared helpers,
+ * - daemon_socket: serve compile requests on this Unix socket (--daemon=PATH), or NULL,
+ * - cache_dir: directory of the per-function code cache (--cache=DIR), or NULL,
+ * - stream:    compile one function at a time and free it after emission (--stream);
+ *              compile-time evaluation, the control-flow simplification and the -Os
+ *              compaction need the whole program and are left out,
+ * - table_expr: parse expressions with the operator-precedence table instead of the
+ *              Pratt parser (--table-expr); no &&, || and !, kept for comparison,
+ * - opt_budget: milliseconds of expensive optimisations per compilation (--opt-budget=MS),
+ *              -1 runs all of them; the passes are scheduled per function by budget.h.
+ */
+typedef struct {
+    int opt_level;
+    unsigned unroll;
+    bool stats;
+    bool size;
+    const char *daemon_socket;
+    const char *cache_dir;
+    bool stream;
+    bool table_expr;
+    int opt_budget;
+} compiler_options;
+
+/**
+ * @brief Counters reported by --stats.
+ */
+typedef struct {
+    unsigned induction_vars;     // loops with specialised int update/test
+    unsigned unrolled_loops;     // loops unrolled by the unroll factor
+    unsigned removed_loops;      // loops fully unrolled or never executed
+    unsigned cse_eliminated;     // repeated subexpressions read from a temporary
+    unsigned frame_locals;       // declared locals placed in frame slots
+    unsigned frame_slots;        // frame slots (DEFVARs) of all functions
+    unsigned consteval_folded;   // pure calls replaced by their compile-time result
+    unsigned consteval_steps;    // evaluation steps spent on compile-time calls
+    unsigned if_trees;           // if/else-if chains lowered to a decision tree
+    unsigned typed_loops;        // loops generated with the types of their variables known
+    unsigned versioned_loops;    // of them, loops with a type guard in front of the typed copy
+    unsigned typed_operations;   // arithmetic and comparisons emitted without a coercion sequence
+    unsigned globals_constant;   // globals assigned a literal once, read as the literal
+    unsigned globals_removed;    // globals never read, declared no more
+    unsigned globals_typed;      // globals whose type is known in the whole program
+    unsigned jumps_threaded;     // jumps retargeted past a `JUMP` at their label
+    unsigned jumps_removed;      // jumps to the next instruction, also after moving the target block
+    unsigned dead_instructions;  // unreachable instructions removed
+    unsigned labels_removed;     // labels no jump or call refers to
+    unsigned code_bytes;         // size of the emitted code before -Os compaction
+    unsigned compact_bytes;      // size of the emitted code after -Os compaction
+    unsigned cache_hits;         // functions copied from the --cache directory
+    unsigned cache_misses;       // functions generated and stored to the --cache directory
+    unsigned stream_functions;   // functions compiled one at a time by --stream
+    unsigned budget_steps;       // estimated steps of the passes granted by --opt-budget
+} optimisation_stats;
+
+extern compiler_options options;
+extern optimisation_stats opt_stats;
+
+/**
+ * @brief Restores the default @ref options and clears @ref opt_stats (one daemon request).
+ */
+void options_reset(void);
+
+/**
+ * @brief Parses command line arguments into @ref options.
+ *
+ * Accepted: -O0, -O1, -Os, --unroll=N, --stats, --daemon=PATH,
+ *           --cache=DIR, --stream, --table-expr, --opt-budget=MS.
+ *
+ * @param argc argument count from main
+ * @param argv argument vector from main
+ * @return SUCCESS or ERR_INTERNAL for an unknown/invalid argument.
+ */
+int options_parse(int argc, char **argv);
+
+/**
+ * @brief Prints @ref opt_stats in "name: value" lines.
+ *
+ * @param out output stream
+ */
+void options_print_stats(FILE *out);
+
+#endif /* IFJ_OPTIONS */
@@ -10,15 +10,13 @@
 #include "parser.h"
 #include "error.h"
 #include "expressions.h"
+#include "options.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
-// Current class being parsed - used to track context during AST construction
-ast_class current_class = NULL;
-// Flag indicating if current block has its own block declaration
-bool has_own_block = false;
+static int parse(parser_state *ps, DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule);
 
 /// @brief Parse the token list and generate the AST
 /// @param tokenList The list of tokens to parse
@@ -26,6 +24,26 @@ bool has_own_block = false;
 /// @param expected_rule The grammar rule to apply
 /// @return SUCCESS on success, or an error code on failure
 int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule) {
+    parser_state ps = { NULL, false };
+    return parse(&ps, tokenList, out_ast, expected_rule);
+}
+
+/// @brief Parse one member of a class (function, getter or setter)
+/// @param tokenList Tokens of the member, active token is 'static'
+/// @param out_ast AST with one class, the member is appended to its root block
+/// @return SUCCESS on success, or an error code on failure
+int parser_member(DLListTokens *tokenList, ast out_ast) {
+    parser_state ps = { out_ast->class_list, false };
+    return parse(&ps, tokenList, out_ast, GRAMMAR_COMMAND);
+}
+
+/// @brief Apply one grammar rule
+/// @param ps Parser state (class and block being filled)
+/// @param tokenList The list of tokens to parse
+/// @param out_ast The output AST
+/// @param expected_rule The grammar rule to apply
+/// @return SUCCESS on success, or an error code on failure
+static int parse(parser_state *ps, DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule) {
     while(tokenList->active->token->type == T_EOL) {
         DLLTokens_Next(tokenList);
     }
@@ -33,12 +51,12 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
     switch (expected_rule)
     {
     case GRAMMAR_PROGRAM: {
-        int err = parser(tokenList, out_ast, GRAMMAR_IMPORT);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_IMPORT);
         if (err != SUCCESS) {
             return err;
         }
         
-        err = parser(tokenList, out_ast, GRAMMAR_CLASS_LIST);
+        err = parse(ps, tokenList, out_ast, GRAMMAR_CLASS_LIST);
         if (err != SUCCESS) {
             return err;
         }
@@ -91,11 +109,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Parse class definitions recursively until EOF
-        int err = parser(tokenList, out_ast, GRAMMAR_CLASS_DEF);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_CLASS_DEF);
         if (err != SUCCESS) {
             return err;
         }
-        err = parser(tokenList, out_ast, GRAMMAR_CLASS_LIST);
+        err = parse(ps, tokenList, out_ast, GRAMMAR_CLASS_LIST);
         if (err != SUCCESS) {
             return err;
         }
@@ -108,17 +126,17 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Initialize new class node in AST and set it as current context
-        current_class = ast_class_init(&out_ast->class_list);
+        ps->current_class = ast_class_init(&out_ast->class_list);
         DLLTokens_Next(tokenList);
         
         // Class name must be a valid identifier
         if(tokenList->active->token->type != T_IDENT) {
             return ERR_SYN;
         }
-        current_class->name = tokenList->active->token->value->data;
+        ps->current_class->name = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
 
-        int err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
         }
@@ -142,23 +160,23 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             DLLTokens_Next(tokenList);
         }
         // Initialize block node if not already created
-        if(current_class->current == NULL) {
-            ast_block_init(&current_class);
-        } else if(has_own_block == false) {
-            ast_add_new_node(&current_class, AST_BLOCK);
+        if(ps->current_class->current == NULL) {
+            ast_block_init(&ps->current_class);
+        } else if(ps->has_own_block == false) {
+            ast_add_new_node(&ps->current_class, AST_BLOCK);
         }
-        has_own_block = false;
+        ps->has_own_block = false;
 
         // Handle nested blocks recursively
         if(get_token_type_ignore_eol(tokenList) == T_LBRACE) {
-            int err = parser(tokenList, out_ast, GRAMMAR_BODY);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
             if (err != SUCCESS) {
                 return err;
             }
         }
 
         // Parse all commands inside the body
-        int err = parser(tokenList, out_ast, GRAMMAR_COMMAND_LIST);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_COMMAND_LIST);
         if (err != SUCCESS) {
             return err;
         }
@@ -180,7 +198,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
     case GRAMMAR_COMMAND_LIST: {
         // Check for nested block
         if(get_token_type_ignore_eol(tokenList) == T_LBRACE) {
-            int err = parser(tokenList, out_ast, GRAMMAR_BODY);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
             if (err != SUCCESS) {
                 return err;
             }
@@ -192,7 +210,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Parse single command
-        int err = parser(tokenList, out_ast, GRAMMAR_COMMAND);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_COMMAND);
         if (err != SUCCESS) {
             return err;
         }
@@ -212,7 +230,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             get_token_type_ignore_eol(tokenList) == T_KW_RETURN ||
             get_token_type_ignore_eol(tokenList) == T_LBRACE
         ) {
-            int err = parser(tokenList, out_ast, GRAMMAR_COMMAND_LIST);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_COMMAND_LIST);
             if (err != SUCCESS) {
                 return err;
             }
@@ -225,20 +243,20 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             // Look ahead to determine what kind of static definition this is
             if(tokenList->active->next->next->token->type == T_LBRACE) {
                 // static identifier { -> getter
-                int err = parser(tokenList, out_ast, GRAMMAR_GETTER);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_GETTER);
                 if( err != SUCCESS) {
                     return err;
                 }
             } else if(tokenList->active->next->next->token->type == T_ASSIGN) {
                 // static identifier = -> setter
-                int err = parser(tokenList, out_ast, GRAMMAR_SETTER);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_SETTER);
                 if( err != SUCCESS) {
                     return err;
                 }
             }
             else {
                 // Otherwise it's a regular function definition
-                int err = parser(tokenList, out_ast, GRAMMAR_FUN_DEF);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_FUN_DEF);
                 if (err != SUCCESS) {
                     return err;
                 }
@@ -246,7 +264,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
         // Variable declaration
         else if (tokenList->active->token->type == T_KW_VAR) {
-            int err = parser(tokenList, out_ast, GRAMMAR_DECLARATION);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_DECLARATION);
             if (err != SUCCESS) {
                 return err;
             }
@@ -256,20 +274,20 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
                  tokenList->active->token->type == T_GLOB_IDENT) {
             // Check if it's a builtin function call (Ifj.something)
             if(strcmp(tokenList->active->token->value->data, "Ifj") == 0) {
-                int err = parser(tokenList, out_ast, GRAMMAR_IFJ_CALL);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_IFJ_CALL);
                 if (err != SUCCESS) {
                     return err;
                 }
             }
             // Check if next token is assignment operator -> this is an assignment
             else if(tokenList->active->next->token->type == T_ASSIGN) {
-                int err = parser(tokenList, out_ast, GRAMMAR_ASSIGNMENT);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_ASSIGNMENT);
                 if (err != SUCCESS) {
                     return err;
                 }
             } else {
                 // If not assignment, must be a function call
-                int err = parser(tokenList, out_ast, GRAMMAR_FUN_CALL);
+                int err = parse(ps, tokenList, out_ast, GRAMMAR_FUN_CALL);
                 if (err != SUCCESS) {
                     return err;
                 }
@@ -277,7 +295,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
         // Conditional statement
         else if(tokenList->active->token->type == T_KW_IF) {
-            int err = parser(tokenList, out_ast, GRAMMAR_CONDITION);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_CONDITION);
             if (err != SUCCESS) {
                 return err;
             }
@@ -285,14 +303,14 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         // For loop
         else if (tokenList->active->token->type == T_KW_FOR)
         {
-            int err = parser(tokenList, out_ast, GRAMMAR_FOR);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_FOR);
             if (err != SUCCESS) {
                 return err;
             }
         }
         // While loop
         else if (tokenList->active->token->type == T_KW_WHILE) {
-            int err = parser(tokenList, out_ast, GRAMMAR_WHILE);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_WHILE);
             if (err != SUCCESS) {
                 return err;
             }
@@ -300,16 +318,16 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         // Break statement - just add node to AST
         else if (tokenList->active->token->type == T_KW_BREAK) {
             DLLTokens_Next(tokenList);
-            ast_add_new_node(&current_class, AST_BREAK);
+            ast_add_new_node(&ps->current_class, AST_BREAK);
         }
         // Continue statement - just add node to AST
         else if (tokenList->active->token->type == T_KW_CONTINUE) {
             DLLTokens_Next(tokenList);
-            ast_add_new_node(&current_class, AST_CONTINUE);
+            ast_add_new_node(&ps->current_class, AST_CONTINUE);
         }
         // Return statement
         else if (tokenList->active->token->type == T_KW_RETURN) {
-            int err = parser(tokenList, out_ast, GRAMMAR_RETURN);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_RETURN);
             if (err != SUCCESS) {
                 return err;
             }
@@ -328,8 +346,8 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Create function node in AST
-        ast_add_new_node(&current_class, AST_FUNCTION);
-        ast_function current_function = current_class->current->current->data.function;
+        ast_add_new_node(&ps->current_class, AST_FUNCTION);
+        ast_function current_function = ps->current_class->current->current->data.function;
         
         // Function name must be valid identifier
         if(tokenList->active->token->type != T_IDENT) {
@@ -339,17 +357,17 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Parse function parameters
-        int err = parser(tokenList, out_ast, GRAMMAR_PARAMS);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_PARAMS);
         if (err != SUCCESS) {
             return err;
         }
         
         // Set function body as current context for parsing
-        current_class->current = current_function->code;
+        ps->current_class->current = current_function->code;
 
         // Function body has its own block scope
-        has_own_block = true;
-        err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
         }
@@ -363,7 +381,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Parse the actual parameter list
-        int err = parser(tokenList, out_ast, GRAMMAR_PARAM_LIST);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_PARAM_LIST);
         if (err != SUCCESS) {
             return err;
         }
@@ -374,13 +392,22 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
         DLLTokens_Next(tokenList);
         // For function calls, must be followed by newline
-        if(current_class->current->current->type == AST_CALL_FUNCTION || current_class->current->current->type == AST_IFJ_FUNCTION) {
+        if(ps->current_class->current->current->type == AST_CALL_FUNCTION || ps->current_class->current->current->type == AST_IFJ_FUNCTION) {
             if (tokenList->active->token->type != T_EOL)
                 return ERR_SYN;
         }
         break;
     }
     case GRAMMAR_PARAM_LIST: {
+        // Function call - arguments may be whole expressions (FUNEXP)
+        ast_node current_node = ps->current_class->current->current;
+        if(current_node != NULL && current_node->type == AST_CALL_FUNCTION) {
+            return parse_call_arguments(tokenList, &current_node->data.function_call->parameters);
+        }
+        if(current_node != NULL && current_node->type == AST_IFJ_FUNCTION) {
+            return parse_call_arguments(tokenList, &current_node->data.ifj_function->parameters);
+        }
+
         // Empty parameter list is valid
         if(tokenList->active->token->type == T_RPAREN) {
             break;
@@ -397,14 +424,14 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Handle different contexts where parameters can appear
-        if(current_class->current->current != NULL) {
+        if(ps->current_class->current->current != NULL) {
             // Function definition - parameters are formal parameters
-            if(current_class->current->current->type == AST_FUNCTION) {
+            if(ps->current_class->current->current->type == AST_FUNCTION) {
                 // Function params must be identifiers, not literals
                 if (token_type != T_IDENT) return ERR_SEM;
-                ast_function current_function = current_class->current->current->data.function;
+                ast_function current_function = ps->current_class->current->current->data.function;
                 if(current_function->parameters == NULL) {
-                    current_function->parameters = malloc(sizeof(struct ast_parameter));
+                    current_function->parameters = calloc(1, sizeof(struct ast_parameter));
                     if(tokenList->active->token->type == T_FLOAT) {
                         current_function->parameters->value_type = AST_VALUE_FLOAT;
                         current_function->parameters->value.double_value = tokenList->active->token->value_float;
@@ -425,7 +452,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
                     while(param_iter->next != NULL) {
                         param_iter = param_iter->next;
                     }
-                    param_iter->next = malloc(sizeof(struct ast_parameter));
+                    param_iter->next = calloc(1, sizeof(struct ast_parameter));
                     if(tokenList->active->token->type == T_FLOAT) {
                         param_iter->next->value_type = AST_VALUE_FLOAT;
                         param_iter->next->value.double_value = tokenList->active->token->value_float;
@@ -442,99 +469,14 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
                     }
                     param_iter->next->next = NULL;
                 }
-            // Function call - parameters are actual arguments
-            } else if(current_class->current->current->type == AST_CALL_FUNCTION) {
-                ast_fun_call current_fun_call = current_class->current->current->data.function_call;
-                if(current_fun_call->parameters == NULL) {
-                    current_fun_call->parameters = malloc(sizeof(struct ast_parameter));
-                    if(tokenList->active->token->type == T_FLOAT) {
-                        current_fun_call->parameters->value_type = AST_VALUE_FLOAT;
-                        current_fun_call->parameters->value.double_value = tokenList->active->token->value_float;
-                    } else if (tokenList->active->token->type == T_INT) {
-                        current_fun_call->parameters->value_type = AST_VALUE_INT;
-                        current_fun_call->parameters->value.int_value = tokenList->active->token->value_int;
-                    } else if (tokenList->active->token->type == T_KW_NULL)
-                        current_fun_call->parameters->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenList->active->token->type == T_IDENT)
-                            current_fun_call->parameters->value_type = AST_VALUE_IDENTIFIER;
-                        else current_fun_call->parameters->value_type = AST_VALUE_STRING;
-                        current_fun_call->parameters->value.string_value = tokenList->active->token->value->data;
-                    }
-                    current_fun_call->parameters->next = NULL;
-                } else {
-                    ast_parameter param_iter = current_fun_call->parameters;
-                    while(param_iter->next != NULL) {
-                        param_iter = param_iter->next;
-                    }
-                    param_iter->next = malloc(sizeof(struct ast_parameter));
-                    if(tokenList->active->token->type == T_FLOAT) {
-                        param_iter->next->value_type = AST_VALUE_FLOAT;
-                        param_iter->next->value.double_value = tokenList->active->token->value_float;
-                    } else if (tokenList->active->token->type == T_INT) {
-                        param_iter->next->value_type = AST_VALUE_INT;
-                        param_iter->next->value.int_value = tokenList->active->token->value_int;
-                    } else if (tokenList->active->token->type == T_KW_NULL)
-                        param_iter->next->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenList->active->token->type == T_IDENT)
-                            param_iter->next->value_type = AST_VALUE_IDENTIFIER;
-                        else param_iter->next->value_type = AST_VALUE_STRING;
-                        param_iter->next->value.string_value = tokenList->active->token->value->data;
-                    }
-                    param_iter->next->next = NULL;
-                }
-            // IFJ builtin function - same handling as regular function call
-            } else if(current_class->current->current->type == AST_IFJ_FUNCTION) {
-                ast_ifj_function current_ifj_function = current_class->current->current->data.ifj_function;
-                if(current_ifj_function->parameters == NULL) {
-                    current_ifj_function->parameters = malloc(sizeof(struct ast_parameter));
-                    if(tokenList->active->token->type == T_FLOAT) {
-                        current_ifj_function->parameters->value_type = AST_VALUE_FLOAT;
-                        current_ifj_function->parameters->value.double_value = tokenList->active->token->value_float;
-                    } else if (tokenList->active->token->type == T_INT) {
-                        current_ifj_function->parameters->value_type = AST_VALUE_INT;
-                        current_ifj_function->parameters->value.int_value = tokenList->active->token->value_int;
-                    } else if (tokenList->active->token->type == T_KW_NULL)
-                        current_ifj_function->parameters->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenList->active->token->type == T_IDENT)
-                            current_ifj_function->parameters->value_type = AST_VALUE_IDENTIFIER;
-                        else current_ifj_function->parameters->value_type = AST_VALUE_STRING;
-                        current_ifj_function->parameters->value.string_value = tokenList->active->token->value->data;
-                    }
-                    current_ifj_function->parameters->next = NULL;
-                } else {
-                    ast_parameter param_iter = current_ifj_function->parameters;
-                    while(param_iter->next != NULL) {
-                        param_iter = param_iter->next;
-                    }
-                    param_iter->next = malloc(sizeof(struct ast_parameter));
-                    if(tokenList->active->token->type == T_FLOAT) {
-                        param_iter->next->value_type = AST_VALUE_FLOAT;
-                        param_iter->next->value.double_value = tokenList->active->token->value_float;
-                    } else if (tokenList->active->token->type == T_INT) {
-                        param_iter->next->value_type = AST_VALUE_INT;
-                        param_iter->next->value.int_value = tokenList->active->token->value_int;
-                    } else if (tokenList->active->token->type == T_KW_NULL)
-                        param_iter->next->value_type = AST_VALUE_NULL;
-                    else {
-                        if (tokenList->active->token->type == T_IDENT)
-                            param_iter->next->value_type = AST_VALUE_IDENTIFIER;
-                        else param_iter->next->value_type = AST_VALUE_STRING;
-                        param_iter->next->value.string_value = tokenList->active->token->value->data;
-                    }
-                    param_iter->next->next = NULL;
-                }
             }
         }
-        
         DLLTokens_Next(tokenList);
         
         // If comma follows, parse more parameters recursively
         if(tokenList->active->token->type == T_COMMA) {
             DLLTokens_Next(tokenList);
-            int err = parser(tokenList, out_ast, GRAMMAR_PARAM_LIST);
+            int err = parse(ps, tokenList, out_ast, GRAMMAR_PARAM_LIST);
             if (err != SUCCESS) {
                 return err;
             }
@@ -552,17 +494,17 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             return ERR_SYN;
         }
         // Create declaration node in AST
-        ast_add_new_node(&current_class, AST_VAR_DECLARATION);
+        ast_add_new_node(&ps->current_class, AST_VAR_DECLARATION);
         char *var_name = tokenList->active->token->value->data;
-        current_class->current->current->data.declaration.name = var_name;
+        ps->current_class->current->current->data.declaration.name = var_name;
         DLLTokens_Next(tokenList);
 
         // Declaration with initialization
         if (tokenList->active->token->type == T_ASSIGN) {
             // Also create assignment node for the initial value
-            ast_add_new_node(&current_class, AST_ASSIGNMENT); 
+            ast_add_new_node(&ps->current_class, AST_ASSIGNMENT); 
 
-            current_class->current->current->data.assignment.name = var_name;
+            ps->current_class->current->current->data.assignment.name = var_name;
             
             DLLTokens_Next(tokenList);
 
@@ -572,7 +514,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             if (err != SUCCESS) {
                 return err;
             }
-            current_class->current->current->data.assignment.value = current_expression;
+            ps->current_class->current->current->data.assignment.value = current_expression;
         }
         // Declaration without initialization - must end with newline
         else if (tokenList->active->token->type != T_EOL) {
@@ -586,11 +528,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             return ERR_SYN;
         }
         // Create function call node in AST
-        ast_add_new_node(&current_class, AST_CALL_FUNCTION);
-        current_class->current->current->data.function_call->name = tokenList->active->token->value->data;
+        ast_add_new_node(&ps->current_class, AST_CALL_FUNCTION);
+        ps->current_class->current->current->data.function_call->name = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
 
-        int err = parser(tokenList, out_ast, GRAMMAR_PARAMS);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_PARAMS);
         if (err != SUCCESS) {
             return err;
         }
@@ -602,11 +544,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             return ERR_SYN;
         }
         DLLTokens_Next(tokenList);
-        ast_add_new_node(&current_class, AST_RETURN);
+        ast_add_new_node(&ps->current_class, AST_RETURN);
 
         // Empty return - no expression
         if(tokenList->active->token->type == T_EOL) {
-            current_class->current->current->data.return_expr.output = NULL;
+            ps->current_class->current->current->data.return_expr.output = NULL;
         } else {
             // Return with value - parse the expression
             ast_expression return_expression; 
@@ -614,15 +556,15 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             if (err != SUCCESS) {
                 return err;
             }
-            current_class->current->current->data.return_expr.output = return_expression;
+            ps->current_class->current->current->data.return_expr.output = return_expression;
         }
 
         break;
     }
     case GRAMMAR_ASSIGNMENT: {
         // Create assignment node and store variable name
-        ast_add_new_node(&current_class, AST_ASSIGNMENT);
-        current_class->current->current->data.assignment.name = tokenList->active->token->value->data;
+        ast_add_new_node(&ps->current_class, AST_ASSIGNMENT);
+        ps->current_class->current->current->data.assignment.name = tokenList->active->token->value->data;
 
         DLLTokens_Next(tokenList);
 
@@ -638,7 +580,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         if (err != SUCCESS) {
             return err;
         }
-        current_class->current->current->data.assignment.value = current_expression;
+        ps->current_class->current->current->data.assignment.value = current_expression;
 
         break;
     }
@@ -655,7 +597,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
         DLLTokens_Next(tokenList);
 
-        ast_add_new_node(&current_class, AST_CONDITION);
+        ast_add_new_node(&ps->current_class, AST_CONDITION);
 
         // Parse the condition expression
         ast_expression condition_expression; 
@@ -664,7 +606,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             return err;
         }
 
-        current_class->current->current->data.condition.condition = condition_expression;
+        ps->current_class->current->current->data.condition.condition = condition_expression;
 
         if(tokenList->active->token->type != T_RPAREN) {
             return ERR_SYN;
@@ -672,11 +614,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Set if-branch as current context for body parsing
-        current_class->current = current_class->current->current->data.condition.if_branch;
+        ps->current_class->current = ps->current_class->current->current->data.condition.if_branch;
 
         // Parse if-branch body
-        has_own_block = true;
-        err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
 
@@ -689,10 +631,10 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Set else-branch as current context
-        current_class->current = current_class->current->current->data.condition.else_branch;
+        ps->current_class->current = ps->current_class->current->current->data.condition.else_branch;
         // Parse else-branch body
-        has_own_block = true;
-        err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
 
@@ -713,7 +655,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
         DLLTokens_Next(tokenList);
 
-        ast_add_new_node(&current_class, AST_WHILE_LOOP);
+        ast_add_new_node(&ps->current_class, AST_WHILE_LOOP);
 
         // Parse loop condition
         ast_expression while_expression; 
@@ -722,7 +664,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
             return err;
         }
 
-        current_class->current->current->data.while_loop.condition = while_expression;
+        ps->current_class->current->current->data.while_loop.condition = while_expression;
 
         if(tokenList->active->token->type != T_RPAREN) {
             return ERR_SYN;
@@ -730,11 +672,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Set loop body as current context
-        current_class->current = current_class->current->current->data.while_loop.body;
+        ps->current_class->current = ps->current_class->current->current->data.while_loop.body;
 
         // Parse loop body
-        has_own_block = true;
-        err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
 
@@ -755,16 +697,16 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Create getter node in AST
-        ast_add_new_node(&current_class, AST_GETTER);
-        current_class->current->current->data.getter.name = tokenList->active->token->value->data;
+        ast_add_new_node(&ps->current_class, AST_GETTER);
+        ps->current_class->current->current->data.getter.name = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
 
         // Set getter body as current context
-        current_class->current = current_class->current->current->data.getter.body;
+        ps->current_class->current = ps->current_class->current->current->data.getter.body;
 
         // Parse getter body
-        has_own_block = true;
-        int err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
         }
@@ -784,8 +726,8 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Create setter node in AST
-        ast_add_new_node(&current_class, AST_SETTER);
-        current_class->current->current->data.setter.name = tokenList->active->token->value->data;
+        ast_add_new_node(&ps->current_class, AST_SETTER);
+        ps->current_class->current->current->data.setter.name = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
 
         // Setter uses assignment syntax: static name = (param) { body }
@@ -803,7 +745,7 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         if(tokenList->active->token->type != T_IDENT) {
             return ERR_SYN;
         }
-        current_class->current->current->data.setter.param = tokenList->active->token->value->data;
+        ps->current_class->current->current->data.setter.param = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
         
         if(tokenList->active->token->type != T_RPAREN) {
@@ -812,11 +754,11 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         DLLTokens_Next(tokenList);
 
         // Set setter body as current context
-        current_class->current = current_class->current->current->data.setter.body;
+        ps->current_class->current = ps->current_class->current->current->data.setter.body;
 
         // Parse setter body
-        has_own_block = true;
-        int err = parser(tokenList, out_ast, GRAMMAR_BODY);
+        ps->has_own_block = true;
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_BODY);
         if (err != SUCCESS) {
             return err;
         }
@@ -842,12 +784,12 @@ int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule
         }
 
         // Create IFJ function call node in AST
-        ast_add_new_node(&current_class, AST_IFJ_FUNCTION);
-        current_class->current->current->data.ifj_function->name = tokenList->active->token->value->data;
+        ast_add_new_node(&ps->current_class, AST_IFJ_FUNCTION);
+        ps->current_class->current->current->data.ifj_function->name = tokenList->active->token->value->data;
         DLLTokens_Next(tokenList);
 
         // Parse function call parameters
-        int err = parser(tokenList, out_ast, GRAMMAR_PARAMS);
+        int err = parse(ps, tokenList, out_ast, GRAMMAR_PARAMS);
         if (err != SUCCESS) {
             return err;
         }
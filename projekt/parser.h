@@ -45,6 +45,14 @@ enum grammar_rule {
     GRAMMAR_IFJ_CALL
 };
 
+/// @brief Parser state of one parsing task
+typedef struct parser_state {
+    // Class being parsed; its current block is where new nodes are added
+    ast_class current_class;
+    // The block about to be parsed was already created by its owner (function, if, while)
+    bool has_own_block;
+} parser_state;
+
 /// @brief Parse the token list and generate the AST
 /// @param tokenList The list of tokens to parse
 /// @param out_ast The output AST
@@ -52,4 +60,10 @@ enum grammar_rule {
 /// @return SUCCESS on success, or an error code on failure
 int parser(DLListTokens *tokenList, ast out_ast, enum grammar_rule expected_rule);
 
+/// @brief Parse one member of a class, as inside the class body (--stream)
+/// @param tokenList Tokens of the member, active token is 'static'
+/// @param out_ast AST with one class, the member is appended to its root block
+/// @return SUCCESS on success, or an error code on failure
+int parser_member(DLListTokens *tokenList, ast out_ast);
+
 #endif // IFJ_PARSER_H
\ No newline at end of file
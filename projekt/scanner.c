@@ -8,6 +8,7 @@
  * BUT FIT
  */
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,135 +26,205 @@ static const int CR = 13; // '\r'
 static const int TAB = 9; // '\t'
 static const int SPACE = 32; // ' '
 
-// Input stream
-static FILE *in = NULL;
+// Scanner state used by the non-reentrant API (get_next_token, scanner)
+static scanner_ctx default_ctx = { .in = NULL, .cur_line = 1, .pb_line = 1, .prev_line = 1 };
 
-/* Current source position - increments on each visible character.
- * On '\n': line++, col=0.
+/* Construct a push-mode token stopped in when the buffered bytes ran out.
+ * Until a byte that may end the construct arrives, scanning it again is pointless.
  */
-static int cur_line = 1;
-static int cur_col = 0;
-
-/* Single pushback
- * has_pb - is there a pushed-back character
- * pb_char - the pushed-back character
- * pb_line/pb_col - position of the pushed-back character
- */
-static int has_pb = 0;
-static int pb_char = 0;
-static int pb_line = 1;
-static int pb_col = 0;
-
-/* Previous position - for unget_char() */
-static int prev_line = 1;
-static int prev_col = 0;
+typedef enum scan_wait {
+    WAIT_ANY,          // any byte may complete the token
+    WAIT_BLANK,        // run of spaces/tabs
+    WAIT_EOL,          // run of line ends
+    WAIT_IDENT,        // identifier or keyword
+    WAIT_LINE_COMMENT, // until LF
+    WAIT_BLOCK_COMMENT,// until "*\/" of the outermost level
+    WAIT_STRING,       // single-line string
+    WAIT_ML_STRING     // multi-line string
+} scan_wait;
+
+/* Report a lexical error, silently while the token only ran past the bytes fed so far. */
+static int lex_error(scanner_ctx *s, int code, const char *fmt, ...) {
+    if (s->starved) return code;
+    char message[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof message, fmt, args);
+    va_end(args);
+    return error(code, "%s", message);
+}
 
 /* Advance the current source position counters by character 'c'.
  * On LF, increments line and resets column; otherwise increments column.
  */
-static  void advance_position(int c) {
+static  void advance_position(scanner_ctx *s, int c) {
     if (c == LF) {
-        cur_line++;
-        cur_col = 0;
+        s->cur_line++;
+        s->cur_col = 0;
     } else {
-        cur_col++;
+        s->cur_col++;
     }
 }
 
 /* Get current position (1-based). */
-int scanner_get_line(void) { return cur_line; }
-int scanner_get_col(void) { return cur_col; }
+int scanner_get_line(void) { return default_ctx.cur_line; }
+int scanner_get_col(void) { return default_ctx.cur_col; }
+
+/* Push mode: next buffered character with CR→LF normalization.
+ * Running out of bytes before scanner_finish() marks the token as starved, it is scanned again later.
+ */
+static int get_buffered_char(scanner_ctx *s) {
+    s->prev_line = s->cur_line;
+    s->prev_col = s->cur_col;
+
+    if (s->pos == s->len) {
+        if (!s->finished) s->starved = 1;
+        return EOF;
+    }
+    int c = (unsigned char) s->buf[s->pos++];
+
+    // CRLF normalization, the byte after CR decides
+    if (c == CR) {
+        if (s->pos < s->len) {
+            if (s->buf[s->pos] == LF) s->pos++;
+        } else if (!s->finished) {
+            s->starved = 1;
+            return EOF;
+        }
+        c = LF;
+    }
+
+    advance_position(s, c);
+    return c;
+}
 
 /* Read one character with CR→LF normalization and single-character pushback.
  * Updates cur_line/cur_col. Returns EOF on end of stream.
  */
-static int get_char(void) {
+static int get_char(scanner_ctx *s) {
     // Serve the pushback character
-    if (has_pb) {
-        has_pb = 0;
+    if (s->has_pb) {
+        s->has_pb = 0;
 
         // Snapshot current position BEFORE advancing for the re-read character
-        prev_line = cur_line;
-        prev_col = cur_col;
+        s->prev_line = s->cur_line;
+        s->prev_col = s->cur_col;
 
         // Advance for the re-read character and return it
-        advance_position(pb_char);
-        return pb_char;
+        advance_position(s, s->pb_char);
+        return s->pb_char;
     }
 
-    if (!in) return EOF;
+    if (s->push) return get_buffered_char(s);
+    if (!s->in) return EOF;
 
-    prev_line = cur_line;
-    prev_col = cur_col;
+    s->prev_line = s->cur_line;
+    s->prev_col = s->cur_col;
 
-    int c = fgetc(in);
+    int c = fgetc(s->in);
     if (c == EOF) return EOF;
 
     // CRLF normalization
     if (c == CR) {
-        int d = fgetc(in);
+        int d = fgetc(s->in);
         if (d != LF) {
             if (d != EOF) {
-                ungetc(d, in);
+                ungetc(d, s->in);
             }
         }
         c = LF; // normalize CR or CRLF to a single LF
     }
 
     // Advance position for the resulting character
-    advance_position(c);
+    advance_position(s, c);
     return c;
 }
 
 /* Push back one character so the next get_char() will return it again.
  * Restores cur_line/cur_col to what they were before reading this character.
  */
-static void unget_char(int c) {
+static void unget_char(scanner_ctx *s, int c) {
     if (c == EOF) return;
-    if (has_pb) {
-        error(ERR_INTERNAL, "Scanner pushback overflow at L%d C%d", cur_line, cur_col);
+    if (s->has_pb) {
+        lex_error(s, ERR_INTERNAL, "Scanner pushback overflow at L%d C%d", s->cur_line, s->cur_col);
         return;
     }
 
-    has_pb = 1;
-    pb_char = c;
+    s->has_pb = 1;
+    s->pb_char = c;
 
-    pb_line = prev_line;
-    pb_col = prev_col;
-    cur_line = prev_line;
-    cur_col = prev_col;
+    s->pb_line = s->prev_line;
+    s->pb_col = s->prev_col;
+    s->cur_line = s->prev_line;
+    s->cur_col = s->prev_col;
 }
 
 /* Non-consuming one-character preview.
  * Reads one character and immediately pushes it back, leaving input/position unchanged.
  */
-static int look_ahead(void) {
-    int c = get_char();
-    unget_char(c);
+static int look_ahead(scanner_ctx *s) {
+    int c = get_char(s);
+    unget_char(s, c);
     return c;
 }
 
+/* Push mode: remember the position where the next token starts. */
+static void save_mark(scanner_ctx *s) {
+    s->mark = (scanner_mark) { s->pos, s->cur_line, s->cur_col, s->has_pb, s->pb_char,
+                               s->pb_line, s->pb_col, s->prev_line, s->prev_col };
+}
+
+/* Push mode: return to the start of a token that ran past the buffered bytes. */
+static void restore_mark(scanner_ctx *s) {
+    s->pos = s->mark.pos;
+    s->cur_line = s->mark.cur_line;
+    s->cur_col = s->mark.cur_col;
+    s->has_pb = s->mark.has_pb;
+    s->pb_char = s->mark.pb_char;
+    s->pb_line = s->mark.pb_line;
+    s->pb_col = s->mark.pb_col;
+    s->prev_line = s->mark.prev_line;
+    s->prev_col = s->mark.prev_col;
+}
+
+/* Initialize a scanner context over the given input stream.
+ * Resets position counters and pushback.
+ */
+void scanner_ctx_init(scanner_ctx *s, FILE *source) {
+    s->in = source;
+    s->cur_line = 1;
+    s->cur_col = 0;
+
+    s->has_pb = 0;
+    s->pb_char = 0;
+    s->pb_line = 1;
+    s->pb_col = 0;
+
+    s->prev_line = 1;
+    s->prev_col = 0;
+
+    s->push = 0;
+    s->finished = 0;
+    s->starved = 0;
+    s->wait = WAIT_ANY;
+    s->status = SUCCESS;
+    s->buf = NULL;
+    s->len = 0;
+    s->cap = 0;
+    s->pos = 0;
+}
+
 /* Initialize the scanner over the given input stream (stdin).
  * Resets internal state (position counters, pushback).
  */
 void scanner_init(FILE *source) {
-    in = source;
-    cur_line = 1;
-    cur_col = 0;
-
-    has_pb = 0;
-    pb_char = 0;
-    pb_line = 1;
-    pb_col = 0;
-
-    prev_line = 1;
-    prev_col = 0;
+    scanner_ctx_init(&default_ctx, source);
 }
 
 /* Finalize and clean up scanner resources. */
 void scanner_destroy(void) {
-    in = NULL;
-    has_pb = 0;
+    default_ctx.in = NULL;
+    default_ctx.has_pb = 0;
 }
 
 /* Returns true if the slice [text, text_len] equals the null-terminated literal. */
@@ -258,17 +329,17 @@ static bool keyword_lookup(const char *text, size_t text_len, int *out_type) {
  * Returns SUCCESS on success, ERR_LEX on lexical error (invalid format or out of range),
  * ERR_INTERNAL on internal error.
  */
-static int str_to_number(const struct string *src, bool as_float, long long *out_int, double *out_float) {
+static int str_to_number(scanner_ctx *s, const struct string *src, bool as_float, long long *out_int, double *out_float) {
     if (!src)
-        return error(ERR_INTERNAL, "str_to_number: null source string");
+        return lex_error(s, ERR_INTERNAL, "str_to_number: null source string");
     if (src->length == 0)
-        return error(ERR_LEX, "str_to_number: empty numeric lexeme");
+        return lex_error(s, ERR_LEX, "str_to_number: empty numeric lexeme");
 
     // Copy to a NUL-terminated buffer for strtod/strtoll
     size_t n = src->length;
     char *buf = (char *) malloc(n + 1);
     if (!buf)
-        return error(ERR_INTERNAL, "str_to_number: out of memory");
+        return lex_error(s, ERR_INTERNAL, "str_to_number: out of memory");
     memcpy(buf, src->data, n);
     buf[n] = '\0';
 
@@ -279,9 +350,9 @@ static int str_to_number(const struct string *src, bool as_float, long long *out
     if (as_float) {
         double val = strtod(buf, &endp);
         if (endp == buf || *endp != '\0')
-            ret = error(ERR_LEX, "Invalid floating literal");
+            ret = lex_error(s, ERR_LEX, "Invalid floating literal");
         else if (errno == ERANGE)
-            ret = error(ERR_LEX, "Floating literal out of range");
+            ret = lex_error(s, ERR_LEX, "Floating literal out of range");
         *out_float = val;
     } else {
         int base = 10;
@@ -290,9 +361,9 @@ static int str_to_number(const struct string *src, bool as_float, long long *out
 
         long long val = strtoll(buf, &endp, base);
         if (endp == buf || *endp != '\0')
-            ret = error(ERR_LEX, "Invalid integer literal");
+            ret = lex_error(s, ERR_LEX, "Invalid integer literal");
         else if (errno == ERANGE)
-            ret = error(ERR_LEX, "Integer literal out of range");
+            ret = lex_error(s, ERR_LEX, "Integer literal out of range");
         *out_int = val;
     }
 
@@ -389,13 +460,19 @@ static  bool is_allowed_ascii_multi_line_literal(int c) {
 /* Main tokenization function.
  * Reads the next token from the input stream and writes it to 'out'.
  */
-int get_next_token(tokenPtr out) {
+int scanner_ctx_next_token(scanner_ctx *s, tokenPtr out) {
     if (!out)
-        return error(ERR_INTERNAL, "Null token pointer passed to get_next_token()");
+        return lex_error(s, ERR_INTERNAL, "Null token pointer passed to get_next_token()");
     token_clear(out);
 
     while (true) {
-        int c = look_ahead();
+        // Push mode: a token running past the buffered bytes is scanned again from here
+        if (s->push) {
+            if (s->starved) return SUCCESS; // skipped blanks ran out of bytes, the result is dropped
+            save_mark(s);
+            s->wait = WAIT_ANY;
+        }
+        int c = look_ahead(s);
 
         /** =========================
          *  EOF
@@ -409,11 +486,12 @@ int get_next_token(tokenPtr out) {
          *  WHITESPACE (SPACE/TAB)
          *  ========================= */
         if (is_space_or_tab(c)) {
-            get_char();
+            s->wait = WAIT_BLANK;
+            get_char(s);
             while (true) {
-                c = look_ahead();
+                c = look_ahead(s);
                 if (!is_space_or_tab(c)) break;
-                get_char();
+                get_char(s);
             }
             continue;
         }
@@ -423,11 +501,12 @@ int get_next_token(tokenPtr out) {
          *  Collapse one or more LFs into a single T_EOL.
          *  ========================= */
         if (is_eol(c)) {
-            get_char();
+            s->wait = WAIT_EOL;
+            get_char(s);
             while (true) {
-                c = look_ahead();
+                c = look_ahead(s);
                 if (!is_eol(c)) break;
-                get_char();
+                get_char(s);
             }
             out->type = T_EOL;
             return SUCCESS;
@@ -439,28 +518,28 @@ int get_next_token(tokenPtr out) {
          *  Emits T_GLOB_IDENT and stores lexeme to token->value.
          *  ========================= */
         if (is_underscore(c)) {
-            get_char(); // consume first '_'
-            int la1 = look_ahead(); // peek next
+            get_char(s); // consume first '_'
+            int la1 = look_ahead(s); // peek next
 
             if (!is_underscore(la1)) {
                 // Only one '_' -> lexical error (no standalone '_')
-                return error(ERR_LEX, "Only one underscore as standalone token at L%d C%d", scanner_get_line(), scanner_get_col());
+                return lex_error(s, ERR_LEX, "Only one underscore as standalone token at L%d C%d", s->cur_line, s->cur_col);
             }
 
             // "__"
-            get_char(); // consume second '_'
+            get_char(s); // consume second '_'
 
             // At least one valid identifier
-            int la2 = look_ahead();
+            int la2 = look_ahead(s);
             if (!is_ident_cont(la2)) {
-                return error(ERR_LEX, "Empty global identifier after '__' at L%d C%d", scanner_get_line(), scanner_get_col());
+                return lex_error(s, ERR_LEX, "Empty global identifier after '__' at L%d C%d", s->cur_line, s->cur_col);
             }
 
             // Ensure token->value exists and is empty
             if (!out->value) {
                 out->value = string_create(DEFAULT_SIZE);
                 if (!out->value)
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
             } else {
                 out->value->length = 0;
                 if (out->value->data) out->value->data[0] = '\0';
@@ -468,17 +547,18 @@ int get_next_token(tokenPtr out) {
 
             // Append "__"
             if (!string_append_char(out->value, '_'))
-                return error(ERR_INTERNAL, "Out of memory in scanner");
+                return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
             if (!string_append_char(out->value, '_'))
-                return error(ERR_INTERNAL, "Out of memory in scanner");
+                return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
 
             // Read the rest of the identifier
+            s->wait = WAIT_IDENT;
             while (true) {
-                int ident_c = look_ahead();
+                int ident_c = look_ahead(s);
                 if (!is_ident_cont(ident_c)) break;
-                get_char(); // consume
+                get_char(s); // consume
                 if (!string_append_char(out->value, (char) ident_c)) {
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                 }
             }
 
@@ -496,19 +576,20 @@ int get_next_token(tokenPtr out) {
             if (!out->value) {
                 out->value = string_create(DEFAULT_SIZE);
                 if (!out->value)
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
             } else {
                 out->value->length = 0;
                 if (out->value->data) out->value->data[0] = '\0';
             }
 
             // Collect the identifier into string
+            s->wait = WAIT_IDENT;
             while (true) {
-                int ident_char = look_ahead();
+                int ident_char = look_ahead(s);
                 if (!is_ident_cont(ident_char)) break;
-                get_char(); // consume
+                get_char(s); // consume
                 if (!string_append_char(out->value, (char) ident_char)) {
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                 }
             }
 
@@ -531,43 +612,43 @@ int get_next_token(tokenPtr out) {
         if (is_zero(c) || is_nonzero_digit(c)) {
             string num = string_create(DEFAULT_SIZE);
             if (!num)
-                return error(ERR_INTERNAL, "Out of memory in scanner");
+                return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
 
             if (is_zero(c)) {
                 // Numbers starting with '0'
-                get_char(); // consume '0'
+                get_char(s); // consume '0'
                 if (!string_append_char(num, '0')) {
                     string_destroy(num);
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                 }
 
-                int la = look_ahead();
+                int la = look_ahead(s);
 
                 // Hex integer: 0x / 0X
                 if (is_hex_lead(la)) {
-                    get_char(); // consume 'x'/'X'
+                    get_char(s); // consume 'x'/'X'
                     if (!string_append_char(num, (char) la)) {
                         string_destroy(num);
-                        return error(ERR_INTERNAL, "Out of memory in scanner");
+                        return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                     }
 
                     // At least one hex digit required
-                    int la_hex = look_ahead();
+                    int la_hex = look_ahead(s);
                     if (!is_hex_digit(la_hex)) {
                         string_destroy(num);
-                        return error(ERR_LEX, "Hex literal requires at least one hex digit after 0x/0X");
+                        return lex_error(s, ERR_LEX, "Hex literal requires at least one hex digit after 0x/0X");
                     }
-                    while (is_hex_digit(look_ahead())) {
-                        int hex_digit = get_char();
+                    while (is_hex_digit(look_ahead(s))) {
+                        int hex_digit = get_char(s);
                         if (!string_append_char(num, (char) hex_digit)) {
                             string_destroy(num);
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         }
                     }
 
                     // Convert to integer
                     long long integer = 0;
-                    int conv = str_to_number(num, /*as_float=*/false, &integer, NULL);
+                    int conv = str_to_number(s, num, /*as_float=*/false, &integer, NULL);
                     if (conv != SUCCESS) {
                         string_destroy(num);
                         return conv;
@@ -587,7 +668,7 @@ int get_next_token(tokenPtr out) {
                 // Decimal digit after leading 0 is not allowed
                 if (is_digit(la)) {
                     string_destroy(num);
-                    return error(ERR_LEX, "Decimal literal with a leading zero is not allowed");
+                    return lex_error(s, ERR_LEX, "Decimal literal with a leading zero is not allowed");
                 }
 
                 // Standalone '0'
@@ -597,18 +678,18 @@ int get_next_token(tokenPtr out) {
                 return SUCCESS;
             } else {
                 // Numbers starting with [1-9]
-                int first_digit = get_char(); // consume first digit
+                int first_digit = get_char(s); // consume first digit
                 if (!string_append_char(num, (char) first_digit)) {
                     string_destroy(num);
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                 }
 
                 // Subsequent digits
-                while (is_digit(look_ahead())) {
-                    int digit_ch = get_char();
+                while (is_digit(look_ahead(s))) {
+                    int digit_ch = get_char(s);
                     if (!string_append_char(num, (char) digit_ch)) {
                         string_destroy(num);
-                        return error(ERR_INTERNAL, "Out of memory in scanner");
+                        return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                     }
                 }
             }
@@ -618,34 +699,34 @@ int get_next_token(tokenPtr out) {
                 bool is_float_number = false;
 
                 // Optional fractional part: '.' DIGIT+
-                int la1 = look_ahead();
+                int la1 = look_ahead(s);
                 if (is_dot(la1)) {
                     // Temporarily consume the first '.'
-                    get_char();
-                    int la2 = look_ahead();
+                    get_char(s);
+                    int la2 = look_ahead(s);
 
                     if (la2 == '.') {
                         // Pattern ".." or "..." is a range operator,
-                        unget_char('.');
+                        unget_char(s, '.');
                     } else {
                         // Real decimal point: a digit must follow
                         if (!is_digit(la2)) {
                             string_destroy(num);
-                            return error(ERR_LEX, "Digit required after decimal point");
+                            return lex_error(s, ERR_LEX, "Digit required after decimal point");
                         }
 
                         // Append '.' to buffer
                         if (!string_append_char(num, '.')) {
                             string_destroy(num);
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         }
 
                         // Consume digits after '.'
-                        while (is_digit(look_ahead())) {
-                            int digit_char = get_char();
+                        while (is_digit(look_ahead(s))) {
+                            int digit_char = get_char(s);
                             if (!string_append_char(num, (char) digit_char)) {
                                 string_destroy(num);
-                                return error(ERR_INTERNAL, "Out of memory in scanner");
+                                return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                             }
                         }
 
@@ -654,39 +735,39 @@ int get_next_token(tokenPtr out) {
                 }
 
                 // Optional exponent: 'e'/'E' ['+'|'-'] DIGIT+
-                if (is_exponent_marker(look_ahead())) {
-                    int exp = get_char(); // consume 'e'/'E'
+                if (is_exponent_marker(look_ahead(s))) {
+                    int exp = get_char(s); // consume 'e'/'E'
                     if (!string_append_char(num, (char) exp)) {
                         string_destroy(num);
-                        return error(ERR_INTERNAL, "Out of memory in scanner");
+                        return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                     }
 
                     // Optional sign
-                    if (is_sign(look_ahead())) {
-                        int sign = get_char();
+                    if (is_sign(look_ahead(s))) {
+                        int sign = get_char(s);
                         if (!string_append_char(num, (char) sign)) {
                             string_destroy(num);
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         }
                         // At least one digit after the sign
-                        if (!is_digit(look_ahead())) {
+                        if (!is_digit(look_ahead(s))) {
                             string_destroy(num);
-                            return error(ERR_LEX, "Exponent requires at least one digit");
+                            return lex_error(s, ERR_LEX, "Exponent requires at least one digit");
                         }
                     } else {
                         // No sign - a digit must follow immediately
-                        if (!is_digit(look_ahead())) {
+                        if (!is_digit(look_ahead(s))) {
                             string_destroy(num);
-                            return error(ERR_LEX, "Exponent requires at least one digit");
+                            return lex_error(s, ERR_LEX, "Exponent requires at least one digit");
                         }
                     }
 
                     // Subsequent exponent digits
-                    while (is_digit(look_ahead())) {
-                        int exp_digid = get_char();
+                    while (is_digit(look_ahead(s))) {
+                        int exp_digid = get_char(s);
                         if (!string_append_char(num, (char) exp_digid)) {
                             string_destroy(num);
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         }
                     }
 
@@ -696,7 +777,7 @@ int get_next_token(tokenPtr out) {
                 // Conversion and emit
                 if (is_float_number) {
                     double float_val = 0.0;
-                    int conv = str_to_number(num, /*as_float=*/true, NULL, &float_val);
+                    int conv = str_to_number(s, num, /*as_float=*/true, NULL, &float_val);
                     if (conv != SUCCESS) {
                         string_destroy(num);
                         return conv;
@@ -708,7 +789,7 @@ int get_next_token(tokenPtr out) {
                     return SUCCESS;
                 } else {
                     long long int_val = 0;
-                    int conv = str_to_number(num, /*as_float=*/false, &int_val, NULL);
+                    int conv = str_to_number(s, num, /*as_float=*/false, &int_val, NULL);
                     if (conv != SUCCESS) {
                         string_destroy(num);
                         return conv;
@@ -728,28 +809,29 @@ int get_next_token(tokenPtr out) {
          *  - Multi-line:  """ ... """ with indentation handling and no escapes
          *  ========================= */
         if (is_quote(c)) {
-            get_char(); // consume first '"'
+            get_char(s); // consume first '"'
 
             // Ensure token->value exists and is empty
             if (!out->value) {
                 out->value = string_create(DEFAULT_SIZE);
                 if (!out->value)
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
             } else {
                 out->value->length = 0;
                 if (out->value->data) out->value->data[0] = '\0';
             }
 
-            int la1 = look_ahead();
+            int la1 = look_ahead(s);
 
             // Check for multiline prefix """
             if (is_quote(la1)) {
-                get_char(); // consume second '"'
-                int la2 = look_ahead();
+                get_char(s); // consume second '"'
+                int la2 = look_ahead(s);
 
                 if (is_quote(la2)) {
                     // ===== MULTI-LINE STRING =====
-                    get_char(); // consume third '"'
+                    get_char(s); // consume third '"'
+                    s->wait = WAIT_ML_STRING;
 
                     bool first_line_trim = true; // skip whitespace-only tail of the opening line
                     bool at_line_start = false; // just crossed LF-  content of the new line not yet committed
@@ -760,15 +842,15 @@ int get_next_token(tokenPtr out) {
                     size_t ws_len = 0;
                     char *ws_buf = (char *) malloc(ws_cap);
                     if (!ws_buf)
-                        return error(ERR_INTERNAL, "Out of memory in scanner");
+                        return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
 
                     int ml_result = SUCCESS;
 
                     while (true) {
-                        int string_char_ml = get_char();
+                        int string_char_ml = get_char(s);
                         if (string_char_ml == EOF) {
-                            ml_result = error(ERR_LEX, "Unterminated multi-line string literal at L%d C%d",
-                                              scanner_get_line(), scanner_get_col());
+                            ml_result = lex_error(s, ERR_LEX, "Unterminated multi-line string literal at L%d C%d",
+                                              s->cur_line, s->cur_col);
                             goto ml_cleanup;
                         }
 
@@ -788,12 +870,12 @@ int get_next_token(tokenPtr out) {
 
                         // Detect closing delimiter  """
                         if (is_quote(string_char_ml)) {
-                            int q2 = look_ahead();
+                            int q2 = look_ahead(s);
                             if (is_quote(q2)) {
-                                get_char(); // consume second '"'
-                                int q3 = look_ahead();
+                                get_char(s); // consume second '"'
+                                int q3 = look_ahead(s);
                                 if (is_quote(q3)) {
-                                    get_char(); // consume third '"' - close
+                                    get_char(s); // consume third '"' - close
 
                                     // Closing-line trim
                                     if (!line_has_content) {
@@ -801,14 +883,14 @@ int get_next_token(tokenPtr out) {
                                     } else {
                                         if (pending_newline) {
                                             if (!string_append_char(out->value, (char) LF)) {
-                                                ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                                ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                                 goto ml_cleanup;
                                             }
                                             pending_newline = false;
                                         }
                                         for (size_t i = 0; i < ws_len; ++i) {
                                             if (!string_append_char(out->value, ws_buf[i])) {
-                                                ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                                ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                                 goto ml_cleanup;
                                             }
                                         }
@@ -822,14 +904,14 @@ int get_next_token(tokenPtr out) {
                                     if (at_line_start && !line_has_content) {
                                         if (pending_newline) {
                                             if (!string_append_char(out->value, (char) LF)) {
-                                                ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                                ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                                 goto ml_cleanup;
                                             }
                                             pending_newline = false;
                                         }
                                         for (size_t i = 0; i < ws_len; ++i) {
                                             if (!string_append_char(out->value, ws_buf[i])) {
-                                                ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                                ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                                 goto ml_cleanup;
                                             }
                                         }
@@ -838,7 +920,7 @@ int get_next_token(tokenPtr out) {
                                         ws_len = 0;
                                     }
                                     if (!string_append_char(out->value, '"') || !string_append_char(out->value, '"')) {
-                                        ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                        ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                         goto ml_cleanup;
                                     }
                                     continue;
@@ -848,14 +930,14 @@ int get_next_token(tokenPtr out) {
                                 if (at_line_start && !line_has_content) {
                                     if (pending_newline) {
                                         if (!string_append_char(out->value, (char) LF)) {
-                                            ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                            ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                             goto ml_cleanup;
                                         }
                                         pending_newline = false;
                                     }
                                     for (size_t i = 0; i < ws_len; ++i) {
                                         if (!string_append_char(out->value, ws_buf[i])) {
-                                            ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                            ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                             goto ml_cleanup;
                                         }
                                     }
@@ -864,7 +946,7 @@ int get_next_token(tokenPtr out) {
                                     ws_len = 0;
                                 }
                                 if (!string_append_char(out->value, '"')) {
-                                    ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                    ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                     goto ml_cleanup;
                                 }
                                 continue;
@@ -888,7 +970,7 @@ int get_next_token(tokenPtr out) {
                                     size_t ncap = ws_cap * 2;
                                     char *nbuf = (char *) realloc(ws_buf, ncap);
                                     if (!nbuf) {
-                                        ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                        ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                         goto ml_cleanup;
                                     }
                                     ws_buf = nbuf;
@@ -900,14 +982,14 @@ int get_next_token(tokenPtr out) {
                             // first non-whitespace on the line
                             if (pending_newline) {
                                 if (!string_append_char(out->value, (char) LF)) {
-                                    ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                    ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                     goto ml_cleanup;
                                 }
                                 pending_newline = false;
                             }
                             for (size_t i = 0; i < ws_len; ++i) {
                                 if (!string_append_char(out->value, ws_buf[i])) {
-                                    ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                                    ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                                     goto ml_cleanup;
                                 }
                             }
@@ -918,12 +1000,12 @@ int get_next_token(tokenPtr out) {
 
                         // Regular char
                         if (!is_allowed_ascii_multi_line_literal(string_char_ml)) {
-                            ml_result = error(ERR_LEX, "Disallowed character in multi-line string 0x%02X at L%d C%d",
-                                              string_char_ml, scanner_get_line(), scanner_get_col());
+                            ml_result = lex_error(s, ERR_LEX, "Disallowed character in multi-line string 0x%02X at L%d C%d",
+                                              string_char_ml, s->cur_line, s->cur_col);
                             goto ml_cleanup;
                         }
                         if (!string_append_char(out->value, (char) string_char_ml)) {
-                            ml_result = error(ERR_INTERNAL, "Out of memory in scanner");
+                            ml_result = lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                             goto ml_cleanup;
                         }
                     }
@@ -939,11 +1021,12 @@ int get_next_token(tokenPtr out) {
             }
 
             // ===== SINGLE-LINE STRING =====
+            s->wait = WAIT_STRING;
             while (true) {
-                int string_char = get_char();
+                int string_char = get_char(s);
 
                 if (string_char == EOF || is_eol(string_char)) {
-                    return error(ERR_LEX, "Unterminated string literal at L%d C%d", scanner_get_line(), scanner_get_col());
+                    return lex_error(s, ERR_LEX, "Unterminated string literal at L%d C%d", s->cur_line, s->cur_col);
                 }
 
                 if (is_quote(string_char)) {
@@ -952,9 +1035,9 @@ int get_next_token(tokenPtr out) {
                 }
 
                 if (is_escape_lead(string_char)) {
-                    int esc = get_char();
+                    int esc = get_char(s);
                     if (esc == EOF || is_eol(esc)) {
-                        return error(ERR_LEX, "Unterminated escape in string at L%d C%d", scanner_get_line(), scanner_get_col());
+                        return lex_error(s, ERR_LEX, "Unterminated escape in string at L%d C%d", s->cur_line, s->cur_col);
                     }
 
                     if (is_simple_escape_letter(esc)) {
@@ -970,33 +1053,33 @@ int get_next_token(tokenPtr out) {
                                 break;
                             case 't': out_ch = (char) TAB;
                                 break;
-                            default: return error(ERR_INTERNAL, "Unhandled simple escape '\\%c' at L%d C%d", esc, scanner_get_line(), scanner_get_col());
+                            default: return lex_error(s, ERR_INTERNAL, "Unhandled simple escape '\\%c' at L%d C%d", esc, s->cur_line, s->cur_col);
                         }
                         if (!string_append_char(out->value, out_ch))
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         continue;
                     }
 
                     if (is_hex_lead(esc)) {
-                        int hex1 = get_char();
-                        int hex2 = get_char();
+                        int hex1 = get_char(s);
+                        int hex2 = get_char(s);
                         if (!is_hex_digit(hex1) || !is_hex_digit(hex2)) {
-                            return error(ERR_LEX, "Invalid hex escape in string at L%d C%d", scanner_get_line(), scanner_get_col());
+                            return lex_error(s, ERR_LEX, "Invalid hex escape in string at L%d C%d", s->cur_line, s->cur_col);
                         }
                         int byte_val = (hex_value(hex1) << 4) | hex_value(hex2);
                         if (!string_append_char(out->value, (char) byte_val))
-                            return error(ERR_INTERNAL, "Out of memory in scanner");
+                            return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                         continue;
                     }
-                    return error(ERR_LEX, "Unknown escape '\\%c' in string at L%d C%d", esc, scanner_get_line(), scanner_get_col());
+                    return lex_error(s, ERR_LEX, "Unknown escape '\\%c' in string at L%d C%d", esc, s->cur_line, s->cur_col);
                 }
 
                 // Regular character in single-line string
                 if (!is_allowed_ascii_single_line_literal(string_char)) {
-                    return error(ERR_LEX, "Disallowed character in string 0x%02X at L%d C%d", string_char, scanner_get_line(), scanner_get_col());
+                    return lex_error(s, ERR_LEX, "Disallowed character in string 0x%02X at L%d C%d", string_char, s->cur_line, s->cur_col);
                 }
                 if (!string_append_char(out->value, (char) string_char)) {
-                    return error(ERR_INTERNAL, "Out of memory in scanner");
+                    return lex_error(s, ERR_INTERNAL, "Out of memory in scanner");
                 }
             }
         }
@@ -1008,15 +1091,16 @@ int get_next_token(tokenPtr out) {
          *  - Plain '/' -> T_DIV
          *  ========================= */
         if (is_slash(c)) {
-            get_char(); // consume '/'
-            int la = look_ahead();
+            get_char(s); // consume '/'
+            int la = look_ahead(s);
 
             // Line comment: // ... (until LF or EOF), return one T_EOL
             if (la == '/') {
-                get_char(); // consume the second '/'
+                get_char(s); // consume the second '/'
+                s->wait = WAIT_LINE_COMMENT;
                 // Consume characters until EOL or EOF.
                 while (true) {
-                    int next_char = get_char();
+                    int next_char = get_char(s);
                     if (next_char == EOF || is_eol(next_char)) break;
                 }
                 out->type = T_EOL;
@@ -1025,22 +1109,23 @@ int get_next_token(tokenPtr out) {
 
             // Block comment: /* ... */ with nesting
             if (la == '*') {
-                get_char(); // consume '*'
+                get_char(s); // consume '*'
+                s->wait = WAIT_BLOCK_COMMENT;
                 int depth = 1;
                 while (true) {
-                    int next_char = get_char();
+                    int next_char = get_char(s);
                     if (next_char == EOF) {
-                        return error(ERR_LEX, "Unterminated block comment at L%d C%d", scanner_get_line(), scanner_get_col());
+                        return lex_error(s, ERR_LEX, "Unterminated block comment at L%d C%d", s->cur_line, s->cur_col);
                     }
                     // start nested: '/*'
-                    if (next_char == '/' && look_ahead() == '*') {
-                        get_char();
+                    if (next_char == '/' && look_ahead(s) == '*') {
+                        get_char(s);
                         depth++;
                         continue;
                     }
                     // end current level: '*/'
-                    if (next_char == '*' && look_ahead() == '/') {
-                        get_char();
+                    if (next_char == '*' && look_ahead(s) == '/') {
+                        get_char(s);
                         depth--;
                         if (depth == 0)
                             break;
@@ -1060,7 +1145,7 @@ int get_next_token(tokenPtr out) {
          *  Emits T_PLUS / T_MINUS / T_MUL.
          *  ========================= */
         if (is_basic_operator(c)) {
-            get_char(); // consume '+' | '-' | '*'
+            get_char(s); // consume '+' | '-' | '*'
             switch (c) {
                 case '+': out->type = T_PLUS;
                     return SUCCESS;
@@ -1070,7 +1155,7 @@ int get_next_token(tokenPtr out) {
                     return SUCCESS;
                 default: break;
             }
-            return error(ERR_INTERNAL, "Unhandled basic operator '%c' at L%d C%d", c, scanner_get_line(), scanner_get_col());
+            return lex_error(s, ERR_INTERNAL, "Unhandled basic operator '%c' at L%d C%d", c, s->cur_line, s->cur_col);
         }
 
         /** =========================
@@ -1079,11 +1164,11 @@ int get_next_token(tokenPtr out) {
          *  - Single:  =, <, >, !
          *  ========================= */
         if (is_operator_starter(c)) {
-            int first = get_char(); // consume '=', '!', '<', '>'
-            int la = look_ahead(); // peek next
+            int first = get_char(s); // consume '=', '!', '<', '>'
+            int la = look_ahead(s); // peek next
 
             if (la == '=') {
-                get_char(); // consume '='
+                get_char(s); // consume '='
                 switch (first) {
                     case '=': out->type = T_EQ;
                         break; // '=='
@@ -1108,7 +1193,7 @@ int get_next_token(tokenPtr out) {
                         return SUCCESS; // '!'
                     default: break;
                 }
-                return error(ERR_INTERNAL, "Unhandled operator-starter '%c' at L%d C%d", first, scanner_get_line(), scanner_get_col());
+                return lex_error(s, ERR_INTERNAL, "Unhandled operator-starter '%c' at L%d C%d", first, s->cur_line, s->cur_col);
             }
         }
 
@@ -1117,10 +1202,10 @@ int get_next_token(tokenPtr out) {
          *  Requires double char, otherwise lexical error.
          *  ========================= */
         if (is_bool_and_or(c)) {
-            int first = get_char(); // consume '&' or '|'
-            int la = look_ahead(); // must match the same char
+            int first = get_char(s); // consume '&' or '|'
+            int la = look_ahead(s); // must match the same char
             if (la == first) {
-                get_char(); // consume second '&' or '|'
+                get_char(s); // consume second '&' or '|'
                 if (first == '&') {
                     out->type = T_AND;
                     return SUCCESS;
@@ -1129,7 +1214,7 @@ int get_next_token(tokenPtr out) {
                     return SUCCESS;
                 }
             }
-            return error(ERR_LEX, "Unexpected '%c' at L%d C%d", first, scanner_get_line(), scanner_get_col());
+            return lex_error(s, ERR_LEX, "Unexpected '%c' at L%d C%d", first, s->cur_line, s->cur_col);
         }
 
         /** =========================
@@ -1137,7 +1222,7 @@ int get_next_token(tokenPtr out) {
          *  Emits T_LPAREN, T_RPAREN, T_LBRACE, T_RBRACE.
          *  ========================= */
         if (is_paren_or_brace(c)) {
-            get_char(); // consume '(' | ')' | '{' | '}'
+            get_char(s); // consume '(' | ')' | '{' | '}'
             switch (c) {
                 case '(': out->type = T_LPAREN;
                     return SUCCESS;
@@ -1149,7 +1234,7 @@ int get_next_token(tokenPtr out) {
                     return SUCCESS;
                 default: break;
             }
-            return error(ERR_INTERNAL, "Unhandled paren/brace '%c' at L%d C%d", c, scanner_get_line(), scanner_get_col());
+            return lex_error(s, ERR_INTERNAL, "Unhandled paren/brace '%c' at L%d C%d", c, s->cur_line, s->cur_col);
         }
 
         /** =========================
@@ -1157,7 +1242,7 @@ int get_next_token(tokenPtr out) {
          *  Emits T_COMMA, T_COLON, T_QUESTION.
          *  ========================= */
         if (is_punct(c)) {
-            get_char(); // consume ',' | ':' | '?'
+            get_char(s); // consume ',' | ':' | '?'
             switch (c) {
                 case ',': out->type = T_COMMA;
                     return SUCCESS;
@@ -1167,7 +1252,7 @@ int get_next_token(tokenPtr out) {
                     return SUCCESS;
                 default: break;
             }
-            return error(ERR_INTERNAL, "Unhandled punct '%c' at L%d C%d", c, scanner_get_line(), scanner_get_col());
+            return lex_error(s, ERR_INTERNAL, "Unhandled punct '%c' at L%d C%d", c, s->cur_line, s->cur_col);
         }
 
         /** =========================
@@ -1175,13 +1260,13 @@ int get_next_token(tokenPtr out) {
          *  Emits T_DOT, T_RANGE_INC (".."), T_RANGE_EXC ("...").
          *  ========================= */
         if (is_dot(c)) {
-            get_char(); // consumed first '.'
-            int la1 = look_ahead();
+            get_char(s); // consumed first '.'
+            int la1 = look_ahead(s);
             if (la1 == '.') {
-                get_char(); // consumed second '.'
-                int la2 = look_ahead();
+                get_char(s); // consumed second '.'
+                int la2 = look_ahead(s);
                 if (la2 == '.') {
-                    get_char(); // consumed third '.'
+                    get_char(s); // consumed third '.'
                     out->type = T_RANGE_EXC;
                     return SUCCESS;
                 } else {
@@ -1199,14 +1284,19 @@ int get_next_token(tokenPtr out) {
          *  Reject controls (except TAB/LF/SPACE) and non-ASCII.
          *  ========================= */
         if (!is_allowed_ascii(c)) {
-            return error(ERR_LEX, "Invalid character 0x%02X at L%d C%d", c, scanner_get_line(), scanner_get_col());
+            return lex_error(s, ERR_LEX, "Invalid character 0x%02X at L%d C%d", c, s->cur_line, s->cur_col);
         }
 
         // Fallback: allowed ASCII, but not recognized above
-        return error(ERR_LEX, "Unexpected character '%c' (0x%02X) at L%d C%d", c, (unsigned int) (unsigned char) c, scanner_get_line(), scanner_get_col());
+        return lex_error(s, ERR_LEX, "Unexpected character '%c' (0x%02X) at L%d C%d", c, (unsigned int) (unsigned char) c, s->cur_line, s->cur_col);
     }
 }
 
+/* Produce the next token of the default scanner. */
+int get_next_token(tokenPtr out) {
+    return scanner_ctx_next_token(&default_ctx, out);
+}
+
 /* Append next token from source into the given token list. */
 int scanner_append_next_token(DLListTokens *list) {
     if (!list)
@@ -1249,3 +1339,104 @@ int scanner(FILE *source, DLListTokens *out_list) {
         }
     }
 }
+
+/* ========== Push mode ========== */
+
+/* Initialize a push-mode scanner context, input comes from scanner_feed(). */
+void scanner_ctx_init_push(scanner_ctx *s) {
+    scanner_ctx_init(s, NULL);
+    s->push = 1;
+}
+
+/* Can one of the new bytes end the construct the last token stopped in? */
+static bool may_end_wait(int wait, const char *bytes, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        int c = (unsigned char) bytes[i];
+        switch (wait) {
+            case WAIT_BLANK: if (!is_space_or_tab(c)) return true; break;
+            case WAIT_EOL: if (c != LF && c != CR) return true; break;
+            case WAIT_IDENT: if (!is_ident_cont(c)) return true; break;
+            case WAIT_LINE_COMMENT: if (c == LF || c == CR) return true; break;
+            case WAIT_BLOCK_COMMENT: if (is_slash(c)) return true; break;
+            // quote, escape, EOL or a disallowed character
+            case WAIT_STRING: if (!is_allowed_ascii_single_line_literal(c)) return true; break;
+            case WAIT_ML_STRING: if (is_quote(c) || !is_allowed_ascii_multi_line_literal(c)) return true; break;
+            default: return true;
+        }
+    }
+    return false;
+}
+
+/* Scan the buffered bytes until a token runs past them (or up to T_EOF after scanner_finish),
+ * then drop the bytes of the returned tokens.
+ */
+static int scan_buffered(scanner_ctx *s, DLListTokens *out) {
+    while (true) {
+        tokenPtr t = token_create();
+        if (!t)
+            return s->status = error(ERR_INTERNAL, "scanner_feed: token_create failed");
+
+        s->starved = 0;
+        int status = scanner_ctx_next_token(s, t);
+        if (s->starved) {
+            // Unfinished token, wait for more bytes
+            token_destroy(t);
+            restore_mark(s);
+            break;
+        }
+        if (status != SUCCESS) {
+            token_destroy(t);
+            return s->status = status;
+        }
+        DLLTokens_InsertLast(out, t);
+        if (t->type == T_EOF)
+            break;
+    }
+
+    if (s->pos > 0) {
+        memmove(s->buf, s->buf + s->pos, s->len - s->pos);
+        s->len -= s->pos;
+        s->pos = 0;
+    }
+    return SUCCESS;
+}
+
+/* Append a chunk of input and return the tokens it completes. */
+int scanner_feed(scanner_ctx *s, const char *bytes, size_t len, DLListTokens *out) {
+    if (!s || !out || (!bytes && len > 0))
+        return error(ERR_INTERNAL, "scanner_feed: null argument");
+    if (s->status != SUCCESS)
+        return s->status;
+
+    if (s->len + len > s->cap) {
+        size_t cap = s->cap ? s->cap : 4096;
+        while (cap < s->len + len) cap *= 2;
+        char *grown = (char *) realloc(s->buf, cap);
+        if (!grown)
+            return s->status = error(ERR_INTERNAL, "Out of memory in scanner");
+        s->buf = grown;
+        s->cap = cap;
+    }
+    if (len > 0) memcpy(s->buf + s->len, bytes, len);
+    s->len += len;
+
+    // The unfinished token cannot end inside these bytes, scanning it again would not finish it
+    if (!may_end_wait(s->wait, bytes, len))
+        return SUCCESS;
+    return scan_buffered(s, out);
+}
+
+/* End of push-mode input: the remaining tokens and T_EOF. */
+int scanner_finish(scanner_ctx *s, DLListTokens *out) {
+    if (!s || !out)
+        return error(ERR_INTERNAL, "scanner_finish: null argument");
+    if (s->status == SUCCESS) {
+        s->finished = 1;
+        s->status = scan_buffered(s, out);
+    }
+
+    free(s->buf);
+    s->buf = NULL;
+    s->len = s->cap = s->pos = 0;
+    return s->status;
+}
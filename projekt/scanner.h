@@ -14,6 +14,83 @@
 #include <stdio.h>
 #include "token.h"
 
+/**
+ * Position of a push-mode scanner where the current token started; the token is
+ * scanned again from here when it ran past the buffered bytes.
+ */
+typedef struct scanner_mark {
+    size_t pos;     // offset in the buffer
+    int cur_line;
+    int cur_col;
+    int has_pb;
+    int pb_char;
+    int pb_line;
+    int pb_col;
+    int prev_line;
+    int prev_col;
+} scanner_mark;
+
+/**
+ * Scanner state: input stream, source position and single-character pushback.
+ * Every context is independent, so several scanners (e.g. one per thread) may run at once.
+ */
+typedef struct scanner_ctx {
+    FILE *in;
+    int cur_line;   // line of the last read character (1-based)
+    int cur_col;    // column of the last read character (1-based, 0 after LF)
+    int has_pb;     // is there a pushed-back character
+    int pb_char;    // the pushed-back character
+    int pb_line;    // position of the pushed-back character
+    int pb_col;
+    int prev_line;  // position before the last read character (for unget)
+    int prev_col;
+
+    // Push mode (scanner_feed): bytes from the start of the unfinished token on
+    int push;       // input comes from scanner_feed() instead of `in`
+    int finished;   // scanner_finish() was called, the buffer ends the input
+    int starved;    // the last token needs more bytes than are buffered
+    int wait;       // construct the last token stopped in, decides which bytes may end it
+    int status;     // first error, returned by every later call
+    char *buf;
+    size_t len;
+    size_t cap;
+    size_t pos;     // next byte to read
+    scanner_mark mark;
+} scanner_ctx;
+
+/**
+ * Initialize a scanner context over the given input stream.
+ */
+void scanner_ctx_init(scanner_ctx *ctx, FILE *source);
+
+/**
+ * Produce the next token of `ctx` according to the FSM rules (reentrant variant of get_next_token).
+ * @return SUCCESS on success, ERR_LEX on lexical error, ERR_INTERNAL on internal error.
+ */
+int scanner_ctx_next_token(scanner_ctx *ctx, tokenPtr out);
+
+/**
+ * Initialize a push-mode scanner context: input is handed over by scanner_feed()
+ * in chunks of any size and ended by scanner_finish().
+ */
+void scanner_ctx_init_push(scanner_ctx *ctx);
+
+/**
+ * Hand the next `len` bytes of input to a push-mode scanner and append every token
+ * completed by them to `out` (initialized by the caller). A token cut by the end of
+ * the chunk (identifier, number, escape, comment, string) is kept back until the
+ * bytes that end it arrive; T_EOF is only produced by scanner_finish().
+ * @return SUCCESS, ERR_LEX or ERR_INTERNAL; after an error every later call returns it again.
+ */
+int scanner_feed(scanner_ctx *ctx, const char *bytes, size_t len, DLListTokens *out);
+
+/**
+ * End the input of a push-mode scanner: append the remaining tokens and T_EOF to `out`
+ * and free the buffer. Must be called even after an error.
+ * @return SUCCESS, ERR_LEX or ERR_INTERNAL.
+ */
+int scanner_finish(scanner_ctx *ctx, DLListTokens *out);
+
 /**
  * Initialize the scanner over the given input stream (e.g., stdin).
  * Resets internal state (position counters, pushback, normalization flags).
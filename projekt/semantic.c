@@ -56,13 +56,6 @@ static bool sem_is_string_type(data_type t) {
     return t == ST_STRING;
 }
 
-/**
- * @brief Returns true if given data_type is a boolean.
- */
-static bool sem_is_bool_type(data_type t) {
-    return t == ST_BOOL;
-}
-
 /**
  * @brief Returns a unified numeric type for two numeric operands.
  */
@@ -282,27 +275,39 @@ static void sem_uint_to_dec(char *buffer, size_t buffer_size, unsigned int value
 }
 
 /**
- * @brief Builds a flattened scope suffix by stripping dots from scope_str.
+ * @brief Builds the scope suffix of a codegen name: the scope path inside the
+ *        function, "1.F.3.1" -> "3$1" (class "1" and function "F" levels left out).
+ *
+ * Locals live in the frame of their function, so the name is unique there and
+ * does not change when functions are added or removed before it. '$' never
+ * occurs in an identifier, scopes 1.11 and 11.1 give different suffixes.
  */
 static void sem_build_scope_suffix(const char *scope_str, char *buffer, size_t buffer_size) {
     size_t pos = 0;
+    unsigned level = 0;
     if (scope_str) {
         for (size_t i = 0; scope_str[i] != '\0'; ++i) {
             char c = scope_str[i];
             if (c == '.') {
+                level++;
+                c = '$';
+                if (level < 3) {
+                    continue; // class and function levels
+                }
+            } else if (level < 2) {
                 continue;
             }
             if (pos + 1 >= buffer_size) {
                 break;
             }
-            buffer[pos++] = c; // copy non-dot character
+            buffer[pos++] = c; // copy scope index or separator
         }
     }
-    buffer[pos] = '\0'; // terminate flattened scope string
+    buffer[pos] = '\0'; // terminate scope suffix
 }
 
 /**
- * @brief Builds "<name>_<flat_scope>" into buffer (null-terminated).
+ * @brief Builds "<name>$<scope suffix>", or just "<name>" at function level, into buffer (null-terminated).
  */
 static void sem_build_cg_name(char *buffer, size_t buffer_size, const char *name, const char *scope_str) {
     buffer[0] = '\0';
@@ -320,22 +325,19 @@ static void sem_build_cg_name(char *buffer, size_t buffer_size, const char *name
     memcpy(buffer + pos, name, name_len);
     pos += name_len;
 
-    if (pos < max_total) {
-        buffer[pos++] = '_'; // add separator before flattened scope
-
-        char scope_clean[64];
-        sem_build_scope_suffix(scope_str, scope_clean, sizeof scope_clean);
+    char scope_clean[64];
+    sem_build_scope_suffix(scope_str, scope_clean, sizeof scope_clean);
+    if (pos < max_total && scope_clean[0] != '\0') {
+        buffer[pos++] = '$'; // add separator before scope suffix
 
-        // append flattened scope, truncated if needed
+        // append scope suffix, truncated if needed
         size_t scope_len = strlen(scope_clean);
         size_t remaining = max_total - pos;
         if (scope_len > remaining) {
             scope_len = remaining;
         }
-        if (scope_len > 0) {
-            memcpy(buffer + pos, scope_clean, scope_len);
-            pos += scope_len;
-        }
+        memcpy(buffer + pos, scope_clean, scope_len);
+        pos += scope_len;
     }
     buffer[pos] = '\0'; // terminate final cg name
 }
@@ -920,26 +922,22 @@ static literal_kind get_literal_kind_of_value_expression(ast_expression expressi
 }
 
 /**
- * @brief recursively computes literal-kind for an expression subtree.
+ * @brief computes literal-kind of an expression node from the kinds of its operands.
  *  - LITERAL_NUMERIC: numeric-only literals/operators.
  *  - LITERAL_STRING : string-safe literals/operators (string+string, string*int literal, concat).
  *  - LITERAL_UNKNOWN: involves identifiers, calls, or mixed/unsupported combinations.
  * @param expression_node expression node.
+ * @param left_kind literal kind of the left operand.
+ * @param right_kind literal kind of the right operand.
  * @return literal kind classification.
  */
-static literal_kind get_expression_literal_kind(ast_expression expression_node) {
-    if (!expression_node) {
-        return LITERAL_UNKNOWN;
-    }
-
+static literal_kind get_expression_literal_kind(ast_expression expression_node, literal_kind left_kind,
+                                                literal_kind right_kind) {
     switch (expression_node->type) {
         case AST_VALUE:
             return get_literal_kind_of_value_expression(expression_node);
         // binary operators
-        case AST_ADD: {
-            literal_kind left_kind = get_expression_literal_kind(expression_node->operands.binary_op.left);
-            literal_kind right_kind = get_expression_literal_kind(expression_node->operands.binary_op.right);
-
+        case AST_ADD:
             // mixed  to unknown
             if (!left_kind || !right_kind) {
                 return LITERAL_UNKNOWN;
@@ -951,43 +949,29 @@ static literal_kind get_expression_literal_kind(ast_expression expression_node)
                 return LITERAL_STRING;
             }
             return LITERAL_UNKNOWN;
-        }
         // subtraction, division: num-num
         case AST_SUB:
-        case AST_DIV: {
-            literal_kind left_kind = get_expression_literal_kind(expression_node->operands.binary_op.left);
-            literal_kind right_kind = get_expression_literal_kind(expression_node->operands.binary_op.right);
-
+        case AST_DIV:
             if (left_kind == LITERAL_NUMERIC && right_kind == LITERAL_NUMERIC) {
                 return LITERAL_NUMERIC;
             }
             return LITERAL_UNKNOWN;
-        }
         // multiplication: num*num or str*int-literal
-        case AST_MUL: {
-            literal_kind left_kind = get_expression_literal_kind(expression_node->operands.binary_op.left);
-            literal_kind right_kind = get_expression_literal_kind(expression_node->operands.binary_op.right);
-
+        case AST_MUL:
             if (left_kind == LITERAL_NUMERIC && right_kind == LITERAL_NUMERIC) {
                 return LITERAL_NUMERIC;
             }
-
             if (left_kind == LITERAL_STRING &&
                 expression_is_integer_literal(expression_node->operands.binary_op.right)) {
                 return LITERAL_STRING;
             }
             return LITERAL_UNKNOWN;
-        }
         // relational operators require numeric literals
-        case AST_CONCAT: {
-            literal_kind left_kind = get_expression_literal_kind(expression_node->operands.binary_op.left);
-            literal_kind right_kind = get_expression_literal_kind(expression_node->operands.binary_op.right);
-
+        case AST_CONCAT:
             if (left_kind == LITERAL_STRING && right_kind == LITERAL_STRING) {
                 return LITERAL_STRING;
             }
             return LITERAL_UNKNOWN;
-        }
 
         default:
             // all other treated as nonliteral
@@ -995,8 +979,120 @@ static literal_kind get_expression_literal_kind(ast_expression expression_node)
     }
 }
 
+/**
+ * @brief Stack of the results (literal kinds, data types) of the operands walked so far.
+ *
+ * Expressions are walked with ast_walk and checked in post-order: every node
+ * pushes its result when it is left and pops the results of its operands.
+ */
+typedef struct sem_result_stack {
+    int *items;
+    size_t count;
+    size_t capacity;
+} sem_result_stack;
+
+/**
+ * @brief Pushes the result of a node.
+ * @return SUCCESS or ERR_INTERNAL when out of memory.
+ */
+static int sem_results_push(sem_result_stack *stack, int result) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = stack->capacity ? 2 * stack->capacity : 64;
+        int *items = realloc(stack->items, capacity * sizeof *items);
+        if (!items) {
+            return error(ERR_INTERNAL, "memory allocation failed for expression walk");
+        }
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = result;
+    return SUCCESS;
+}
+
+/**
+ * @brief Pops the results of the operands of a node left by the walk.
+ * @param stack results of the walked operands.
+ * @param expression_node node whose operands were walked.
+ * @param results output, results[i] of operand i (missing operands get @p fallback).
+ * @param fallback result of a missing (NULL) operand.
+ */
+static void sem_results_pop_operands(sem_result_stack *stack, ast_expression expression_node, int results[3],
+                                     int fallback) {
+    results[0] = results[1] = results[2] = fallback;
+    for (int i = ast_expression_operand_count(expression_node) - 1; i >= 0; i--) {
+        if (ast_expression_operand(expression_node, i) && stack->count > 0) {
+            results[i] = stack->items[--stack->count];
+        }
+    }
+}
+
+/**
+ * @brief Runs a walk of an expression with a result stack.
+ *
+ * @p leave is called on every node after its operands, with their results;
+ * it stores the result of the node.
+ *
+ * @param cxt semantic context.
+ * @param expression_node root of the expression, may be NULL.
+ * @param leave check of one node.
+ * @param fallback result of a missing operand.
+ * @param out_result optional output, result of the root.
+ * @return SUCCESS or the first error code.
+ */
+static int sem_walk_expression(semantic *cxt, ast_expression expression_node,
+                               int (*leave)(semantic *, ast_expression, const int *, int *), int fallback,
+                               int *out_result) {
+    ast_walk walk;
+    sem_result_stack results = {NULL, 0, 0};
+    int result_code = SUCCESS;
+    int result = fallback;
+
+    ast_walk_init(&walk, expression_node);
+    for (ast_expression node; result_code == SUCCESS && (node = ast_walk_next(&walk)) != NULL;) {
+        // operands first, the node is checked when it is left
+        if (!walk.leaving) {
+            continue;
+        }
+        int operand_results[3];
+        sem_results_pop_operands(&results, node, operand_results, fallback);
+        result = fallback;
+        result_code = leave(cxt, node, operand_results, &result);
+        if (result_code == SUCCESS) {
+            result_code = sem_results_push(&results, result);
+        }
+    }
+    if (result_code == SUCCESS && walk.failed) {
+        result_code = error(ERR_INTERNAL, "memory allocation failed for expression walk");
+    }
+    if (result_code == SUCCESS && out_result) {
+        *out_result = result;
+    }
+    ast_walk_free(&walk);
+    free(results.items);
+    return result_code;
+}
+
 static int visit_expression_node(semantic *semantic_table, ast_expression expression_node);
 
+/**
+ * @brief Visits call arguments that are whole expressions (FUNEXP) in pass 1.
+ * @param semantic_table semantic context.
+ * @param parameters argument list of the call.
+ * @return SUCCESS or error code.
+ */
+static int sem_visit_argument_expressions(semantic *semantic_table, ast_parameter parameters) {
+    for (ast_parameter p = parameters; p; p = p->next) {
+        if (p->value_type != AST_VALUE_EXPRESSION) {
+            continue;
+        }
+        int result_code = visit_expression_node(semantic_table, p->expression);
+        if (result_code != SUCCESS) {
+            return result_code;
+        }
+    }
+    return SUCCESS;
+}
+
 /**
  * @brief performs literal-only checks for a binary expression.
  *
@@ -1224,6 +1320,10 @@ static int sem_visit_call_expr(semantic *semantic_table, ast_expression expressi
     // read call node and function name from expression
     ast_fun_call call_node = expression_node->operands.function_call;
     const char *called_name = call_node->name;
+    int result_code = sem_visit_argument_expressions(semantic_table, call_node->parameters);
+    if (result_code != SUCCESS) {
+        return result_code;
+    }
     // handle builtin calls (arity + literals)
     if (builtins_is_builtin_qname(called_name)) {
         return sem_check_builtin_call(semantic_table, called_name, call_node->parameters);
@@ -1234,57 +1334,28 @@ static int sem_visit_call_expr(semantic *semantic_table, ast_expression expressi
 }
 
 /**
- * @brief handles a binary-like expression (relational, logical, ternary, 'is') in pass 1.
+ * @brief checks an expression node in pass 1, its operands are already visited.
  * @param semantic_table semantic context.
  * @param expression_node expression node.
+ * @param operand_kinds literal kinds of the operands.
+ * @param out_kind output, literal kind of the node.
  * @return SUCCESS or error code.
  */
-static int sem_visit_binary_expr(semantic *semantic_table, ast_expression expression_node) {
-    // read operand pointers
-    ast_expression left_expression = expression_node->operands.binary_op.left;
-    ast_expression right_expression = expression_node->operands.binary_op.right;
-
-    // visit left operand
-    int result_code = visit_expression_node(semantic_table, left_expression);
-    if (result_code != SUCCESS) {
-        return result_code;
-    }
-
-    // visit right operand
-    result_code = visit_expression_node(semantic_table, right_expression);
-    if (result_code != SUCCESS) {
-        return result_code;
-    }
-    // compute literal kinds
-    literal_kind left_kind = get_expression_literal_kind(left_expression);
-    literal_kind right_kind = get_expression_literal_kind(right_expression);
-    // literal checker
-    return sem_check_literal_binary(expression_node->type, left_kind, right_kind, right_expression);
-}
-
-/**
- * @brief visits an expression node in pass 1 and runs early checks.
- * @param semantic_table semantic context.
- * @param expression_node expression node.
- * @return SUCCESS or error code.
- */
-static int visit_expression_node(semantic *semantic_table, ast_expression expression_node) {
-    if (!expression_node) {
-        return SUCCESS;
-    }
+static int sem_leave_expression_node(semantic *semantic_table, ast_expression expression_node,
+                                     const int *operand_kinds, int *out_kind) {
+    *out_kind = get_expression_literal_kind(expression_node, operand_kinds[0], operand_kinds[1]);
 
     switch (expression_node->type) {
-        case AST_VALUE:
-        case AST_NOT:
-        case AST_NOT_NULL:
-            // simple values and unary operators are ignored
-            return SUCCESS;
         case AST_IFJ_FUNCTION_EXPR: {
             // handle expression-form builtin call (Ifj.*)
             ast_ifj_function ifj_call = expression_node->operands.ifj_function;
             if (!ifj_call || !ifj_call->name) {
                 return SUCCESS;
             }
+            int result_code = sem_visit_argument_expressions(semantic_table, ifj_call->parameters);
+            if (result_code != SUCCESS) {
+                return result_code;
+            }
             return sem_check_builtin_call(semantic_table, ifj_call->name, ifj_call->parameters);
         }
         case AST_FUNCTION_CALL:
@@ -1302,15 +1373,30 @@ static int visit_expression_node(semantic *semantic_table, ast_expression expres
         case AST_GE:
         case AST_AND:
         case AST_OR:
-        case AST_TERNARY:
-        case AST_IS:
-            // visit binary expression and apply literal rules
-            return sem_visit_binary_expr(semantic_table, expression_node);
+            // apply literal rules to the operands
+            return sem_check_literal_binary(expression_node->type, operand_kinds[0], operand_kinds[1],
+                                            expression_node->operands.binary_op.right);
         default:
+            // values, unary operators, ternary and 'is' (type name on the right) have no literal rules
             return SUCCESS;
     }
 }
 
+/**
+ * @brief visits an expression in pass 1 and runs early checks.
+ *
+ * The tree is walked in post-order with an explicit stack, so the literal
+ * kinds of the operands are computed once and the depth of the expression is
+ * not limited by the C stack.
+ *
+ * @param semantic_table semantic context.
+ * @param expression_node expression node.
+ * @return SUCCESS or error code.
+ */
+static int visit_expression_node(semantic *semantic_table, ast_expression expression_node) {
+    return sem_walk_expression(semantic_table, expression_node, sem_leave_expression_node, LITERAL_UNKNOWN, NULL);
+}
+
 /* =========================================================================
  *                       Bodies walk (scopes & nodes) – Pass 1
  * ========================================================================= */
@@ -1614,12 +1700,20 @@ static int visit_statement_node(semantic *semantic_table, ast_node node) {
             if (!ifj_call || !ifj_call->name) {
                 return SUCCESS;
             }
+            int result_code = sem_visit_argument_expressions(semantic_table, ifj_call->parameters);
+            if (result_code != SUCCESS) {
+                return result_code;
+            }
             return sem_check_builtin_call(semantic_table, ifj_call->name, ifj_call->parameters);
         }
         case AST_CALL_FUNCTION: {
             // handle user or builtin call
             ast_fun_call call_node = node->data.function_call;
             int parameter_count = count_parameters(call_node->parameters);
+            int result_code = sem_visit_argument_expressions(semantic_table, call_node->parameters);
+            if (result_code != SUCCESS) {
+                return result_code;
+            }
 
             if (builtins_is_builtin_qname(call_node->name)) {
                 return sem_check_builtin_call(semantic_table, call_node->name, call_node->parameters);
@@ -1736,61 +1830,78 @@ static int collect_headers_from_block(semantic *semantic_table, ast_block block_
  *                              PASS 1
  * ========================================================================= */
 /**
- * @brief Runs the first semantic pass over the AST and then Pass 2.
+ * @brief Prepares the semantic context for a program.
  *  - initializes semantic tables and registries,
  *  - installs IFJ built-ins into the function table,
  *  - collects function/getter/setter headers (Pass 1, step 1),
- *  - checks presence and arity of main(),
- *  - walks bodies and fills scopes (Pass 1, step 2),
- *  - runs semantic_pass2() with the same semantic context,
- *  - frees all internal tables and returns the result of Pass 2.
+ *  - checks presence and arity of main().
  *
- * @param tree AST root.
- * @return SUCCESS or the first error encountered.
+ * @param semantic_table Context to initialize.
+ * @param tree AST root, only the headers of its functions are read.
+ * @return SUCCESS, or the first error (the function table is then freed).
  */
-int semantic_pass1(ast tree) {
+int semantic_stream_begin(semantic *semantic_table, ast tree) {
     // initialize semantic context
-    semantic semantic_table = {0};
+    *semantic_table = (semantic){0};
     // reset globals
     sem_globals_reset();
     // reset global types
     sem_global_types_reset();
 
     // initialize global function table
-    semantic_table.funcs = st_init();
-    if (!semantic_table.funcs) {
+    semantic_table->funcs = st_init();
+    if (!semantic_table->funcs) {
         return error(ERR_INTERNAL, "failed to init global function table");
     }
 
     // initialize scopes and scope ids stack
-    scopes_init(&semantic_table.scopes);
-    sem_scope_ids_init(&semantic_table.ids);
+    scopes_init(&semantic_table->scopes);
+    sem_scope_ids_init(&semantic_table->ids);
 
     // initialize loop depth and main() seen flag
-    semantic_table.loop_depth = 0;
-    semantic_table.seen_main = false;
+    semantic_table->loop_depth = 0;
+    semantic_table->seen_main = false;
 
     // install built-in functions
     builtins_config builtins_configuration = (builtins_config){.ext_boolthen = false, .ext_statican = false};
-    if (!builtins_install(semantic_table.funcs, builtins_configuration)) {
+    if (!builtins_install(semantic_table->funcs, builtins_configuration)) {
         int rc = error(ERR_INTERNAL, "failed to install built-ins");
-        st_free(semantic_table.funcs);
+        semantic_stream_end(semantic_table);
         return rc;
     }
 
     // collect function/getter/setter headers from all classes
-    int result_code = collect_headers(&semantic_table, tree);
+    int result_code = collect_headers(semantic_table, tree);
     if (result_code != SUCCESS) {
-        st_free(semantic_table.funcs);
+        semantic_stream_end(semantic_table);
         return result_code;
     }
 
     // check that main() with 0 parameters exists
-    if (!semantic_table.seen_main) {
+    if (!semantic_table->seen_main) {
         int rc = error(ERR_DEF, "missing main() with 0 parameters");
-        st_free(semantic_table.funcs);
+        semantic_stream_end(semantic_table);
         return rc;
     }
+    return SUCCESS;
+}
+
+/**
+ * @brief Runs the first semantic pass over the AST and then Pass 2.
+ *  - prepares the context and collects headers (semantic_stream_begin),
+ *  - walks bodies and fills scopes (Pass 1, step 2),
+ *  - runs semantic_pass2() with the same semantic context,
+ *  - frees all internal tables and returns the result of Pass 2.
+ *
+ * @param tree AST root.
+ * @return SUCCESS or the first error encountered.
+ */
+int semantic_pass1(ast tree) {
+    semantic semantic_table;
+    int result_code = semantic_stream_begin(&semantic_table, tree);
+    if (result_code != SUCCESS) {
+        return result_code;
+    }
 
     // visit all class root blocks to fill scopes
     for (ast_class class_node = tree->class_list; class_node; class_node = class_node->next) {
@@ -1801,7 +1912,7 @@ int semantic_pass1(ast tree) {
 
         result_code = visit_block_node(&semantic_table, root_block);
         if (result_code != SUCCESS) {
-            st_free(semantic_table.funcs);
+            semantic_stream_end(&semantic_table);
             return result_code;
         }
     }
@@ -1809,10 +1920,36 @@ int semantic_pass1(ast tree) {
     // run Pass 2 with the same semantic context
     int pass2_result = semantic_pass2(&semantic_table, tree);
     // free function table
-    st_free(semantic_table.funcs);
+    semantic_stream_end(&semantic_table);
     return pass2_result;
 }
 
+/**
+ * @brief Pass 1 of one function, getter or setter inside the class root scope.
+ * @param semantic_table Context from semantic_stream_begin().
+ * @param function Member of the class.
+ * @return SUCCESS or an error code.
+ */
+int semantic_stream_pass1(semantic *semantic_table, ast_node function) {
+    scopes_init(&semantic_table->scopes);
+    sem_scope_ids_init(&semantic_table->ids);
+    semantic_table->loop_depth = 0;
+
+    sem_scope_enter_block(semantic_table);
+    int result_code = visit_statement_node(semantic_table, function);
+    sem_scope_leave_block(semantic_table, "semantic_stream_pass1");
+    return result_code;
+}
+
+/**
+ * @brief Frees the tables of the semantic context.
+ * @param semantic_table Semantic context.
+ */
+void semantic_stream_end(semantic *semantic_table) {
+    st_free(semantic_table->funcs);
+    semantic_table->funcs = NULL;
+}
+
 /* =========================================================================
  *                              Pass 2
  * ========================================================================= */
@@ -1918,6 +2055,27 @@ static bool sem_is_unknownish_type(data_type t) {
     return t == ST_UNKNOWN || t == ST_VOID || sem_is_unknown_type(t);
 }
 
+static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type);
+
+/**
+ * @brief Visits call arguments that are whole expressions (FUNEXP) in Pass 2.
+ * @param cxt Semantic context.
+ * @param params Argument list of the function call.
+ * @return SUCCESS or an error code.
+ */
+static int sem2_visit_argument_expressions(semantic *cxt, ast_parameter params) {
+    for (ast_parameter p = params; p; p = p->next) {
+        if (p->value_type != AST_VALUE_EXPRESSION) {
+            continue;
+        }
+        int rc = sem2_visit_expr(cxt, p->expression, NULL);
+        if (rc != SUCCESS) {
+            return rc;
+        }
+    }
+    return SUCCESS;
+}
+
 /**
  * @brief common function call handler for Pass 2.
  * @param cxt Semantic context.
@@ -1944,19 +2102,21 @@ static int sem2_visit_call_common(semantic *cxt, const char *name_for_check, ast
             }
         }
     }
+    rc = sem2_visit_argument_expressions(cxt, params);
+    if (rc != SUCCESS) {
+        return rc;
+    }
     // return type for builtins only
-    if (out_type) {
-        data_type ret = ST_UNKNOWN;
-        if (treat_as_builtin && name_for_check) {
-            char key[256];
-            make_function_key(key, sizeof key, name_for_check, ar);
-            st_data *fn = st_get(cxt->funcs, key);
-            if (fn) {
-                ret = fn->data_type;
-            }
+    data_type ret = ST_UNKNOWN;
+    if (treat_as_builtin && name_for_check) {
+        char key[256];
+        make_function_key(key, sizeof key, name_for_check, ar);
+        st_data *fn = st_get(cxt->funcs, key);
+        if (fn) {
+            ret = fn->data_type;
         }
-        *out_type = ret;
     }
+    *out_type = ret;
     return SUCCESS;
 }
 
@@ -1964,22 +2124,14 @@ static int sem2_visit_call_common(semantic *cxt, const char *name_for_check, ast
  *  Expression visitor and type checker (Pass 2)
  * ------------------------------------------------------------------------- */
 /**
- * @brief Visits an expression in Pass 2 and checks its approximate data type.
+ * @brief Checks an expression node in Pass 2, its operands are already visited.
  * @param cxt Semantic context.
  * @param e Expression node.
- * @param out_type Optional output for inferred type.
+ * @param operand_types Inferred types of the operands (data_type).
+ * @param out_type Output for inferred type, preset to ST_UNKNOWN.
  * @return SUCCESS or an error code.
  */
-static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type) {
-    if (!e) {
-        return SUCCESS;
-    }
-
-    // set default inferred type for this expression
-    if (out_type) {
-        *out_type = ST_UNKNOWN;
-    }
-
+static int sem2_leave_expr(semantic *cxt, ast_expression e, const int *operand_types, int *out_type) {
     switch (e->type) {
         case AST_IDENTIFIER: {
             // resolve identifier and check visibility
@@ -1999,7 +2151,7 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
             }
 
             // infer type from local symbol or learned global type
-            if (out_type && name) {
+            if (name) {
                 data_type t = ST_UNKNOWN;
 
                 if (sym) {
@@ -2024,24 +2176,22 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
 
         case AST_VALUE: {
             // map literal node kind to data_type
-            if (out_type) {
-                switch (e->operands.identity.value_type) {
-                    case AST_VALUE_INT:
-                        *out_type = ST_INT;
-                        break;
-                    case AST_VALUE_FLOAT:
-                        *out_type = ST_DOUBLE;
-                        break;
-                    case AST_VALUE_STRING:
-                        *out_type = ST_STRING;
-                        break;
-                    case AST_VALUE_NULL:
-                        *out_type = ST_NULL;
-                        break;
-                    default:
-                        *out_type = ST_UNKNOWN;
-                        break;
-                }
+            switch (e->operands.identity.value_type) {
+                case AST_VALUE_INT:
+                    *out_type = ST_INT;
+                    break;
+                case AST_VALUE_FLOAT:
+                    *out_type = ST_DOUBLE;
+                    break;
+                case AST_VALUE_STRING:
+                    *out_type = ST_STRING;
+                    break;
+                case AST_VALUE_NULL:
+                    *out_type = ST_NULL;
+                    break;
+                default:
+                    *out_type = ST_UNKNOWN;
+                    break;
             }
 
             return SUCCESS;
@@ -2055,10 +2205,12 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
 
             bool treat_as_builtin = (call->name && builtins_is_builtin_qname(call->name));
 
-            int rc = sem2_visit_call_common(cxt, call->name, call->parameters, treat_as_builtin, out_type);
+            data_type ret;
+            int rc = sem2_visit_call_common(cxt, call->name, call->parameters, treat_as_builtin, &ret);
             if (rc != SUCCESS) {
                 return rc;
             }
+            *out_type = ret;
 
             // change cg_name of identifier parameters to their resolved cg_name
             for (ast_parameter p = call->parameters; p; p = p->next) {
@@ -2098,10 +2250,12 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
             char qname[128];
             const char *name = call->name ? sem_build_ifj_qname(call->name, qname, sizeof qname) : "(null)";
 
-            int rc = sem2_visit_call_common(cxt, name, call->parameters, true, out_type);
+            data_type ret;
+            int rc = sem2_visit_call_common(cxt, name, call->parameters, true, &ret);
             if (rc != SUCCESS) {
                 return rc;
             }
+            *out_type = ret;
 
             //change cg_name for identifier parameters
             for (ast_parameter p = call->parameters; p; p = p->next) {
@@ -2133,16 +2287,8 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
 
         case AST_NOT:
         case AST_NOT_NULL: {
-            // visit inner expression for side effects and then treat result as bool
-            data_type inner;
-            int rc = sem2_visit_expr(cxt, e->operands.unary_op.expression, &inner);
-            if (rc != SUCCESS) {
-                return rc;
-            }
-
-            if (out_type) {
-                *out_type = ST_BOOL;
-            }
+            // any operand: false and null are false, every other value is true (as in if/while)
+            *out_type = ST_BOOL;
             return SUCCESS;
         }
 
@@ -2160,29 +2306,18 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
         case AST_AND:
         case AST_OR:
         case AST_CONCAT: {
-            // visit both operands and infer their types
-            data_type lt, rt;
-            int rc = sem2_visit_expr(cxt, e->operands.binary_op.left, &lt);
-            if (rc != SUCCESS) {
-                return rc;
-            }
-
-            rc = sem2_visit_expr(cxt, e->operands.binary_op.right, &rt);
-            if (rc != SUCCESS) {
-                return rc;
-            }
+            // both operands are visited, use their inferred types
+            data_type lt = operand_types[0], rt = operand_types[1];
 
             // bail out early if any side is unknownish
             if (sem_is_unknownish_type(lt) || sem_is_unknownish_type(rt)) {
-                if (out_type) {
-                    if (e->type == AST_EQUALS || e->type == AST_NOT_EQUAL ||
-                        e->type == AST_LT || e->type == AST_LE ||
-                        e->type == AST_GT || e->type == AST_GE ||
-                        e->type == AST_AND || e->type == AST_OR) {
-                        *out_type = ST_BOOL;
-                    } else {
-                        *out_type = ST_UNKNOWN;
-                    }
+                if (e->type == AST_EQUALS || e->type == AST_NOT_EQUAL ||
+                    e->type == AST_LT || e->type == AST_LE ||
+                    e->type == AST_GT || e->type == AST_GE ||
+                    e->type == AST_AND || e->type == AST_OR) {
+                    *out_type = ST_BOOL;
+                } else {
+                    *out_type = ST_UNKNOWN;
                 }
                 return SUCCESS;
             }
@@ -2191,15 +2326,11 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
             switch (e->type) {
                 case AST_ADD:
                     if (sem_is_numeric_type(lt) && sem_is_numeric_type(rt)) {
-                        if (out_type) {
-                            *out_type = sem_unify_numeric_type(lt, rt);
-                        }
+                        *out_type = sem_unify_numeric_type(lt, rt);
                         return SUCCESS;
                     }
                     if (sem_is_string_type(lt) && sem_is_string_type(rt)) {
-                        if (out_type) {
-                            *out_type = ST_STRING;
-                        }
+                        *out_type = ST_STRING;
                         return SUCCESS;
                     }
                     return error(ERR_EXPR, "invalid operands for '+'");
@@ -2207,33 +2338,25 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
                 case AST_SUB:
                 case AST_DIV:
                     if (sem_is_numeric_type(lt) && sem_is_numeric_type(rt)) {
-                        if (out_type) {
-                            *out_type = sem_unify_numeric_type(lt, rt);
-                        }
+                        *out_type = sem_unify_numeric_type(lt, rt);
                         return SUCCESS;
                     }
                     return error(ERR_EXPR, "invalid operands for arithmetic operator");
 
                 case AST_MUL:
                     if (sem_is_numeric_type(lt) && sem_is_numeric_type(rt)) {
-                        if (out_type) {
-                            *out_type = sem_unify_numeric_type(lt, rt);
-                        }
+                        *out_type = sem_unify_numeric_type(lt, rt);
                         return SUCCESS;
                     }
                     if ((sem_is_string_type(lt) && rt == ST_INT) || (sem_is_string_type(rt) && lt == ST_INT)) {
-                        if (out_type) {
-                            *out_type = ST_STRING;
-                        }
+                        *out_type = ST_STRING;
                         return SUCCESS;
                     }
                     return error(ERR_EXPR, "invalid operands for '*'");
 
                 case AST_CONCAT:
                     if (sem_is_string_type(lt) && sem_is_string_type(rt)) {
-                        if (out_type) {
-                            *out_type = ST_STRING;
-                        }
+                        *out_type = ST_STRING;
                         return SUCCESS;
                     }
                     return error(ERR_EXPR, "invalid operands for concat operator");
@@ -2243,9 +2366,7 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
                 case AST_GT:
                 case AST_GE:
                     if (sem_is_numeric_type(lt) && sem_is_numeric_type(rt)) {
-                        if (out_type) {
-                            *out_type = ST_BOOL;
-                        }
+                        *out_type = ST_BOOL;
                         return SUCCESS;
                     }
                     return error(ERR_EXPR, "relational operators require numeric operands");
@@ -2253,21 +2374,14 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
                 // equality operators
                 case AST_EQUALS:
                 case AST_NOT_EQUAL:
-                    if (out_type) {
-                        *out_type = ST_BOOL;
-                    }
+                    *out_type = ST_BOOL;
                     return SUCCESS;
 
-                // logical operators
+                // logical operators take the truth value of any operand, like '!' and '?:'
                 case AST_AND:
                 case AST_OR:
-                    if (sem_is_bool_type(lt) && sem_is_bool_type(rt)) {
-                        if (out_type) {
-                            *out_type = ST_BOOL;
-                        }
-                        return SUCCESS;
-                    }
-                    return error(ERR_EXPR, "logical operators require bool operands");
+                    *out_type = ST_BOOL;
+                    return SUCCESS;
                 default:
                     break;
             }
@@ -2275,30 +2389,15 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
         }
 
         case AST_TERNARY: {
-            // visit both branches to trigger checks
-            data_type lt, rt;
-            int rc = sem2_visit_expr(cxt, e->operands.binary_op.left, &lt);
-            if (rc != SUCCESS) {
-                return rc;
-            }
-            rc = sem2_visit_expr(cxt, e->operands.binary_op.right, &rt);
-            if (rc != SUCCESS) {
-                return rc;
-            }
-            if (out_type) {
-                *out_type = ST_UNKNOWN;
-            }
+            // condition and both branches are visited
+            data_type lt = operand_types[1], rt = operand_types[2];
+            // result type is known only when both branches agree
+            *out_type = (lt == rt && !sem_is_unknownish_type(lt)) ? lt : ST_UNKNOWN;
             return SUCCESS;
         }
 
         case AST_IS: {
-            // visit left-hand side and enforce allowed type name
-            data_type lhs_type;
-            int rc = sem2_visit_expr(cxt, e->operands.binary_op.left, &lhs_type);
-            if (rc != SUCCESS) {
-                return rc;
-            }
-
+            // left-hand side is visited, enforce allowed type name
             ast_expression rhs = e->operands.binary_op.right;
             const char *type_name = NULL;
 
@@ -2315,17 +2414,13 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
                 return error(ERR_EXPR, "invalid type '%s' on right-hand side of 'is' (expected Num, String or Null)", type_name);
             }
 
-            if (out_type) {
-                *out_type = ST_BOOL;
-            }
+            *out_type = ST_BOOL;
             return SUCCESS;
         }
         case AST_NONE:
         case AST_NIL:
             // treat as null
-            if (out_type) {
-                *out_type = ST_NULL;
-            }
+            *out_type = ST_NULL;
             return SUCCESS;
         default:
             // unknown node kind
@@ -2333,6 +2428,27 @@ static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type)
     }
 }
 
+/**
+ * @brief Visits an expression in Pass 2 and checks its approximate data type.
+ *
+ * The tree is walked in post-order with an explicit stack, the operands are
+ * visited left to right before the operator; the type name on the right of
+ * 'is' is not visited as an identifier.
+ *
+ * @param cxt Semantic context.
+ * @param e Expression node.
+ * @param out_type Optional output for inferred type.
+ * @return SUCCESS or an error code.
+ */
+static int sem2_visit_expr(semantic *cxt, ast_expression e, data_type *out_type) {
+    int type = ST_UNKNOWN;
+    int rc = sem_walk_expression(cxt, e, sem2_leave_expr, ST_UNKNOWN, &type);
+    if (out_type) {
+        *out_type = (data_type)type;
+    }
+    return rc;
+}
+
 /* -------------------------------------------------------------------------
  *  Statement visitor (Pass 2)
  * ------------------------------------------------------------------------- */
@@ -2664,7 +2780,7 @@ static int sem2_visit_statement_node(semantic *table, ast_node node) {
                 }
             }
 
-            return SUCCESS;
+            return sem2_visit_argument_expressions(table, call->parameters);
         }
 
         case AST_RETURN: {
@@ -2730,7 +2846,7 @@ static int sem2_visit_statement_node(semantic *table, ast_node node) {
                 }
             }
 
-            return SUCCESS;
+            return sem2_visit_argument_expressions(table, call->parameters);
         }
     }
     return SUCCESS;
@@ -2794,6 +2910,24 @@ int semantic_pass2(semantic *table, ast syntax_tree) {
     return SUCCESS;
 }
 
+/**
+ * @brief Pass 2 of one function, getter or setter inside the class root scope.
+ * Global types learned by earlier functions are kept, as in semantic_pass2().
+ * @param table Semantic context after semantic_stream_pass1() of the function.
+ * @param function Member of the class.
+ * @return SUCCESS or an error code.
+ */
+int semantic_stream_pass2(semantic *table, ast_node function) {
+    scopes_init(&table->scopes);
+    sem_scope_ids_init(&table->ids);
+    table->loop_depth = 0;
+
+    sem_scope_enter_block(table);
+    int rc = sem2_visit_statement_node(table, function);
+    sem_scope_leave_block(table, "semantic_stream_pass2");
+    return rc;
+}
+
 /* =========================================================================
  *                    Global names retrieval
  * ========================================================================= */
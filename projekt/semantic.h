@@ -69,6 +69,38 @@ typedef struct semantic_ctx {
  */
 int semantic_pass1(ast tree);
 
+/**
+ * @brief Starts the analysis of a program checked one function at a time (--stream).
+ *
+ * Installs the built-ins, registers the headers of all functions, getters and
+ * setters of @p headers (their bodies are not read) and checks main().
+ * The functions are then checked in source order, each by
+ * semantic_stream_pass1() and semantic_stream_pass2(); the result is the same
+ * as semantic_pass1() of the whole program if the first failing Pass 1 is
+ * preferred to a failing Pass 2 of an earlier function.
+ *
+ * @param table   Context to initialize, freed by semantic_stream_end().
+ * @param headers Program AST with the headers of all functions.
+ * @return 0 (SUCCESS) on success, otherwise error code (the context is freed).
+ */
+int semantic_stream_begin(semantic *table, ast headers);
+
+/**
+ * @brief Pass 1 of one function, getter or setter (scopes, declarations, calls).
+ */
+int semantic_stream_pass1(semantic *table, ast_node function);
+
+/**
+ * @brief Pass 2 of one function, getter or setter; fills the codegen names.
+ */
+int semantic_stream_pass2(semantic *table, ast_node function);
+
+/**
+ * @brief Frees the context of semantic_stream_begin(); the globals stay
+ *        available to semantic_get_globals().
+ */
+void semantic_stream_end(semantic *table);
+
 
 /**
  * @brief Collects names of all used globals ("__name") during semantic analysis.
@@ -0,0 +1,367 @@
+/**
+ * @file stream.c
+ * @brief Function-at-a-time pipeline (--stream): peak memory follows the
+ *        largest function, not the whole program.
+ *
+ * @authors Hana Liškařová (xliskah00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "stream.h"
+#include "scanner.h"
+#include "parser.h"
+#include "semantic.h"
+#include "codegen.h"
+#include "options.h"
+#include "budget.h"
+#include "error.h"
+
+#define STREAM_COPY_CHUNK 65536
+
+// Copies the rest of one stream to another
+static bool copy_stream(FILE *from, FILE *to) {
+    char buf[STREAM_COPY_CHUNK];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, from)) > 0)
+        if (fwrite(buf, 1, n, to) != n) return false;
+    return !ferror(from);
+}
+
+// Input readable twice: the stream itself if it can seek, otherwise a copy in a temporary file
+static FILE *rereadable_input(FILE *input, long *start) {
+    *start = ftell(input);
+    if (*start >= 0 && fseek(input, *start, SEEK_SET) == 0) return input;
+
+    FILE *copy = tmpfile();
+    if (copy == NULL) return NULL;
+    if (!copy_stream(input, copy)) {
+        fclose(copy);
+        return NULL;
+    }
+    *start = 0;
+    rewind(copy);
+    return copy;
+}
+
+static char *copy_string(const char *s) {
+    char *copy = malloc(strlen(s) + 1);
+    if (copy) strcpy(copy, s);
+    return copy;
+}
+
+// ---- pre-scan: headers of all members, layout check ----
+
+static bool next_is(scanner_ctx *scan, tokenPtr t, token_type type) {
+    return scanner_ctx_next_token(scan, t) == SUCCESS && t->type == type;
+}
+
+// Next token other than EOL
+static bool next_significant(scanner_ctx *scan, tokenPtr t) {
+    do {
+        if (scanner_ctx_next_token(scan, t) != SUCCESS) return false;
+    } while (t->type == T_EOL);
+    return true;
+}
+
+// import "ifj25" for Ifj, class Name {, EOL
+static bool prescan_prologue(scanner_ctx *scan, tokenPtr t, ast headers) {
+    if (!next_significant(scan, t) || t->type != T_KW_IMPORT) return false;
+    if (!next_is(scan, t, T_STRING) || strcmp(t->value->data, "ifj25") != 0) return false;
+    if (!next_is(scan, t, T_KW_FOR) || !next_is(scan, t, T_IDENT) || strcmp(t->value->data, "Ifj") != 0) return false;
+    if (!next_significant(scan, t) || t->type != T_KW_CLASS || !next_is(scan, t, T_IDENT)) return false;
+
+    ast_class_init(&headers->class_list);
+    ast_block_init(&headers->class_list);
+    headers->class_list->name = copy_string(t->value->data);
+    return headers->class_list->name != NULL && next_is(scan, t, T_LBRACE) && next_is(scan, t, T_EOL);
+}
+
+// Parameter names: (), (a) or (a, b, ...); the active token is '('
+static bool prescan_parameters(scanner_ctx *scan, tokenPtr t, ast_function function) {
+    if (scanner_ctx_next_token(scan, t) != SUCCESS) return false;
+    if (t->type == T_RPAREN) return true;
+    for (;;) {
+        if (t->type != T_IDENT) return false;
+        ast_parameter param = calloc(1, sizeof(struct ast_parameter));
+        if (param == NULL) return false;
+        param->value_type = AST_VALUE_IDENTIFIER;  // only the arity is read
+        param->next = function->parameters;
+        function->parameters = param;
+
+        if (scanner_ctx_next_token(scan, t) != SUCCESS) return false;
+        if (t->type == T_RPAREN) return true;
+        if (t->type != T_COMMA || scanner_ctx_next_token(scan, t) != SUCCESS) return false;
+    }
+}
+
+// Header of one member, its body is only skipped; the active token is 'static'
+static bool prescan_member(scanner_ctx *scan, tokenPtr t, ast headers) {
+    if (!next_is(scan, t, T_IDENT)) return false;
+    char *name = copy_string(t->value->data);
+    if (name == NULL || scanner_ctx_next_token(scan, t) != SUCCESS) {
+        free(name);
+        return false;
+    }
+
+    ast_class class_node = headers->class_list;
+    if (t->type == T_LBRACE) {  // static name { -> getter
+        ast_add_new_node(&class_node, AST_GETTER);
+        class_node->current->current->data.getter.name = name;
+    } else if (t->type == T_ASSIGN) {  // static name = (param) { -> setter
+        ast_add_new_node(&class_node, AST_SETTER);
+        class_node->current->current->data.setter.name = name;
+        if (!next_is(scan, t, T_LPAREN) || !next_is(scan, t, T_IDENT) || !next_is(scan, t, T_RPAREN) ||
+            !next_is(scan, t, T_LBRACE)) return false;
+    } else if (t->type == T_LPAREN) {
+        ast_add_new_node(&class_node, AST_FUNCTION);
+        ast_function function = class_node->current->current->data.function;
+        function->name = name;
+        if (!prescan_parameters(scan, t, function) || !next_is(scan, t, T_LBRACE)) return false;
+    } else {
+        free(name);
+        return false;
+    }
+
+    // Body up to the matching closing brace, the member ends with its line
+    for (int depth = 1; depth > 0;) {
+        if (scanner_ctx_next_token(scan, t) != SUCCESS || t->type == T_EOF) return false;
+        if (t->type == T_LBRACE) depth++;
+        else if (t->type == T_RBRACE) depth--;
+    }
+    return next_is(scan, t, T_EOL);
+}
+
+/**
+ * @brief Reads the whole source once, the headers of its members are added to headers.
+ * @return true for a lexically valid source of one class of static members,
+ *         false if it has to be compiled as a whole.
+ */
+static bool prescan(FILE *input, ast headers) {
+    tokenPtr t = token_create();
+    if (t == NULL) return false;
+    scanner_ctx scan;
+    scanner_ctx_init(&scan, input);
+
+    bool plain = prescan_prologue(&scan, t, headers);
+    while (plain) {
+        if (!next_significant(&scan, t)) plain = false;
+        else if (t->type == T_RBRACE) break;  // end of the class
+        else plain = t->type == T_KW_STATIC && prescan_member(&scan, t, headers);
+    }
+    plain = plain && next_significant(&scan, t) && t->type == T_EOF;
+    token_destroy(t);
+    return plain;
+}
+
+// Names of the headers were copied from the tokens of the pre-scan
+static void headers_dispose(ast headers) {
+    if (headers->class_list) {
+        for (ast_node node = headers->class_list->current->first; node; node = node->next) {
+            if (node->type == AST_FUNCTION) free(node->data.function->name);
+            else if (node->type == AST_GETTER) free(node->data.getter.name);
+            else if (node->type == AST_SETTER) free(node->data.setter.name);
+        }
+        free(headers->class_list->name);
+    }
+    ast_dispose(headers);
+}
+
+// ---- second reading: one member at a time ----
+
+static int append_token(scanner_ctx *scan, DLListTokens *list, tokenPtr *out) {
+    tokenPtr t = token_create();
+    if (t == NULL) return error(ERR_INTERNAL, "Allocation error");
+    int result = scanner_ctx_next_token(scan, t);
+    if (result != SUCCESS) {
+        token_destroy(t);
+        return result;
+    }
+    if (t->type == T_EOF) {
+        token_destroy(t);
+        return error(ERR_INTERNAL, "stream: the source changed after the pre-scan");
+    }
+    DLLTokens_InsertLast(list, t);
+    *out = t;
+    return SUCCESS;
+}
+
+/**
+ * @brief Tokens of the next member: 'static' up to its closing brace, the EOL
+ *        after it and an EOF for the parser. The list stays empty at the end
+ *        of the class.
+ */
+static int read_member(scanner_ctx *scan, DLListTokens *list) {
+    tokenPtr t;
+    do {  // empty lines between members
+        DLLTokens_Dispose(list);
+        int result = append_token(scan, list, &t);
+        if (result != SUCCESS) return result;
+    } while (t->type == T_EOL);
+    if (t->type == T_RBRACE) {  // end of the class
+        DLLTokens_Dispose(list);
+        return SUCCESS;
+    }
+
+    for (int depth = 0;;) {
+        if (t->type == T_LBRACE) depth++;
+        else if (t->type == T_RBRACE && --depth == 0) break;
+        int result = append_token(scan, list, &t);
+        if (result != SUCCESS) return result;
+    }
+
+    int result = append_token(scan, list, &t);
+    tokenPtr eof = token_create();
+    if (eof == NULL) return error(ERR_INTERNAL, "Allocation error");
+    eof->type = T_EOF;
+    DLLTokens_InsertLast(list, eof);
+    return result;
+}
+
+// Skips the tokens of the prologue checked by the pre-scan
+static int skip_prologue(scanner_ctx *scan) {
+    tokenPtr t = token_create();
+    if (t == NULL) return error(ERR_INTERNAL, "Allocation error");
+    int result;
+    do result = scanner_ctx_next_token(scan, t);
+    while (result == SUCCESS && t->type != T_LBRACE && t->type != T_EOF);
+    if (result == SUCCESS) result = scanner_ctx_next_token(scan, t);  // EOL after the brace
+    token_destroy(t);
+    return result;
+}
+
+// Frees the member compiled last, the class block is empty again
+static void drop_members(ast_block root) {
+    ast_node node = root->first;
+    while (node != NULL) {
+        ast_node next = node->next;
+        ast_node_dispose(node);
+        node = next;
+    }
+    root->first = NULL;
+    root->current = NULL;
+}
+
+static void flush_code(generator gen, FILE *output) {
+    fputs(gen->output->data, output);
+    string_clear(gen->output);
+}
+
+/**
+ * @brief Compiles the members of the class in source order.
+ *
+ * A semantic error is kept until the end of the class, a syntax error of a later
+ * member still wins; after an error of Pass 2 the later members run Pass 1 only.
+ *
+ * @param semantic_result result of semantic_stream_begin(), no code is generated unless SUCCESS
+ */
+static int compile_members(scanner_ctx *scan, ast tree, semantic *sem, int semantic_result, generator gen, FILE *output) {
+    ast_block root = tree->class_list->current;
+    bool pass2_failed = false;  // semantic_result comes from Pass 2, Pass 1 of the later members may replace it
+    int result = SUCCESS;
+    for (;;) {
+        DLListTokens tokens;
+        DLLTokens_Init(&tokens);
+        result = read_member(scan, &tokens);
+        if (result != SUCCESS || tokens.length == 0) {
+            DLLTokens_Dispose(&tokens);
+            break;
+        }
+
+        DLLTokens_First(&tokens);
+        result = parser_member(&tokens, tree);
+        ast_node member = root->first;
+        if (result == SUCCESS && (semantic_result == SUCCESS || pass2_failed)) {
+            int pass1 = semantic_stream_pass1(sem, member);
+            if (pass1 != SUCCESS) {
+                semantic_result = pass1;
+                pass2_failed = false;
+            }
+        }
+        if (result == SUCCESS && semantic_result == SUCCESS) {
+            semantic_result = semantic_stream_pass2(sem, member);
+            pass2_failed = semantic_result != SUCCESS;
+        }
+        if (result == SUCCESS && semantic_result == SUCCESS) {
+            generate_stream_function(gen, member);
+            flush_code(gen, output);
+            opt_stats.stream_functions++;
+        }
+
+        // The names in the tree point into the tokens, both go now
+        tree->class_list->current = root;
+        drop_members(root);
+        DLLTokens_Dispose(&tokens);
+        if (result != SUCCESS) return result;
+    }
+    return result != SUCCESS ? result : semantic_result;
+}
+
+// ---- pipeline ----
+
+int stream_compile(FILE *input, FILE *output, FILE *diag, stream_whole_fn whole) {
+    long start;
+    FILE *source = rereadable_input(input, &start);
+    if (source == NULL) return error(ERR_INTERNAL, "stream: cannot keep the source for a second reading");
+
+    ast headers = NULL;
+    ast_init(&headers);
+    bool plain = prescan(source, headers);
+    if (fseek(source, start, SEEK_SET) != 0) {
+        headers_dispose(headers);
+        if (source != input) fclose(source);
+        return error(ERR_INTERNAL, "stream: cannot read the source again");
+    }
+    if (!plain) {
+        headers_dispose(headers);
+        int result = whole(source, output, diag);
+        if (source != input) fclose(source);
+        return result;
+    }
+
+    // Signatures only: the table keeps its own keys, the header tree goes now
+    semantic sem;
+    int semantic_result = semantic_stream_begin(&sem, headers);
+    headers_dispose(headers);
+
+    // The class name is read by the header collection only
+    ast tree = NULL;
+    ast_init(&tree);
+    ast_class_init(&tree->class_list);
+    ast_block_init(&tree->class_list);
+
+    // The code of each function goes to the spool, output gets it only if the whole program compiles
+    generator gen = malloc(sizeof(*gen));
+    FILE *spool = tmpfile();
+    scanner_ctx scan;
+    scanner_ctx_init(&scan, source);
+    int result = gen == NULL ? error(ERR_INTERNAL, "Allocation error") : skip_prologue(&scan);
+    if (result == SUCCESS && spool == NULL) result = error(ERR_INTERNAL, "stream: cannot create the output spool");
+    if (result == SUCCESS) {
+        init_stream_code(gen);
+        if (semantic_result == SUCCESS) flush_code(gen, spool);
+        result = compile_members(&scan, tree, &sem, semantic_result, gen, spool);
+        if (result == SUCCESS) {
+            finish_stream_code(gen);
+            flush_code(gen, spool);
+            rewind(spool);
+            if (!copy_stream(spool, output)) result = error(ERR_INTERNAL, "stream: cannot copy the output spool");
+            if (options.stats) {
+                options_print_stats(diag);
+                budget_report(diag);
+            }
+        }
+        string_destroy(gen->output);
+        string_destroy(gen->scope);
+    }
+
+    if (spool != NULL) fclose(spool);
+    free(gen);
+    semantic_stream_end(&sem);
+    ast_dispose(tree);
+    if (source != input) fclose(source);
+    return result;
+}
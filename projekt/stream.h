@@ -0,0 +1,47 @@
+/**
+ * @file stream.h
+ * @brief Function-at-a-time pipeline (--stream): peak memory follows the
+ *        largest function, not the whole program.
+ *
+ * @authors Hana Liškařová (xliskah00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#ifndef IFJ_STREAM
+#define IFJ_STREAM
+
+#include <stdio.h>
+
+/**
+ * @brief Whole-program pipeline, compiles the inputs --stream cannot split.
+ */
+typedef int (*stream_whole_fn)(FILE *input, FILE *output, FILE *diag);
+
+/**
+ * @brief Compiles a program one function at a time.
+ *
+ * A pre-scan reads the whole input once and keeps only the headers of the
+ * functions, getters and setters (name and arity). The input is then read
+ * again and each member of the class is scanned, parsed, checked, generated,
+ * written to a temporary spool file and freed before the next one is read; only the function
+ * signatures and the registry of globals live across functions. The globals
+ * are defined at the end of the code, which starts with a jump to them.
+ *
+ * The exit code is the one of the whole-program pipeline: syntax errors of any
+ * function win over semantic errors, Pass 1 errors over Pass 2 errors. The spool
+ * is copied to output only when the whole program compiles, so after an error
+ * nothing is written, as with the whole-program pipeline. A lexical error or a source outside
+ * the plain layout (import, one class of static members) is compiled by
+ * @p whole instead.
+ *
+ * A source on a pipe is copied to a temporary file for the second reading.
+ *
+ * @param input  source, read twice
+ * @param output IFJcode25, written after the last function
+ * @param diag   statistics (--stats)
+ * @param whole  pipeline for the sources that cannot be streamed
+ * @return exit code of the compiler
+ */
+int stream_compile(FILE *input, FILE *output, FILE *diag, stream_whole_fn whole);
+
+#endif /* IFJ_STREAM */
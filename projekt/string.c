@@ -91,15 +91,17 @@ bool string_append_char(string str, char c) {
 bool string_append_literal(string str, char *literal) {
     if (literal == NULL)
         return true;
-    while (str->capacity < str->length + strlen(literal)) {
+    size_t len = strlen(literal);
+    while (str->capacity < str->length + len) {
         if (!__double_string(str)) {
             error(ERR_INTERNAL, "Memory alocation error");
             return false;
         }
     }
 
-    strcpy(str->data + str->length, literal);
-    str->length = strlen(str->data);
+    // the length is known, no rescan of the whole string (appending stays linear)
+    memcpy(str->data + str->length, literal, len + 1);
+    str->length += len;
     return true;
 }
 
@@ -9,6 +9,10 @@
 #include "symtable.h"
 #include "string.h"
 
+// Slot arrays of freed tables, already empty; they outlive a compilation (--daemon)
+static st_symbol *slot_pool[SYMTABLE_POOL];
+static unsigned pooled = 0;
+
 /**
  * @brief Duplicates a string by allocating new memory.
  * @param s Input string to duplicate.
@@ -46,17 +50,12 @@ symtable *st_init(void) {
     symtable *table = malloc(sizeof(symtable));
     if (table == NULL) return NULL;
 
-    table->table = calloc(SYMTABLE_SIZE, sizeof(st_symbol));
+    // calloc() leaves every slot empty (false/NULL); the pages are only touched on insert
+    table->table = pooled > 0 ? slot_pool[--pooled] : calloc(SYMTABLE_SIZE, sizeof(st_symbol));
     if (table->table == NULL) {
         free(table);
         return NULL;
     }
-    for (int i = 0; i < SYMTABLE_SIZE; i++) {
-        table->table[i].occupied = false;
-        table->table[i].deleted = false;
-        table->table[i].key = NULL;
-        table->table[i].data = NULL;
-    }
 
     table->size = 0;
     return table;
@@ -152,13 +151,23 @@ st_data *st_get(symtable *table, char *key) {
 void st_free(symtable *table) {
     if (!table) return;
 
-    for (int i = 0; i < SYMTABLE_SIZE; i++) {
+    // stops after the last symbol, a scope with few locals does not read the whole table
+    unsigned left = table->size;
+    for (int i = 0; i < SYMTABLE_SIZE && left > 0; i++) {
         if (table->table[i].occupied) {
             free(table->table[i].key);
+            if (table->table[i].data) {  // signatures own their names
+                string_destroy(table->table[i].data->ID);
+                string_destroy(table->table[i].data->scope_name);
+            }
             free(table->table[i].data);
+            memset(&table->table[i], 0, sizeof(st_symbol));
+            left--;
         }
     }
-    free(table->table);
+    // the array is empty again, the next table takes it without a new calloc()
+    if (pooled < SYMTABLE_POOL) slot_pool[pooled++] = table->table;
+    else free(table->table);
     free(table);
 }
 
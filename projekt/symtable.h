@@ -20,6 +20,7 @@
 #include "ast.h"
 
 #define SYMTABLE_SIZE 16381
+#define SYMTABLE_POOL 8      // emptied slot arrays kept by st_free() for the next st_init()
 
 /**
  * @brief Data type enumeration.
@@ -149,10 +149,10 @@ void DLLTokens_First(DLListTokens *list) {
     list->active = list->first;
 }
 
-/// @brief sets active token to the next token
+/// @brief sets active token to the next token, the last token (EOF) stays active
 /// @param list pointer to the list
 void DLLTokens_Next(DLListTokens *list) {
-    if (list->active != NULL) {
+    if (list->active != NULL && list->active->next != NULL) {
         list->active = list->active->next;
     }
 }
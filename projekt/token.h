@@ -146,7 +146,7 @@ void DLLTokens_InsertLast(DLListTokens *list, tokenPtr t);
 /// @param list pointer to the list
 void DLLTokens_First(DLListTokens *list);
 
-/// @brief sets active token to the next token
+/// @brief sets active token to the next token, the last token (EOF) stays active
 /// @param list pointer to the list
 void DLLTokens_Next(DLListTokens *list);
 
@@ -0,0 +1,467 @@
+/**
+ * @file microbench.c
+ * @brief Microbenchmarks of the compiler components (`make microbench`).
+ *
+ * Times the scanner, the symbol table, the scope stack, the dynamic strings and
+ * the instruction emitter of the code generator on fixed inputs. Every benchmark
+ * is warmed up, then repeated; the report gives percentiles of the repetition
+ * time, the time per item and the allocations per repetition as JSON, so two
+ * runs (e.g. two commits) can be compared.
+ *
+ * Allocations are counted by wrapping malloc/calloc/realloc at link time
+ * (`-Wl,--wrap=...`), so only the calls made by the project code are seen.
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../projekt/scanner.h"
+#include "../../projekt/token.h"
+#include "../../projekt/string.h"
+#include "../../projekt/symtable.h"
+#include "../../projekt/scope_stack.h"
+#include "../../projekt/codegen.h"
+#include "../../projekt/error.h"
+
+// Functions of codegen.c without a declaration in codegen.h
+char *escape_string_literal(const char *original_str);
+void binary_operation(generator gen, char *op, char *result, char *left, char *right);
+void move_var(generator gen, char *var1, char *var2);
+void label(generator gen, char *label);
+void add_jumpifeq(generator gen, char *label, char *symb1, char *symb2);
+void create_gen(generator gen);
+
+// ===== allocation counting =====
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+static unsigned long long alloc_calls;
+static unsigned long long alloc_bytes;
+
+void *__wrap_malloc(size_t size) {
+    alloc_calls++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_calls++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    alloc_calls++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+// ===== harness =====
+
+/// @brief One benchmark: prepare and release run around every repetition, untimed
+typedef struct bench {
+    const char *name;
+    void (*setup)(void);    // once before the warm-up, may be NULL
+    void (*prepare)(void);  // before every repetition, may be NULL
+    size_t (*run)(void);    // timed part, returns the number of items processed
+    void (*release)(void);  // after every repetition, may be NULL
+    void (*teardown)(void); // once after the last repetition, may be NULL
+} bench;
+
+static unsigned opt_reps = 30;
+static unsigned opt_warmup = 3;
+static unsigned opt_scale = 1;
+static const char *opt_filter = NULL;
+static const char *opt_label = "";
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const double *sorted, unsigned n, double p) {
+    unsigned rank = (unsigned)(p / 100.0 * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static void run_bench(const bench *b, bool *first) {
+    if (opt_filter && !strstr(b->name, opt_filter)) return;
+    double *samples = malloc(opt_reps * sizeof(double));
+    if (!samples) exit(ERR_INTERNAL);
+
+    if (b->setup) b->setup();
+    for (unsigned i = 0; i < opt_warmup; i++) {
+        if (b->prepare) b->prepare();
+        b->run();
+        if (b->release) b->release();
+    }
+
+    size_t items = 0;
+    unsigned long long calls = 0, bytes = 0;
+    double total = 0;
+    for (unsigned i = 0; i < opt_reps; i++) {
+        if (b->prepare) b->prepare();
+        unsigned long long calls0 = alloc_calls, bytes0 = alloc_bytes;
+        double start = now_ns();
+        items = b->run();
+        samples[i] = now_ns() - start;
+        calls += alloc_calls - calls0;
+        bytes += alloc_bytes - bytes0;
+        total += samples[i];
+        if (b->release) b->release();
+    }
+    if (b->teardown) b->teardown();
+
+    qsort(samples, opt_reps, sizeof(double), cmp_double);
+    double p50 = percentile(samples, opt_reps, 50);
+    printf("%s\n    {\"name\": \"%s\", \"items\": %zu, \"reps\": %u,\n", *first ? "" : ",", b->name, items, opt_reps);
+    printf("     \"ns\": {\"min\": %.0f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f, \"mean\": %.0f},\n",
+           samples[0], p50, percentile(samples, opt_reps, 90), percentile(samples, opt_reps, 99),
+           samples[opt_reps - 1], total / opt_reps);
+    printf("     \"ns_per_item_p50\": %.2f, \"allocs_per_rep\": %.1f, \"alloc_bytes_per_rep\": %.0f}",
+           items ? p50 / (double)items : 0.0, (double)calls / opt_reps, (double)bytes / opt_reps);
+    *first = false;
+    free(samples);
+}
+
+// ===== scanner =====
+
+static char *scan_input;
+static size_t scan_length;
+
+static void scan_make(const char *unit, unsigned repeat) {
+    size_t len = strlen(unit);
+    scan_length = len * repeat;
+    scan_input = malloc(scan_length + 1);
+    if (!scan_input) exit(ERR_INTERNAL);
+    for (unsigned i = 0; i < repeat; i++) memcpy(scan_input + i * len, unit, len);
+    scan_input[scan_length] = '\0';
+}
+
+static void scan_program_setup(void) {
+    scan_make("static f(a, b) {\n"
+              "    var x = a * 2 + b / 3.5e1\n"
+              "    if (x >= 10) {\n"
+              "        Ifj.write(\"x = \\n\")\n"
+              "    } else {\n"
+              "        x = 0x1F // comment\n"
+              "    }\n"
+              "    return x is Num\n"
+              "}\n", 200 * opt_scale);
+}
+
+static void scan_identifiers_setup(void) {
+    scan_make("alpha_beta gamma_1 __global_x delta epsilon_long_identifier_name var while\n", 400 * opt_scale);
+}
+
+static void scan_numbers_setup(void) {
+    scan_make("1 23 456789 4.5 6e3 1.25E-2 0xFF 0x7fffffff\n", 400 * opt_scale);
+}
+
+static void scan_strings_setup(void) {
+    scan_make("\"a string with \\t escapes \\x41 and # chars\" \"\"\"multi\nline\n  string\"\"\"\n", 400 * opt_scale);
+}
+
+static void scan_eols_setup(void) {
+    scan_make("/* block /* nested */ comment */\n\n\n// line comment\n\n\nx\n", 400 * opt_scale);
+}
+
+static size_t scan_run(void) {
+    FILE *in = fmemopen(scan_input, scan_length, "r");
+    if (!in) exit(ERR_INTERNAL);
+    scanner_init(in);
+    tokenPtr tok = token_create();
+    size_t tokens = 0;
+    while (get_next_token(tok) == SUCCESS && tok->type != T_EOF) tokens++;
+    token_destroy(tok);
+    scanner_destroy();
+    fclose(in);
+    return tokens;
+}
+
+static void scan_teardown(void) {
+    free(scan_input);
+    scan_input = NULL;
+}
+
+// ===== symbol table =====
+
+#define ST_KEYS 1000
+
+static char st_keys[ST_KEYS][16];
+static char st_misses[ST_KEYS][16];
+static symtable *st_table;
+
+static void st_keys_setup(void) {
+    for (unsigned i = 0; i < ST_KEYS; i++) {
+        snprintf(st_keys[i], sizeof st_keys[i], "var_%u", i);
+        snprintf(st_misses[i], sizeof st_misses[i], "miss_%u", i);
+    }
+}
+
+static void st_filled_setup(void) {
+    st_keys_setup();
+    st_table = st_init();
+    for (unsigned i = 0; i < ST_KEYS; i++) st_insert(st_table, st_keys[i], ST_VAR, true);
+}
+
+static void st_empty_prepare(void) { st_table = st_init(); }
+
+static void st_table_free(void) {
+    st_free(st_table);
+    st_table = NULL;
+}
+
+static size_t st_insert_run(void) {
+    for (unsigned i = 0; i < ST_KEYS; i++) st_insert(st_table, st_keys[i], ST_VAR, true);
+    return ST_KEYS;
+}
+
+static size_t st_hit_run(void) {
+    size_t found = 0;
+    for (unsigned i = 0; i < ST_KEYS; i++) found += st_find(st_table, st_keys[i]) != NULL;
+    return found;
+}
+
+static size_t st_miss_run(void) {
+    size_t missed = 0;
+    for (unsigned i = 0; i < ST_KEYS; i++) missed += st_find(st_table, st_misses[i]) == NULL;
+    return missed;
+}
+
+static size_t st_init_run(void) {
+    st_table = st_init();
+    return 1;
+}
+
+// ===== scope stack =====
+
+#define SCOPE_LOCALS 4
+#define SCOPE_LOOKUPS 1000
+
+static scope_stack scopes;
+static unsigned scope_depth;
+
+static void scopes_fill(unsigned depth) {
+    char name[32];
+    scope_depth = depth;
+    scopes_init(&scopes);
+    for (unsigned d = 0; d < depth; d++) {
+        scopes_push(&scopes);
+        for (unsigned i = 0; i < SCOPE_LOCALS; i++) {
+            snprintf(name, sizeof name, "v%u_%u", d, i);
+            scopes_declare_local(&scopes, name, true);
+        }
+    }
+}
+
+static void scopes_empty(void) {
+    while (scopes_pop(&scopes)) {}
+    scopes_dispose(&scopes);
+}
+
+static void scopes_d1(void) { scopes_fill(1); }
+static void scopes_d8(void) { scopes_fill(8); }
+static void scopes_d64(void) { scopes_fill(64); }
+
+static size_t scopes_push_pop_run(void) {
+    for (unsigned d = 0; d < scope_depth; d++) scopes_push(&scopes);
+    for (unsigned d = 0; d < scope_depth; d++) scopes_pop(&scopes);
+    return scope_depth;
+}
+
+// Name declared in the outermost frame: the lookup walks all frames
+static size_t scopes_outer_run(void) {
+    size_t found = 0;
+    for (unsigned i = 0; i < SCOPE_LOOKUPS; i++) found += scopes_lookup(&scopes, "v0_1") != NULL;
+    return found;
+}
+
+static size_t scopes_inner_run(void) {
+    char name[32];
+    snprintf(name, sizeof name, "v%u_1", scope_depth - 1);
+    size_t found = 0;
+    for (unsigned i = 0; i < SCOPE_LOOKUPS; i++) found += scopes_lookup(&scopes, name) != NULL;
+    return found;
+}
+
+static size_t scopes_miss_run(void) {
+    size_t missed = 0;
+    for (unsigned i = 0; i < SCOPE_LOOKUPS; i++) missed += scopes_lookup(&scopes, "missing") == NULL;
+    return missed;
+}
+
+// ===== dynamic strings =====
+
+#define STR_CHARS 65536
+#define STR_LITERALS 8192
+#define STR_CONCATS 256
+
+static string str_target;
+static string str_block;
+
+static void str_prepare(void) { str_target = string_create(0); }
+
+static void str_release(void) {
+    string_destroy(str_target);
+    str_target = NULL;
+}
+
+static void str_block_setup(void) {
+    str_block = string_create(0);
+    for (unsigned i = 0; i < 1024; i++) string_append_char(str_block, (char)('a' + i % 26));
+}
+
+static void str_block_teardown(void) { string_destroy(str_block); }
+
+static size_t str_char_run(void) {
+    for (unsigned i = 0; i < STR_CHARS; i++) string_append_char(str_target, (char)('a' + i % 26));
+    return STR_CHARS;
+}
+
+static size_t str_literal_run(void) {
+    for (unsigned i = 0; i < STR_LITERALS; i++) string_append_literal(str_target, "MOVE LF@x ");
+    return STR_LITERALS;
+}
+
+static size_t str_concat_run(void) {
+    for (unsigned i = 0; i < STR_CONCATS; i++) string_concat(str_target, str_block);
+    return STR_CONCATS;
+}
+
+// ===== instruction emission =====
+
+#define EMIT_COUNT 4096
+#define ESCAPE_LENGTH 4096
+
+static struct generator emit_gen;
+static char escape_input[ESCAPE_LENGTH + 1];
+
+static void emit_setup(void) {
+    create_gen(&emit_gen);
+    // printable text with spaces, newlines, '#' and '\' mixed in, as in string literals
+    static const char sample[] = "Hello, world! # tab\there \\ newline\n and some more plain text ";
+    for (unsigned i = 0; i < ESCAPE_LENGTH; i++) escape_input[i] = sample[i % (sizeof sample - 1)];
+    escape_input[ESCAPE_LENGTH] = '\0';
+}
+
+static void emit_release(void) { string_clear(emit_gen.output); }
+
+static void emit_teardown(void) {
+    string_destroy(emit_gen.output);
+    string_destroy(emit_gen.scope);
+}
+
+static size_t emit_binary_run(void) {
+    for (unsigned i = 0; i < EMIT_COUNT; i++) binary_operation(&emit_gen, "ADD", "result", "left", "int@1");
+    return EMIT_COUNT;
+}
+
+static size_t emit_move_run(void) {
+    for (unsigned i = 0; i < EMIT_COUNT; i++) move_var(&emit_gen, "__global", "local");
+    return EMIT_COUNT;
+}
+
+static size_t emit_branch_run(void) {
+    for (unsigned i = 0; i < EMIT_COUNT; i++) {
+        label(&emit_gen, "main$0%loop");
+        add_jumpifeq(&emit_gen, "main$0%end", "cond", "bool@false");
+    }
+    return 2 * EMIT_COUNT;
+}
+
+static size_t emit_escape_run(void) {
+    char *escaped = escape_string_literal(escape_input);
+    string_append_literal(emit_gen.output, escaped);
+    free(escaped);
+    return ESCAPE_LENGTH;
+}
+
+// ===== driver =====
+
+static const bench benches[] = {
+    {"scanner/program", scan_program_setup, NULL, scan_run, NULL, scan_teardown},
+    {"scanner/identifiers", scan_identifiers_setup, NULL, scan_run, NULL, scan_teardown},
+    {"scanner/numbers", scan_numbers_setup, NULL, scan_run, NULL, scan_teardown},
+    {"scanner/strings", scan_strings_setup, NULL, scan_run, NULL, scan_teardown},
+    {"scanner/comments_eols", scan_eols_setup, NULL, scan_run, NULL, scan_teardown},
+    {"symtable/init", NULL, NULL, st_init_run, st_table_free, NULL},
+    {"symtable/insert", st_keys_setup, st_empty_prepare, st_insert_run, st_table_free, NULL},
+    {"symtable/find_hit", st_filled_setup, NULL, st_hit_run, NULL, st_table_free},
+    {"symtable/find_miss", st_filled_setup, NULL, st_miss_run, NULL, st_table_free},
+    {"scopes/push_pop/depth1", scopes_d1, NULL, scopes_push_pop_run, NULL, scopes_empty},
+    {"scopes/push_pop/depth8", scopes_d8, NULL, scopes_push_pop_run, NULL, scopes_empty},
+    {"scopes/push_pop/depth64", scopes_d64, NULL, scopes_push_pop_run, NULL, scopes_empty},
+    {"scopes/lookup_outer/depth1", scopes_d1, NULL, scopes_outer_run, NULL, scopes_empty},
+    {"scopes/lookup_outer/depth8", scopes_d8, NULL, scopes_outer_run, NULL, scopes_empty},
+    {"scopes/lookup_outer/depth64", scopes_d64, NULL, scopes_outer_run, NULL, scopes_empty},
+    {"scopes/lookup_inner/depth64", scopes_d64, NULL, scopes_inner_run, NULL, scopes_empty},
+    {"scopes/lookup_miss/depth1", scopes_d1, NULL, scopes_miss_run, NULL, scopes_empty},
+    {"scopes/lookup_miss/depth8", scopes_d8, NULL, scopes_miss_run, NULL, scopes_empty},
+    {"scopes/lookup_miss/depth64", scopes_d64, NULL, scopes_miss_run, NULL, scopes_empty},
+    {"string/append_char", NULL, str_prepare, str_char_run, str_release, NULL},
+    {"string/append_literal", NULL, str_prepare, str_literal_run, str_release, NULL},
+    {"string/concat", str_block_setup, str_prepare, str_concat_run, str_release, str_block_teardown},
+    {"codegen/binary_operation", emit_setup, NULL, emit_binary_run, emit_release, emit_teardown},
+    {"codegen/move_var", emit_setup, NULL, emit_move_run, emit_release, emit_teardown},
+    {"codegen/label_jumpifeq", emit_setup, NULL, emit_branch_run, emit_release, emit_teardown},
+    {"codegen/escape_string_literal", emit_setup, NULL, emit_escape_run, emit_release, emit_teardown},
+};
+
+static bool parse_unsigned(const char *arg, const char *flag, unsigned *out) {
+    size_t len = strlen(flag);
+    if (strncmp(arg, flag, len) != 0) return false;
+    char *end;
+    unsigned long value = strtoul(arg + len, &end, 10);
+    if (*end != '\0' || end == arg + len) {
+        fprintf(stderr, "microbench: bad value in %s\n", arg);
+        exit(ERR_INTERNAL);
+    }
+    *out = (unsigned)value;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (parse_unsigned(argv[i], "--reps=", &opt_reps) ||
+            parse_unsigned(argv[i], "--warmup=", &opt_warmup) ||
+            parse_unsigned(argv[i], "--scale=", &opt_scale)) continue;
+        if (strncmp(argv[i], "--filter=", 9) == 0) opt_filter = argv[i] + 9;
+        else if (strncmp(argv[i], "--label=", 8) == 0) opt_label = argv[i] + 8;
+        else {
+            fprintf(stderr, "usage: %s [--reps=N] [--warmup=N] [--scale=N] [--filter=TEXT] [--label=TEXT]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (opt_reps == 0) {
+        fprintf(stderr, "microbench: --reps must be positive\n");
+        return 1;
+    }
+
+    printf("{\"label\": \"%s\", \"reps\": %u, \"warmup\": %u, \"scale\": %u,\n \"benchmarks\": [",
+           opt_label, opt_reps, opt_warmup, opt_scale);
+    bool first = true;
+    for (size_t i = 0; i < sizeof benches / sizeof benches[0]; i++) run_bench(&benches[i], &first);
+    printf("\n]}\n");
+    return 0;
+}
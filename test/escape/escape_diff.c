@@ -0,0 +1,96 @@
+/**
+ * @file escape_diff.c
+ * @brief Differential test of the string-literal escaper (`make test-escape`).
+ *
+ * Compares escape_literal() and escape_literal_scalar() with the original
+ * byte-by-byte sprintf("\\%03d") escaping on random byte strings (NUL, control
+ * bytes, `#`, `\`, bytes above 127) of many lengths, starting at every offset
+ * of a vector block. Bytes written past ESCAPE_MAX_LENGTH(len) are reported too.
+ * Prints the implementation tested and the number of strings, exits 1 on a difference.
+ *
+ * Usage: escape_diff [ROUNDS] [SEED]
+ *
+ * @authors Šimon Dufek (xdufeks00)
+ * @note  Project: IFJ / BUT FIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../projekt/escape.h"
+
+#define MAX_LEN 300
+#define GUARD   64      // canary bytes after the output buffer
+#define CANARY  0x5a
+
+static unsigned long long state;
+
+static unsigned next_random(void) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(state >> 33);
+}
+
+// The escaping of codegen.c before the escaper, kept as the reference
+static size_t reference(char *out, const unsigned char *text, size_t len) {
+    char *current = out;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char ch = text[i];
+        if (ch <= 32 || ch == 35 || ch == 92) {
+            current += sprintf(current, "\\%03d", ch);
+        } else {
+            *current++ = ch;
+        }
+    }
+    return (size_t)(current - out);
+}
+
+// Random byte: mostly plain text with escaped bytes sprinkled in, sometimes any byte
+static unsigned char random_byte(unsigned density) {
+    static const unsigned char special[] = { 0, 9, 10, 31, 32, 33, '#', '\\', 34, 91, 93, 127, 128, 255 };
+    unsigned r = next_random() % 100;
+    if (r < density) return special[next_random() % sizeof special];
+    if (r < density + 10) return (unsigned char)next_random();
+    return (unsigned char)('a' + next_random() % 26);
+}
+
+static int check(const char *name, size_t (*escape)(char *, const char *, size_t),
+                 const unsigned char *text, size_t len, const char *expected, size_t expected_len) {
+    static char out[ESCAPE_MAX_LENGTH(MAX_LEN) + GUARD];
+    memset(out, CANARY, sizeof out);
+    size_t written = escape(out, (const char *)text, len);
+    if (written != expected_len || memcmp(out, expected, written) != 0) {
+        fprintf(stderr, "%s: different output for %zu bytes (%zu, expected %zu)\n", name, len, written, expected_len);
+        return 1;
+    }
+    for (size_t i = ESCAPE_MAX_LENGTH(len); i < sizeof out; i++)
+        if ((unsigned char)out[i] != CANARY) {
+            fprintf(stderr, "%s: byte %zu written past the buffer of %zu bytes\n", name, i, len);
+            return 1;
+        }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    state = argc > 2 ? strtoull(argv[2], NULL, 10) : 2025;
+
+    static unsigned char buffer[MAX_LEN + 32];
+    static char expected[ESCAPE_MAX_LENGTH(MAX_LEN) + 1];
+    unsigned long strings = 0;
+    int failed = 0;
+
+    for (unsigned long round = 0; round < rounds && !failed; round++) {
+        size_t len = round < MAX_LEN ? round : next_random() % (MAX_LEN + 1);
+        size_t offset = round % 32;  // every alignment of the input
+        unsigned density = next_random() % 4 == 0 ? 0 : next_random() % 60;
+        unsigned char *text = buffer + offset;
+        for (size_t i = 0; i < len; i++) text[i] = random_byte(density);
+
+        size_t expected_len = reference(expected, text, len);
+        failed |= check(escape_implementation(), escape_literal, text, len, expected, expected_len);
+        failed |= check("scalar", escape_literal_scalar, text, len, expected, expected_len);
+        strings++;
+    }
+    printf("%s %lu\n", escape_implementation(), strings);
+    return failed;
+}
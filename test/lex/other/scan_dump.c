@@ -1,5 +1,10 @@
 // test/scan_dump.c
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "../../../projekt/scanner.h"
 #include "../../../projekt/token.h"
 #include "../../../projekt/string.h"
@@ -76,22 +81,56 @@ static const char* tt(int t) {
 // pokud ho máte jinak pojmenovaný, uprav deklaraci:
 extern const char *tt(int type);
 
-int main(int argc, char **argv)
+// push-mode scanner: "-" reads stdin as the bytes arrive, --chunk=N feeds a file N bytes at a time
+static int scan_pushed(int fd, size_t chunk, DLListTokens *list)
 {
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s <input-file>\n", argv[0]);
-        return 1;
+    char *buf = malloc(chunk);
+    if (!buf) return ERR_INTERNAL;
+
+    scanner_ctx ctx;
+    scanner_ctx_init_push(&ctx);
+    DLLTokens_Init(list);
+
+    int status = SUCCESS;
+    ssize_t n;
+    while (status == SUCCESS && (n = read(fd, buf, chunk)) > 0) {
+        status = scanner_feed(&ctx, buf, (size_t)n, list);
     }
+    int fin = scanner_finish(&ctx, list);
+    free(buf);
+    return status != SUCCESS ? status : fin;
+}
 
-    FILE *f = fopen(argv[1], "rb");
-    if (!f) {
-        perror("fopen");
+int main(int argc, char **argv)
+{
+    size_t chunk = 0;
+    if (argc == 3 && strncmp(argv[1], "--chunk=", 8) == 0) {
+        chunk = (size_t)strtoul(argv[1] + 8, NULL, 10);
+        argv++;
+        argc--;
+    }
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s [--chunk=N] <input-file>|-\n", argv[0]);
         return 1;
     }
 
     DLListTokens list;
-    int status = scanner(f, &list);
-    fclose(f);
+    int status;
+    if (strcmp(argv[1], "-") == 0) {
+        status = scan_pushed(STDIN_FILENO, chunk ? chunk : 4096, &list);
+    } else {
+        FILE *f = fopen(argv[1], "rb");
+        if (!f) {
+            perror("fopen");
+            return 1;
+        }
+        if (chunk > 0) {
+            status = scan_pushed(fileno(f), chunk, &list);
+        } else {
+            status = scanner(f, &list);
+        }
+        fclose(f);
+    }
 
     if (status != SUCCESS) {
         fprintf(stderr, "scanner() failed with code %d\n", status);
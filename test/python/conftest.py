@@ -1,5 +1,5 @@
 # -*- coding: utf-8 -*-
-import os, re, pathlib, subprocess, pytest
+import os, re, pathlib, shutil, subprocess, pytest
 
 # Kořen repa – rozumné defaulty
 REPO_ROOT = pathlib.Path(__file__).resolve().parents[2] if len(pathlib.Path(__file__).resolve().parents) >= 3 else pathlib.Path.cwd()
@@ -95,3 +95,45 @@ def supports_stdin(bin_path) -> bool:
         return True
     except Exception:
         return False
+
+# ====== překladač a interpret IFJcode25 (testy generátoru kódu) ======
+def _compiler_candidates():
+    env = os.environ.get("COMPILER_BIN")
+    if env:
+        yield pathlib.Path(env)
+    yield REPO_ROOT / "projekt" / "compiler"
+    yield REPO_ROOT / "build" / "compiler"
+
+@pytest.fixture(scope="session")
+def COMPILER():
+    for p in _compiler_candidates():
+        if p.exists():
+            return p
+    pytest.skip("Set COMPILER_BIN or build projekt/compiler")
+
+@pytest.fixture(scope="session")
+def INTERPRET():
+    """Interpret IFJcode25 (IC25INT=cesta), bez něj se běhové testy přeskočí."""
+    env = os.environ.get("IC25INT")
+    if env:
+        return env
+    return shutil.which("ic25int")
+
+@pytest.fixture(scope="session")
+def GEN(DATA_ROOT):
+    return DATA_ROOT / "gen"
+
+# ====== tenký klient kompilačního démona (test_daemon.py) ======
+def _client_candidates():
+    env = os.environ.get("CLIENT_BIN")
+    if env:
+        yield pathlib.Path(env)
+    yield REPO_ROOT / "projekt" / "compiler_client"
+    yield REPO_ROOT / "build" / "compiler_client"
+
+@pytest.fixture(scope="session")
+def CLIENT():
+    for p in _client_candidates():
+        if p.exists():
+            return p
+    pytest.skip("Set CLIENT_BIN or build projekt/compiler_client")
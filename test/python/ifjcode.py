@@ -0,0 +1,307 @@
+# -*- coding: utf-8 -*-
+"""Lokální interpret IFJcode25 pro testy: výstup, návratový kód a počty provedených instrukcí.
+
+Použití: python3 ifjcode.py program.ifjcode < vstup
+(výstup programu na stdout, počty instrukcí na stderr, návratový kód interpretu jako exit code).
+"""
+import sys
+from collections import namedtuple
+
+# výsledek běhu; rc je kód EXIT, 0 nebo kód běhové chyby interpretu (52–58),
+# STEP_LIMIT_RC pokud program nedoběhl v limitu instrukcí
+Run = namedtuple("Run", "rc stdout steps jumps message")
+STEP_LIMIT = 50_000_000
+STEP_LIMIT_RC = -1
+
+class RuntimeFault(Exception):
+    def __init__(self, code, msg=""):
+        super().__init__(msg)
+        self.code = code
+
+UNINIT = object()  # proměnná po DEFVAR bez hodnoty
+
+# počty operandů instrukcí
+ARITY = {op: n for n, ops in enumerate((
+    "CREATEFRAME PUSHFRAME POPFRAME RETURN CLEARS ADDS SUBS MULS DIVS IDIVS LTS GTS EQS ANDS ORS NOTS BREAK",
+    "DEFVAR CALL PUSHS POPS WRITE LABEL JUMP EXIT DPRINT",
+    "MOVE INT2FLOAT FLOAT2INT INT2CHAR INT2STR FLOAT2STR READ STRLEN TYPE NOT",
+    "ADD SUB MUL DIV IDIV LT GT EQ AND OR STRI2INT CONCAT GETCHAR SETCHAR JUMPIFEQ JUMPIFNEQ",
+)) for op in ops.split()}
+
+def unescape(s: str) -> str:
+    out, i = [], 0
+    while i < len(s):
+        if s[i] == '\\':
+            out.append(chr(int(s[i + 1:i + 4])))
+            i += 4
+        else:
+            out.append(s[i])
+            i += 1
+    return ''.join(out)
+
+def parse_operand(tok: str):
+    """Konstanta ('c', hodnota) nebo proměnná ('v', rámec, jméno)."""
+    kind, _, v = tok.partition('@')
+    if kind == 'int':
+        return ('c', int(v, 0) if not v.lstrip('-').isdigit() else int(v))
+    if kind == 'float':
+        try:
+            return ('c', float.fromhex(v))
+        except ValueError:
+            return ('c', float(v))
+    if kind == 'string':
+        return ('c', unescape(v))
+    if kind == 'bool':
+        return ('c', v == 'true')
+    if kind == 'nil':
+        return ('c', None)
+    if kind in ('GF', 'LF', 'TF'):
+        return ('v', kind, v)
+    raise RuntimeFault(32, "bad operand " + tok)
+
+def type_name(v) -> str:
+    if v is None: return 'nil'
+    if v is True or v is False: return 'bool'
+    if isinstance(v, int): return 'int'
+    if isinstance(v, float): return 'float'
+    return 'string'
+
+def format_value(v) -> str:
+    if v is None: return 'null'
+    if v is True: return 'true'
+    if v is False: return 'false'
+    if isinstance(v, float):
+        # printf("%a") v C nevypisuje koncové nuly mantisy
+        mant, _, exp = float.hex(v).partition('p')
+        if '.' in mant:
+            mant = mant.rstrip('0').rstrip('.')
+        return mant + 'p' + exp
+    return str(v)
+
+class Machine:
+    def __init__(self, code: str, stdin: str):
+        self.prog, self.labels = [], {}
+        first = True
+        for ln in code.split('\n'):
+            ln = ln.split('#', 1)[0].strip()
+            if not ln:
+                continue
+            if first:
+                if ln.upper() != '.IFJCODE25':
+                    raise RuntimeFault(21, "missing header")
+                first = False
+                continue
+            parts = ln.split()
+            op, args = parts[0].upper(), parts[1:]
+            if op not in ARITY:
+                raise RuntimeFault(22, "unknown opcode " + op)
+            if len(args) != ARITY[op]:
+                raise RuntimeFault(23, "%s expects %d operands" % (op, ARITY[op]))
+            if op == 'LABEL':
+                if args[0] in self.labels:
+                    raise RuntimeFault(52, "duplicate label " + args[0])
+                self.labels[args[0]] = len(self.prog)
+            self.prog.append((op, args, [parse_operand(a) if '@' in a else a for a in args]))
+        self.gf, self.lfs, self.tf = {}, [], None
+        self.stack, self.calls = [], []
+        self.stdin = stdin.split('\n') if stdin else []
+        self.stdin_pos = 0
+        self.out = []
+        self.steps = self.jumps = 0
+
+    def frame(self, f):
+        if f == 'GF': return self.gf
+        if f == 'LF':
+            if not self.lfs: raise RuntimeFault(55, "no LF")
+            return self.lfs[-1]
+        if self.tf is None: raise RuntimeFault(55, "no TF")
+        return self.tf
+
+    def get(self, o):
+        if o[0] == 'c': return o[1]
+        fr = self.frame(o[1])
+        if o[2] not in fr: raise RuntimeFault(54, "undefined var " + o[2])
+        v = fr[o[2]]
+        if v is UNINIT: raise RuntimeFault(56, "uninit var " + o[2])
+        return v
+
+    def set(self, o, v):
+        if o[0] != 'v': raise RuntimeFault(53, "not a var")
+        fr = self.frame(o[1])
+        if o[2] not in fr: raise RuntimeFault(54, "undefined var " + o[2])
+        fr[o[2]] = v
+
+    def target(self, label):
+        if label not in self.labels: raise RuntimeFault(52, "undefined label " + label)
+        return self.labels[label]
+
+    def compare(self, op, a, b):
+        ta, tb = type_name(a), type_name(b)
+        if op == 'EQ':
+            if ta == 'nil' or tb == 'nil':
+                return a is None and b is None
+            if ta != tb: raise RuntimeFault(53, "EQ types %s %s" % (ta, tb))
+            return a == b
+        if ta != tb or ta == 'nil': raise RuntimeFault(53, "%s types %s %s" % (op, ta, tb))
+        return a < b if op == 'LT' else a > b
+
+    def arith(self, op, a, b):
+        ta, tb = type_name(a), type_name(b)
+        if op in ('AND', 'OR'):
+            if ta != 'bool' or tb != 'bool': raise RuntimeFault(53, op)
+            return (a and b) if op == 'AND' else (a or b)
+        if ta != tb or ta not in ('int', 'float'): raise RuntimeFault(53, "%s types %s %s" % (op, ta, tb))
+        if op == 'ADD': return a + b
+        if op == 'SUB': return a - b
+        if op == 'MUL': return a * b
+        if op == 'DIV':
+            if ta != 'float': raise RuntimeFault(53, "DIV int")
+            if b == 0: raise RuntimeFault(57, "division by zero")
+            return a / b
+        if ta != 'int': raise RuntimeFault(53, "IDIV float")
+        if b == 0: raise RuntimeFault(57, "division by zero")
+        q = abs(a) // abs(b)
+        return q if (a >= 0) == (b >= 0) else -q
+
+    def read(self, kind):
+        if self.stdin_pos >= len(self.stdin) or (self.stdin_pos == len(self.stdin) - 1 and self.stdin[-1] == ''):
+            return None
+        ln = self.stdin[self.stdin_pos]
+        self.stdin_pos += 1
+        try:
+            if kind == 'int': return int(ln.strip())
+            if kind == 'float':
+                try: return float(ln.strip())
+                except ValueError: return float.fromhex(ln.strip())
+            if kind == 'bool': return ln.strip().lower() == 'true'
+            return ln
+        except ValueError:
+            return None
+
+    def convert(self, op, v):
+        t = type_name(v)
+        if op == 'INT2FLOAT' and t == 'int': return float(v)
+        if op == 'FLOAT2INT' and t == 'float': return int(v)
+        if op == 'INT2STR' and t == 'int': return str(v)
+        if op == 'FLOAT2STR' and t == 'float': return repr(v)
+        if op == 'INT2CHAR' and t == 'int':
+            if v < 0 or v > 0x10FFFF: raise RuntimeFault(58, op)
+            return chr(v)
+        raise RuntimeFault(53, op)
+
+    def run(self, limit=STEP_LIMIT):
+        pc, prog = 0, self.prog
+        while pc < len(prog):
+            op, raw, a = prog[pc]
+            pc += 1
+            if op == 'LABEL':
+                continue
+            self.steps += 1
+            if self.steps > limit: raise RuntimeFault(STEP_LIMIT_RC, "step limit")
+            if op == 'MOVE': self.set(a[0], self.get(a[1]))
+            elif op == 'DEFVAR':
+                fr = self.frame(a[0][1])
+                if a[0][2] in fr: raise RuntimeFault(52, "redefinition " + a[0][2])
+                fr[a[0][2]] = UNINIT
+            elif op == 'CREATEFRAME': self.tf = {}
+            elif op == 'PUSHFRAME':
+                if self.tf is None: raise RuntimeFault(55, "no TF")
+                self.lfs.append(self.tf)
+                self.tf = None
+            elif op == 'POPFRAME':
+                if not self.lfs: raise RuntimeFault(55, "no LF")
+                self.tf = self.lfs.pop()
+            elif op == 'CALL':
+                self.jumps += 1
+                self.calls.append(pc)
+                pc = self.target(raw[0])
+            elif op == 'RETURN':
+                if not self.calls: raise RuntimeFault(56, "empty call stack")
+                self.jumps += 1
+                pc = self.calls.pop()
+            elif op == 'PUSHS': self.stack.append(self.get(a[0]))
+            elif op == 'POPS':
+                if not self.stack: raise RuntimeFault(56, "empty stack")
+                self.set(a[0], self.stack.pop())
+            elif op == 'CLEARS': self.stack = []
+            elif op in ('ADD', 'SUB', 'MUL', 'DIV', 'IDIV', 'AND', 'OR'):
+                self.set(a[0], self.arith(op, self.get(a[1]), self.get(a[2])))
+            elif op in ('LT', 'GT', 'EQ'):
+                self.set(a[0], self.compare(op, self.get(a[1]), self.get(a[2])))
+            elif op in ('ADDS', 'SUBS', 'MULS', 'DIVS', 'IDIVS', 'ANDS', 'ORS', 'LTS', 'GTS', 'EQS'):
+                if len(self.stack) < 2: raise RuntimeFault(56, "empty stack")
+                b, x = self.stack.pop(), self.stack.pop()
+                o = op[:-1]
+                self.stack.append(self.compare(o, x, b) if o in ('LT', 'GT', 'EQ') else self.arith(o, x, b))
+            elif op in ('NOT', 'NOTS'):
+                v = self.get(a[1]) if op == 'NOT' else (self.stack.pop() if self.stack else UNINIT)
+                if type_name(v) != 'bool': raise RuntimeFault(53 if v is not UNINIT else 56, op)
+                if op == 'NOT': self.set(a[0], not v)
+                else: self.stack.append(not v)
+            elif op in ('INT2FLOAT', 'FLOAT2INT', 'INT2CHAR', 'INT2STR', 'FLOAT2STR'):
+                self.set(a[0], self.convert(op, self.get(a[1])))
+            elif op in ('STRI2INT', 'GETCHAR'):
+                s, i = self.get(a[1]), self.get(a[2])
+                if type_name(s) != 'string' or type_name(i) != 'int': raise RuntimeFault(53, op)
+                if i < 0 or i >= len(s): raise RuntimeFault(58, op)
+                self.set(a[0], ord(s[i]) if op == 'STRI2INT' else s[i])
+            elif op == 'SETCHAR':
+                s, i, c = self.get(a[0]), self.get(a[1]), self.get(a[2])
+                if type_name(s) != 'string' or type_name(i) != 'int' or type_name(c) != 'string':
+                    raise RuntimeFault(53, op)
+                if i < 0 or i >= len(s) or not c: raise RuntimeFault(58, op)
+                self.set(a[0], s[:i] + c[0] + s[i + 1:])
+            elif op == 'READ': self.set(a[0], self.read(raw[1]))
+            elif op == 'WRITE': self.out.append(format_value(self.get(a[0])))
+            elif op == 'CONCAT':
+                x, y = self.get(a[1]), self.get(a[2])
+                if type_name(x) != 'string' or type_name(y) != 'string': raise RuntimeFault(53, op)
+                self.set(a[0], x + y)
+            elif op == 'STRLEN':
+                x = self.get(a[1])
+                if type_name(x) != 'string': raise RuntimeFault(53, op)
+                self.set(a[0], len(x))
+            elif op == 'TYPE':
+                o = a[1]
+                if o[0] == 'v':
+                    fr = self.frame(o[1])
+                    if o[2] not in fr: raise RuntimeFault(54, "undefined var " + o[2])
+                    self.set(a[0], '' if fr[o[2]] is UNINIT else type_name(fr[o[2]]))
+                else:
+                    self.set(a[0], type_name(o[1]))
+            elif op == 'JUMP':
+                self.jumps += 1
+                pc = self.target(raw[0])
+            elif op in ('JUMPIFEQ', 'JUMPIFNEQ'):
+                dest = self.target(raw[0])
+                if self.compare('EQ', self.get(a[1]), self.get(a[2])) == (op == 'JUMPIFEQ'):
+                    self.jumps += 1
+                    pc = dest
+            elif op == 'EXIT':
+                v = self.get(a[0])
+                if type_name(v) != 'int' or not 0 <= v <= 49: raise RuntimeFault(57, op)
+                return v
+            elif op in ('BREAK', 'DPRINT'):
+                pass
+            else:
+                raise RuntimeFault(22, "unknown opcode " + op)
+        return 0
+
+def run(code: str, stdin: str = "", limit: int = STEP_LIMIT) -> Run:
+    """Spustí program v IFJcode25; jumps počítá provedené skoky, volání a návraty."""
+    try:
+        m = Machine(code, stdin)
+    except RuntimeFault as e:
+        return Run(e.code, "", 0, 0, str(e))
+    try:
+        rc, msg = m.run(limit), ""
+    except RuntimeFault as e:
+        rc, msg = e.code, str(e)
+    return Run(rc, ''.join(m.out), m.steps, m.jumps, msg)
+
+if __name__ == '__main__':
+    with open(sys.argv[1], encoding="utf-8") as f:
+        r = run(f.read(), sys.stdin.read())
+    sys.stdout.write(r.stdout)
+    sys.stderr.write("[steps=%d jumps=%d rc=%d %s]\n" % (r.steps, r.jumps, r.rc, r.message))
+    sys.exit(r.rc if r.rc >= 0 else 1)
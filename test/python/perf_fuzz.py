@@ -0,0 +1,310 @@
+# -*- coding: utf-8 -*-
+"""Fuzzer výkonu překladače: hledá vstupy, jejichž překlad trvá nejdéle nebo spotřebuje
+nejvíc paměti na bajt zdrojáku.
+
+Vychází z programů v test/ (ty, které se přeloží), a mutuje je podle gramatiky IFJ25:
+vkládá do bloků vnořené příkazy, smyčky, lokální i globální proměnné, funkce, dlouhé
+výrazy, řetězce, výpisy, prázdné řádky a komentáře. Kandidát je program a seznam mutací
+(operátor, počet opakování, značka), takže se dá přesně zopakovat a zvětšit. Cena je čas
+CPU a špičková paměť (RSS) procesu překladače nad cenou prázdného programu, dělená délkou
+zdrojáku; nejhorší kandidáti se drží zvlášť pro čas a pro paměť.
+
+Pro nejhorší nálezy se změří křivka škálování (počty mutací ×1, ×2, ×4, ×8) a exponent
+mocninné závislosti ceny na délce vstupu; exponent nad 1 značí superlineární chování.
+Pád nebo vypršení limitu překladače se hlásí hned. Každý nález lze uložit (--save DIR)
+jako regresní benchmark.
+
+Použití: python3 perf_fuzz.py [--iterations N] [--seed S] [--top K] [--json SOUBOR] [--save DIR]
+"""
+import argparse, json, math, os, pathlib, random, resource, subprocess, sys, tempfile, threading
+from collections import namedtuple
+
+TEST_DIR = pathlib.Path(__file__).resolve().parent.parent
+ROOT = TEST_DIR.parent
+MAX_BYTES = 64 * 1024     # větší kandidáti se nezkoušejí (křivka škálování jde až na 8×)
+TIMEOUT = 20.0            # s na jeden překlad, pak se hlásí jako nález
+MEM_LIMIT = 4 << 30       # B adresního prostoru překladače (RLIMIT_AS), nad ním selže alokace
+FACTORS = (1, 2, 4, 8)
+SUPERLINEAR = 1.15        # exponent, od kterého je nález superlineární
+EMPTY = 'import "ifj25" for Ifj\nclass Program {\n    static main() {\n    }\n}\n'
+
+Cost = namedtuple("Cost", "rc cpu rss bytes")   # rc < 0: signál, None: vypršel limit
+OBJECTIVES = ("time", "memory")
+
+# ---------------- mutace ----------------
+
+def block_lines(lines):
+    """Řádky, za které lze vložit příkaz: otevření bloku uvnitř funkce (ne třídy)."""
+    return [i for i, l in enumerate(lines) if l.rstrip().endswith("{") and not l.lstrip().startswith("class ")]
+
+def class_lines(lines):
+    return [i for i, l in enumerate(lines) if l.lstrip().startswith("class ") and l.rstrip().endswith("{")]
+
+def op_nest(tag, n, rng):
+    # vnořené bloky: každý má vlastní rozsah (tabulku symbolů)
+    return [f"if ({tag % 7} == {tag % 7}) {{"] * n + [f"var fz{tag}_in = {n}"] + ["}"] * n
+
+def op_loops(tag, n, rng):
+    lines = []
+    for k in range(n):
+        lines += [f"var fz{tag}_w{k} = 0", f"while (fz{tag}_w{k} < 1) {{", f"fz{tag}_w{k} = fz{tag}_w{k} + 1"]
+    return lines + ["}"] * n
+
+def op_locals(tag, n, rng):
+    return [f"var fz{tag}_v{k} = {rng.randint(0, 999)}" for k in range(n)]
+
+def op_globals(tag, n, rng):
+    return [f"__fz{tag}_g{k} = {rng.randint(0, 999)}" for k in range(n)]
+
+def op_parens(tag, n, rng):
+    return [f"var fz{tag}_p = " + "(" * n + str(rng.randint(0, 9)) + ")" * n]
+
+def op_chain(tag, n, rng):
+    return [f"var fz{tag}_c = " + " + ".join(str(rng.randint(0, 99)) for _ in range(n + 1))]
+
+def op_concat(tag, n, rng):
+    return [f"var fz{tag}_s = " + " + ".join(f'"{rng.choice("ab# ")}"' for _ in range(n + 1))]
+
+def op_string(tag, n, rng):
+    text = "".join(rng.choice(["a", "Z", " ", "#", "\\n", "\\\\", "\\t", "\\x41"]) for _ in range(8 * n))
+    return [f'var fz{tag}_l = "{text}"']
+
+def op_writes(tag, n, rng):
+    return [f"Ifj.write({rng.randint(0, 999)})" for _ in range(n)]
+
+def op_eols(tag, n, rng):
+    return [rng.choice(["", "// fz", "/* fz */"]) for _ in range(n)]
+
+def op_comment(tag, n, rng):
+    return ["/*" * n + " fz " + "*/" * n]
+
+def op_calls(tag, n, rng):
+    return [f"var fz{tag}_r{k} = fz{tag}_f{k}({k})" for k in range(n)]
+
+def op_functions(tag, n, rng):
+    lines = []
+    for k in range(n):
+        lines += [f"static fz{tag}_f{k}(a) {{", f"var b = a + {rng.randint(0, 99)}", "return b", "}"]
+    return lines
+
+# operátor -> (vkládané řádky, místa vložení)
+OPERATORS = {
+    "nest": (op_nest, block_lines), "loops": (op_loops, block_lines), "locals": (op_locals, block_lines),
+    "globals": (op_globals, block_lines), "parens": (op_parens, block_lines), "chain": (op_chain, block_lines),
+    "concat": (op_concat, block_lines), "string": (op_string, block_lines), "writes": (op_writes, block_lines),
+    "eols": (op_eols, block_lines), "comment": (op_comment, block_lines), "functions": (op_functions, class_lines),
+}
+
+def apply(source: str, op: str, count: int, tag: int) -> str:
+    """Jedna mutace; značka určuje místo vložení, jména i náhodné hodnoty (zopakovatelné)."""
+    rng = random.Random(f"{op}:{tag}")
+    lines = source.split("\n")
+    make, places = OPERATORS[op]
+    spots = places(lines)
+    if not spots:
+        return source
+    at = rng.choice(spots)
+    indent = " " * (len(lines[at]) - len(lines[at].lstrip()) + 4)
+    added = [indent + l for l in make(tag, count, rng)]
+    if op == "functions":
+        # volání nových funkcí z main, jinak by je odstranila optimalizace
+        main = next((i for i, l in enumerate(lines) if l.strip() == "static main() {"), None)
+        if main is not None:
+            calls = [" " * 8 + l for l in op_calls(tag, count, rng)]
+            lines = lines[:main + 1] + calls + lines[main + 1:]
+    return "\n".join(lines[:at + 1] + added + lines[at + 1:])
+
+class Candidate:
+    def __init__(self, seed: pathlib.Path, text: str, mutations=()):
+        self.seed, self.text, self.mutations = seed, text, tuple(mutations)
+
+    def build(self, factor: int = 1) -> str:
+        source = self.text
+        for op, count, tag in self.mutations:
+            source = apply(source, op, count * factor, tag)
+        return source
+
+    def mutate(self, rng: random.Random, tag: int) -> "Candidate":
+        muts = list(self.mutations)
+        if muts and rng.random() < 0.35:
+            k = rng.randrange(len(muts))   # zesílit existující mutaci
+            op, count, t = muts[k]
+            muts[k] = (op, count * 2, t)
+        else:
+            muts.append((rng.choice(sorted(OPERATORS)), rng.randint(1, 16), tag))
+        return Candidate(self.seed, self.text, muts)
+
+    def signature(self) -> str:
+        return "+".join(sorted({op for op, _, _ in self.mutations})) or "seed"
+
+    def describe(self) -> dict:
+        return {"seed": str(self.seed.relative_to(TEST_DIR)) if self.seed.is_relative_to(TEST_DIR) else str(self.seed),
+                "mutations": [list(m) for m in self.mutations]}
+
+# ---------------- měření ----------------
+
+def limit_memory():
+    resource.setrlimit(resource.RLIMIT_AS, (MEM_LIMIT, MEM_LIMIT))
+
+def compile_cost(compiler, source: str, flags=(), timeout: float = TIMEOUT) -> Cost:
+    """Čas CPU (s) a špičková paměť (KiB) jednoho překladu ze stdin (os.wait4 měří jen tento proces)."""
+    data = source.encode("utf-8")
+    with tempfile.TemporaryFile() as f:
+        f.write(data)
+        f.seek(0)
+        p = subprocess.Popen([str(compiler), *flags], stdin=f, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                             preexec_fn=limit_memory)
+        timer = threading.Timer(timeout, p.kill)
+        timer.start()
+        _, status, usage = os.wait4(p.pid, 0)
+        expired = not timer.is_alive()
+        timer.cancel()
+        p.returncode = os.waitstatus_to_exitcode(status)
+    rc = None if expired else p.returncode
+    return Cost(rc, usage.ru_utime + usage.ru_stime, usage.ru_maxrss, len(data))
+
+def measure(compiler, source: str, flags=(), repeat: int = 3) -> Cost:
+    """Nejmenší čas a paměť z několika běhů (šum jde jen nahoru)."""
+    runs = [compile_cost(compiler, source, flags) for _ in range(repeat)]
+    bad = [r for r in runs if r.rc is None or r.rc < 0]
+    if bad:
+        return bad[0]
+    return Cost(runs[0].rc, min(r.cpu for r in runs), min(r.rss for r in runs), runs[0].bytes)
+
+def excess(cost: Cost, base: Cost, objective: str) -> float:
+    if objective == "time":
+        return max(cost.cpu - base.cpu, 0.0)
+    return max(cost.rss - base.rss, 0) * 1024.0
+
+def score(cost: Cost, base: Cost, objective: str) -> float:
+    """Cena nad prázdným programem na bajt vstupu (s/B nebo B/B)."""
+    return excess(cost, base, objective) / max(cost.bytes, 1)
+
+def fit_exponent(points) -> float:
+    """Sklon přímky log(cena) ~ log(délka) metodou nejmenších čtverců."""
+    pts = [(math.log(b), math.log(c)) for b, c in points if b > 0 and c > 0]
+    if len(pts) < 2:
+        return 0.0
+    mx = sum(x for x, _ in pts) / len(pts)
+    my = sum(y for _, y in pts) / len(pts)
+    var = sum((x - mx) ** 2 for x, _ in pts)
+    return sum((x - mx) * (y - my) for x, y in pts) / var if var else 0.0
+
+def scaling_curve(compiler, cand: Candidate, base: Cost, objective: str, flags=(), factors=FACTORS,
+                  max_bytes: int = MAX_BYTES):
+    """Body křivky pro zvětšené mutace a exponent proložený body s úspěšným překladem."""
+    curve = []
+    for f in factors:
+        source = cand.build(f)
+        if len(source) > max_bytes * factors[-1]:
+            break
+        cost = measure(compiler, source, flags, repeat=2)
+        curve.append({"factor": f, "bytes": cost.bytes, "rc": cost.rc, "cpu_ms": round(cost.cpu * 1000, 3),
+                      "rss_kib": cost.rss, "excess": excess(cost, base, objective)})
+        if cost.rc != 0:
+            break   # pád, limit nebo selhaná alokace ukončí křivku
+    return curve, fit_exponent([(p["bytes"], p["excess"]) for p in curve if p["rc"] == 0])
+
+# ---------------- hledání ----------------
+
+def corpus_seeds(compiler, flags=()):
+    seeds = []
+    for path in sorted(TEST_DIR.glob("**/*.wren")):
+        text = path.read_text(encoding="utf-8", errors="replace")
+        if block_lines(text.split("\n")) and compile_cost(compiler, text, flags).rc == 0:
+            seeds.append(Candidate(path, text))
+    return seeds
+
+def fuzz(compiler, iterations: int = 200, seed: int = 0, top: int = 3, flags=(), seeds=None, log=None,
+         max_bytes: int = MAX_BYTES):
+    """Evoluční hledání; vrací zprávu (slovník) s nejhoršími nálezy a jejich křivkami."""
+    rng = random.Random(seed)
+    base = measure(compiler, EMPTY, flags, repeat=5)
+    seeds = seeds if seeds is not None else corpus_seeds(compiler, flags)
+    pool = {o: [] for o in OBJECTIVES}   # (skóre, kandidát), sestupně
+    failures = []
+
+    def offer(cand, cost):
+        for o in OBJECTIVES:
+            pool[o].append((score(cost, base, o), cand))
+            pool[o].sort(key=lambda e: -e[0])
+            del pool[o][4 * top:]
+
+    for cand in seeds:
+        offer(cand, measure(compiler, cand.text, flags, repeat=1))
+    for it in range(iterations):
+        objective = OBJECTIVES[it % len(OBJECTIVES)]
+        entries = pool[objective] or [(0.0, rng.choice(seeds))]
+        parent = rng.choice(entries[:top * 2])[1]
+        child = parent.mutate(rng, it + 1)
+        source = child.build()
+        if len(source) > max_bytes:
+            continue
+        cost = measure(compiler, source, flags)
+        if cost.rc is None or cost.rc < 0:
+            failures.append({"kind": "timeout" if cost.rc is None else f"signal {-cost.rc}", "bytes": cost.bytes,
+                             **child.describe()})
+            continue
+        if cost.rc != 0:
+            continue   # mutace rozbila program (např. return před vloženým kódem)
+        offer(child, cost)
+        if log:
+            log(f"{it:5} {objective:6} {cost.bytes:7} B {cost.cpu * 1000:9.2f} ms {cost.rss:8} KiB  {child.signature()}")
+
+    report = {"compiler": str(compiler), "flags": list(flags), "seed": seed, "iterations": iterations,
+              "baseline": {"cpu_ms": round(base.cpu * 1000, 3), "rss_kib": base.rss}, "offenders": [],
+              "failures": failures}
+    for objective in OBJECTIVES:
+        seen = set()
+        for value, cand in pool[objective]:
+            if len(seen) == top or not cand.mutations:
+                continue
+            if cand.signature() in seen:
+                continue
+            seen.add(cand.signature())
+            curve, exponent = scaling_curve(compiler, cand, base, objective, flags, max_bytes=max_bytes)
+            broken = next((p for p in curve if p["rc"] != 0), None)
+            report["offenders"].append({"objective": objective, "score": value, "shape": cand.signature(),
+                                        "exponent": round(exponent, 3), "superlinear": exponent > SUPERLINEAR,
+                                        "fails_at": broken and broken["factor"], "curve": curve, **cand.describe()})
+    return report
+
+def rebuild(entry: dict, factor: int = 1) -> str:
+    """Zdroják nálezu ze zprávy (seed + mutace), např. pro regresní benchmark."""
+    seed = TEST_DIR / entry["seed"]
+    cand = Candidate(seed, seed.read_text(encoding="utf-8", errors="replace"), [tuple(m) for m in entry["mutations"]])
+    return cand.build(factor)
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description="Fuzzer výkonu překladu IFJ25")
+    ap.add_argument("--compiler", default=os.getenv("COMPILER_BIN") or str(ROOT / "projekt" / "compiler"))
+    ap.add_argument("--flags", default="", help="přepínače překladače, např. \"-O0\"")
+    ap.add_argument("--iterations", type=int, default=200)
+    ap.add_argument("--seed", type=int, default=0)
+    ap.add_argument("--top", type=int, default=3, help="nálezů na cíl (čas, paměť)")
+    ap.add_argument("--json", help="zpráva jako JSON do souboru")
+    ap.add_argument("--save", help="adresář pro zdrojáky nálezů (největší změřená velikost)")
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args(argv)
+
+    log = (lambda s: print(s, file=sys.stderr)) if args.verbose else None
+    report = fuzz(args.compiler, args.iterations, args.seed, args.top, args.flags.split(), log=log)
+    print(f"baseline: {report['baseline']['cpu_ms']} ms, {report['baseline']['rss_kib']} KiB")
+    for k, o in enumerate(report["offenders"]):
+        mark = ("SUPERLINEAR " if o["superlinear"] else "") + (f"FAILS x{o['fails_at']}" if o["fails_at"] else "")
+        print(f"[{o['objective']}] {o['shape']:30} exponent {o['exponent']:6.2f} {mark}  ({o['seed']})")
+        for p in o["curve"]:
+            print(f"    x{p['factor']:<2} {p['bytes']:8} B {p['cpu_ms']:10.2f} ms {p['rss_kib']:9} KiB  rc={p['rc']}")
+        if args.save and o["curve"]:
+            out = pathlib.Path(args.save)
+            out.mkdir(parents=True, exist_ok=True)
+            name = f"{o['objective']}_{k}_{o['shape'].replace('+', '_')}.wren"
+            (out / name).write_text(rebuild(o, o["curve"][-1]["factor"]), encoding="utf-8")
+    for f in report["failures"]:
+        print(f"[{f['kind']}] {f['bytes']} B ({f['seed']}) {f['mutations']}")
+    if args.json:
+        pathlib.Path(args.json).write_text(json.dumps(report, indent=1), encoding="utf-8")
+    return 1 if report["failures"] else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,7 +4,8 @@ from token_parser import parse_tokens_flex, as_pairs
 
 def pairs(text: str): return as_pairs(parse_tokens_flex(text))
 
-@pytest.mark.skip(reason="enable when binary supports '-' (stdin)")
+BLOCK_SIZES = [1,2,3,5,7,13,64,257,1024]
+
 def test_chunk_equivalence(BIN, LEX_OK):
     src = next(iter(sorted(LEX_OK.glob("*.wren"))))
     text = src.read_text(encoding="utf-8")
@@ -14,11 +15,22 @@ def test_chunk_equivalence(BIN, LEX_OK):
     assert rc_ref == 0
     ref = pairs(out_ref)
 
-    for bs in [1,2,3,5,7,13,64,257,1024]:
+    for bs in BLOCK_SIZES:
         proc = subprocess.Popen([str(BIN), "-"], stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
         for i in range(0, len(text), bs):
             proc.stdin.write(text[i:i+bs]); proc.stdin.flush()
         proc.stdin.close()
-        out, err = proc.communicate()
-        assert proc.returncode == 0
+        out = proc.stdout.read()
+        proc.stdout.close(); proc.stderr.close()
+        assert proc.wait() == 0
         assert pairs(out) == ref, f"chunk={bs} differs"
+
+@pytest.mark.parametrize("kind", ["ok", "err"])
+def test_chunk_boundaries_everywhere(BIN, DATA_ROOT, kind):
+    # --chunk=N předává soubor scanneru po N bajtech: tokeny, návratový kód i chybová hláška
+    # musí být stejné jako při čtení celého souboru, ať hranice bloku padne kamkoli
+    for src in sorted((DATA_ROOT / "lex" / kind).glob("*.wren")):
+        ref = subprocess.run([str(BIN), str(src)], capture_output=True)
+        for bs in BLOCK_SIZES:
+            p = subprocess.run([str(BIN), f"--chunk={bs}", str(src)], capture_output=True)
+            assert (p.returncode, p.stdout, p.stderr) == (ref.returncode, ref.stdout, ref.stderr), f"{src.name}: chunk={bs}"
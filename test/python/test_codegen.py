@@ -0,0 +1,555 @@
+# -*- coding: utf-8 -*-
+import os, re, pathlib, subprocess, tempfile, pytest
+
+# Programy pro generátor kódu: X.wren + očekávaný výstup X.out (volitelně vstup X.in)
+GEN_DIR = pathlib.Path(__file__).resolve().parent.parent / "gen"
+GEN_PROGRAMS = sorted(GEN_DIR.glob("*.wren"))
+# všechny zdrojáky z test/ (OK i chybové)
+ALL_SOURCES = sorted(GEN_DIR.parent.glob("**/*.wren"))
+
+# ---------------- helpers ----------------
+
+def compile_src(compiler, text: str, args=()):
+    p = subprocess.run([str(compiler), *args], input=text, text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    return p.returncode, p.stdout
+
+def run_code(interpret, code: str, stdin: str = ""):
+    f = tempfile.NamedTemporaryFile(mode="w", suffix=".ifjcode", delete=False, encoding="utf-8")
+    try:
+        f.write(code); f.close()
+        p = subprocess.run([str(interpret), f.name], input=stdin, text=True,
+                           stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+        return p.returncode, p.stdout
+    finally:
+        os.unlink(f.name)
+
+def wrap_main(body: str, extra: str = "") -> str:
+    return ('import "ifj25" for Ifj\nclass Program {\n' + extra +
+            '    static main() {\n' + body + '\n    }\n}\n')
+
+SIDE = ('    static side(x) {\n'
+        '        Ifj.write(x)\n'
+        '        return x\n'
+        '    }\n')
+
+# ---------------- tests ----------------
+
+@pytest.mark.parametrize("src", GEN_PROGRAMS, ids=lambda p: p.name)
+def test_gen_program_compiles(COMPILER, src):
+    rc, code = compile_src(COMPILER, src.read_text(encoding="utf-8"))
+    assert rc == 0, f"{src.name}: rc={rc}"
+    assert code.startswith(".IFJcode25")
+
+# úrovně optimalizace, na kterých musí být výstup programu stejný
+OPT_FLAGS = [(), ("-O0",), ("-Os",), ("--unroll=1",), ("--unroll=16",), ("--stream",)]
+
+@pytest.mark.parametrize("flags", OPT_FLAGS, ids=lambda f: " ".join(f) or "default")
+@pytest.mark.parametrize("src", GEN_PROGRAMS, ids=lambda p: p.name)
+def test_gen_program_output(COMPILER, INTERPRET, src, flags):
+    if not INTERPRET:
+        pytest.skip("set IC25INT to run generated code")
+    rc, code = compile_src(COMPILER, src.read_text(encoding="utf-8"), flags)
+    assert rc == 0
+    inp = src.with_suffix(".in")
+    stdin = inp.read_text(encoding="utf-8") if inp.exists() else ""
+    rc, out = run_code(INTERPRET, code, stdin)
+    assert rc == 0, f"{src.name}: interpreter rc={rc}"
+    assert out == src.with_suffix(".out").read_text(encoding="utf-8")
+
+def test_ternary_constant_condition_drops_other_branch(COMPILER):
+    body = ('        var r\n'
+            '        r = null ? side(1) : 2\n'
+            '        r = 1 < 2 ? 3 : side(4)\n')
+    rc, code = compile_src(COMPILER, wrap_main(body, SIDE))
+    assert rc == 0
+    # nevybraná vetev se vůbec nevygeneruje
+    assert "CALL side$1" not in code
+
+def test_ternary_branches_are_jumped_over(COMPILER):
+    body = ('        var a\n'
+            '        a = 1\n'
+            '        var r\n'
+            '        r = a < 2 ? side(1) : side(2)\n')
+    rc, code = compile_src(COMPILER, wrap_main(body, SIDE))
+    assert rc == 0
+    lines = [l.split() for l in code.splitlines() if l and not l.startswith("#")]
+    calls = [i for i, l in enumerate(lines) if l[:2] == ["CALL", "side$1"]]
+    assert len(calls) == 2
+    # mezi voláními musí být nepodmíněný skok za konec ternárního výrazu
+    assert any(l[0] == "JUMP" for l in lines[calls[0]:calls[1]])
+
+def test_unknown_option_is_rejected(COMPILER):
+    rc, _ = compile_src(COMPILER, wrap_main("        var a"), ("--bogus",))
+    assert rc == 99
+
+COUNTER = ('        var i\n'
+           '        i = 0\n'
+           '        while (i < 3) {\n'
+           '            Ifj.write(i)\n'
+           '            i = i + 1\n'
+           '        }\n')
+
+def test_small_counted_loop_is_unrolled(COMPILER):
+    rc, code = compile_src(COMPILER, wrap_main(COUNTER))
+    assert rc == 0
+    assert "LABEL whileStart" not in code
+    assert len(re.findall(r"^ADD (LF@\S+) \1 int@1$", code, re.M)) == 3
+
+def test_induction_variable_uses_plain_int_ops(COMPILER):
+    rc, code = compile_src(COMPILER, wrap_main(COUNTER), ("--unroll=1",))
+    assert rc == 0
+    loop = code[code.index("LABEL whileStart"):]
+    assert re.search(r"^LT GF@tmp_while LF@\S+ int@3$", loop, re.M)
+    # žádná dynamická koerce v těle smyčky
+    assert "TYPE GF@tmp_type_l" not in loop.split("LABEL whileEnd")[0]
+
+def test_O0_keeps_generic_loop(COMPILER):
+    rc, code = compile_src(COMPILER, wrap_main(COUNTER), ("-O0",))
+    assert rc == 0
+    assert "LABEL whileStart" in code and "# INDUCTION" not in code
+
+def test_repeated_subexpression_is_computed_once(COMPILER):
+    body = ('        var a\n'
+            '        a = 1\n'
+            '        var b\n'
+            '        b = 2\n'
+            '        var r\n'
+            '        r = (a + b) * (a + b)\n')
+    rc, code = compile_src(COMPILER, wrap_main(body))
+    assert rc == 0
+    assert code.count("# START ADDITION/CONCAT CHECK") == 1
+    assert "DEFVAR LF@%s" in code
+    rc, code = compile_src(COMPILER, wrap_main(body), ("-O0",))
+    assert code.count("# START ADDITION/CONCAT CHECK") == 2
+
+def test_subexpression_is_recomputed_after_assignment(COMPILER):
+    body = ('        var a\n'
+            '        a = 1\n'
+            '        var r\n'
+            '        r = a + 2\n'
+            '        a = 5\n'
+            '        r = a + 2\n')
+    rc, code = compile_src(COMPILER, wrap_main(body))
+    assert rc == 0
+    assert code.count("# START ADDITION/CONCAT CHECK") == 2
+
+def test_locals_with_disjoint_ranges_share_a_slot(COMPILER):
+    body = ('        var a\n'
+            '        a = 1\n'
+            '        Ifj.write(a)\n'
+            '        var b\n'
+            '        b = 2\n'
+            '        Ifj.write(b)\n')
+    rc, code = compile_src(COMPILER, wrap_main(body))
+    assert rc == 0
+    assert code.count("DEFVAR LF@") == 1
+    rc, code = compile_src(COMPILER, wrap_main(body), ("-O0",))
+    assert code.count("DEFVAR LF@") == 2
+
+def test_loop_variable_keeps_its_slot_over_the_loop(COMPILER, INTERPRET):
+    body = ('        var s\n'
+            '        s = "x"\n'
+            '        var n\n'
+            '        n = 0\n'
+            '        while (n < 3) {\n'
+            '            var t\n'
+            '            t = s + "y"\n'
+            '            s = t\n'
+            '            n = n + 1\n'
+            '        }\n'
+            '        Ifj.write(s)\n')
+    rc, code = compile_src(COMPILER, wrap_main(body))
+    assert rc == 0
+    # s, n a t žijí přes celou smyčku -> tři různé sloty
+    assert code.count("DEFVAR LF@") == 3
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "xyyy")
+
+def test_expression_arguments_go_straight_to_the_stack(COMPILER, INTERPRET):
+    extra = ('    static diff(x, y) {\n'
+             '        return x - y\n'
+             '    }\n')
+    body = ('        var a\n'
+            '        a = 5\n'
+            '        Ifj.write(diff(a + 1, a * 2))\n')
+    rc, code = compile_src(COMPILER, wrap_main(body, extra))
+    assert rc == 0
+    # argumenty se nevyhodnocují do pomocných proměnných
+    assert code.count("DEFVAR LF@") == 1 + 2
+    lines = [l.split() for l in code.splitlines() if l and not l.startswith("#")]
+    call = lines.index(["CALL", "diff$2"])
+    assert ["PUSHS", "GF@tmp1"] == lines[call - 1]
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "-4")
+
+def test_pure_call_with_literal_arguments_is_folded(COMPILER, INTERPRET):
+    extra = ('    static sq(x) {\n'
+             '        return x * x + 1\n'
+             '    }\n'
+             '    static bad(x) {\n'
+             '        return x + "a"\n'
+             '    }\n')
+    rc, code = compile_src(COMPILER, wrap_main('        Ifj.write(sq(7))\n', extra))
+    assert rc == 0
+    # volání nahradí výsledek, funkce zůstane jen jako definice
+    assert "CALL sq$1" not in code and "int@50" in code
+    rc, code = compile_src(COMPILER, wrap_main('        Ifj.write(sq(7))\n', extra), ("-O0",))
+    assert "CALL sq$1" in code
+    # běhová chyba (typová chyba 26) se nechá až na interpret
+    rc, code = compile_src(COMPILER, wrap_main('        Ifj.write(bad(1))\n', extra))
+    assert rc == 0 and "CALL bad$1" in code
+    if INTERPRET:
+        assert run_code(INTERPRET, code)[0] == 26
+
+def test_size_mode_is_compact(COMPILER, INTERPRET):
+    body = ('        var a\n'
+            '        a = 1.5\n'
+            '        var n\n'
+            '        n = 0\n'
+            '        while (n < a * 4) {\n'
+            '            n = n + a\n'
+            '        }\n'
+            '        Ifj.write(n - a)\n')
+    rc, full = compile_src(COMPILER, wrap_main(body))
+    rc, code = compile_src(COMPILER, wrap_main(body), ("-Os",))
+    assert rc == 0
+    assert "#" not in code and len(code) * 2 < len(full)
+    lines = [l.split() for l in code.splitlines()]
+    # koerce jsou sdílené podprogramy, podmínka smyčky je ve výstupu jen jednou
+    assert sum(l[0] == "CALL" for l in lines) == 4
+    main = lines[:lines.index(["EXIT", "int@0"])]
+    assert sum(l[0] == "LT" for l in main) == 1
+    # krátká jména návěští i proměnných
+    assert all(len(l[1].split("@")[-1]) <= 2 for l in lines if l[0] in ("LABEL", "DEFVAR"))
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "0x1.2p+2")
+
+def test_overloads_get_distinct_labels(COMPILER, INTERPRET):
+    extra = ('    static f(a) {\n'
+             '        return a + 1\n'
+             '    }\n'
+             '    static f(a, b) {\n'
+             '        return a * b\n'
+             '    }\n')
+    rc, code = compile_src(COMPILER, wrap_main('        Ifj.write(f(1))\n        Ifj.write(f(3, 7))\n', extra), ("-O0",))
+    assert rc == 0
+    # návěští funkce = jméno + arita
+    assert "LABEL f$1" in code and "LABEL f$2" in code
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "221")
+
+def function_code(code: str, name: str) -> str:
+    # konec funkce za příkazem return je nedosažitelný a s -O1 se odstraní i se svým komentářem
+    start = code.index(f"# START OF FUNCTION ---{name}---")
+    end = code.find("# START OF", start + 1)
+    return code[start:end if end >= 0 else len(code)]
+
+def test_local_labels_do_not_depend_on_other_functions(COMPILER):
+    loop = ('    static g(n) {\n'
+            '        while (n > 0) {\n'
+            '            if (n > 2) {\n'
+            '                n = n - 2\n'
+            '            } else {\n'
+            '                n = n - 1\n'
+            '            }\n'
+            '        }\n'
+            '        return n\n'
+            '    }\n')
+    other = loop.replace("g(n)", "h(n)")
+    # argument až za běhu: volání se nevyhodnotí při překladu a g() zůstane dosažitelná
+    call = '        Ifj.write(g(Ifj.read_num()))\n        Ifj.write(h(Ifj.read_num()))\n'
+    _, alone = compile_src(COMPILER, wrap_main(call.replace("h(", "g("), loop))
+    _, after = compile_src(COMPILER, wrap_main(call, other + loop))
+    # číslování návěští začíná v každé funkci znovu, kód g() je stejný
+    assert function_code(alone, "g") == function_code(after, "g")
+    assert "LABEL whileStartg$1$0" in alone
+
+def cache_stats(stderr: str) -> dict:
+    return {k: int(v) for k, v in re.findall(r"^(cache_\w+): (\d+)$", stderr, re.M)}
+
+def test_function_cache_regenerates_only_edited_function(COMPILER, tmp_path):
+    funcs = ''.join(f'    static f{i}(x) {{\n        return x * {i}\n    }}\n' for i in range(6))
+    src = wrap_main('        Ifj.write(f3(Ifj.read_num()))\n', funcs)
+    # úprava f4 a nová funkce před všemi ostatními
+    edited = src.replace("x * 4", "x * 40").replace("    static f0", "    static g(x) {\n        var y\n        return x\n    }\n    static f0")
+    args = [str(COMPILER), f"--cache={tmp_path}", "--stats"]
+    run = lambda text: subprocess.run(args, input=text, text=True, stdout=subprocess.PIPE,
+                                      stderr=subprocess.PIPE, timeout=60)
+    first, second, third = run(src), run(src), run(edited)
+    assert cache_stats(first.stderr) == {"cache_hits": 0, "cache_misses": 7}
+    assert cache_stats(second.stderr) == {"cache_hits": 7, "cache_misses": 0}
+    assert cache_stats(third.stderr) == {"cache_hits": 6, "cache_misses": 2}
+    # kód z cache je stejný jako bez ní
+    assert second.stdout == first.stdout == compile_src(COMPILER, src)[1]
+    assert third.stdout == compile_src(COMPILER, edited)[1]
+
+@pytest.mark.parametrize("src", ALL_SOURCES, ids=lambda p: str(p.relative_to(GEN_DIR.parent)))
+def test_stream_mode_keeps_exit_code(COMPILER, src):
+    # po funkcích se kód liší (globální proměnné na konci), návratový kód ne
+    text = src.read_text(encoding="utf-8", errors="replace")
+    assert compile_src(COMPILER, text, ("--stream",))[0] == compile_src(COMPILER, text)[0]
+
+def test_stream_compiles_function_by_function(COMPILER, INTERPRET):
+    funcs = ''.join(f'    static f{i}(x) {{\n        __g = __g + x\n        return x * {i}\n    }}\n' for i in range(5))
+    src = wrap_main('        __g = 0\n        Ifj.write(f4(f2(3)))\n        Ifj.write(__g)\n', funcs)
+    p = subprocess.run([str(COMPILER), "--stream", "--stats"], input=src, text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    assert p.returncode == 0
+    assert "stream_functions: 6" in p.stderr
+    if INTERPRET:
+        assert run_code(INTERPRET, p.stdout) == (0, "249")
+
+def test_stream_error_precedence(COMPILER):
+    # chyba Passu 2 v a() (nedefinovaná proměnná) a chyba Passu 1 v b() (redeklarace): 4,
+    # se syntaktickou chybou v c(): 2; kód bezchybné ok() před nimi se při chybě nevypíše
+    extra = ('    static ok() {\n'
+             '        return 1\n'
+             '    }\n'
+             '    static a() {\n'
+             '        return y\n'
+             '    }\n'
+             '    static b() {\n'
+             '        var x\n'
+             '        var x\n'
+             '    }\n')
+    src = wrap_main('        var r', extra)
+    for later in ("", '    static c() {\n        var = 1\n    }\n'):
+        text = src.replace("class Program {\n", "class Program {\n" + later)
+        base, out = compile_src(COMPILER, text)
+        assert base != 0 and out == ""
+        assert compile_src(COMPILER, text, ("--stream",)) == (base, "")
+
+# zdrojáky bez && || ! (ty tabulkový parser nezná)
+TABLE_SOURCES = [p for p in ALL_SOURCES if p.name not in ("logic_ops.wren", "logic_truthy.wren")]
+
+@pytest.mark.parametrize("src", TABLE_SOURCES, ids=lambda p: str(p.relative_to(GEN_DIR.parent)))
+def test_pratt_parser_matches_precedence_table(COMPILER, src):
+    # stejný strom výrazů = stejný návratový kód i vygenerovaný kód
+    text = src.read_text(encoding="utf-8", errors="replace")
+    assert compile_src(COMPILER, text, ("--table-expr",)) == compile_src(COMPILER, text)
+
+@pytest.mark.parametrize("expr,value", [("1 && 2", "true"), ('"s" || a < 1', "true"), ("!a", "false"),
+                                        ("!(a + 1)", "false"), ("!n", "true"), ("n || a", "true"),
+                                        ("n && a", "false"), ("!n ? 1 : 2", "1")])
+def test_logical_operators_take_any_value(COMPILER, INTERPRET, expr, value):
+    # ! && || přijmou operand libovolného typu: null a false jsou nepravdivé, vše ostatní pravdivé
+    src = wrap_main(f'        var a\n        a = 1\n        var n\n        n = null\n        var r\n        r = {expr}\n        Ifj.write(r)')
+    for flags in ((), ("-O0",)):
+        rc, code = compile_src(COMPILER, src, flags)
+        assert rc == 0
+        if INTERPRET:
+            assert run_code(INTERPRET, code) == (0, value)
+
+def test_call_under_negation_is_checked(COMPILER):
+    extra = '    static f(x) {\n        return x < 1\n    }\n'
+    rc, _ = compile_src(COMPILER, wrap_main('        var r\n        r = !f(1, 2)', extra))
+    assert rc == 5  # ERR_ARGNUM
+
+DEEP_SHAPES = {
+    "left": lambda n: ' + '.join(['a'] * n),
+    "right": lambda n: 'a + (' * (n - 1) + 'a' + ')' * (n - 1),
+    "ternary": lambda n: 'a < 0 ? 0 : ' * (n - 1) + 'a',
+}
+
+def deep_program(shape: str, n: int) -> str:
+    return wrap_main('        var a = 1\n        var r\n        r = ' + DEEP_SHAPES[shape](n) +
+                     '\n        Ifj.write(r)')
+
+@pytest.mark.parametrize("shape,n", [("left", 10 ** 6), ("right", 10 ** 6), ("ternary", 10 ** 5)])
+def test_deep_expression(COMPILER, INTERPRET, shape, n):
+    # parser, sémantika i generátor procházejí strom s vlastním zásobníkem, hloubku omezuje jen paměť
+    rc, code = compile_src(COMPILER, deep_program(shape, n), ["-Os"])
+    assert rc == 0
+    # každý operátor volá sdílenou koerci (-Os) právě jednou
+    assert code.count("\nCALL ") == n - 1
+    if INTERPRET:
+        # milion operací by interpret počítal přes minutu, výsledek ověří menší strom téhož tvaru
+        rc, code = compile_src(COMPILER, deep_program(shape, 10 ** 4))
+        assert rc == 0
+        assert run_code(INTERPRET, code) == (0, "1" if shape == "ternary" else "10000")
+
+def test_expression_depth_limit(COMPILER, INTERPRET, ERROR_CODES):
+    parens = lambda n: wrap_main('        var r\n        r = ' + '(' * n + '1 < 2' + ')' * n +
+                                 '\n        Ifj.write(!!r)')
+    rc, code = compile_src(COMPILER, parens(20000))
+    assert rc == 0
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "true")
+    extra = '    static f(x) {\n        return x\n    }\n'
+    calls = lambda n: wrap_main('        var r\n        r = ' + 'f(' * n + '1 < 2' + ')' * n +
+                                '\n        Ifj.write(!!r)', extra)
+    rc, code = compile_src(COMPILER, calls(900))
+    assert rc == 0
+    if INTERPRET:
+        assert run_code(INTERPRET, code) == (0, "true")
+    # argumenty volání se zpracovávají rekurzí, hlubší vnoření volání skončí interní chybou
+    assert compile_src(COMPILER, calls(2000))[0] == ERROR_CODES["ERR_INTERNAL"]
+
+IF_CHAIN = ('    static f(x) {\n'
+            '        if (x == 4) {\n            return "d"\n        } else {\n'
+            '            if (x == 2) {\n                return "b"\n            } else {\n'
+            '                if (1 == x) {\n                    return "a"\n                } else {\n'
+            '                    if (x == 3) {\n                        return "c"\n'
+            '                    }\n                }\n            }\n        }\n'
+            '        return "-"\n'
+            '    }\n')
+
+def test_if_chain_decision_tree(COMPILER, INTERPRET):
+    # argumenty přes proměnnou, volání se nevyhodnotí při překladu
+    body = ('        var a = 1\n        Ifj.write(f(a))\n        a = 3\n        Ifj.write(f(a))\n'
+            '        a = 5\n        Ifj.write(f(a))\n        a = 2.0\n        Ifj.write(f(a))\n')
+    rc, code = compile_src(COMPILER, wrap_main(body, IF_CHAIN))
+    assert rc == 0 and "# IF DECISION TREE" in code
+    rc, plain = compile_src(COMPILER, wrap_main(body, IF_CHAIN), ("-O0",))
+    assert rc == 0 and "# IF DECISION TREE" not in plain
+    if INTERPRET:
+        # float se porovná s převodem
+        assert run_code(INTERPRET, code) == run_code(INTERPRET, plain) == (0, "ac-b")
+        # řetězec i nil proti celým číslům: stejná běhová chyba 26 jako bez stromu
+        for arg in ('"a"', 'null'):
+            bad = wrap_main('        var a = ' + arg + '\n        Ifj.write(f(a))\n', IF_CHAIN)
+            assert run_code(INTERPRET, compile_src(COMPILER, bad)[1])[0] == 26
+
+def instructions(code: str):
+    return [l.split() for l in code.splitlines() if l.strip() and not l.lstrip().startswith("#")]
+
+@pytest.mark.parametrize("src", GEN_PROGRAMS, ids=lambda p: p.name)
+def test_control_flow_simplified(COMPILER, src):
+    rc, code = compile_src(COMPILER, src.read_text(encoding="utf-8"), ("--stats",))
+    assert rc == 0
+    ins = instructions(code)
+    labels = {l[1]: i for i, l in enumerate(ins) if l[0] == "LABEL"}
+    refs = {l[1] for l in ins if l[0] in ("JUMP", "JUMPIFEQ", "JUMPIFNEQ", "CALL")}
+    # každé návěští je cílem skoku nebo volání
+    assert set(labels) <= refs
+    def first_after(i):
+        while i < len(ins) and ins[i][0] == "LABEL":
+            i += 1
+        return i
+    for i, l in enumerate(ins):
+        if l[0] not in ("JUMP", "JUMPIFEQ", "JUMPIFNEQ") or l[1] not in labels:
+            continue
+        target = first_after(labels[l[1]])
+        # žádný skok na JUMP, žádný JUMP na následující instrukci
+        assert target == len(ins) or ins[target][0] != "JUMP", f"{l} -> {ins[target]}"
+        if l[0] == "JUMP":
+            assert target != first_after(i + 1), l
+
+def test_control_flow_unreachable_code(COMPILER, INTERPRET):
+    extra = ('    static f(x) {\n'
+             '        if (x > 2) {\n            return 1\n        } else {\n            return 2\n        }\n'
+             '    }\n'
+             '    static unused(x) {\n        return x\n    }\n')
+    body = '        var a = 3\n        Ifj.write(f(a))\n'
+    p = subprocess.run([str(COMPILER), "--stats"], input=wrap_main(body, extra), text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    assert p.returncode == 0
+    stats = {k: int(v) for k, v in re.findall(r"^(\w+): (\d+)$", p.stderr, re.M)}
+    # konec funkce za return i nevolaná funkce
+    assert stats["dead_instructions"] > 0 and stats["labels_removed"] > 0
+    assert "unused$1" not in p.stdout
+    rc, plain = compile_src(COMPILER, wrap_main(body, extra), ("-O0",))
+    assert "LABEL unused$1" in plain
+    if INTERPRET:
+        assert run_code(INTERPRET, p.stdout) == run_code(INTERPRET, plain) == (0, "1")
+
+TYPED_LOOP = ('    static f(n) {\n'
+              '        var i = 0\n        var s = 0.0\n        var v = n\n'
+              '        while (i < n) {\n'
+              '            var t\n            t = i * i\n'
+              '            s = s + t / 2\n'
+              '            v = v / 2\n'
+              '            i = i + 1\n'
+              '        }\n'
+              '        return s\n'
+              '    }\n')
+
+def test_loop_versioning(COMPILER, INTERPRET):
+    body = '        var a = 4\n        Ifj.write(f(a))\n        a = 5.0\n        Ifj.write(f(a))\n'
+    p = subprocess.run([str(COMPILER), "--stats"], input=wrap_main(body, TYPED_LOOP), text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    assert p.returncode == 0
+    stats = {k: int(v) for k, v in re.findall(r"^(\w+): (\d+)$", p.stderr, re.M)}
+    assert stats["versioned_loops"] == 1 and stats["typed_operations"] > 0
+    f = function_code(p.stdout, "f")
+    guard, rest = f.split("# LOOP TYPE GUARD", 1)[1].split("# TYPED LOOP", 1)
+    typed = rest.split("# GENERIC LOOP", 1)[0]
+    # strež testuje i, n a s; t se zapíše před čtením, v mění typ (int / 2 je float)
+    assert guard.count("TYPE ") == 3
+    # typovaná kopie: i * i, s + t / 2 i podmínka bez převodů, v = v / 2 s kontrolou
+    assert "MUL CHECK" not in typed and "ADDITION/CONCAT CHECK" not in typed
+    assert typed.count("DIV CHECK") == 1
+    rc, plain = compile_src(COMPILER, wrap_main(body, TYPED_LOOP), ("-O0",))
+    assert rc == 0 and "# TYPED LOOP" not in plain
+    if INTERPRET:
+        # 5.0 neprojde strží a poběží obecná kopie
+        assert run_code(INTERPRET, p.stdout) == run_code(INTERPRET, plain) == (0, "715")
+
+GLOBALS = ('    static tick() {\n'
+           '        __count = __count + __step\n'
+           '        return __late\n'
+           '    }\n')
+
+def test_global_analysis(COMPILER, INTERPRET):
+    body = ('        __count = 0\n        __step = 2\n        __unused = "x"\n'
+            '        Ifj.write(tick())\n        __late = 1\n        Ifj.write(tick())\n'
+            '        Ifj.write(__count)\n')
+    p = subprocess.run([str(COMPILER), "--stats"], input=wrap_main(body, GLOBALS), text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    assert p.returncode == 0
+    stats = {k: int(v) for k, v in re.findall(r"^(\w+): (\d+)$", p.stderr, re.M)}
+    assert stats["globals_constant"] == 2 and stats["globals_removed"] == 2 and stats["globals_typed"] == 1
+    # __step se čte jako literál, __unused zmizí i se zápisem, __late se čte před přiřazením a zůstane
+    assert "GF@__step" not in p.stdout and "GF@__unused" not in p.stdout
+    assert "DEFVAR GF@__late" in p.stdout and "DEFVAR GF@__count" in p.stdout
+    # __count je v celém programu int, sčítání v tick() je bez převodní sekvence
+    assert "ADDITION/CONCAT CHECK" not in function_code(p.stdout, "tick")
+    rc, plain = compile_src(COMPILER, wrap_main(body, GLOBALS), ("-O0",))
+    assert rc == 0 and "DEFVAR GF@__unused" in plain
+    assert "ADDITION/CONCAT CHECK" in function_code(plain, "tick")
+    if INTERPRET:
+        assert run_code(INTERPRET, p.stdout) == run_code(INTERPRET, plain) == (0, "null14")
+
+def budget_lines(stderr: str) -> dict:
+    return {name: (ran, skipped) for name, ran, skipped in
+            re.findall(r"^budget (\S+): ran=(\S+) skipped=(\S+)$", stderr, re.M)}
+
+BUDGET_FUNCTION = ('    static f{k}(n) {{\n'
+                   '        var s = 0\n'
+                   '        var i = 0\n'
+                   '        while (i < n) {{\n'
+                   '            var d = i * {k} + (i * {k}) * 2\n'
+                   '            s = s + d - i * {k}\n'
+                   '            i = i + 1\n'
+                   '        }}\n'
+                   '        return s\n'
+                   '    }}\n')
+
+def test_opt_budget(COMPILER, INTERPRET):
+    # 60 funkcí se smyčkou: všechny drahé průchody se do 1 ms (20000 kroků) nevejdou
+    src = wrap_main("\n".join(f"        Ifj.write(f{k}({k % 4 + 3}))" for k in range(60)),
+                    "".join(BUDGET_FUNCTION.format(k=k) for k in range(60)))
+    expected = "".join(str(sum(2 * k * i for i in range(k % 4 + 3))) for k in range(60))
+    runs = {}
+    for budget in ("0", "1", "1000000"):
+        p = subprocess.run([str(COMPILER), "--stats", f"--opt-budget={budget}"], input=src, text=True,
+                           stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+        assert p.returncode == 0
+        runs[budget] = (p.stdout, budget_lines(p.stderr),
+                        {k: int(v) for k, v in re.findall(r"^(\w+): (\d+)$", p.stderr, re.M)})
+    # nulový rozpočet: jen levné průchody, drahé se u každé funkce vypíšou jako přeskočené
+    code, lines, stats = runs["0"]
+    assert lines and all(ran == "-" for ran, _ in lines.values())
+    assert stats["budget_steps"] == 0 and stats["typed_loops"] == 0 and stats["frame_slots"] == 0
+    # velký rozpočet pustí všechno: stejný kód jako bez --opt-budget
+    assert all(skipped == "-" for _, skipped in runs["1000000"][1].values())
+    assert runs["1000000"][0] == compile_src(COMPILER, src)[1]
+    # malý rozpočet: část průchodů, deterministicky (počítají se odhadnuté kroky, ne čas)
+    code, lines, stats = runs["1"]
+    assert 0 < stats["budget_steps"] <= 20000
+    assert any(ran != "-" for ran, _ in lines.values()) and any(skipped != "-" for _, skipped in lines.values())
+    assert compile_src(COMPILER, src, ("--opt-budget=1",))[1] == code
+    if INTERPRET:
+        for budget, (code, _, _) in runs.items():
+            assert run_code(INTERPRET, code) == (0, expected), budget
@@ -0,0 +1,100 @@
+# -*- coding: utf-8 -*-
+import os, time, pathlib, subprocess, tempfile, pytest
+
+# Kompilační démon (compiler --daemon=SOCKET) a klient compiler_client:
+# klient musí dát stejný návratový kód, kód i chybový výstup jako přímý překlad.
+TEST_DIR = pathlib.Path(__file__).resolve().parent.parent
+ALL_SOURCES = sorted(TEST_DIR.glob("**/*.wren"))
+DAEMON_FLAGS = [(), ("-O0",), ("-Os",)]
+
+# ---------------- helpers ----------------
+
+def run(cmd, text: str, env=None):
+    p = subprocess.run([str(c) for c in cmd], input=text, text=True, env=env,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    # pád (záporné rc) jako v shellu: 128 + signál
+    rc = 128 - p.returncode if p.returncode < 0 else p.returncode
+    return rc, p.stdout, p.stderr
+
+@pytest.fixture(scope="module")
+def DAEMON(COMPILER):
+    tmp = tempfile.mkdtemp(prefix="ifj25-daemon-")
+    sock = pathlib.Path(tmp) / "sock"
+    proc = subprocess.Popen([str(COMPILER), f"--daemon={sock}"],
+                            stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    for _ in range(200):
+        if sock.exists():
+            break
+        time.sleep(0.01)
+    yield proc, sock
+    if proc.poll() is None:
+        proc.terminate()
+        proc.wait(timeout=10)
+
+# ---------------- tests ----------------
+
+@pytest.mark.parametrize("flags", DAEMON_FLAGS, ids=lambda f: " ".join(f) or "default")
+@pytest.mark.parametrize("src", ALL_SOURCES, ids=lambda p: str(p.relative_to(TEST_DIR)))
+def test_client_matches_direct_compile(COMPILER, CLIENT, DAEMON, src, flags):
+    _, sock = DAEMON
+    text = src.read_text(encoding="utf-8", errors="replace")
+    rc, out, err = run([COMPILER, *flags], text)
+    c_rc, c_out, c_err = run([CLIENT, f"--socket={sock}", *flags], text)
+    # žádný zdroják překladač neshodí, ani přímo, ani v démonu
+    assert rc < 128 and c_rc < 128, (rc, c_rc, err, c_err)
+    assert (c_rc, c_out) == (rc, out)
+    # chybová hláška jde klientovi, ne na stderr démona
+    assert c_err == err
+
+def test_daemon_repeats_requests_in_worker(COMPILER, CLIENT, DAEMON):
+    # jeden worker démona překládá požadavek za požadavkem: pořád stejný výsledek a démon běží dál
+    proc, sock = DAEMON
+    sources = [p for p in ALL_SOURCES if "gen" in p.parts][:8]
+    expected = [run([COMPILER], p.read_text(encoding="utf-8")) for p in sources]
+    for _ in range(5):
+        for p, want in zip(sources, expected):
+            assert run([CLIENT, f"--socket={sock}"], p.read_text(encoding="utf-8")) == want
+    assert proc.poll() is None
+
+# zdroják, na kterém překladač padá (SIGSEGV)
+CRASHING_SOURCE = 'import "ifj25" for Ifj\nclass Program {\n static '
+
+def test_daemon_survives_crashing_request(COMPILER, CLIENT, DAEMON):
+    # pád překladu shodí jen worker: klient dostane 128 + signál jako přímý běh a další požadavek se přeloží
+    proc, sock = DAEMON
+    rc, out, err = run([COMPILER], CRASHING_SOURCE)
+    if rc < 128:
+        pytest.skip("zdroják už překladač neshodí")
+    assert run([CLIENT, f"--socket={sock}"], CRASHING_SOURCE) == (rc, out, err)
+    c_rc, c_out, _ = run([CLIENT, f"--socket={sock}"], 'import "ifj25" for Ifj\nclass Program {\n    static main() {\n    }\n}\n')
+    assert c_rc == 0 and c_out.startswith(".IFJcode25")
+    assert proc.poll() is None and sock.exists()
+
+def test_client_reads_socket_from_environment(CLIENT, DAEMON):
+    _, sock = DAEMON
+    env = dict(os.environ, IFJ25_SOCKET=str(sock))
+    rc, out, _ = run([CLIENT], 'import "ifj25" for Ifj\nclass Program {\n    static main() {\n    }\n}\n', env)
+    assert rc == 0 and out.startswith(".IFJcode25")
+
+def test_daemon_rejects_daemon_option_in_request(CLIENT, DAEMON, ERROR_CODES):
+    _, sock = DAEMON
+    rc, out, err = run([CLIENT, f"--socket={sock}", "--daemon=/tmp/x"], "")
+    assert rc == ERROR_CODES["ERR_INTERNAL"] and out == ""
+    assert "daemon" in err
+
+def test_client_without_daemon_fails(CLIENT, ERROR_CODES):
+    rc, _, err = run([CLIENT, "--socket=/nonexistent/ifj25.sock"], "")
+    assert rc == ERROR_CODES["ERR_INTERNAL"]
+    assert err.startswith("Error:client:")
+
+def test_daemon_stops_on_sigterm(COMPILER):
+    sock = pathlib.Path(tempfile.mkdtemp(prefix="ifj25-daemon-")) / "sock"
+    proc = subprocess.Popen([str(COMPILER), f"--daemon={sock}"], stderr=subprocess.PIPE)
+    for _ in range(200):
+        if sock.exists():
+            break
+        time.sleep(0.01)
+    assert sock.exists()
+    proc.terminate()
+    assert proc.wait(timeout=10) == 0
+    assert not sock.exists()
@@ -0,0 +1,42 @@
+# -*- coding: utf-8 -*-
+import pathlib, subprocess, pytest
+
+PROJEKT = pathlib.Path(__file__).resolve().parents[2] / "projekt"
+
+def has_avx2():
+    try:
+        return " avx2" in pathlib.Path("/proc/cpuinfo").read_text()
+    except OSError:
+        return False
+
+def build(target):
+    p = subprocess.run(["make", "-s", "-C", str(PROJEKT), target], capture_output=True, text=True)
+    if p.returncode != 0:
+        pytest.skip(f"{target} se nepřeložil: {p.stderr[-400:]}")
+    return PROJEKT / target
+
+def escape(data: bytes) -> str:
+    # referenční escapování operandu string@ (bajty 0–32, # a \ jako \ddd)
+    return "".join(f"\\{b:03d}" if b <= 32 or b in (35, 92) else chr(b) for b in data)
+
+@pytest.mark.parametrize("target", ["escape_diff", "escape_diff_avx2"])
+@pytest.mark.parametrize("seed", [1, 2025, 987654321])
+def test_escape_matches_sprintf(target, seed):
+    # vektorová i skalární verze dají na náhodných řetězcích bajt po bajtu stejný výstup jako sprintf
+    if target.endswith("avx2") and not has_avx2():
+        pytest.skip("procesor nemá AVX2")
+    binary = build(target)
+    p = subprocess.run([str(binary), "5000", str(seed)], capture_output=True, text=True, timeout=120)
+    assert p.returncode == 0, p.stderr
+    impl, count = p.stdout.split()
+    assert impl in ("avx2", "sse2", "scalar") and int(count) == 5000
+
+def test_long_literal_operand(COMPILER):
+    # dlouhý literál s escapovanými znaky přes hranice vektorových bloků
+    chunk = 'ab#c\\\\d e\\tf\\ng' + "x" * 37
+    src = ('import "ifj25" for Ifj\nclass Program {\n    static main() {\n'
+           f'        Ifj.write("{chunk * 40}")\n    }}\n}}\n')
+    p = subprocess.run([str(COMPILER)], input=src, text=True, capture_output=True, timeout=60)
+    assert p.returncode == 0, p.stderr
+    value = ("ab#c\\d e\tf\ng" + "x" * 37) * 40
+    assert "string@" + escape(value.encode()) in p.stdout
@@ -0,0 +1,37 @@
+# -*- coding: utf-8 -*-
+import json, pathlib, subprocess, pytest
+
+PROJEKT = pathlib.Path(__file__).resolve().parents[2] / "projekt"
+COMPONENTS = {"scanner", "symtable", "scopes", "string", "codegen"}
+
+@pytest.fixture(scope="module")
+def microbench():
+    p = subprocess.run(["make", "-s", "-C", str(PROJEKT), "bench_micro"], capture_output=True, text=True)
+    if p.returncode != 0:
+        pytest.skip(f"bench_micro se nepřeložil: {p.stderr[-400:]}")
+    return PROJEKT / "bench_micro"
+
+def run(binary, *args):
+    p = subprocess.run([str(binary), *args], capture_output=True, text=True, timeout=300)
+    assert p.returncode == 0, p.stderr
+    return json.loads(p.stdout)
+
+def test_microbench_reports_json(microbench):
+    # jedno opakování každého měření: platný JSON, všechny komponenty, seřazené percentily
+    report = run(microbench, "--reps=1", "--warmup=0", "--label=test")
+    assert report["label"] == "test"
+    names = [b["name"] for b in report["benchmarks"]]
+    assert {n.split("/")[0] for n in names} == COMPONENTS
+    for b in report["benchmarks"]:
+        ns = b["ns"]
+        assert 0 <= ns["min"] <= ns["p50"] <= ns["p90"] <= ns["p99"] <= ns["max"], b["name"]
+        assert b["items"] > 0 and b["allocs_per_rep"] >= 0, b["name"]
+
+def test_microbench_counts_allocations(microbench):
+    # hledání v tabulce symbolů nealokuje, vložení alokuje klíč i data (2 na symbol)
+    report = run(microbench, "--reps=3", "--warmup=1", "--filter=symtable/")
+    by_name = {b["name"]: b for b in report["benchmarks"]}
+    assert set(by_name) == {"symtable/init", "symtable/insert", "symtable/find_hit", "symtable/find_miss"}
+    assert by_name["symtable/find_hit"]["allocs_per_rep"] == 0
+    assert by_name["symtable/find_hit"]["items"] == by_name["symtable/find_miss"]["items"] == 1000
+    assert by_name["symtable/insert"]["allocs_per_rep"] == 2 * by_name["symtable/insert"]["items"]
@@ -0,0 +1,45 @@
+# -*- coding: utf-8 -*-
+import pathlib, subprocess, pytest
+import perf_fuzz
+
+GEN = pathlib.Path(__file__).resolve().parent.parent / "gen"
+SEEDS = ["consteval_pure.wren", "loops_typed.wren", "string_build.wren"]
+
+def seed(name):
+    path = GEN / name
+    return perf_fuzz.Candidate(path, path.read_text(encoding="utf-8"))
+
+@pytest.mark.parametrize("op", sorted(perf_fuzz.OPERATORS))
+def test_mutation_keeps_program_valid(COMPILER, op):
+    # mutace respektují gramatiku: program se po vložení (i zvětšeném) dál přeloží
+    for name in SEEDS:
+        for tag in (1, 2):
+            source = perf_fuzz.apply(seed(name).text, op, 5, tag)
+            assert source != seed(name).text, f"{op} nic nevložil do {name}"
+            p = subprocess.run([str(COMPILER)], input=source, capture_output=True, text=True)
+            assert p.returncode == 0, f"{op} (značka {tag}) rozbil {name}:\n{p.stderr}"
+
+def test_mutations_replay_and_scale():
+    # kandidát je seed + mutace: stejný seznam dá stejný zdroják, faktor jen zvětší počty
+    cand = seed(SEEDS[0]).mutate(perf_fuzz.random.Random(3), 1).mutate(perf_fuzz.random.Random(4), 2)
+    again = perf_fuzz.Candidate(cand.seed, cand.text, cand.mutations)
+    assert cand.build() == again.build()
+    assert len(cand.build(4)) > len(cand.build(2)) > len(cand.build())
+    entry = cand.describe()
+    assert perf_fuzz.rebuild(entry, 2) == cand.build(2)
+
+def test_fit_exponent():
+    assert perf_fuzz.fit_exponent([(n, 3 * n) for n in (10, 20, 40, 80)]) == pytest.approx(1.0)
+    assert perf_fuzz.fit_exponent([(n, n * n) for n in (10, 20, 40, 80)]) == pytest.approx(2.0)
+
+def test_fuzzer_reports_scaling_curves(COMPILER):
+    # krátký běh: pro čas i paměť nálezy s mutacemi, rostoucí křivkou a exponentem
+    report = perf_fuzz.fuzz(COMPILER, iterations=12, seed=5, top=1, seeds=[seed(n) for n in SEEDS],
+                            max_bytes=4096)
+    assert {o["objective"] for o in report["offenders"]} <= set(perf_fuzz.OBJECTIVES)
+    assert report["offenders"], "žádný nález"
+    for o in report["offenders"]:
+        assert o["mutations"] and o["curve"]
+        sizes = [p["bytes"] for p in o["curve"]]
+        assert sizes == sorted(sizes) and len(set(sizes)) == len(sizes)
+        assert isinstance(o["exponent"], float)
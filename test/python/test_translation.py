@@ -0,0 +1,272 @@
+# -*- coding: utf-8 -*-
+"""Validace překladu: každý testovací a vygenerovaný zátěžový program se přeloží na všech
+úrovních optimalizace, výstupy se spustí lokálním interpretem (ifjcode.py) se stejným vstupem
+a musí se shodovat ve výstupu, návratovém kódu i kódu běhové chyby.
+
+Počty provedených instrukcí se zaznamenají (IFJ_TV_REPORT=soubor, řádky JSON), takže běh
+slouží i jako benchmark. Rozdíl se automaticky zmenší na malý reprodukční program
+(IFJ_TV_REPRO=adresář, jinak dočasný adresář), který je i ve zprávě selhání.
+
+Samostatně: python3 test_translation.py [soubor.wren ...] vypíše tabulku počtů instrukcí.
+"""
+import json, os, pathlib, random, subprocess, sys, tempfile, pytest
+import ifjcode
+
+TEST_DIR = pathlib.Path(__file__).resolve().parent.parent
+CORPUS = sorted(TEST_DIR.glob("**/*.wren"))
+# úrovně optimalizace, první je referenční
+LEVELS = [("-O0",), ("-O1",), ("-Os",), ("-O1", "--unroll=16"), ("--opt-budget=0",)]
+STRESS_SEED = int(os.getenv("IFJ_TV_SEED", "0"))
+STRESS_COUNT = int(os.getenv("IFJ_TV_COUNT", "24"))
+MINIMISE_TRIES = 600  # překladů a běhů kandidátů při zmenšování
+
+# ---------------- harness ----------------
+
+def level_name(flags) -> str:
+    return " ".join(flags)
+
+def outcome(compiler, source: str, stdin: str, flags):
+    """(chování, počet instrukcí, počet skoků); chování je ('compile', rc) nebo ('run', rc, stdout)."""
+    p = subprocess.run([str(compiler), *flags], input=source, text=True,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=60)
+    if p.returncode != 0:
+        return ("compile", p.returncode), 0, 0
+    r = ifjcode.run(p.stdout, stdin)
+    return ("run", r.rc, r.stdout), r.steps, r.jumps
+
+def validate(compiler, source: str, stdin: str = ""):
+    return {level_name(flags): outcome(compiler, source, stdin, flags) for flags in LEVELS}
+
+def diverges(results) -> bool:
+    return len({behaviour for behaviour, _, _ in results.values()}) > 1
+
+def record(name: str, results):
+    path = os.getenv("IFJ_TV_REPORT")
+    if not path:
+        return
+    with open(path, "a", encoding="utf-8") as f:
+        for level, (behaviour, steps, jumps) in results.items():
+            f.write(json.dumps({"program": name, "level": level, "rc": behaviour[1],
+                                "steps": steps, "jumps": jumps}) + "\n")
+
+def removable_spans(lines):
+    """Úseky řádků k odebrání: blok od `{` po odpovídající `}` (i s větví else) a jednotlivé řádky."""
+    for i, line in enumerate(lines):
+        if line.rstrip().endswith("{"):
+            depth = 0
+            for j in range(i, len(lines)):
+                depth += lines[j].count("{") - lines[j].count("}")
+                if depth <= 0:
+                    yield i, j + 1
+                    break
+        yield i, i + 1
+
+def minimise(source: str, still_fails, tries: int = MINIMISE_TRIES) -> str:
+    """Odebírá bloky a řádky, dokud program selhává (hladově, do pevného bodu nebo vyčerpání pokusů)."""
+    lines = source.split("\n")
+    changed = True
+    while changed and tries > 0:
+        changed = False
+        for start, end in sorted(removable_spans(lines), key=lambda s: s[0] - s[1]):
+            if tries <= 0:
+                break
+            candidate = lines[:start] + lines[end:]
+            tries -= 1
+            if still_fails("\n".join(candidate)):
+                lines, changed = candidate, True
+                break
+    return "\n".join(lines)
+
+def reproducer(compiler, name: str, source: str, stdin: str) -> str:
+    """Zmenšený program se stejným rozdílem mezi úrovněmi, uložený do souboru; vrací popis pro zprávu."""
+    small = minimise(source, lambda s: diverges(validate(compiler, s, stdin)))
+    out_dir = pathlib.Path(os.getenv("IFJ_TV_REPRO") or tempfile.mkdtemp(prefix="ifj25-tv-"))
+    out_dir.mkdir(parents=True, exist_ok=True)
+    path = out_dir / (pathlib.Path(name).stem + ".repro.wren")
+    path.write_text(small, encoding="utf-8")
+    lines = [f"{level}: {behaviour}" for level, (behaviour, _, _) in validate(compiler, small, stdin).items()]
+    return f"reproducer {path}:\n{small}\n" + "\n".join(lines)
+
+def check(compiler, name: str, source: str, stdin: str = ""):
+    results = validate(compiler, source, stdin)
+    record(name, results)
+    if diverges(results):
+        pytest.fail(f"{name}: optimisation levels disagree\n" + reproducer(compiler, name, source, stdin))
+    return results
+
+# ---------------- zátěžové programy ----------------
+
+class StressProgram:
+    """Náhodný program bez vstupu, který vždy skončí: cykly mají čítač, funkce volají jen dřívější funkce.
+
+    Čísla rostou v cyklech jen sčítáním a řetězce jen o literál, násobí se malými literály.
+    """
+    FLOATS = ("0.5", "1.25", "2.0", "0.75")
+
+    def __init__(self, seed: int):
+        self.r = random.Random(seed)
+        self.ints, self.floats, self.strs = ["a", "b", "c"], ["x", "y"], ["s", "t"]
+        self.counters, self.funcs = [], []
+        self.loops = 0
+
+    def int_expr(self, d: int) -> str:
+        r = self.r
+        if d <= 0 or r.random() < 0.3:
+            return r.choice([str(r.randint(0, 9)), *self.ints, *self.counters])
+        k = r.randrange(8)
+        if k == 0: return f"({self.int_expr(d - 1)} + {self.int_expr(d - 1)})"
+        if k == 1: return f"({self.int_expr(d - 1)} - {self.int_expr(d - 1)})"
+        if k == 2 and not self.loops: return f"({self.int_expr(d - 1)} * {r.randint(0, 3)})"
+        if k == 3: return f"Ifj.length({self.str_expr(d - 1)})"
+        if k == 4 and self.funcs: return f"{r.choice(self.funcs)}({self.int_expr(d - 1)}, {self.int_expr(d - 1)})"
+        if k == 5: return f"({self.cond(d - 1)} ? {self.int_expr(d - 1)} : {self.int_expr(d - 1)})"
+        if k == 6: return "__g"
+        return str(r.randint(0, 9))
+
+    def float_expr(self, d: int) -> str:
+        r = self.r
+        if d <= 0 or r.random() < 0.3:
+            return r.choice([r.choice(self.FLOATS), *self.floats])
+        k = r.randrange(4)
+        if k == 0: return f"({self.float_expr(d - 1)} + {self.float_expr(d - 1)})"
+        if k == 1: return f"({self.float_expr(d - 1)} - {self.int_expr(d - 1)})"
+        if k == 2 and not self.loops: return f"({self.float_expr(d - 1)} * {r.choice(self.FLOATS)})"
+        return f"({self.int_expr(d - 1)} / {r.choice(('2', '4'))})"
+
+    def str_expr(self, d: int) -> str:
+        r = self.r
+        leaves = ['"ab"', '"x"', '""', "__k"] + ([] if self.loops else self.strs)
+        if d <= 0 or r.random() < 0.4:
+            return r.choice(leaves)
+        k = r.randrange(3)
+        if k == 0: return f"({self.str_expr(d - 1)} + {self.str_expr(d - 1)})"
+        if k == 1: return f"({self.str_expr(d - 1)} * {r.randint(0, 2)})"
+        return f"Ifj.chr({65 + r.randint(0, 25)})"
+
+    def cond(self, d: int) -> str:
+        r = self.r
+        k = r.randrange(7)
+        if k == 0: return f"{self.int_expr(d)} < {self.int_expr(d)}"
+        if k == 1: return f"{self.int_expr(d)} == {self.int_expr(d)}"
+        if k == 2: return f"{self.float_expr(d)} >= {self.int_expr(d)}"
+        if k == 3: return f"{self.str_expr(d)} != {self.str_expr(d)}"
+        if k == 4 and d > 0: return f"({self.cond(d - 1)}) && ({self.cond(d - 1)})"
+        if k == 5 and d > 0: return f"({self.cond(d - 1)}) || !({self.cond(d - 1)})"
+        return f"{r.choice(self.ints)} is Num"
+
+    def statements(self, depth: int, count: int, indent: str):
+        return [line for _ in range(count) for line in self.statement(depth, indent)]
+
+    def statement(self, depth: int, indent: str):
+        r = self.r
+        k = r.randrange(10)
+        if k == 0 and self.ints:
+            v = r.choice(self.ints)
+            return [f"{indent}{v} = {v} + {self.int_expr(2)}" if self.loops else f"{indent}{v} = {self.int_expr(3)}"]
+        if k == 1 and self.floats:
+            v = r.choice(self.floats)
+            return [f"{indent}{v} = {v} + {self.float_expr(2)}" if self.loops else f"{indent}{v} = {self.float_expr(3)}"]
+        if k == 2 and self.strs:
+            v = r.choice(self.strs)
+            return [f'{indent}{v} = {v} + "{r.choice("xyz")}"' if self.loops else f"{indent}{v} = {self.str_expr(3)}"]
+        if k == 3:
+            return [f"{indent}__g = __g + {self.int_expr(1)}"]
+        if k == 4 and depth > 0:
+            return ([f"{indent}if ({self.cond(1)}) {{"] + self.statements(depth - 1, r.randint(1, 3), indent + "    ") +
+                    [f"{indent}}} else {{"] + self.statements(depth - 1, r.randint(0, 2), indent + "    ") + [f"{indent}}}"])
+        if k == 5 and depth > 0 and self.loops < 2:
+            i = f"i{self.loops}"
+            self.loops += 1
+            self.counters.append(i)
+            body = self.statements(depth - 1, r.randint(1, 3), indent + "    ")
+            if r.random() < 0.2:
+                body += [f"{indent}    if ({self.cond(0)}) {{", f"{indent}        break", f"{indent}    }}"]
+            self.counters.pop()
+            self.loops -= 1
+            return ([f"{indent}{i} = {r.randint(0, 2)}", f"{indent}while ({i} < {r.randint(0, 6)}) {{"] + body +
+                    [f"{indent}    {i} = {i} + 1", f"{indent}}}"])
+        return [f"{indent}Ifj.write({r.choice([self.int_expr(2), self.float_expr(2), self.str_expr(2), *self.ints])})"]
+
+    def function(self, name: str):
+        saved = self.ints, self.floats, self.strs
+        self.ints, self.floats, self.strs = ["p", "q"], [], []
+        lines = [f"    static {name}(p, q) {{", f"        var r = {self.int_expr(2)}", "        var i0 = 0", "        var i1 = 0"]
+        self.ints.append("r")
+        lines += self.statements(1, self.r.randint(1, 3), "        ")
+        lines += [f"        return {self.int_expr(2)}", "    }"]
+        self.ints, self.floats, self.strs = saved
+        self.funcs.append(name)
+        return lines
+
+    def source(self) -> str:
+        r = self.r
+        lines = ['import "ifj25" for Ifj', "class Program {"]
+        for n in range(r.randint(0, 3)):
+            lines += self.function(f"h{n}")
+        lines += ["    static main() {"]
+        if r.random() < 0.9:
+            lines += ["        __g = 0"]
+        lines += ['        __k = "ab"']
+        lines += [f"        var {v} = {r.randint(0, 5)}" for v in self.ints]
+        lines += [f"        var {v} = {r.choice(self.FLOATS)}" for v in self.floats]
+        lines += [f'        var {v} = "{v}"' for v in self.strs]
+        lines += ["        var i0 = 0", "        var i1 = 0"]
+        lines += self.statements(2, r.randint(6, 12), "        ")
+        lines += [f"        Ifj.write({v})" for v in self.ints + self.floats + self.strs]
+        lines += ["    }", "}", ""]
+        return "\n".join(lines)
+
+def stress_program(seed: int) -> str:
+    return StressProgram(seed).source()
+
+# ---------------- tests ----------------
+
+@pytest.mark.parametrize("src", CORPUS, ids=lambda p: str(p.relative_to(TEST_DIR)))
+def test_levels_agree_on_corpus(COMPILER, src):
+    inp = src.with_suffix(".in")
+    stdin = inp.read_text(encoding="utf-8") if inp.exists() else ""
+    check(COMPILER, str(src.relative_to(TEST_DIR)), src.read_text(encoding="utf-8", errors="replace"), stdin)
+
+@pytest.mark.parametrize("seed", range(STRESS_SEED, STRESS_SEED + STRESS_COUNT))
+def test_levels_agree_on_stress(COMPILER, seed):
+    results = check(COMPILER, f"stress{seed}", stress_program(seed))
+    # generátor tvoří jen platné programy, jinak by se optimalizace netestovaly
+    assert results["-O0"][0][0] == "run"
+
+def test_minimiser_keeps_divergence(COMPILER):
+    # umělý rozdíl: „selhává“ každý přeložitelný program, který ještě vypisuje 7
+    source = stress_program(STRESS_SEED).replace("    static main() {\n", "    static main() {\n        Ifj.write(7)\n", 1)
+    def fails(s):
+        behaviour = outcome(COMPILER, s, "", ("-O0",))[0]
+        return behaviour[0] == "run" and "Ifj.write(7)" in s
+    small = minimise(source, fails)
+    assert fails(small)
+    assert len(small.split("\n")) <= 8 < len(source.split("\n"))
+
+# ---------------- benchmark ----------------
+
+def main(argv):
+    root = pathlib.Path(__file__).resolve().parents[2]
+    compiler = os.getenv("COMPILER_BIN") or str(root / "projekt" / "compiler")
+    programs = [(p, pathlib.Path(p).read_text(encoding="utf-8", errors="replace")) for p in argv] or \
+               [(str(p.relative_to(TEST_DIR)), p.read_text(encoding="utf-8", errors="replace")) for p in CORPUS] + \
+               [(f"stress{s}", stress_program(s)) for s in range(STRESS_SEED, STRESS_SEED + STRESS_COUNT)]
+    levels = [level_name(f) for f in LEVELS]
+    print(f"{'program':40}" + "".join(f"{l:>18}" for l in levels))
+    totals, failures = [0] * len(levels), 0
+    for name, source in programs:
+        stdin_path = pathlib.Path(TEST_DIR / name).with_suffix(".in")
+        stdin = stdin_path.read_text(encoding="utf-8") if stdin_path.exists() else ""
+        results = validate(compiler, source, stdin)
+        record(name, results)
+        steps = [results[l][1] for l in levels]
+        totals = [t + s for t, s in zip(totals, steps)]
+        print(f"{name[-40:]:40}" + "".join(f"{s:>18}" for s in steps))
+        if diverges(results):
+            failures += 1
+            print(reproducer(compiler, name, source, stdin))
+    print(f"{'total':40}" + "".join(f"{t:>18}" for t in totals))
+    return 1 if failures else 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))